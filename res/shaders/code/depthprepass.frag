@@ -0,0 +1,6 @@
+#version 460
+
+// the depth prepass only writes depth, SDL_gpu still wants a fragment stage
+void main()
+{
+}
@@ -0,0 +1,35 @@
+#version 460
+
+// instanced.vert for the depth prepass: positions only, from their own vertex stream
+layout(location = 0) in vec3 a_position;
+
+// computed exactly as instanced.vert does, the shading pass tests depth for equality
+invariant gl_Position;
+
+struct Instance
+{
+    mat4 transform;
+};
+
+// per-instance data of every batch in the frame, in sorted order
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+// where the current batch starts in the instance buffer
+layout(set = 1, binding = 1) uniform Draw
+{
+    uint base_instance;
+};
+
+void main()
+{
+    mat4 model = instances[base_instance + gl_InstanceIndex].transform;
+    gl_Position = view_projection * model * vec4(a_position, 1.0);
+}
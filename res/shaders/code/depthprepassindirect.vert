@@ -0,0 +1,41 @@
+#version 460
+
+// instancedindirect.vert for the depth prepass: positions only, from their own vertex stream
+layout(location = 0) in vec3 a_position;
+
+// computed exactly as instancedindirect.vert does, the shading pass tests depth for equality
+invariant gl_Position;
+
+struct Object
+{
+    mat4 transform;
+    vec4 center;
+    vec4 extent;
+    uint mesh;
+    uint command;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+// written by cull.comp, each command's instances start at its first_instance
+layout(std430, set = 0, binding = 1) readonly buffer Visible
+{
+    uint visible[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+void main()
+{
+    // SPIR-V's InstanceIndex counts from the command's first_instance
+    mat4 model = objects[visible[gl_InstanceIndex]].transform;
+    gl_Position = view_projection * model * vec4(a_position, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 460
+
+// instancedpacked.vert for the depth prepass: positions only, from their own vertex stream
+layout(location = 0) in vec4 a_position;    // unorm16, relative to the mesh bounds
+
+// computed exactly as instancedpacked.vert does, the shading pass tests depth for equality
+invariant gl_Position;
+
+struct Instance
+{
+    mat4 transform;
+};
+
+// per-instance data of every batch in the frame, in sorted order
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+// where the current batch starts in the instance buffer and how its mesh decodes
+layout(set = 1, binding = 1) uniform Draw
+{
+    uint base_instance;
+    vec4 position_offset;
+    vec4 position_scale;
+};
+
+void main()
+{
+    mat4 model = instances[base_instance + gl_InstanceIndex].transform;
+    vec3 position = position_offset.xyz + a_position.xyz * position_scale.xyz;
+    gl_Position = view_projection * model * vec4(position, 1.0);
+}
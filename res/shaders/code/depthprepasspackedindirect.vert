@@ -0,0 +1,58 @@
+#version 460
+
+// instancedpackedindirect.vert for the depth prepass: positions only, from their own vertex stream
+layout(location = 0) in vec4 a_position;    // unorm16, relative to the mesh bounds
+
+// computed exactly as instancedpackedindirect.vert does, the shading pass tests depth for equality
+invariant gl_Position;
+
+struct Object
+{
+    mat4 transform;
+    vec4 center;
+    vec4 extent;
+    uint mesh;
+    uint command;
+    uint padding0;
+    uint padding1;
+};
+
+struct MeshLods
+{
+    vec4 position_offset;
+    vec4 position_scale;
+    float errors[5];        // Mesh::kMaxLods, GpuCulling::GpuMesh must match
+    uint lod_count;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+// written by cull.comp, each command's instances start at its first_instance
+layout(std430, set = 0, binding = 1) readonly buffer Visible
+{
+    uint visible[];
+};
+
+// one draw covers several meshes, each decodes with its own bounds
+layout(std430, set = 0, binding = 2) readonly buffer Meshes
+{
+    MeshLods meshes[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+void main()
+{
+    // SPIR-V's InstanceIndex counts from the command's first_instance
+    Object object = objects[visible[gl_InstanceIndex]];
+    vec3 position = meshes[object.mesh].position_offset.xyz + a_position.xyz * meshes[object.mesh].position_scale.xyz;
+    gl_Position = view_projection * object.transform * vec4(position, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 460
+
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec2 a_texcoord;
+
+layout(location = 0) out vec2 v_texcoord;
+
+// the depth prepass computes it the same way, its equal depth test needs identical results
+invariant gl_Position;
+
+struct Instance
+{
+    mat4 transform;
+};
+
+// per-instance data of every batch in the frame, in sorted order
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+// where the current batch starts in the instance buffer
+layout(set = 1, binding = 1) uniform Draw
+{
+    uint base_instance;
+};
+
+void main()
+{
+    mat4 model = instances[base_instance + gl_InstanceIndex].transform;
+    gl_Position = view_projection * model * vec4(a_position, 1.0);
+    v_texcoord = a_texcoord;
+}
@@ -0,0 +1,45 @@
+#version 460
+
+// instanced.vert for draws that GPU culling filled in, see src/gpu_culling.h
+layout(location = 0) in vec3 a_position;
+layout(location = 1) in vec2 a_texcoord;
+
+layout(location = 0) out vec2 v_texcoord;
+
+// the depth prepass computes it the same way, its equal depth test needs identical results
+invariant gl_Position;
+
+struct Object
+{
+    mat4 transform;
+    vec4 center;
+    vec4 extent;
+    uint mesh;
+    uint command;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+// written by cull.comp, each command's instances start at its first_instance
+layout(std430, set = 0, binding = 1) readonly buffer Visible
+{
+    uint visible[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+void main()
+{
+    // SPIR-V's InstanceIndex counts from the command's first_instance
+    mat4 model = objects[visible[gl_InstanceIndex]].transform;
+    gl_Position = view_projection * model * vec4(a_position, 1.0);
+    v_texcoord = a_texcoord;
+}
@@ -0,0 +1,55 @@
+#version 460
+
+// vtx::LAYOUT_COMPACT, see src/vertex_format.h
+layout(location = 0) in vec4 a_position;    // unorm16, relative to the mesh bounds
+layout(location = 1) in vec2 a_texcoord;    // half floats
+layout(location = 2) in vec2 a_normal;      // octahedral, snorm16
+
+layout(location = 0) out vec2 v_texcoord;
+layout(location = 1) out vec3 v_normal;
+
+// the depth prepass computes it the same way, its equal depth test needs identical results
+invariant gl_Position;
+
+struct Instance
+{
+    mat4 transform;
+};
+
+// per-instance data of every batch in the frame, in sorted order
+layout(std430, set = 0, binding = 0) readonly buffer Instances
+{
+    Instance instances[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+// where the current batch starts in the instance buffer and how its mesh decodes
+layout(set = 1, binding = 1) uniform Draw
+{
+    uint base_instance;
+    vec4 position_offset;
+    vec4 position_scale;
+};
+
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    mat4 model = instances[base_instance + gl_InstanceIndex].transform;
+    vec3 position = position_offset.xyz + a_position.xyz * position_scale.xyz;
+    gl_Position = view_projection * model * vec4(position, 1.0);
+    v_texcoord = a_texcoord;
+    // fine for rotations and uniform scale, which is all the scene uses
+    v_normal = normalize(mat3(model) * OctDecode(a_normal));
+}
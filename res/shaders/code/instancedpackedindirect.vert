@@ -0,0 +1,75 @@
+#version 460
+
+// instancedpacked.vert for draws that GPU culling filled in, see src/gpu_culling.h
+layout(location = 0) in vec4 a_position;    // unorm16, relative to the mesh bounds
+layout(location = 1) in vec2 a_texcoord;    // half floats
+layout(location = 2) in vec2 a_normal;      // octahedral, snorm16
+
+layout(location = 0) out vec2 v_texcoord;
+layout(location = 1) out vec3 v_normal;
+
+// the depth prepass computes it the same way, its equal depth test needs identical results
+invariant gl_Position;
+
+struct Object
+{
+    mat4 transform;
+    vec4 center;
+    vec4 extent;
+    uint mesh;
+    uint command;
+    uint padding0;
+    uint padding1;
+};
+
+struct MeshLods
+{
+    vec4 position_offset;
+    vec4 position_scale;
+    float errors[5];        // Mesh::kMaxLods, GpuCulling::GpuMesh must match
+    uint lod_count;
+    uint padding0;
+    uint padding1;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer Objects
+{
+    Object objects[];
+};
+
+// written by cull.comp, each command's instances start at its first_instance
+layout(std430, set = 0, binding = 1) readonly buffer Visible
+{
+    uint visible[];
+};
+
+// one draw covers several meshes, each decodes with its own bounds
+layout(std430, set = 0, binding = 2) readonly buffer Meshes
+{
+    MeshLods meshes[];
+};
+
+layout(set = 1, binding = 0) uniform Frame
+{
+    mat4 view_projection;
+};
+
+vec3 OctDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main()
+{
+    // SPIR-V's InstanceIndex counts from the command's first_instance
+    Object object = objects[visible[gl_InstanceIndex]];
+    vec3 position = meshes[object.mesh].position_offset.xyz + a_position.xyz * meshes[object.mesh].position_scale.xyz;
+    gl_Position = view_projection * object.transform * vec4(position, 1.0);
+    v_texcoord = a_texcoord;
+    // fine for rotations and uniform scale, which is all the scene uses
+    v_normal = normalize(mat3(object.transform) * OctDecode(a_normal));
+}
@@ -0,0 +1,12 @@
+#version 460
+
+// Renderer::Settings::overdraw_view: adds one to red per shaded fragment. Drawn
+// with premultiplied alpha blending and alpha 0, which adds the color as is
+layout(location = 0) in vec2 v_texcoord;
+
+layout(location = 0) out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(1.0 / 255.0, 0.0, 0.0, 0.0);
+}
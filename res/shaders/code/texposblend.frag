@@ -0,0 +1,19 @@
+#version 460
+
+// texpos.frag for blended materials, premultiplied alpha
+layout(location = 0) in vec2 v_texcoord;
+
+layout(location = 0) out vec4 FragColor;
+
+layout(set = 2, binding = 0) uniform sampler2D ourTexture;
+
+layout(set = 3, binding = 0) uniform Material
+{
+    float opacity;
+};
+
+void main()
+{
+    vec4 color = texture(ourTexture, v_texcoord);
+    FragColor = vec4(color.rgb, 1.0) * (color.a * opacity);
+}
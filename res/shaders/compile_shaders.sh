@@ -6,12 +6,21 @@ IFS=$'\n\t'
 # Walk the "code" directory and compile shader files with glslc.
 # Input files are expected as name.stage (e.g. myshader.vert)
 # Output files will be placed under CODE_DIR/../compiled preserving tree
+# Shaders whose output is newer than the source and every file it includes
+# are skipped, the rest compile in parallel, one job per core.
 #
-# Usage: ./compile_shaders.sh [CODE_DIR]
+# Usage: ./compile_shaders.sh [-f] [CODE_DIR]
+#   -f  compile everything, even when up to date
 # Default CODE_DIR is "$(dirname "$0")/../../code"
 
 SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+FORCE=0
+if [ "${1:-}" = "-f" ]; then
+    FORCE=1
+    shift
+fi
 CODE_DIR="${1:-code}"
+JOBS="$(nproc 2>/dev/null || echo 4)"
 
 # Ensure glslc is available
 if ! command -v glslc >/dev/null 2>&1; then
@@ -40,6 +49,36 @@ if [ ! -d "$CODE_DIR" ]; then
     exit 3
 fi
 
+# true when out is missing or older than the source or anything it includes,
+# includes are resolved next to the including file like glslc does
+needs_build() {
+    local src="$1" out="$2" inc
+    [ "$FORCE" = 1 ] && return 0
+    [ -f "$out" ] || return 0
+    [ "$src" -nt "$out" ] && return 0
+    while IFS= read -r inc; do
+        inc="$(dirname "$src")/$inc"
+        if [ -f "$inc" ] && needs_build "$inc" "$out"; then
+            return 0
+        fi
+    done < <(sed -n 's/^[[:space:]]*#[[:space:]]*include[[:space:]]*"\([^"]*\)".*/\1/p' "$src")
+    return 1
+}
+
+compile() {
+    local file="$1" out="$2"
+    if glslc "$file" -o "$out"; then
+        echo " OK: $out"
+    else
+        echo " FAIL: $file" >&2
+        return 1
+    fi
+}
+
+running=0
+failed=0
+skipped=0
+
 # Use NUL-separated output to be safe with spaces
 while IFS= read -r -d '' file; do
     base="$(basename "$file")"
@@ -60,11 +99,25 @@ while IFS= read -r -d '' file; do
 
     out="${out_dir}/${name}${ext}.spv"
 
-    echo "Compiling: $file -> $out"
-    if glslc "$file" -o "$out"; then
-        echo " OK: $out"
-    else
-        echo " FAIL: $file" >&2
-        # continue processing other files instead of exiting to show all failures
+    if ! needs_build "$file" "$out"; then
+        skipped=$((skipped + 1))
+        continue
+    fi
+
+    # keep at most JOBS compiles running, a failure does not stop the others
+    if [ "$running" -ge "$JOBS" ]; then
+        wait -n || failed=$((failed + 1))
+        running=$((running - 1))
     fi
-done < <(find "$CODE_DIR" -type f \( "${find_args[@]}" \) -print0)
\ No newline at end of file
+    echo "Compiling: $file -> $out"
+    compile "$file" "$out" &
+    running=$((running + 1))
+done < <(find "$CODE_DIR" -type f \( "${find_args[@]}" \) -print0)
+
+while [ "$running" -gt 0 ]; do
+    wait -n || failed=$((failed + 1))
+    running=$((running - 1))
+done
+
+echo "$skipped up to date, $failed failed"
+[ "$failed" -eq 0 ]
\ No newline at end of file
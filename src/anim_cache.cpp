@@ -0,0 +1,186 @@
+#include "anim_cache.h"
+#include "hash.h"
+#include "mesh_cache.h"
+
+#include <SDL3/SDL.h>
+
+namespace animcache
+{
+    // On-disk layout, native endian:
+    // FileHeader | ClipRecord[] | strings | clip data, each clip aligned to kClipAlignment
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t source_hash;
+        uint64_t settings_hash;
+        uint32_t clip_count;
+        uint32_t strings_size;
+    };
+
+    struct ClipRecord
+    {
+        uint64_t data_offset;
+        uint64_t data_size;
+        uint32_t name_offset;
+        uint32_t name_length;
+    };
+
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool AnimCache::Open(const char* path)
+    {
+        Close();
+
+        if (!file.Open(path))
+            return false;
+
+        const uint8_t* base = file.Data();
+        size_t size = file.Size();
+        if (size < sizeof(FileHeader))
+        {
+            SDL_Log("Animation cache %s is truncated", path);
+            file.Close();
+            return false;
+        }
+
+        const FileHeader* h = (const FileHeader*)base;
+        if (h->magic != kMagic || h->version != kVersion)
+        {
+            SDL_Log("Animation cache %s has an incompatible format", path);
+            file.Close();
+            return false;
+        }
+
+        // the clip data itself is only checked when a clip is asked for, to keep it unmapped until then
+        uint64_t tables_end = sizeof(FileHeader) + (uint64_t)h->clip_count * sizeof(ClipRecord) + h->strings_size;
+        bool ok = tables_end <= size;
+        const ClipRecord* records = (const ClipRecord*)(base + sizeof(FileHeader));
+        for (uint32_t i = 0; ok && i < h->clip_count; i++)
+        {
+            ok = records[i].data_offset >= tables_end && records[i].data_offset <= size
+                && records[i].data_size <= size - records[i].data_offset
+                && (uint64_t)records[i].name_offset + records[i].name_length <= h->strings_size;
+        }
+        if (!ok)
+        {
+            SDL_Log("Animation cache %s is corrupt", path);
+            file.Close();
+            return false;
+        }
+
+        header = h;
+        clips = records;
+        strings = (const char*)(clips + h->clip_count);
+        return true;
+    }
+
+    void AnimCache::Close()
+    {
+        file.Close();
+        header = nullptr;
+        clips = nullptr;
+        strings = nullptr;
+    }
+
+    uint64_t AnimCache::SourceHash() const { return header ? header->source_hash : 0; }
+    uint64_t AnimCache::SettingsHash() const { return header ? header->settings_hash : 0; }
+
+    bool AnimCache::IsUpToDate(const char* source_path, const anim::CompressionSettings& settings) const
+    {
+        if (!header || header->settings_hash != HashSettings(settings))
+            return false;
+        return header->source_hash == meshcache::HashFile(source_path);
+    }
+
+    uint32_t AnimCache::ClipCount() const { return header ? header->clip_count : 0; }
+
+    std::string_view AnimCache::ClipName(uint32_t index) const
+    {
+        return std::string_view(strings + clips[index].name_offset, clips[index].name_length);
+    }
+
+    anim::CompressedClip AnimCache::GetClip(uint32_t index) const
+    {
+        const ClipRecord& record = clips[index];
+        return anim::ViewCompressedClip(file.Data() + record.data_offset, (size_t)record.data_size);
+    }
+
+    anim::CompressedClip AnimCache::FindClip(std::string_view name) const
+    {
+        for (uint32_t i = 0; i < ClipCount(); i++)
+        {
+            if (ClipName(i) == name)
+                return GetClip(i);
+        }
+        return anim::CompressedClip();
+    }
+
+    bool Bake(const char* path, const std::vector<BakedClip>& clips, uint64_t source_hash, uint64_t settings_hash)
+    {
+        std::vector<ClipRecord> records;
+        std::string string_table;
+        for (const BakedClip& clip : clips)
+        {
+            ClipRecord record{};
+            record.data_size = clip.data.size();
+            record.name_offset = (uint32_t)string_table.size();
+            record.name_length = (uint32_t)clip.name.size();
+            string_table += clip.name;
+            records.push_back(record);
+        }
+
+        FileHeader header{};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.source_hash = source_hash;
+        header.settings_hash = settings_hash;
+        header.clip_count = (uint32_t)records.size();
+        header.strings_size = (uint32_t)string_table.size();
+
+        uint64_t offset = sizeof(FileHeader) + records.size() * sizeof(ClipRecord) + string_table.size();
+        for (ClipRecord& record : records)
+        {
+            record.data_offset = AlignUp(offset, kClipAlignment);
+            offset = record.data_offset + record.data_size;
+        }
+
+        // the file is assembled in memory once and written with a single call
+        std::vector<uint8_t> blob(offset, 0);
+        uint8_t* out = blob.data();
+        SDL_memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        if (!records.empty())
+            SDL_memcpy(out, records.data(), records.size() * sizeof(ClipRecord));
+        out += records.size() * sizeof(ClipRecord);
+        if (!string_table.empty())
+            SDL_memcpy(out, string_table.data(), string_table.size());
+        for (size_t i = 0; i < clips.size(); i++)
+        {
+            if (!clips[i].data.empty())
+                SDL_memcpy(blob.data() + records[i].data_offset, clips[i].data.data(), clips[i].data.size());
+        }
+
+        if (!SDL_SaveFile(path, blob.data(), blob.size()))
+        {
+            SDL_Log("Failed to write animation cache %s: %s", path, SDL_GetError());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t HashSettings(const anim::CompressionSettings& settings)
+    {
+        uint64_t h = hash::Combine(kMagic, kVersion);
+        for (float value : { settings.translation_error, settings.rotation_error, settings.scale_error, settings.chunk_seconds })
+        {
+            uint32_t bits;
+            SDL_memcpy(&bits, &value, sizeof(bits));
+            h = hash::Combine(h, bits);
+        }
+        return h;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "clip_compression.h"
+#include "mapped_file.h"
+
+// Baked animation cache (.skanim), the clips of a model next to its .skmesh.
+// Produced offline by the anim_bake tool and mapped at runtime like the mesh
+// cache. Every clip is a compressed blob (see clip_compression.h) sampled
+// straight from the mapping; its chunks are contiguous and in time order, so
+// playback touches the file sequentially and only faults in the chunks it
+// plays, while clips nobody plays never leave the disk.
+namespace animcache
+{
+    static const uint32_t kMagic = 0x4E414B53; // "SKAN"
+    static const uint32_t kVersion = 1;
+    static const uint32_t kClipAlignment = 64;
+
+    struct FileHeader;
+    struct ClipRecord;
+
+    struct BakedClip
+    {
+        std::string name;
+        std::vector<uint8_t> data;      // from anim::CompressClip
+    };
+
+    class AnimCache
+    {
+        MappedFile file;
+        const FileHeader* header = nullptr;
+        const ClipRecord* clips = nullptr;
+        const char* strings = nullptr;
+    public:
+        bool Open(const char* path);
+        void Close();
+
+        bool IsOpen() const { return header != nullptr; }
+        uint64_t SourceHash() const;
+        uint64_t SettingsHash() const;
+        // true when the cache was baked from this exact source file with these settings
+        bool IsUpToDate(const char* source_path, const anim::CompressionSettings& settings) const;
+
+        uint32_t ClipCount() const;
+        std::string_view ClipName(uint32_t index) const;
+        // invalid when the clip's data is corrupt
+        anim::CompressedClip GetClip(uint32_t index) const;
+        // the clip with this name, invalid when there is none
+        anim::CompressedClip FindClip(std::string_view name) const;
+    };
+
+    bool Bake(const char* path, const std::vector<BakedClip>& clips, uint64_t source_hash, uint64_t settings_hash);
+
+    // Cache key of the compression settings, covers the format version too
+    uint64_t HashSettings(const anim::CompressionSettings& settings);
+}
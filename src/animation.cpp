@@ -0,0 +1,106 @@
+#include "animation.h"
+
+#include <cmath>
+
+namespace anim
+{
+    void ClipCursor::Reset(const AnimationClip& clip)
+    {
+        keys.assign(clip.TrackCount(), 0);
+        time = 0.0f;
+    }
+
+    void SampleClip(const AnimationClip& clip, float time, ClipCursor& cursor, const LocalPose& bind_pose, LocalPose& pose)
+    {
+        if (cursor.keys.size() != clip.TrackCount())
+            cursor.Reset(clip);
+        if (pose.joint_count != bind_pose.joint_count)
+            pose.Resize(bind_pose.joint_count);
+
+        time = time < 0.0f ? 0.0f : (time > clip.duration ? clip.duration : time);
+        bool rewind = time < cursor.time;
+        cursor.time = time;
+
+        uint32_t joints = clip.joint_count < pose.joint_count ? clip.joint_count : pose.joint_count;
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            float out[TRACK_COUNT][4];
+            for (uint32_t type = 0; type < TRACK_COUNT; type++)
+            {
+                uint32_t track = j * TRACK_COUNT + type;
+                uint32_t begin = clip.key_offsets[track];
+                uint32_t count = clip.key_offsets[track + 1] - begin;
+                float* value = out[type];
+
+                if (count == 0)
+                {
+                    if (type == TRACK_TRANSLATION)
+                    {
+                        value[0] = bind_pose.tx[j]; value[1] = bind_pose.ty[j]; value[2] = bind_pose.tz[j]; value[3] = 0.0f;
+                    }
+                    else if (type == TRACK_ROTATION)
+                    {
+                        value[0] = bind_pose.rx[j]; value[1] = bind_pose.ry[j]; value[2] = bind_pose.rz[j]; value[3] = bind_pose.rw[j];
+                    }
+                    else
+                    {
+                        value[0] = bind_pose.sx[j]; value[1] = bind_pose.sy[j]; value[2] = bind_pose.sz[j]; value[3] = 0.0f;
+                    }
+                    continue;
+                }
+
+                const float* times = clip.times.data() + begin;
+                const glm::vec4* values = clip.values.data() + begin;
+                uint32_t& k = cursor.keys[track];
+                if (rewind || k >= count)
+                    k = 0;
+                while (k + 1 < count && times[k + 1] <= time)
+                    k++;
+
+                const glm::vec4& a = values[k];
+                if (k + 1 >= count || time <= times[k])
+                {
+                    value[0] = a.x; value[1] = a.y; value[2] = a.z; value[3] = a.w;
+                    continue;
+                }
+
+                const glm::vec4& b = values[k + 1];
+                float f = (time - times[k]) / (times[k + 1] - times[k]);
+                float fb = f;
+                if (type == TRACK_ROTATION && a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f)
+                    fb = -f;
+
+                value[0] = a.x * (1.0f - f) + b.x * fb;
+                value[1] = a.y * (1.0f - f) + b.y * fb;
+                value[2] = a.z * (1.0f - f) + b.z * fb;
+                value[3] = a.w * (1.0f - f) + b.w * fb;
+
+                if (type == TRACK_ROTATION)
+                {
+                    // nlerp, dense keys keep the angular error well below slerp's cost
+                    float len = sqrtf(value[0] * value[0] + value[1] * value[1] + value[2] * value[2] + value[3] * value[3]);
+                    value[0] /= len; value[1] /= len; value[2] /= len; value[3] /= len;
+                }
+            }
+
+            pose.tx[j] = out[TRACK_TRANSLATION][0];
+            pose.ty[j] = out[TRACK_TRANSLATION][1];
+            pose.tz[j] = out[TRACK_TRANSLATION][2];
+            pose.rx[j] = out[TRACK_ROTATION][0];
+            pose.ry[j] = out[TRACK_ROTATION][1];
+            pose.rz[j] = out[TRACK_ROTATION][2];
+            pose.rw[j] = out[TRACK_ROTATION][3];
+            pose.sx[j] = out[TRACK_SCALE][0];
+            pose.sy[j] = out[TRACK_SCALE][1];
+            pose.sz[j] = out[TRACK_SCALE][2];
+        }
+
+        // joints the clip doesn't cover stay in bind pose
+        for (uint32_t j = joints; j < pose.joint_count; j++)
+        {
+            pose.tx[j] = bind_pose.tx[j]; pose.ty[j] = bind_pose.ty[j]; pose.tz[j] = bind_pose.tz[j];
+            pose.rx[j] = bind_pose.rx[j]; pose.ry[j] = bind_pose.ry[j]; pose.rz[j] = bind_pose.rz[j]; pose.rw[j] = bind_pose.rw[j];
+            pose.sx[j] = bind_pose.sx[j]; pose.sy[j] = bind_pose.sy[j]; pose.sz[j] = bind_pose.sz[j];
+        }
+    }
+}
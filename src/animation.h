@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+#include "pose.h"
+
+namespace anim
+{
+    enum TrackType : uint32_t
+    {
+        TRACK_TRANSLATION = 0,
+        TRACK_ROTATION = 1,
+        TRACK_SCALE = 2,
+        TRACK_COUNT = 3
+    };
+
+    // Keyframes of all tracks live in two flat arrays. Track t = joint * TRACK_COUNT + type
+    // owns keys [key_offsets[t], key_offsets[t + 1]); tracks without keys keep the bind pose.
+    // Rotations are stored as xyzw quaternions, translations and scales use xyz.
+    struct AnimationClip
+    {
+        std::string name;
+        float duration = 0.0f;
+        uint32_t joint_count = 0;
+        std::vector<uint32_t> key_offsets;
+        std::vector<float> times;
+        std::vector<glm::vec4> values;
+
+        uint32_t TrackCount() const { return joint_count * TRACK_COUNT; }
+    };
+
+    // Remembers the active key of every track between samples. Playback moves
+    // forward by small steps, so the next key is found by stepping the cursor
+    // rather than binary searching; jumping backwards rewinds the track.
+    struct ClipCursor
+    {
+        std::vector<uint32_t> keys;
+        float time = 0.0f;
+
+        void Reset(const AnimationClip& clip);
+    };
+
+    // Samples every track at time (seconds, clamped to the clip) into pose.
+    void SampleClip(const AnimationClip& clip, float time, ClipCursor& cursor, const LocalPose& bind_pose, LocalPose& pose);
+}
@@ -0,0 +1,55 @@
+#include "animator.h"
+#include "skinning.h"
+
+#include <cmath>
+
+namespace anim
+{
+    void Animator::Advance(float dt)
+    {
+        float duration = compressed ? compressed->Duration() : (clip ? clip->duration : 0.0f);
+        if (duration <= 0.0f)
+            return;
+        time = fmodf(time + dt * speed, duration);
+        if (time < 0.0f)
+            time += duration;
+    }
+
+    void Animator::Evaluate()
+    {
+        if (skeleton == nullptr || (clip == nullptr && compressed == nullptr))
+            return;
+
+        uint32_t joints = skeleton->JointCount();
+        model.resize(joints);
+        palette.resize(joints);
+
+        if (compressed)
+            SampleCompressedClip(*compressed, time, compressed_cursor, skeleton->bind_pose, pose);
+        else
+            SampleClip(*clip, time, cursor, skeleton->bind_pose, pose);
+        LocalToModel(*skeleton, pose, model.data());
+        BuildSkinningPalette(*skeleton, model.data(), palette.data());
+
+        if (mesh && mesh->IsSkinned())
+        {
+            const std::pmr::vector<Vertex>& bind = mesh->Vertices();
+            skinned.resize(bind.size());
+            SkinVertices(palette.data(), bind.data(), mesh->Skin().data(), skinned.data(), bind.size());
+        }
+    }
+
+    void UpdateAnimators(JobSystem& jobs, std::vector<Animator>& animators, float dt, JobCounter* counter)
+    {
+        for (Animator& animator : animators)
+            animator.Advance(dt);
+
+        // one character per job, characters differ a lot in cost and stealing evens that out
+        jobs.ParallelFor((uint32_t)animators.size(), 1, [](void* data, uint32_t begin, uint32_t end)
+        {
+            Animator* animators = (Animator*)data;
+            for (uint32_t i = begin; i < end; i++)
+                animators[i].Evaluate();
+        }, animators.data(), counter);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include "animation.h"
+#include "clip_compression.h"
+#include "job_system.h"
+#include "mesh.h"
+#include "skeleton.h"
+
+namespace anim
+{
+    // One animated character instance: plays a looping clip on a skeleton and
+    // optionally deforms a skinned mesh on the CPU. The clip is either raw or
+    // compressed, e.g. from an animcache::AnimCache; compressed wins when both are set.
+    struct Animator
+    {
+        const Skeleton* skeleton = nullptr;
+        const AnimationClip* clip = nullptr;
+        const CompressedClip* compressed = nullptr;
+        const Mesh* mesh = nullptr;
+        float time = 0.0f;
+        float speed = 1.0f;
+
+        ClipCursor cursor;
+        CompressedCursor compressed_cursor;
+        LocalPose pose;
+        std::vector<glm::mat4> model;
+        std::vector<SkinMatrix> palette;
+        std::vector<Vertex> skinned;
+
+        // cheap clock update, done serially on the main thread
+        void Advance(float dt);
+        // pose sampling, hierarchy, palette and skinning
+        void Evaluate();
+    };
+
+    // Advances every animator by dt and fans the evaluation out over the job system.
+    void UpdateAnimators(JobSystem& jobs, std::vector<Animator>& animators, float dt, JobCounter* counter);
+}
@@ -0,0 +1,634 @@
+#include "block_compress.h"
+
+#include <SDL3/SDL.h>
+#include <cfloat>
+#include <cmath>
+#include "job_system.h"
+
+namespace bc
+{
+    uint32_t BlockBytes(Format format)
+    {
+        return format == FORMAT_BC1 ? 8 : 16;
+    }
+
+    size_t ImageBytes(Format format, uint32_t width, uint32_t height)
+    {
+        return (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(format);
+    }
+
+    // -----------------------------------------------------------------------
+    // shared helpers
+
+    static inline float Square(float x)
+    {
+        return x * x;
+    }
+
+    static inline int Clamp(int value, int low, int high)
+    {
+        return value < low ? low : (value > high ? high : value);
+    }
+
+    // principal axis of the texels by power iteration on the covariance matrix
+    static void PrincipalAxis(const float texels[16][4], int channels, float mean[4], float axis[4])
+    {
+        for (int c = 0; c < 4; c++)
+            mean[c] = 0.0f;
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < channels; c++)
+                mean[c] += texels[i][c];
+        for (int c = 0; c < channels; c++)
+            mean[c] /= 16.0f;
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float d[4] = {};
+            for (int c = 0; c < channels; c++)
+                d[c] = texels[i][c] - mean[c];
+            for (int r = 0; r < channels; r++)
+                for (int c = 0; c < channels; c++)
+                    covariance[r][c] += d[r] * d[c];
+        }
+
+        float v[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = {};
+            for (int r = 0; r < channels; r++)
+                for (int c = 0; c < channels; c++)
+                    next[r] += covariance[r][c] * v[c];
+            float length = 0.0f;
+            for (int c = 0; c < channels; c++)
+                length += next[c] * next[c];
+            if (length < 1e-12f)
+                break;
+            length = 1.0f / std::sqrt(length);
+            for (int c = 0; c < channels; c++)
+                v[c] = next[c] * length;
+        }
+        for (int c = 0; c < 4; c++)
+            axis[c] = c < channels ? v[c] : 0.0f;
+    }
+
+    // endpoints spanning the texels along the principal axis
+    static void AxisEndpoints(const float texels[16][4], int channels, float e0[4], float e1[4])
+    {
+        float mean[4], axis[4];
+        PrincipalAxis(texels, channels, mean, axis);
+
+        float t_min = FLT_MAX, t_max = -FLT_MAX;
+        for (int i = 0; i < 16; i++)
+        {
+            float t = 0.0f;
+            for (int c = 0; c < channels; c++)
+                t += (texels[i][c] - mean[c]) * axis[c];
+            t_min = SDL_min(t_min, t);
+            t_max = SDL_max(t_max, t);
+        }
+        for (int c = 0; c < 4; c++)
+        {
+            e0[c] = mean[c] + axis[c] * t_min;
+            e1[c] = mean[c] + axis[c] * t_max;
+        }
+    }
+
+    // least squares endpoints for fixed interpolation weights t (weight of e1)
+    static bool LeastSquares(const float texels[16][4], const float t[16], int channels, float e0[4], float e1[4])
+    {
+        float a = 0.0f, b = 0.0f, c = 0.0f;
+        float x0[4] = {}, x1[4] = {};
+        for (int i = 0; i < 16; i++)
+        {
+            float s = 1.0f - t[i];
+            a += s * s;
+            b += s * t[i];
+            c += t[i] * t[i];
+            for (int ch = 0; ch < channels; ch++)
+            {
+                x0[ch] += s * texels[i][ch];
+                x1[ch] += t[i] * texels[i][ch];
+            }
+        }
+        float det = a * c - b * b;
+        if (SDL_fabsf(det) < 1e-6f)
+            return false;
+        float inv = 1.0f / det;
+        for (int ch = 0; ch < channels; ch++)
+        {
+            e0[ch] = SDL_clamp((c * x0[ch] - b * x1[ch]) * inv, 0.0f, 255.0f);
+            e1[ch] = SDL_clamp((a * x1[ch] - b * x0[ch]) * inv, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    static void LoadTexels(const uint8_t texels[64], float out[16][4])
+    {
+        for (int i = 0; i < 16; i++)
+            for (int c = 0; c < 4; c++)
+                out[i][c] = texels[i * 4 + c];
+    }
+
+    // -----------------------------------------------------------------------
+    // BC1
+
+    static inline uint16_t To565(const float color[4])
+    {
+        int r = Clamp((int)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        int g = Clamp((int)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        int b = Clamp((int)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return (uint16_t)(r << 11 | g << 5 | b);
+    }
+
+    static inline void From565(uint16_t value, int color[3])
+    {
+        int r = value >> 11 & 31, g = value >> 5 & 63, b = value & 31;
+        color[0] = r << 3 | r >> 2;
+        color[1] = g << 2 | g >> 4;
+        color[2] = b << 3 | b >> 2;
+    }
+
+    static void Palette565(uint16_t c0, uint16_t c1, int palette[4][3])
+    {
+        From565(c0, palette[0]);
+        From565(c1, palette[1]);
+        for (int c = 0; c < 3; c++)
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    // four color palette, returns the squared error
+    static float FitBC1(const float texels[16][4], uint16_t c0, uint16_t c1, uint8_t indices[16])
+    {
+        int palette[4][3];
+        Palette565(c0, c1, palette);
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            float best = FLT_MAX;
+            for (uint8_t p = 0; p < 4; p++)
+            {
+                float error = Square(texels[i][0] - palette[p][0]) + Square(texels[i][1] - palette[p][1]) + Square(texels[i][2] - palette[p][2]);
+                if (error < best)
+                {
+                    best = error;
+                    indices[i] = p;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    static void EncodeColorBlock(const float texels[16][4], uint8_t block[8])
+    {
+        float e0[4], e1[4];
+        AxisEndpoints(texels, 3, e1, e0);
+
+        uint16_t c0 = To565(e0), c1 = To565(e1);
+        uint8_t indices[16];
+        float error = FitBC1(texels, c0, c1, indices);
+
+        // refine: endpoints from the chosen indices, keep whatever is better
+        static const float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+        for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++)
+        {
+            float t[16];
+            for (int i = 0; i < 16; i++)
+                t[i] = kWeights[indices[i]];
+            if (!LeastSquares(texels, t, 3, e0, e1))
+                break;
+            uint16_t r0 = To565(e0), r1 = To565(e1);
+            uint8_t refined[16];
+            float refined_error = FitBC1(texels, r0, r1, refined);
+            if (refined_error >= error)
+                break;
+            c0 = r0;
+            c1 = r1;
+            error = refined_error;
+            SDL_memcpy(indices, refined, sizeof(indices));
+        }
+
+        // c0 > c1 selects the four color mode
+        if (c0 < c1)
+        {
+            uint16_t swap = c0;
+            c0 = c1;
+            c1 = swap;
+            static const uint8_t kSwapped[4] = { 1, 0, 3, 2 };
+            for (int i = 0; i < 16; i++)
+                indices[i] = kSwapped[indices[i]];
+        }
+        else if (c0 == c1)
+        {
+            // equal endpoints read as three color mode, index 0 is the only safe choice
+            for (int i = 0; i < 16; i++)
+                indices[i] = 0;
+        }
+
+        uint32_t bits = 0;
+        for (int i = 0; i < 16; i++)
+            bits |= (uint32_t)indices[i] << (i * 2);
+        block[0] = (uint8_t)c0;
+        block[1] = (uint8_t)(c0 >> 8);
+        block[2] = (uint8_t)c1;
+        block[3] = (uint8_t)(c1 >> 8);
+        SDL_memcpy(block + 4, &bits, 4);
+    }
+
+    static void DecodeColorBlock(const uint8_t block[8], uint8_t texels[64], bool four_color_only)
+    {
+        uint16_t c0 = (uint16_t)(block[0] | block[1] << 8);
+        uint16_t c1 = (uint16_t)(block[2] | block[3] << 8);
+        int palette[4][3];
+        Palette565(c0, c1, palette);
+        int alpha[4] = { 255, 255, 255, 255 };
+        if (c0 <= c1 && !four_color_only)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+            alpha[3] = 0;
+        }
+
+        uint32_t bits;
+        SDL_memcpy(&bits, block + 4, 4);
+        for (int i = 0; i < 16; i++)
+        {
+            int index = bits >> (i * 2) & 3;
+            texels[i * 4 + 0] = (uint8_t)palette[index][0];
+            texels[i * 4 + 1] = (uint8_t)palette[index][1];
+            texels[i * 4 + 2] = (uint8_t)palette[index][2];
+            texels[i * 4 + 3] = (uint8_t)alpha[index];
+        }
+    }
+
+    void EncodeBC1(const uint8_t texels[64], uint8_t block[8])
+    {
+        float values[16][4];
+        LoadTexels(texels, values);
+        EncodeColorBlock(values, block);
+    }
+
+    void DecodeBC1(const uint8_t block[8], uint8_t texels[64])
+    {
+        DecodeColorBlock(block, texels, false);
+    }
+
+    // -----------------------------------------------------------------------
+    // BC3 = BC4 alpha + BC1 color
+
+    static void EncodeAlphaBlock(const uint8_t texels[64], uint8_t block[8])
+    {
+        int a_min = 255, a_max = 0;
+        for (int i = 0; i < 16; i++)
+        {
+            a_min = SDL_min(a_min, (int)texels[i * 4 + 3]);
+            a_max = SDL_max(a_max, (int)texels[i * 4 + 3]);
+        }
+
+        uint64_t bits = 0;
+        if (a_max > a_min)
+        {
+            // a0 > a1: eight interpolated values
+            int palette[8];
+            palette[0] = a_max;
+            palette[1] = a_min;
+            for (int i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * a_max + (i - 1) * a_min) / 7;
+
+            for (int i = 0; i < 16; i++)
+            {
+                int alpha = texels[i * 4 + 3];
+                int best = 0, best_error = 256;
+                for (int p = 0; p < 8; p++)
+                {
+                    int error = SDL_abs(alpha - palette[p]);
+                    if (error < best_error)
+                    {
+                        best_error = error;
+                        best = p;
+                    }
+                }
+                bits |= (uint64_t)best << (i * 3);
+            }
+        }
+
+        block[0] = (uint8_t)a_max;
+        block[1] = (uint8_t)a_min;
+        for (int i = 0; i < 6; i++)
+            block[2 + i] = (uint8_t)(bits >> (i * 8));
+    }
+
+    static void DecodeAlphaBlock(const uint8_t block[8], uint8_t texels[64])
+    {
+        int a0 = block[0], a1 = block[1];
+        int palette[8] = { a0, a1 };
+        if (a0 > a1)
+        {
+            for (int i = 2; i < 8; i++)
+                palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+        }
+        else
+        {
+            for (int i = 2; i < 6; i++)
+                palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+
+        uint64_t bits = 0;
+        for (int i = 0; i < 6; i++)
+            bits |= (uint64_t)block[2 + i] << (i * 8);
+        for (int i = 0; i < 16; i++)
+            texels[i * 4 + 3] = (uint8_t)palette[bits >> (i * 3) & 7];
+    }
+
+    void EncodeBC3(const uint8_t texels[64], uint8_t block[16])
+    {
+        EncodeAlphaBlock(texels, block);
+        EncodeBC1(texels, block + 8);
+    }
+
+    void DecodeBC3(const uint8_t block[16], uint8_t texels[64])
+    {
+        DecodeColorBlock(block + 8, texels, true);
+        DecodeAlphaBlock(block, texels);
+    }
+
+    // -----------------------------------------------------------------------
+    // BC7 mode 6
+
+    static const int kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    struct BitWriter
+    {
+        uint8_t* bytes;
+        uint32_t position = 0;
+
+        void Write(uint32_t value, uint32_t count)
+        {
+            for (uint32_t i = 0; i < count; i++, position++)
+            {
+                if (value >> i & 1)
+                    bytes[position >> 3] |= (uint8_t)(1 << (position & 7));
+            }
+        }
+    };
+
+    struct BitReader
+    {
+        const uint8_t* bytes;
+        uint32_t position = 0;
+
+        uint32_t Read(uint32_t count)
+        {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < count; i++, position++)
+                value |= (uint32_t)(bytes[position >> 3] >> (position & 7) & 1) << i;
+            return value;
+        }
+    };
+
+    // 7 bits per channel plus a shared p-bit, the p-bit with the smaller error wins
+    static void QuantizeEndpoint(const float endpoint[4], uint8_t quantized[4], uint8_t& p_bit)
+    {
+        float best_error = FLT_MAX;
+        for (uint8_t p = 0; p < 2; p++)
+        {
+            uint8_t q[4];
+            float error = 0.0f;
+            for (int c = 0; c < 4; c++)
+            {
+                q[c] = (uint8_t)Clamp((int)std::floor((endpoint[c] - p) * 0.5f + 0.5f), 0, 127);
+                error += Square((float)(q[c] << 1 | p) - endpoint[c]);
+            }
+            if (error < best_error)
+            {
+                best_error = error;
+                p_bit = p;
+                SDL_memcpy(quantized, q, 4);
+            }
+        }
+    }
+
+    static float FitBC7(const float texels[16][4], const uint8_t q0[4], uint8_t p0, const uint8_t q1[4], uint8_t p1, uint8_t indices[16])
+    {
+        int palette[16][4];
+        for (int c = 0; c < 4; c++)
+        {
+            int e0 = q0[c] << 1 | p0;
+            int e1 = q1[c] << 1 | p1;
+            for (int w = 0; w < 16; w++)
+                palette[w][c] = ((64 - kWeights4[w]) * e0 + kWeights4[w] * e1 + 32) >> 6;
+        }
+
+        float total = 0.0f;
+        for (int i = 0; i < 16; i++)
+        {
+            float best = FLT_MAX;
+            for (uint8_t p = 0; p < 16; p++)
+            {
+                float error = Square(texels[i][0] - palette[p][0]) + Square(texels[i][1] - palette[p][1]) +
+                              Square(texels[i][2] - palette[p][2]) + Square(texels[i][3] - palette[p][3]);
+                if (error < best)
+                {
+                    best = error;
+                    indices[i] = p;
+                }
+            }
+            total += best;
+        }
+        return total;
+    }
+
+    void EncodeBC7(const uint8_t texels[64], uint8_t block[16])
+    {
+        float values[16][4];
+        LoadTexels(texels, values);
+
+        float e0[4], e1[4];
+        AxisEndpoints(values, 4, e0, e1);
+
+        uint8_t q0[4], q1[4], p0, p1;
+        QuantizeEndpoint(e0, q0, p0);
+        QuantizeEndpoint(e1, q1, p1);
+        uint8_t indices[16];
+        float error = FitBC7(values, q0, p0, q1, p1, indices);
+
+        for (int iteration = 0; iteration < 2 && error > 0.0f; iteration++)
+        {
+            float t[16];
+            for (int i = 0; i < 16; i++)
+                t[i] = kWeights4[indices[i]] / 64.0f;
+            if (!LeastSquares(values, t, 4, e0, e1))
+                break;
+            uint8_t r0[4], r1[4], rp0, rp1, refined[16];
+            QuantizeEndpoint(e0, r0, rp0);
+            QuantizeEndpoint(e1, r1, rp1);
+            float refined_error = FitBC7(values, r0, rp0, r1, rp1, refined);
+            if (refined_error >= error)
+                break;
+            SDL_memcpy(q0, r0, 4);
+            SDL_memcpy(q1, r1, 4);
+            p0 = rp0;
+            p1 = rp1;
+            SDL_memcpy(indices, refined, sizeof(indices));
+            error = refined_error;
+        }
+
+        // the anchor index is stored with its top bit implied zero
+        if (indices[0] & 8)
+        {
+            uint8_t swap[4];
+            SDL_memcpy(swap, q0, 4);
+            SDL_memcpy(q0, q1, 4);
+            SDL_memcpy(q1, swap, 4);
+            uint8_t p = p0;
+            p0 = p1;
+            p1 = p;
+            for (int i = 0; i < 16; i++)
+                indices[i] = 15 - indices[i];
+        }
+
+        SDL_memset(block, 0, 16);
+        BitWriter writer{ block };
+        writer.Write(1 << 6, 7);
+        for (int c = 0; c < 4; c++)
+        {
+            writer.Write(q0[c], 7);
+            writer.Write(q1[c], 7);
+        }
+        writer.Write(p0, 1);
+        writer.Write(p1, 1);
+        writer.Write(indices[0], 3);
+        for (int i = 1; i < 16; i++)
+            writer.Write(indices[i], 4);
+    }
+
+    void DecodeBC7(const uint8_t block[16], uint8_t texels[64])
+    {
+        if ((block[0] & 0x7F) != 0x40)
+        {
+            for (int i = 0; i < 16; i++)
+            {
+                texels[i * 4 + 0] = 255;
+                texels[i * 4 + 1] = 0;
+                texels[i * 4 + 2] = 255;
+                texels[i * 4 + 3] = 255;
+            }
+            return;
+        }
+
+        BitReader reader{ block };
+        reader.Read(7);
+        int q[2][4];
+        for (int c = 0; c < 4; c++)
+        {
+            q[0][c] = (int)reader.Read(7);
+            q[1][c] = (int)reader.Read(7);
+        }
+        int p0 = (int)reader.Read(1), p1 = (int)reader.Read(1);
+        for (int i = 0; i < 16; i++)
+        {
+            int index = (int)reader.Read(i == 0 ? 3 : 4);
+            for (int c = 0; c < 4; c++)
+            {
+                int e0 = q[0][c] << 1 | p0;
+                int e1 = q[1][c] << 1 | p1;
+                texels[i * 4 + c] = (uint8_t)(((64 - kWeights4[index]) * e0 + kWeights4[index] * e1 + 32) >> 6);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------
+    // images
+
+    struct ImageJob
+    {
+        Format format;
+        const uint8_t* rgba;
+        uint32_t width;
+        uint32_t height;
+        uint8_t* out;
+    };
+
+    static void EncodeRows(void* data, uint32_t begin, uint32_t end)
+    {
+        const ImageJob& job = *(const ImageJob*)data;
+        uint32_t blocks_x = (job.width + 3) / 4;
+        uint32_t block_bytes = BlockBytes(job.format);
+        uint8_t texels[64];
+        for (uint32_t by = begin; by < end; by++)
+        {
+            for (uint32_t bx = 0; bx < blocks_x; bx++)
+            {
+                for (uint32_t y = 0; y < 4; y++)
+                {
+                    uint32_t sy = SDL_min(by * 4 + y, job.height - 1);
+                    for (uint32_t x = 0; x < 4; x++)
+                    {
+                        uint32_t sx = SDL_min(bx * 4 + x, job.width - 1);
+                        SDL_memcpy(texels + (y * 4 + x) * 4, job.rgba + ((size_t)sy * job.width + sx) * 4, 4);
+                    }
+                }
+
+                uint8_t* block = job.out + ((size_t)by * blocks_x + bx) * block_bytes;
+                switch (job.format)
+                {
+                case FORMAT_BC1: EncodeBC1(texels, block); break;
+                case FORMAT_BC3: EncodeBC3(texels, block); break;
+                case FORMAT_BC7: EncodeBC7(texels, block); break;
+                }
+            }
+        }
+    }
+
+    void EncodeImage(Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out, JobSystem* jobs)
+    {
+        ImageJob job{ format, rgba, width, height, out };
+        uint32_t blocks_y = (height + 3) / 4;
+        if (jobs)
+        {
+            JobCounter counter;
+            jobs->ParallelFor(blocks_y, 1, EncodeRows, &job, &counter);
+            jobs->Wait(&counter);
+        }
+        else
+        {
+            EncodeRows(&job, 0, blocks_y);
+        }
+    }
+
+    void DecodeImage(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba)
+    {
+        uint32_t blocks_x = (width + 3) / 4;
+        uint32_t blocks_y = (height + 3) / 4;
+        uint32_t block_bytes = BlockBytes(format);
+        uint8_t texels[64];
+        for (uint32_t by = 0; by < blocks_y; by++)
+        {
+            for (uint32_t bx = 0; bx < blocks_x; bx++)
+            {
+                const uint8_t* block = blocks + ((size_t)by * blocks_x + bx) * block_bytes;
+                switch (format)
+                {
+                case FORMAT_BC1: DecodeBC1(block, texels); break;
+                case FORMAT_BC3: DecodeBC3(block, texels); break;
+                case FORMAT_BC7: DecodeBC7(block, texels); break;
+                }
+
+                for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+                {
+                    for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+                        SDL_memcpy(rgba + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4, texels + (y * 4 + x) * 4, 4);
+                }
+            }
+        }
+    }
+}
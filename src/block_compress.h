@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class JobSystem;
+
+// BC1/BC3/BC7 block encoders for the offline texture cook, plus decoders for
+// measuring their error. Blocks are 4x4 RGBA8 texels, row major.
+//
+// BC7 only uses mode 6 (one subset, RGBA endpoints with p-bits, 4-bit
+// indices): a fraction of the full mode search cost and a good fit for
+// opaque and smoothly varying alpha content.
+namespace bc
+{
+    enum Format
+    {
+        FORMAT_BC1,     // RGB, alpha ignored, 8 bytes per block
+        FORMAT_BC3,     // BC1 color + BC4 alpha, 16 bytes per block
+        FORMAT_BC7,     // 16 bytes per block
+    };
+
+    uint32_t BlockBytes(Format format);
+    size_t ImageBytes(Format format, uint32_t width, uint32_t height);
+
+    void EncodeBC1(const uint8_t texels[64], uint8_t block[8]);
+    void EncodeBC3(const uint8_t texels[64], uint8_t block[16]);
+    void EncodeBC7(const uint8_t texels[64], uint8_t block[16]);
+
+    void DecodeBC1(const uint8_t block[8], uint8_t texels[64]);
+    void DecodeBC3(const uint8_t block[16], uint8_t texels[64]);
+    // mode 6 blocks only, anything else decodes to opaque magenta
+    void DecodeBC7(const uint8_t block[16], uint8_t texels[64]);
+
+    // Whole RGBA8 image, edge texels are repeated to fill partial blocks.
+    // Rows of blocks are spread over jobs when given.
+    void EncodeImage(Format format, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out, JobSystem* jobs = nullptr);
+    void DecodeImage(Format format, const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* rgba);
+}
@@ -0,0 +1,62 @@
+#include "bounds.h"
+
+Aabb ComputeBounds(const Vertex* vertices, uint32_t count)
+{
+    Aabb bounds;
+    for (uint32_t i = 0; i < count; i++)
+        bounds.Merge(vertices[i].position);
+    return bounds;
+}
+
+Aabb TransformBounds(const Aabb& bounds, const glm::mat4& transform)
+{
+    if (bounds.IsEmpty())
+        return bounds;
+
+    // Arvo: the new half extent is |M| applied to the old one
+    glm::vec3 center = glm::vec3(transform * glm::vec4(bounds.Center(), 1.0f));
+    glm::vec3 extent = bounds.Extent();
+    glm::vec3 new_extent(0.0f);
+    for (int column = 0; column < 3; column++)
+        new_extent += glm::abs(glm::vec3(transform[column])) * extent[column];
+
+    Aabb result;
+    result.min = center - new_extent;
+    result.max = center + new_extent;
+    return result;
+}
+
+Frustum Frustum::FromMatrix(const glm::mat4& m)
+{
+    // Gribb/Hartmann on the rows of the matrix, glm is column major
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i++)
+        rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    Frustum frustum;
+    frustum.planes[PLANE_LEFT] = rows[3] + rows[0];
+    frustum.planes[PLANE_RIGHT] = rows[3] - rows[0];
+    frustum.planes[PLANE_BOTTOM] = rows[3] + rows[1];
+    frustum.planes[PLANE_TOP] = rows[3] - rows[1];
+    frustum.planes[PLANE_NEAR] = rows[2];
+    frustum.planes[PLANE_FAR] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : frustum.planes)
+        plane /= glm::length(glm::vec3(plane));
+    return frustum;
+}
+
+bool Frustum::Intersects(const Aabb& bounds) const
+{
+    glm::vec3 center = bounds.Center();
+    glm::vec3 extent = bounds.Extent();
+    for (const glm::vec4& plane : planes)
+    {
+        glm::vec3 normal(plane);
+        float distance = glm::dot(normal, center) + plane.w;
+        float radius = glm::dot(glm::abs(normal), extent);
+        if (distance + radius < 0.0f)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cfloat>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "mesh.h"
+
+struct Aabb
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    bool IsEmpty() const { return min.x > max.x; }
+    glm::vec3 Center() const { return (min + max) * 0.5f; }
+    glm::vec3 Extent() const { return (max - min) * 0.5f; }
+
+    void Merge(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Merge(const Aabb& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+};
+
+Aabb ComputeBounds(const Vertex* vertices, uint32_t count);
+
+// Bounds of the transformed box, not of the transformed vertices, so slightly loose under rotation.
+Aabb TransformBounds(const Aabb& bounds, const glm::mat4& transform);
+
+// Six planes facing inwards, a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for all.
+struct Frustum
+{
+    enum Plane { PLANE_LEFT, PLANE_RIGHT, PLANE_BOTTOM, PLANE_TOP, PLANE_NEAR, PLANE_FAR, PLANE_COUNT };
+
+    glm::vec4 planes[PLANE_COUNT];
+
+    // expects clip space depth in [0, 1], the convention of SDL_gpu
+    static Frustum FromMatrix(const glm::mat4& view_projection);
+
+    bool Intersects(const Aabb& bounds) const;
+};
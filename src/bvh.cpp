@@ -0,0 +1,324 @@
+#include "bvh.h"
+
+#include <SDL3/SDL.h>
+#include "render_queue.h"
+#include "simd.h"
+
+void BoundsSoA::Resize(uint32_t _count)
+{
+    count = _count;
+    uint32_t padded = count + 3;
+    cx.assign(padded, 0.0f);
+    cy.assign(padded, 0.0f);
+    cz.assign(padded, 0.0f);
+    ex.assign(padded, 0.0f);
+    ey.assign(padded, 0.0f);
+    ez.assign(padded, 0.0f);
+}
+
+void BoundsSoA::Set(uint32_t index, const Aabb& bounds)
+{
+    glm::vec3 center = bounds.Center();
+    glm::vec3 extent = bounds.Extent();
+    cx[index] = center.x;
+    cy[index] = center.y;
+    cz[index] = center.z;
+    ex[index] = extent.x;
+    ey[index] = extent.y;
+    ez[index] = extent.z;
+}
+
+Aabb BoundsSoA::Get(uint32_t index) const
+{
+    glm::vec3 center(cx[index], cy[index], cz[index]);
+    glm::vec3 extent(ex[index], ey[index], ez[index]);
+    Aabb bounds;
+    bounds.min = center - extent;
+    bounds.max = center + extent;
+    return bounds;
+}
+
+// Tests objects [first, first + count) against the planes in plane_mask and
+// appends ids[slot] (or the slot itself without ids) of those not fully outside.
+static void CullRange(const BoundsSoA& bounds, uint32_t first, uint32_t count, const Frustum& frustum,
+    uint32_t plane_mask, const uint32_t* ids, std::vector<uint32_t>& visible)
+{
+#if SKELETAL_SSE
+    uint32_t end = first + count;
+    for (uint32_t slot = first; slot < end; slot += 4)
+    {
+        __m128 cx = _mm_loadu_ps(&bounds.cx[slot]);
+        __m128 cy = _mm_loadu_ps(&bounds.cy[slot]);
+        __m128 cz = _mm_loadu_ps(&bounds.cz[slot]);
+        __m128 ex = _mm_loadu_ps(&bounds.ex[slot]);
+        __m128 ey = _mm_loadu_ps(&bounds.ey[slot]);
+        __m128 ez = _mm_loadu_ps(&bounds.ez[slot]);
+
+        // lanes past the end start out culled
+        uint32_t lanes = SDL_min(end - slot, 4u);
+        int inside = (1 << lanes) - 1;
+        for (uint32_t p = 0; p < Frustum::PLANE_COUNT && inside; p++)
+        {
+            if (!(plane_mask & (1u << p)))
+                continue;
+            const glm::vec4& plane = frustum.planes[p];
+            __m128 distance = SKELETAL_MADD(cx, _mm_set1_ps(plane.x),
+                              SKELETAL_MADD(cy, _mm_set1_ps(plane.y),
+                              SKELETAL_MADD(cz, _mm_set1_ps(plane.z), _mm_set1_ps(plane.w))));
+            __m128 radius = SKELETAL_MADD(ex, _mm_set1_ps(SDL_fabsf(plane.x)),
+                            SKELETAL_MADD(ey, _mm_set1_ps(SDL_fabsf(plane.y)),
+                            _mm_mul_ps(ez, _mm_set1_ps(SDL_fabsf(plane.z)))));
+            __m128 outside = _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps());
+            inside &= ~_mm_movemask_ps(outside);
+        }
+
+        while (inside)
+        {
+            int lane = SDL_MostSignificantBitIndex32(inside & -inside);
+            inside &= inside - 1;
+            visible.push_back(ids ? ids[slot + lane] : slot + lane);
+        }
+    }
+#else
+    for (uint32_t slot = first; slot < first + count; slot++)
+    {
+        bool inside = true;
+        for (uint32_t p = 0; p < Frustum::PLANE_COUNT && inside; p++)
+        {
+            if (!(plane_mask & (1u << p)))
+                continue;
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = bounds.cx[slot] * plane.x + bounds.cy[slot] * plane.y + bounds.cz[slot] * plane.z + plane.w;
+            float radius = bounds.ex[slot] * SDL_fabsf(plane.x) + bounds.ey[slot] * SDL_fabsf(plane.y) + bounds.ez[slot] * SDL_fabsf(plane.z);
+            inside = distance + radius >= 0.0f;
+        }
+        if (inside)
+            visible.push_back(ids ? ids[slot] : slot);
+    }
+#endif
+}
+
+static const uint32_t kAllPlanes = (1u << Frustum::PLANE_COUNT) - 1;
+
+void CullBounds(const BoundsSoA& bounds, const Frustum& frustum, std::vector<uint32_t>& visible)
+{
+    CullRange(bounds, 0, bounds.Size(), frustum, kAllPlanes, nullptr, visible);
+}
+
+// spreads the low 10 bits of v so that there are two zero bits between each
+static inline uint32_t ExpandBits(uint32_t v)
+{
+    v = (v * 0x00010001u) & 0xFF0000FFu;
+    v = (v * 0x00000101u) & 0x0F00F00Fu;
+    v = (v * 0x00000011u) & 0xC30C30C3u;
+    v = (v * 0x00000005u) & 0x49249249u;
+    return v;
+}
+
+static inline uint32_t Morton3D(const glm::vec3& unit)
+{
+    glm::vec3 scaled = glm::clamp(unit * 1024.0f, 0.0f, 1023.0f);
+    return ExpandBits((uint32_t)scaled.x) << 2 | ExpandBits((uint32_t)scaled.y) << 1 | ExpandBits((uint32_t)scaled.z);
+}
+
+void Bvh::Build(const Aabb* bounds, uint32_t count)
+{
+    nodes.clear();
+    objects.Resize(count);
+    object_ids.resize(count);
+    slots.resize(count);
+    codes.resize(count);
+    if (count == 0)
+        return;
+
+    Aabb centers;
+    for (uint32_t i = 0; i < count; i++)
+        centers.Merge(bounds[i].Center());
+    glm::vec3 scale = 1.0f / glm::max(centers.max - centers.min, glm::vec3(1e-6f));
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        codes[i] = Morton3D((bounds[i].Center() - centers.min) * scale);
+        object_ids[i] = i;
+    }
+    // only the low four bytes are populated, the radix sort skips the rest
+    RadixSort(codes, object_ids, scratch_codes, scratch_ids);
+
+    for (uint32_t slot = 0; slot < count; slot++)
+    {
+        slots[object_ids[slot]] = slot;
+        objects.Set(slot, bounds[object_ids[slot]]);
+    }
+
+    // uneven splits leave many leaves below kLeafSize, this is only a starting guess
+    nodes.reserve(4 * (count / kLeafSize + 1));
+    BuildNode(0, count - 1);
+}
+
+uint32_t Bvh::BuildNode(uint32_t first, uint32_t last)
+{
+    uint32_t index = (uint32_t)nodes.size();
+    nodes.emplace_back();
+    uint32_t count = last - first + 1;
+
+    Node node{};
+    node.first = first;
+    node.count = count;
+
+    if (count <= kLeafSize)
+    {
+        Aabb bounds = SlotBounds(first, count);
+        node.center = bounds.Center();
+        node.extent = bounds.Extent();
+        nodes[index] = node;
+        return index;
+    }
+
+    // split where the highest bit differing between first and last flips,
+    // identical codes fall back to the middle
+    uint32_t split = (first + last) / 2;
+    uint64_t first_code = codes[first];
+    uint64_t last_code = codes[last];
+    if (first_code != last_code)
+    {
+        int prefix = SDL_MostSignificantBitIndex32((uint32_t)(first_code ^ last_code));
+        uint64_t mask = ~0ull << prefix;
+        // binary search for the last code sharing first's prefix up to and including that bit
+        uint32_t lo = first, hi = last;
+        while (lo + 1 < hi)
+        {
+            uint32_t mid = (lo + hi) / 2;
+            if ((codes[mid] & mask) == (first_code & mask))
+                lo = mid;
+            else
+                hi = mid;
+        }
+        split = lo;
+    }
+
+    BuildNode(first, split);
+    node.right = BuildNode(split + 1, last);
+
+    Aabb bounds;
+    const Node& left = nodes[index + 1];
+    const Node& right = nodes[node.right];
+    bounds.Merge(left.center - left.extent);
+    bounds.Merge(left.center + left.extent);
+    bounds.Merge(right.center - right.extent);
+    bounds.Merge(right.center + right.extent);
+    node.center = bounds.Center();
+    node.extent = bounds.Extent();
+    nodes[index] = node;
+    return index;
+}
+
+Aabb Bvh::SlotBounds(uint32_t first, uint32_t count) const
+{
+    // straight over the SoA arrays, this is the inner loop of Refit
+    float min_x = FLT_MAX, min_y = FLT_MAX, min_z = FLT_MAX;
+    float max_x = -FLT_MAX, max_y = -FLT_MAX, max_z = -FLT_MAX;
+    for (uint32_t slot = first; slot < first + count; slot++)
+    {
+        min_x = SDL_min(min_x, objects.cx[slot] - objects.ex[slot]);
+        min_y = SDL_min(min_y, objects.cy[slot] - objects.ey[slot]);
+        min_z = SDL_min(min_z, objects.cz[slot] - objects.ez[slot]);
+        max_x = SDL_max(max_x, objects.cx[slot] + objects.ex[slot]);
+        max_y = SDL_max(max_y, objects.cy[slot] + objects.ey[slot]);
+        max_z = SDL_max(max_z, objects.cz[slot] + objects.ez[slot]);
+    }
+    Aabb bounds;
+    bounds.min = glm::vec3(min_x, min_y, min_z);
+    bounds.max = glm::vec3(max_x, max_y, max_z);
+    return bounds;
+}
+
+void Bvh::Update(uint32_t object, const Aabb& bounds)
+{
+    objects.Set(slots[object], bounds);
+}
+
+void Bvh::Refit()
+{
+    // children always come after their parent, walking backwards visits them first
+    for (uint32_t i = (uint32_t)nodes.size(); i-- > 0;)
+    {
+        Node& node = nodes[i];
+        Aabb bounds;
+        if (node.right == 0)
+        {
+            bounds = SlotBounds(node.first, node.count);
+        }
+        else
+        {
+            const Node& left = nodes[i + 1];
+            const Node& right = nodes[node.right];
+            bounds.Merge(left.center - left.extent);
+            bounds.Merge(left.center + left.extent);
+            bounds.Merge(right.center - right.extent);
+            bounds.Merge(right.center + right.extent);
+        }
+        node.center = bounds.Center();
+        node.extent = bounds.Extent();
+    }
+}
+
+void Bvh::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+{
+    if (nodes.empty())
+        return;
+
+    // planes a node is completely inside of are dropped for its whole subtree
+    struct Entry
+    {
+        uint32_t node;
+        uint32_t plane_mask;
+    };
+
+    // depth is bounded by the 30 code bits plus log2 of the longest run of equal codes
+    Entry stack[128];
+    uint32_t depth = 0;
+    stack[depth++] = { 0, kAllPlanes };
+
+    while (depth)
+    {
+        Entry entry = stack[--depth];
+        const Node& node = nodes[entry.node];
+
+        uint32_t plane_mask = entry.plane_mask;
+        bool outside = false;
+        for (uint32_t p = 0; p < Frustum::PLANE_COUNT; p++)
+        {
+            if (!(plane_mask & (1u << p)))
+                continue;
+            const glm::vec4& plane = frustum.planes[p];
+            float distance = glm::dot(glm::vec3(plane), node.center) + plane.w;
+            float radius = glm::dot(glm::abs(glm::vec3(plane)), node.extent);
+            if (distance + radius < 0.0f)
+            {
+                outside = true;
+                break;
+            }
+            if (distance - radius >= 0.0f)
+                plane_mask &= ~(1u << p);
+        }
+        if (outside)
+            continue;
+
+        if (plane_mask == 0)
+        {
+            // fully inside, the whole subtree is a contiguous run of slots
+            visible.insert(visible.end(), object_ids.begin() + node.first, object_ids.begin() + node.first + node.count);
+        }
+        else if (node.right == 0)
+        {
+            CullRange(objects, node.first, node.count, frustum, plane_mask, object_ids.data(), visible);
+        }
+        else
+        {
+            // right first so the left subtree is visited first, keeping output in slot order
+            SDL_assert(depth + 2 <= SDL_arraysize(stack));
+            stack[depth++] = { node.right, plane_mask };
+            stack[depth++] = { entry.node + 1, plane_mask };
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "bounds.h"
+
+// Object bounds as center / half extent in SoA, padded so SIMD loads of four
+// may run past the last object.
+struct BoundsSoA
+{
+    std::vector<float> cx, cy, cz;
+    std::vector<float> ex, ey, ez;
+
+    void Resize(uint32_t count);
+    void Set(uint32_t index, const Aabb& bounds);
+    Aabb Get(uint32_t index) const;
+    uint32_t Size() const { return count; }
+
+private:
+    uint32_t count = 0;
+};
+
+// Flat SIMD frustum test of every object, appends the indices that are at least partially inside.
+void CullBounds(const BoundsSoA& bounds, const Frustum& frustum, std::vector<uint32_t>& visible);
+
+// Linear BVH over object AABBs. Objects are sorted along a 30-bit Morton curve
+// of their centers and the tree is split at the highest differing code bit, so
+// every subtree covers a contiguous run of objects. Nodes are stored depth
+// first (left child follows its parent) and objects are kept in Morton order,
+// which keeps traversal and leaf tests walking forward in memory.
+//
+// Moving objects call Update and then Refit, which keeps the topology and
+// recomputes node bounds bottom-up. Rebuild when objects move far enough for
+// the tree quality to suffer.
+class Bvh
+{
+public:
+    static const uint32_t kLeafSize = 8;
+
+    void Build(const Aabb* bounds, uint32_t count);
+    void Update(uint32_t object, const Aabb& bounds);
+    void Refit();
+
+    // appends the ids of objects intersecting the frustum, in tree order
+    void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+    uint32_t ObjectCount() const { return (uint32_t)object_ids.size(); }
+    uint32_t NodeCount() const { return (uint32_t)nodes.size(); }
+
+private:
+    struct Node
+    {
+        glm::vec3 center;
+        uint32_t first;             // first object slot of the subtree
+        glm::vec3 extent;
+        uint32_t count;             // objects in the subtree
+        uint32_t right;             // right child, 0 for leaves (the root is never a right child)
+    };
+
+    uint32_t BuildNode(uint32_t first, uint32_t last);
+    Aabb SlotBounds(uint32_t first, uint32_t count) const;
+
+    std::vector<Node> nodes;
+    BoundsSoA objects;              // by slot, Morton order
+    std::vector<uint32_t> object_ids;   // slot -> object
+    std::vector<uint32_t> slots;        // object -> slot
+    std::vector<uint64_t> codes;        // Morton code by slot, used while building
+    std::vector<uint64_t> scratch_codes;
+    std::vector<uint32_t> scratch_ids;
+};
@@ -0,0 +1,29 @@
+#include "camera.h"
+
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+glm::mat4 Camera::View() const
+{
+    return glm::lookAt(position, target, up);
+}
+
+glm::mat4 Camera::Projection() const
+{
+    return glm::perspectiveRH_ZO(fov_y, aspect, near_plane, far_plane);
+}
+
+void Camera::Frame(const Aabb& bounds)
+{
+    if (bounds.IsEmpty())
+        return;
+
+    glm::vec3 forward = Forward();
+    float radius = glm::length(bounds.Extent());
+    float distance = radius / std::sin(fov_y * 0.5f);
+
+    target = bounds.Center();
+    position = target - forward * distance;
+    near_plane = glm::max(distance - radius, distance * 0.001f) * 0.5f;
+    far_plane = (distance + radius) * 2.0f;
+}
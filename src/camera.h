@@ -0,0 +1,24 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "bounds.h"
+
+// Right handed look-at camera with a [0, 1] depth range perspective projection.
+struct Camera
+{
+    glm::vec3 position = glm::vec3(0.0f, 0.0f, 1.5f);
+    glm::vec3 target = glm::vec3(0.0f);
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    float fov_y = glm::radians(60.0f);
+    float aspect = 16.0f / 9.0f;
+    float near_plane = 0.05f;
+    float far_plane = 1000.0f;
+
+    glm::mat4 View() const;
+    glm::mat4 Projection() const;
+    glm::mat4 ViewProjection() const { return Projection() * View(); }
+    glm::vec3 Forward() const { return glm::normalize(target - position); }
+
+    // moves back along the current view direction until bounds fit the vertical field of view
+    void Frame(const Aabb& bounds);
+};
@@ -0,0 +1,570 @@
+#include "clip_compression.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace anim
+{
+    static const uint32_t kClipMagic = 0x50494C43; // "CLIP"
+    // smallest-three components lie within +-1/sqrt(2)
+    static const float kRotationRange = 0.70710678f;
+
+    struct KeyValue
+    {
+        uint16_t q[3];
+    };
+
+    static uint16_t QuantizeUnit(float value, float scale)
+    {
+        value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+        return (uint16_t)lrintf(value * scale);
+    }
+
+    static KeyValue EncodeRotation(glm::vec4 q)
+    {
+        float length = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z + q.w * q.w);
+        q = length > 0.0f ? q / length : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        int largest = 0;
+        for (int i = 1; i < 4; i++)
+        {
+            if (fabsf(q[i]) > fabsf(q[largest]))
+                largest = i;
+        }
+        // q and -q are the same rotation, the dropped component is rebuilt as positive
+        if (q[largest] < 0.0f)
+            q = -q;
+
+        KeyValue value;
+        int c = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            if (i != largest)
+                value.q[c++] = QuantizeUnit((q[i] + kRotationRange) / (2.0f * kRotationRange), 32767.0f);
+        }
+        // the index of the dropped component goes in the spare top bits
+        value.q[0] |= (uint16_t)((largest >> 1) << 15);
+        value.q[1] |= (uint16_t)((largest & 1) << 15);
+        return value;
+    }
+
+    static glm::vec4 DecodeRotation(const uint16_t q[3])
+    {
+        int largest = ((q[0] >> 15) << 1) | (q[1] >> 15);
+        float a = (q[0] & 0x7FFF) * (2.0f * kRotationRange / 32767.0f) - kRotationRange;
+        float b = (q[1] & 0x7FFF) * (2.0f * kRotationRange / 32767.0f) - kRotationRange;
+        float c = q[2] * (2.0f * kRotationRange / 32767.0f) - kRotationRange;
+        float d = sqrtf(std::max(1.0f - a * a - b * b - c * c, 0.0f));
+        switch (largest)
+        {
+        case 0: return glm::vec4(d, a, b, c);
+        case 1: return glm::vec4(a, d, b, c);
+        case 2: return glm::vec4(a, b, d, c);
+        default: return glm::vec4(a, b, c, d);
+        }
+    }
+
+    static KeyValue EncodeRange(const glm::vec4& v, const CompressedRange& range)
+    {
+        KeyValue value;
+        for (int i = 0; i < 3; i++)
+            value.q[i] = range.extent[i] > 0.0f ? QuantizeUnit((v[i] - range.min[i]) / range.extent[i], 65535.0f) : 0;
+        return value;
+    }
+
+    static glm::vec4 DecodeRange(const uint16_t q[3], const CompressedRange& range)
+    {
+        return glm::vec4(range.min[0] + q[0] * (range.extent[0] / 65535.0f), range.min[1] + q[1] * (range.extent[1] / 65535.0f),
+            range.min[2] + q[2] * (range.extent[2] / 65535.0f), 0.0f);
+    }
+
+    static float DecodeTime(uint16_t q, const CompressedChunk& chunk)
+    {
+        return chunk.time_origin + q * chunk.time_scale;
+    }
+
+    // exactly what SampleClip does between two keys
+    static glm::vec4 Interpolate(uint32_t type, const glm::vec4& a, const glm::vec4& b, float f)
+    {
+        if (type != TRACK_ROTATION)
+            return a * (1.0f - f) + b * f;
+        float fb = glm::dot(a, b) < 0.0f ? -f : f;
+        glm::vec4 value = a * (1.0f - f) + b * fb;
+        return value / sqrtf(glm::dot(value, value));
+    }
+
+    static float KeyError(uint32_t type, const glm::vec4& a, const glm::vec4& b)
+    {
+        if (type == TRACK_TRANSLATION)
+            return glm::length(glm::vec3(a) - glm::vec3(b));
+        if (type == TRACK_ROTATION)
+        {
+            // acos of the dot product loses everything below ~1e-3 radians in float
+            glm::vec4 na = a / glm::length(a), nb = b / glm::length(b);
+            if (glm::dot(na, nb) < 0.0f)
+                nb = -nb;
+            return 4.0f * atan2f(glm::length(na - nb), glm::length(na + nb));
+        }
+        glm::vec3 d = glm::abs(glm::vec3(a) - glm::vec3(b));
+        return std::max(d.x, std::max(d.y, d.z));
+    }
+
+    // Greedy: every kept key reaches as far ahead as the dropped keys in between allow
+    static void ReduceKeys(uint32_t type, const float* times, const glm::vec4* source, const glm::vec4* decoded, uint32_t count,
+        float tolerance, std::vector<uint32_t>& kept)
+    {
+        kept.clear();
+        kept.push_back(0);
+        bool constant = true;
+        for (uint32_t i = 1; i < count && constant; i++)
+            constant = KeyError(type, decoded[0], source[i]) <= tolerance;
+        if (constant)
+            return;
+
+        auto Fits = [&](uint32_t a, uint32_t b)
+        {
+            float span = times[b] - times[a];
+            for (uint32_t i = a + 1; i < b; i++)
+            {
+                float f = span > 0.0f ? (times[i] - times[a]) / span : 0.0f;
+                if (KeyError(type, Interpolate(type, decoded[a], decoded[b], f), source[i]) > tolerance)
+                    return false;
+            }
+            return true;
+        };
+
+        uint32_t a = 0;
+        while (a + 1 < count)
+        {
+            uint32_t b = a + 1;
+            while (b + 1 < count && Fits(a, b + 1))
+                b++;
+            kept.push_back(b);
+            a = b;
+        }
+    }
+
+    // The key period when every key sits on one regular grid, as sampled and mocap
+    // clips do, 0 otherwise. Times are then stored as exact frame numbers
+    static float FindFramePeriod(const AnimationClip& clip)
+    {
+        float period = FLT_MAX;
+        for (uint32_t t = 0; t < clip.TrackCount(); t++)
+        {
+            for (uint32_t k = clip.key_offsets[t] + 1; k < clip.key_offsets[t + 1]; k++)
+            {
+                float delta = clip.times[k] - clip.times[k - 1];
+                if (delta > 0.0f)
+                    period = std::min(period, delta);
+            }
+        }
+        if (period == FLT_MAX)
+            return 0.0f;
+        // a difference of two late times is off by their ulp, far too much to count thousands
+        // of frames with. Refine over a few hundred frames first, then over the whole clip
+        for (float limit : { 500.0f * period, FLT_MAX })
+        {
+            float reference = 0.0f;
+            for (float time : clip.times)
+                reference = time <= limit ? std::max(reference, time) : reference;
+            if (reference > 0.0f)
+                period = reference / roundf(reference / period);
+        }
+        for (float time : clip.times)
+        {
+            float frames = time / period;
+            if (fabsf(frames - roundf(frames)) > 1e-3f)
+                return 0.0f;
+        }
+        return period;
+    }
+
+    uint32_t CompressedClip::ChunkAt(float time) const
+    {
+        // chunks are sorted and touch, the last one starting at or before time
+        const CompressedChunk* end = chunks + header->chunk_count;
+        const CompressedChunk* chunk = std::upper_bound(chunks, end, time,
+            [](float t, const CompressedChunk& c) { return t < c.start; });
+        return chunk == chunks ? 0 : (uint32_t)(chunk - chunks - 1);
+    }
+
+    size_t CompressedClip::ChunkOffset(uint32_t chunk) const
+    {
+        return (size_t)((const uint8_t*)(keys + chunks[chunk].first_key) - (const uint8_t*)header);
+    }
+
+    size_t CompressedClip::ChunkSize(uint32_t chunk) const
+    {
+        return (size_t)chunks[chunk].key_count * sizeof(CompressedKey);
+    }
+
+    void CompressedCursor::Reset(const CompressedClip& clip)
+    {
+        tracks.assign(clip.TrackCount(), TrackState{});
+        chunk = UINT32_MAX;
+        next_key = 0;
+        time = 0.0f;
+    }
+
+    bool CompressClip(const AnimationClip& clip, const CompressionSettings& settings, std::vector<uint8_t>& out,
+        CompressionStats* stats)
+    {
+        CompressionStats local;
+        local.source_bytes = clip.times.size() * sizeof(float) + clip.values.size() * sizeof(glm::vec4)
+            + clip.key_offsets.size() * sizeof(uint32_t);
+
+        // keys surviving the reduction, per track with keys
+        std::vector<CompressedTrack> tracks;
+        std::vector<float> quantization_budgets;        // per track with ranges
+        std::vector<std::vector<float>> track_times;
+        std::vector<std::vector<glm::vec4>> track_values;
+        std::vector<glm::vec4> source, decoded;
+        std::vector<uint32_t> kept;
+        uint32_t range_count = 0;
+        for (uint32_t t = 0; t < clip.TrackCount(); t++)
+        {
+            uint32_t begin = clip.key_offsets[t];
+            uint32_t count = clip.key_offsets[t + 1] - begin;
+            if (count == 0)
+                continue;
+            if (tracks.size() == 0xFFFF || t / TRACK_COUNT > 0xFFFF)
+            {
+                SDL_Log("Cannot compress clip %s: too many tracks", clip.name.c_str());
+                return false;
+            }
+
+            CompressedTrack track{};
+            track.joint = (uint16_t)(t / TRACK_COUNT);
+            track.type = (uint16_t)(t % TRACK_COUNT);
+            const float* times = clip.times.data() + begin;
+            source.assign(clip.values.begin() + begin, clip.values.begin() + begin + count);
+            if (track.type == TRACK_ROTATION)
+            {
+                // smallest-three does not depend on the chunk, so interpolation starts from
+                // the values playback will decode and quantization counts against the bound.
+                // Where quantization alone exceeds it, the bound becomes what it allows
+                float tolerance = settings.rotation_error;
+                float quantization_error = 0.0f;
+                decoded.resize(count);
+                for (uint32_t k = 0; k < count; k++)
+                {
+                    source[k] /= sqrtf(glm::dot(source[k], source[k]));
+                    decoded[k] = DecodeRotation(EncodeRotation(source[k]).q);
+                    quantization_error = std::max(quantization_error, KeyError(track.type, decoded[k], source[k]));
+                }
+                if (quantization_error > tolerance)
+                {
+                    local.range_limited_tracks++;
+                    tolerance = quantization_error;
+                }
+                ReduceKeys(track.type, times, source.data(), decoded.data(), count, tolerance, kept);
+            }
+            else
+            {
+                // ranges are only known per chunk once keys are dropped: the reduction takes
+                // three quarters of the bound and leaves the rest to quantization
+                float tolerance = track.type == TRACK_TRANSLATION ? settings.translation_error : settings.scale_error;
+                track.range = range_count++;
+                quantization_budgets.push_back(0.25f * tolerance);
+                ReduceKeys(track.type, times, source.data(), source.data(), count, 0.75f * tolerance, kept);
+            }
+            local.tracks++;
+            local.constant_tracks += kept.size() == 1;
+            local.source_keys += count;
+            local.kept_keys += (uint32_t)kept.size();
+
+            tracks.push_back(track);
+            track_times.emplace_back();
+            track_values.emplace_back();
+            for (uint32_t k : kept)
+            {
+                track_times.back().push_back(times[k]);
+                track_values.back().push_back(source[k]);
+            }
+        }
+
+        float duration = std::max(clip.duration, 0.0f);
+        float frame_period = FindFramePeriod(clip);
+        float chunk_seconds = settings.chunk_seconds > 0.0f ? settings.chunk_seconds : std::max(duration, 1.0f);
+        uint32_t chunk_count = std::max((uint32_t)ceilf(duration / chunk_seconds), 1u);
+
+        struct SortedKey
+        {
+            float need;         // time playback first needs the key at
+            uint32_t track;
+            uint32_t index;     // into the track's kept keys
+            uint16_t time;
+        };
+        std::vector<CompressedChunk> chunks(chunk_count);
+        std::vector<CompressedRange> ranges((size_t)chunk_count * range_count);
+        std::vector<CompressedKey> keys;
+        std::vector<SortedKey> sorted;
+        std::vector<uint32_t> first(tracks.size()), last(tracks.size());
+        std::vector<bool> limited(tracks.size(), false);
+        for (uint32_t c = 0; c < chunk_count; c++)
+        {
+            CompressedChunk& chunk = chunks[c];
+            chunk.start = c * chunk_seconds;
+            chunk.end = c + 1 == chunk_count ? duration : (c + 1) * chunk_seconds;
+            CompressedRange* chunk_ranges = ranges.data() + (size_t)c * range_count;
+
+            // every track's keys from the one in effect at the start to the first at or past the end
+            float lo = FLT_MAX, hi = -FLT_MAX;
+            for (uint32_t t = 0; t < tracks.size(); t++)
+            {
+                const std::vector<float>& times = track_times[t];
+                uint32_t count = (uint32_t)times.size();
+                uint32_t f = (uint32_t)(std::upper_bound(times.begin(), times.end(), chunk.start) - times.begin());
+                first[t] = f > 0 ? f - 1 : 0;
+                uint32_t l = (uint32_t)(std::lower_bound(times.begin(), times.end(), chunk.end) - times.begin());
+                last[t] = std::min(l, count - 1);
+                lo = std::min(lo, times[first[t]]);
+                hi = std::max(hi, times[last[t]]);
+
+                const CompressedTrack& track = tracks[t];
+                if (track.type == TRACK_ROTATION)
+                    continue;
+                glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+                for (uint32_t k = first[t]; k <= last[t]; k++)
+                {
+                    min = glm::min(min, glm::vec3(track_values[t][k]));
+                    max = glm::max(max, glm::vec3(track_values[t][k]));
+                }
+                CompressedRange& range = chunk_ranges[track.range];
+                for (int i = 0; i < 3; i++)
+                {
+                    range.min[i] = min[i];
+                    range.extent[i] = max[i] - min[i];
+                }
+                glm::vec3 half_step = (max - min) * (0.5f / 65535.0f);
+                float quantization_error = track.type == TRACK_TRANSLATION ? glm::length(half_step)
+                    : std::max(half_step.x, std::max(half_step.y, half_step.z));
+                if (quantization_error > quantization_budgets[track.range] && !limited[t])
+                {
+                    limited[t] = true;
+                    local.range_limited_tracks++;
+                }
+            }
+            // frame numbers where keys are on a grid, spreading 16 bits over the chunk's keys
+            // would cost a fast joint its precision: 2 s at 3 rad/s is 1e-4 radians per step
+            if (tracks.empty())
+            {
+                chunk.time_origin = chunk.start;
+                chunk.time_scale = 0.0f;
+            }
+            else if (frame_period > 0.0f && (hi - lo) / frame_period < 65535.0f)
+            {
+                chunk.time_origin = roundf(lo / frame_period) * frame_period;
+                chunk.time_scale = frame_period;
+            }
+            else
+            {
+                chunk.time_origin = lo;
+                chunk.time_scale = (hi - lo) / 65535.0f;
+            }
+
+            sorted.clear();
+            for (uint32_t t = 0; t < tracks.size(); t++)
+            {
+                float previous = -FLT_MAX;
+                for (uint32_t k = first[t]; k <= last[t]; k++)
+                {
+                    float scaled = chunk.time_scale > 0.0f ? (track_times[t][k] - chunk.time_origin) / chunk.time_scale : 0.0f;
+                    uint16_t time = (uint16_t)std::min(std::max(lrintf(scaled), 0l), 65535l);
+                    // the first two keys of a track are needed right away, each later one once
+                    // playback passes the key before it, in the decoded time the sampler compares
+                    sorted.push_back({ k - first[t] < 2 ? -FLT_MAX : previous, t, k, time });
+                    previous = DecodeTime(time, chunk);
+                }
+            }
+            std::sort(sorted.begin(), sorted.end(), [](const SortedKey& a, const SortedKey& b)
+            {
+                if (a.need != b.need)
+                    return a.need < b.need;
+                return a.track != b.track ? a.track < b.track : a.index < b.index;
+            });
+
+            chunk.first_key = (uint32_t)keys.size();
+            chunk.key_count = (uint32_t)sorted.size();
+            for (const SortedKey& s : sorted)
+            {
+                const CompressedTrack& track = tracks[s.track];
+                const glm::vec4& v = track_values[s.track][s.index];
+                KeyValue value = track.type == TRACK_ROTATION ? EncodeRotation(v) : EncodeRange(v, chunk_ranges[track.range]);
+                keys.push_back({ (uint16_t)s.track, s.time, { value.q[0], value.q[1], value.q[2] } });
+            }
+        }
+        local.stored_keys = (uint32_t)keys.size();
+
+        CompressedHeader header{};
+        header.magic = kClipMagic;
+        header.duration = duration;
+        header.joint_count = clip.joint_count;
+        header.track_count = (uint32_t)tracks.size();
+        header.range_count = range_count;
+        header.chunk_count = chunk_count;
+        header.key_count = (uint32_t)keys.size();
+
+        size_t size = sizeof(header) + tracks.size() * sizeof(CompressedTrack) + chunks.size() * sizeof(CompressedChunk)
+            + ranges.size() * sizeof(CompressedRange) + keys.size() * sizeof(CompressedKey);
+        out.assign(size, 0);
+        uint8_t* write = out.data();
+        SDL_memcpy(write, &header, sizeof(header));
+        write += sizeof(header);
+        if (!tracks.empty())
+            SDL_memcpy(write, tracks.data(), tracks.size() * sizeof(CompressedTrack));
+        write += tracks.size() * sizeof(CompressedTrack);
+        SDL_memcpy(write, chunks.data(), chunks.size() * sizeof(CompressedChunk));
+        write += chunks.size() * sizeof(CompressedChunk);
+        if (!ranges.empty())
+            SDL_memcpy(write, ranges.data(), ranges.size() * sizeof(CompressedRange));
+        write += ranges.size() * sizeof(CompressedRange);
+        if (!keys.empty())
+            SDL_memcpy(write, keys.data(), keys.size() * sizeof(CompressedKey));
+
+        local.compressed_bytes = size;
+        if (stats)
+            *stats = local;
+        return true;
+    }
+
+    CompressedClip ViewCompressedClip(const void* data, size_t size)
+    {
+        CompressedClip clip;
+        const CompressedHeader* header = (const CompressedHeader*)data;
+        if (!data || size < sizeof(CompressedHeader) || header->magic != kClipMagic || header->chunk_count == 0)
+            return clip;
+        size_t expected = sizeof(CompressedHeader) + (size_t)header->track_count * sizeof(CompressedTrack)
+            + (size_t)header->chunk_count * sizeof(CompressedChunk)
+            + (size_t)header->chunk_count * header->range_count * sizeof(CompressedRange)
+            + (size_t)header->key_count * sizeof(CompressedKey);
+        if (expected > size)
+            return clip;
+
+        if (!std::isfinite(header->duration) || header->duration < 0.0f)
+            return clip;
+
+        const CompressedTrack* tracks = (const CompressedTrack*)(header + 1);
+        const CompressedChunk* chunks = (const CompressedChunk*)(tracks + header->track_count);
+        const CompressedRange* ranges = (const CompressedRange*)(chunks + header->chunk_count);
+        const CompressedKey* keys = (const CompressedKey*)(ranges + (size_t)header->chunk_count * header->range_count);
+        for (uint32_t t = 0; t < header->track_count; t++)
+        {
+            if (tracks[t].type >= TRACK_COUNT || (tracks[t].type != TRACK_ROTATION && tracks[t].range >= header->range_count))
+                return clip;
+        }
+        // ChunkAt searches the chunks by start time, they have to be in order from 0, and every
+        // key a chunk decodes has to name a track and land on a finite time
+        for (uint32_t c = 0; c < header->chunk_count; c++)
+        {
+            const CompressedChunk& chunk = chunks[c];
+            if ((uint64_t)chunk.first_key + chunk.key_count > header->key_count)
+                return clip;
+            if (!(chunk.start >= (c > 0 ? chunks[c - 1].start : 0.0f) && chunk.start <= chunk.end)
+                || !std::isfinite(chunk.end))
+                return clip;
+            if (!std::isfinite(chunk.time_origin) || !(chunk.time_scale >= 0.0f)
+                || !std::isfinite(DecodeTime(65535, chunk)))
+                return clip;
+            for (uint32_t k = chunk.first_key; k < chunk.first_key + chunk.key_count; k++)
+            {
+                if (keys[k].track >= header->track_count)
+                    return clip;
+            }
+        }
+        clip.header = header;
+        clip.tracks = tracks;
+        clip.chunks = chunks;
+        clip.ranges = ranges;
+        clip.keys = keys;
+        return clip;
+    }
+
+    void SampleCompressedClip(const CompressedClip& clip, float time, CompressedCursor& cursor, const LocalPose& bind_pose,
+        LocalPose& pose)
+    {
+        if (cursor.tracks.size() != clip.TrackCount())
+            cursor.Reset(clip);
+        if (pose.joint_count != bind_pose.joint_count)
+            pose.Resize(bind_pose.joint_count);
+
+        time = time < 0.0f ? 0.0f : (time > clip.Duration() ? clip.Duration() : time);
+        uint32_t chunk_index = clip.ChunkAt(time);
+        if (chunk_index != cursor.chunk || time < cursor.time)
+        {
+            // a chunk decodes on its own from its first key
+            cursor.chunk = chunk_index;
+            cursor.next_key = 0;
+            for (CompressedCursor::TrackState& state : cursor.tracks)
+                state.keys = 0;
+        }
+        cursor.time = time;
+
+        // take in every key playback has reached, the stream is in the order they are needed
+        const CompressedChunk& chunk = clip.chunks[chunk_index];
+        const CompressedKey* keys = clip.keys + chunk.first_key;
+        const CompressedRange* ranges = clip.ranges + (size_t)chunk_index * clip.header->range_count;
+        while (cursor.next_key < chunk.key_count)
+        {
+            const CompressedKey& key = keys[cursor.next_key];
+            CompressedCursor::TrackState& state = cursor.tracks[key.track];
+            if (state.keys >= 2 && state.times[1] > time)
+                break;
+            float key_time = DecodeTime(key.time, chunk);
+            const CompressedTrack& track = clip.tracks[key.track];
+            glm::vec4 value = track.type == TRACK_ROTATION ? DecodeRotation(key.value)
+                : DecodeRange(key.value, ranges[track.range]);
+            if (state.keys == 0)
+            {
+                state.times[0] = key_time;
+                state.values[0] = value;
+            }
+            else
+            {
+                state.times[0] = state.times[1];
+                state.values[0] = state.values[1];
+            }
+            state.times[1] = key_time;
+            state.values[1] = value;
+            state.keys++;
+            cursor.next_key++;
+        }
+
+        // joints and tracks the clip doesn't cover stay in bind pose
+        pose.tx = bind_pose.tx; pose.ty = bind_pose.ty; pose.tz = bind_pose.tz;
+        pose.rx = bind_pose.rx; pose.ry = bind_pose.ry; pose.rz = bind_pose.rz; pose.rw = bind_pose.rw;
+        pose.sx = bind_pose.sx; pose.sy = bind_pose.sy; pose.sz = bind_pose.sz;
+
+        for (uint32_t t = 0; t < clip.TrackCount(); t++)
+        {
+            const CompressedTrack& track = clip.tracks[t];
+            const CompressedCursor::TrackState& state = cursor.tracks[t];
+            if (track.joint >= pose.joint_count || state.keys == 0)
+                continue;
+
+            glm::vec4 value;
+            if (state.keys == 1 || time >= state.times[1])
+                value = state.values[1];
+            else if (time <= state.times[0])
+                value = state.values[0];
+            else
+                value = Interpolate(track.type, state.values[0], state.values[1],
+                    (time - state.times[0]) / (state.times[1] - state.times[0]));
+
+            uint32_t j = track.joint;
+            switch (track.type)
+            {
+            case TRACK_TRANSLATION:
+                pose.tx[j] = value.x; pose.ty[j] = value.y; pose.tz[j] = value.z;
+                break;
+            case TRACK_ROTATION:
+                pose.rx[j] = value.x; pose.ry[j] = value.y; pose.rz[j] = value.z; pose.rw[j] = value.w;
+                break;
+            default:
+                pose.sx[j] = value.x; pose.sy[j] = value.y; pose.sz[j] = value.z;
+                break;
+            }
+        }
+    }
+}
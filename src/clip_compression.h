@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "animation.h"
+#include "pose.h"
+
+// Compressed animation clips. Every track keeps only the keys it needs to stay
+// within an error bound of the source, then values are quantized: rotations
+// as smallest-three quaternions (the largest component is dropped and rebuilt
+// from the unit length, the other three take 15 bits each), translations and
+// scales as 16 bits per component over the range the track covers in its
+// chunk, so a root travelling far keeps its precision. A key is 10 bytes
+// instead of the 20 of a float time and a vec4.
+//
+// Keys are sorted by the time playback first needs them, which is the time of
+// the key before them on the same track, so sampling forward reads the key
+// stream strictly in order and decodes every key once. The clip is cut into
+// chunks by time. A chunk repeats the key each track had at its start, so it
+// can be decoded without anything before it: seeking touches one chunk and
+// chunks can be streamed in as playback reaches them.
+//
+// A compressed clip is one contiguous blob, the same bytes in memory and in a
+// .skanim file (see anim_cache.h), so it is sampled straight from a mapping.
+namespace anim
+{
+    struct CompressionSettings
+    {
+        // largest error against the source keys, dropped keys and quantization together
+        float translation_error = 0.0001f;      // units
+        float rotation_error = 0.0002f;         // radians
+        float scale_error = 0.0001f;
+        float chunk_seconds = 2.0f;
+    };
+
+    struct CompressionStats
+    {
+        uint32_t tracks = 0;                // with keys, tracks without any keep the bind pose
+        uint32_t constant_tracks = 0;       // reduced to a single key
+        uint32_t source_keys = 0;
+        uint32_t kept_keys = 0;
+        uint32_t stored_keys = 0;           // kept keys plus those chunks repeat
+        // tracks where quantization alone exceeds the error bound in some chunk
+        uint32_t range_limited_tracks = 0;
+        size_t source_bytes = 0;            // times and values as AnimationClip holds them
+        size_t compressed_bytes = 0;
+    };
+
+    // Blob layout, native endian:
+    // CompressedHeader | CompressedTrack[] | CompressedChunk[] | CompressedRange[] | CompressedKey[]
+    struct CompressedHeader
+    {
+        uint32_t magic;
+        float duration;
+        uint32_t joint_count;
+        uint32_t track_count;
+        uint32_t range_count;   // translation and scale tracks, each has a range per chunk
+        uint32_t chunk_count;
+        uint32_t key_count;
+    };
+
+    struct CompressedTrack
+    {
+        uint16_t joint;
+        uint16_t type;          // TrackType
+        uint32_t range;         // translation and scale: chunk c's range is ranges[c * range_count + range]
+    };
+
+    // value = min + q / 65535 * extent
+    struct CompressedRange
+    {
+        float min[3];
+        float extent[3];
+    };
+
+    // keys [first_key, first_key + key_count), times are origin + q * time_scale. For
+    // clips keyed on a regular grid the scale is the key period and q the frame number
+    struct CompressedChunk
+    {
+        float start;
+        float end;
+        float time_origin;
+        float time_scale;
+        uint32_t first_key;
+        uint32_t key_count;
+    };
+
+    struct CompressedKey
+    {
+        uint16_t track;
+        uint16_t time;
+        uint16_t value[3];
+    };
+
+    // A compressed clip in memory or in a mapping, valid while its bytes are
+    struct CompressedClip
+    {
+        const CompressedHeader* header = nullptr;
+        const CompressedTrack* tracks = nullptr;
+        const CompressedChunk* chunks = nullptr;
+        const CompressedRange* ranges = nullptr;
+        const CompressedKey* keys = nullptr;
+
+        bool IsValid() const { return header != nullptr; }
+        float Duration() const { return header->duration; }
+        uint32_t TrackCount() const { return header->track_count; }
+        // the chunk playing at time, clamped to the clip
+        uint32_t ChunkAt(float time) const;
+        // where a chunk's keys are inside the blob, what a streamer has to load before playing it
+        size_t ChunkOffset(uint32_t chunk) const;
+        size_t ChunkSize(uint32_t chunk) const;
+    };
+
+    // Decoded keys of every track: the pair around the last sampled time and
+    // where the key stream continues. Sampling forward only decodes new keys;
+    // going backwards or to another chunk starts over at the chunk holding the time.
+    struct CompressedCursor
+    {
+        struct TrackState
+        {
+            float times[2];
+            glm::vec4 values[2];
+            uint32_t keys;          // decoded so far in this chunk
+        };
+
+        std::vector<TrackState> tracks;
+        uint32_t chunk = UINT32_MAX;
+        uint32_t next_key = 0;
+        float time = 0.0f;
+
+        void Reset(const CompressedClip& clip);
+    };
+
+    // Compresses clip into out, replacing its contents. The result is valid for ViewCompressedClip
+    bool CompressClip(const AnimationClip& clip, const CompressionSettings& settings, std::vector<uint8_t>& out,
+        CompressionStats* stats = nullptr);
+
+    // Checks the blob's header, sizes, chunk times and the track of every key, an invalid
+    // clip when anything is out of range
+    CompressedClip ViewCompressedClip(const void* data, size_t size);
+
+    // SampleClip for compressed clips: time is clamped, joints without tracks get the bind pose
+    void SampleCompressedClip(const CompressedClip& clip, float time, CompressedCursor& cursor, const LocalPose& bind_pose,
+        LocalPose& pose);
+}
@@ -0,0 +1,263 @@
+#include "dds.h"
+
+#include <SDL3/SDL.h>
+#include "mapped_file.h"
+#include "mipmap.h"
+
+namespace dds
+{
+    static const uint32_t kMagic = 0x20534444; // "DDS "
+
+    static const uint32_t DDSD_CAPS = 0x1;
+    static const uint32_t DDSD_HEIGHT = 0x2;
+    static const uint32_t DDSD_WIDTH = 0x4;
+    static const uint32_t DDSD_PIXELFORMAT = 0x1000;
+    static const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+    static const uint32_t DDSD_LINEARSIZE = 0x80000;
+    static const uint32_t DDPF_FOURCC = 0x4;
+    static const uint32_t DDSCAPS_COMPLEX = 0x8;
+    static const uint32_t DDSCAPS_TEXTURE = 0x1000;
+    static const uint32_t DDSCAPS_MIPMAP = 0x400000;
+
+    static constexpr uint32_t FourCC(char a, char b, char c, char d)
+    {
+        return (uint32_t)a | (uint32_t)b << 8 | (uint32_t)c << 16 | (uint32_t)d << 24;
+    }
+
+    enum DxgiFormat : uint32_t
+    {
+        DXGI_FORMAT_BC1_UNORM = 71,
+        DXGI_FORMAT_BC1_UNORM_SRGB = 72,
+        DXGI_FORMAT_BC3_UNORM = 77,
+        DXGI_FORMAT_BC3_UNORM_SRGB = 78,
+        DXGI_FORMAT_BC7_UNORM = 98,
+        DXGI_FORMAT_BC7_UNORM_SRGB = 99,
+    };
+
+    static const uint32_t kDimensionTexture2D = 3;
+
+    struct PixelFormat
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t four_cc;
+        uint32_t rgb_bit_count;
+        uint32_t masks[4];
+    };
+
+    struct Header
+    {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitch_or_linear_size;
+        uint32_t depth;
+        uint32_t mip_map_count;
+        uint32_t reserved1[11];
+        PixelFormat pixel_format;
+        uint32_t caps[4];
+        uint32_t reserved2;
+    };
+
+    struct HeaderDX10
+    {
+        uint32_t dxgi_format;
+        uint32_t resource_dimension;
+        uint32_t misc_flag;
+        uint32_t array_size;
+        uint32_t misc_flags2;
+    };
+
+    static_assert(sizeof(Header) == 124, "DDS header layout");
+    static_assert(sizeof(HeaderDX10) == 20, "DDS DX10 header layout");
+
+    static uint32_t ToDxgi(bc::Format format, bool srgb)
+    {
+        switch (format)
+        {
+        case bc::FORMAT_BC1: return srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+        case bc::FORMAT_BC3: return srgb ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
+        case bc::FORMAT_BC7: return srgb ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
+        }
+        return 0;
+    }
+
+    static bool FromDxgi(uint32_t dxgi, bc::Format& format, bool& srgb)
+    {
+        switch (dxgi)
+        {
+        case DXGI_FORMAT_BC1_UNORM:      format = bc::FORMAT_BC1; srgb = false; return true;
+        case DXGI_FORMAT_BC1_UNORM_SRGB: format = bc::FORMAT_BC1; srgb = true; return true;
+        case DXGI_FORMAT_BC3_UNORM:      format = bc::FORMAT_BC3; srgb = false; return true;
+        case DXGI_FORMAT_BC3_UNORM_SRGB: format = bc::FORMAT_BC3; srgb = true; return true;
+        case DXGI_FORMAT_BC7_UNORM:      format = bc::FORMAT_BC7; srgb = false; return true;
+        case DXGI_FORMAT_BC7_UNORM_SRGB: format = bc::FORMAT_BC7; srgb = true; return true;
+        }
+        return false;
+    }
+
+    size_t LevelBytes(const Image& image, uint32_t level)
+    {
+        return bc::ImageBytes(image.format, SDL_max(image.width >> level, 1u), SDL_max(image.height >> level, 1u));
+    }
+
+    bool Save(const char* path, const Image& image)
+    {
+        Header header{};
+        header.size = sizeof(Header);
+        header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+        header.height = image.height;
+        header.width = image.width;
+        header.pitch_or_linear_size = (uint32_t)LevelBytes(image, 0);
+        header.mip_map_count = image.levels;
+        header.pixel_format.size = sizeof(PixelFormat);
+        header.pixel_format.flags = DDPF_FOURCC;
+        header.pixel_format.four_cc = FourCC('D', 'X', '1', '0');
+        header.caps[0] = DDSCAPS_TEXTURE;
+        if (image.levels > 1)
+        {
+            header.flags |= DDSD_MIPMAPCOUNT;
+            header.caps[0] |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+        }
+
+        HeaderDX10 dx10{};
+        dx10.dxgi_format = ToDxgi(image.format, image.srgb);
+        dx10.resource_dimension = kDimensionTexture2D;
+        dx10.array_size = 1;
+
+        size_t data_size = 0;
+        for (uint32_t level = 0; level < image.levels; level++)
+            data_size += LevelBytes(image, level);
+        if (image.data.size() < data_size)
+        {
+            SDL_Log("Failed to write %s: %zu bytes of block data, %zu expected", path, image.data.size(), data_size);
+            return false;
+        }
+
+        std::vector<uint8_t> blob(sizeof(kMagic) + sizeof(Header) + sizeof(HeaderDX10) + data_size);
+        uint8_t* out = blob.data();
+        SDL_memcpy(out, &kMagic, sizeof(kMagic));
+        out += sizeof(kMagic);
+        SDL_memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        SDL_memcpy(out, &dx10, sizeof(dx10));
+        out += sizeof(dx10);
+        SDL_memcpy(out, image.data.data(), data_size);
+
+        if (!SDL_SaveFile(path, blob.data(), blob.size()))
+        {
+            SDL_Log("Failed to write %s: %s", path, SDL_GetError());
+            return false;
+        }
+        return true;
+    }
+
+    bool Load(const char* path, Image& out)
+    {
+        MappedFile file;
+        if (!file.Open(path))
+        {
+            SDL_Log("Failed to open %s", path);
+            return false;
+        }
+
+        const uint8_t* data = file.Data();
+        size_t size = file.Size();
+        size_t offset = sizeof(kMagic) + sizeof(Header);
+        uint32_t magic;
+        Header header;
+        if (size < offset)
+        {
+            SDL_Log("%s: truncated DDS header", path);
+            return false;
+        }
+        SDL_memcpy(&magic, data, sizeof(magic));
+        SDL_memcpy(&header, data + sizeof(magic), sizeof(header));
+        if (magic != kMagic || header.size != sizeof(Header))
+        {
+            SDL_Log("%s: not a DDS file", path);
+            return false;
+        }
+        if (!(header.pixel_format.flags & DDPF_FOURCC))
+        {
+            SDL_Log("%s: uncompressed DDS files are not supported", path);
+            return false;
+        }
+
+        switch (header.pixel_format.four_cc)
+        {
+        case FourCC('D', 'X', 'T', '1'):
+            out.format = bc::FORMAT_BC1;
+            out.srgb = false;
+            break;
+        case FourCC('D', 'X', 'T', '5'):
+            out.format = bc::FORMAT_BC3;
+            out.srgb = false;
+            break;
+        case FourCC('D', 'X', '1', '0'):
+        {
+            HeaderDX10 dx10;
+            if (size < offset + sizeof(dx10))
+            {
+                SDL_Log("%s: truncated DX10 header", path);
+                return false;
+            }
+            SDL_memcpy(&dx10, data + offset, sizeof(dx10));
+            offset += sizeof(dx10);
+            if (dx10.resource_dimension != kDimensionTexture2D || dx10.array_size > 1 || !FromDxgi(dx10.dxgi_format, out.format, out.srgb))
+            {
+                SDL_Log("%s: unsupported DXGI format %u", path, dx10.dxgi_format);
+                return false;
+            }
+            break;
+        }
+        default:
+            SDL_Log("%s: unsupported DDS format", path);
+            return false;
+        }
+
+        out.width = header.width;
+        out.height = header.height;
+        out.levels = SDL_max(header.mip_map_count, 1u);
+        if (out.width == 0 || out.height == 0)
+        {
+            SDL_Log("%s: empty texture", path);
+            return false;
+        }
+        // the largest 2D texture D3D11 allows, block counts and sizes cannot overflow below that
+        if (out.width > 16384 || out.height > 16384)
+        {
+            SDL_Log("%s: %ux%u is larger than 16384x16384", path, out.width, out.height);
+            return false;
+        }
+        // also keeps width >> level defined below
+        uint32_t max_levels = mip::LevelCount(out.width, out.height);
+        if (out.levels > max_levels)
+        {
+            SDL_Log("%s: %u mip levels, a %ux%u texture has at most %u", path, out.levels, out.width, out.height, max_levels);
+            return false;
+        }
+
+        out.level_offsets.resize(out.levels);
+        size_t data_size = 0;
+        for (uint32_t level = 0; level < out.levels; level++)
+        {
+            out.level_offsets[level] = data_size;
+            data_size += LevelBytes(out, level);
+        }
+        if (size - offset < data_size)
+        {
+            SDL_Log("%s: truncated block data", path);
+            return false;
+        }
+        out.data.assign(data + offset, data + offset + data_size);
+        return true;
+    }
+
+    bool IsDDSPath(const char* path)
+    {
+        size_t length = SDL_strlen(path);
+        return length >= 4 && SDL_strcasecmp(path + length - 4, ".dds") == 0;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "block_compress.h"
+
+// DDS container for block compressed textures. Written with the DX10 header
+// extension so BC7 and sRGB are expressible; legacy DXT1/DXT5 files from other
+// tools load as well. Mip levels are stored back to back, level 0 first.
+namespace dds
+{
+    struct Image
+    {
+        bc::Format format = bc::FORMAT_BC1;
+        bool srgb = false;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t levels = 0;
+        std::vector<uint8_t> data;
+        std::vector<size_t> level_offsets;
+    };
+
+    // byte size of one level
+    size_t LevelBytes(const Image& image, uint32_t level);
+
+    bool Save(const char* path, const Image& image);
+    bool Load(const char* path, Image& out);
+
+    bool IsDDSPath(const char* path);
+}
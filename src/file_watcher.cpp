@@ -0,0 +1,191 @@
+#include "file_watcher.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+
+#ifdef __linux__
+#include <errno.h>
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+// writes finish with a close, editors that save through a temporary file finish with a rename
+static const uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+#endif
+
+struct EnumerateContext
+{
+    const std::string* directory;
+    std::vector<std::string> files;
+    std::vector<std::string> subdirectories;
+};
+
+static SDL_EnumerationResult SDLCALL CollectEntry(void* userdata, const char*, const char* fname)
+{
+    EnumerateContext& context = *(EnumerateContext*)userdata;
+    std::string path = *context.directory + "/" + fname;
+    SDL_PathInfo info;
+    if (SDL_GetPathInfo(path.c_str(), &info))
+    {
+        if (info.type == SDL_PATHTYPE_DIRECTORY)
+            context.subdirectories.push_back(path);
+        else if (info.type == SDL_PATHTYPE_FILE)
+            context.files.push_back(path);
+    }
+    return SDL_ENUM_CONTINUE;
+}
+
+FileWatcher::FileWatcher(uint32_t scan_interval_ms)
+    : scan_interval_ns((uint64_t)scan_interval_ms * 1000000)
+{
+#ifdef __linux__
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+        SDL_Log("inotify unavailable, watching files by rescanning");
+#endif
+}
+
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+    if (fd >= 0)
+        close(fd);
+#endif
+}
+
+bool FileWatcher::IsNative() const
+{
+    return fd >= 0;
+}
+
+bool FileWatcher::Watch(const std::string& directory, bool recursive)
+{
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(directory.c_str(), &info) || info.type != SDL_PATHTYPE_DIRECTORY)
+    {
+        SDL_Log("Cannot watch %s: not a directory", directory.c_str());
+        return false;
+    }
+
+    // no trailing separator, paths are joined with one
+    std::string root = directory;
+    while (root.size() > 1 && (root.back() == '/' || root.back() == '\\'))
+        root.pop_back();
+
+    if (IsNative())
+    {
+        AddTree(root, recursive);
+    }
+    else
+    {
+        roots.push_back({ root, recursive });
+        Scan(roots.back(), nullptr);
+    }
+    return true;
+}
+
+void FileWatcher::AddTree(const std::string& directory, bool recursive)
+{
+#ifdef __linux__
+    int watch = inotify_add_watch(fd, directory.c_str(), kWatchMask);
+    if (watch < 0)
+    {
+        SDL_Log("Cannot watch %s: %s", directory.c_str(), strerror(errno));
+        return;
+    }
+    directories[watch] = { directory, recursive };
+#endif
+    if (!recursive)
+        return;
+
+    EnumerateContext context;
+    context.directory = &directory;
+    SDL_EnumerateDirectory(directory.c_str(), CollectEntry, &context);
+    for (const std::string& subdirectory : context.subdirectories)
+        AddTree(subdirectory, true);
+}
+
+void FileWatcher::Scan(const Directory& directory, std::vector<std::string>* changed)
+{
+    EnumerateContext context;
+    context.directory = &directory.path;
+    SDL_EnumerateDirectory(directory.path.c_str(), CollectEntry, &context);
+    for (const std::string& file : context.files)
+    {
+        SDL_PathInfo info;
+        if (!SDL_GetPathInfo(file.c_str(), &info))
+            continue;
+        auto [found, inserted] = times.try_emplace(file, info.modify_time);
+        if (!inserted && found->second != info.modify_time)
+        {
+            found->second = info.modify_time;
+            if (changed)
+                changed->push_back(file);
+        }
+        else if (inserted && changed)
+        {
+            // created since the last scan
+            changed->push_back(file);
+        }
+    }
+    if (!directory.recursive)
+        return;
+    for (const std::string& subdirectory : context.subdirectories)
+        Scan({ subdirectory, true }, changed);
+}
+
+void FileWatcher::Poll(std::vector<std::string>& changed)
+{
+    size_t first = changed.size();
+#ifdef __linux__
+    if (IsNative())
+    {
+        alignas(struct inotify_event) char buffer[16 * 1024];
+        for (;;)
+        {
+            ssize_t size = read(fd, buffer, sizeof(buffer));
+            if (size <= 0)
+                break;
+            for (char* at = buffer; at < buffer + size;)
+            {
+                const struct inotify_event* event = (const struct inotify_event*)at;
+                at += sizeof(struct inotify_event) + event->len;
+
+                if (event->mask & IN_Q_OVERFLOW)
+                    SDL_Log("File watcher queue overflowed, some changes were missed");
+                auto directory = directories.find(event->wd);
+                if (directory == directories.end() || event->len == 0)
+                    continue;
+
+                std::string path = directory->second.path + "/" + event->name;
+                if (event->mask & IN_ISDIR)
+                {
+                    // files written into a new directory before its watch exists are missed,
+                    // editors create the directory well ahead of saving into it
+                    if ((event->mask & (IN_CREATE | IN_MOVED_TO)) && directory->second.recursive)
+                        AddTree(path, true);
+                }
+                else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                {
+                    changed.push_back(path);
+                }
+            }
+        }
+    }
+#endif
+    if (!IsNative())
+    {
+        uint64_t now = SDL_GetTicksNS();
+        if (now - last_scan < scan_interval_ns && last_scan != 0)
+            return;
+        last_scan = now;
+        for (const Directory& root : roots)
+            Scan(root, &changed);
+    }
+
+    // one entry per file
+    std::sort(changed.begin() + first, changed.end());
+    changed.erase(std::unique(changed.begin() + first, changed.end()), changed.end());
+}
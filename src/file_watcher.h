@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SDL3/SDL_stdinc.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Reports files written or moved into watched directory trees. Uses inotify
+// on Linux, where Poll is a single non-blocking read. Elsewhere the trees are
+// rescanned for changed modification times, at most every scan_interval_ms.
+// Paths come back as the watched directory joined with the path below it, so
+// watching "res" reports "res/textures/tex.bmp", the same string the loaders
+// were given.
+class FileWatcher
+{
+public:
+    explicit FileWatcher(uint32_t scan_interval_ms = 250);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // the directory and, when recursive, everything below it, directories created later included
+    bool Watch(const std::string& directory, bool recursive = true);
+
+    // appends the files changed since the last call, never blocks. A file written
+    // several times shows up once per call at most
+    void Poll(std::vector<std::string>& changed);
+
+    // false when falling back to rescanning
+    bool IsNative() const;
+
+private:
+    struct Directory
+    {
+        std::string path;
+        bool recursive;
+    };
+
+    void AddTree(const std::string& directory, bool recursive);
+    void Scan(const Directory& directory, std::vector<std::string>* changed);
+
+    int fd = -1;
+    std::unordered_map<int, Directory> directories;     // inotify watch -> directory
+
+    // fallback: the watched roots and the last seen modification time of every file below them
+    std::vector<Directory> roots;
+    std::unordered_map<std::string, Sint64> times;
+    uint64_t scan_interval_ns;
+    uint64_t last_scan = 0;
+};
@@ -0,0 +1,331 @@
+#include "frame_graph.h"
+
+#include <SDL3/SDL.h>
+
+// SDL_gpu's limit on color targets per render pass
+static const uint32_t kMaxColorTargets = 4;
+
+FrameGraph::~FrameGraph()
+{
+    ReleaseTextures();
+}
+
+FrameGraph::ResourceId FrameGraph::CreateTexture(const std::string& name, const TextureDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resources.push_back(resource);
+    compiled = false;
+    return (ResourceId)resources.size() - 1;
+}
+
+FrameGraph::ResourceId FrameGraph::ImportTexture(const std::string& name, const TextureDesc& desc)
+{
+    Resource resource;
+    resource.name = name;
+    resource.desc = desc;
+    resource.imported = true;
+    resources.push_back(resource);
+    compiled = false;
+    return (ResourceId)resources.size() - 1;
+}
+
+void FrameGraph::SetTexture(ResourceId resource, SDL_GPUTexture* texture)
+{
+    SDL_assert(resources[resource].imported);
+    resources[resource].texture = texture;
+}
+
+SDL_GPUTexture* FrameGraph::GetTexture(ResourceId resource) const
+{
+    const Resource& r = resources[resource];
+    if (r.imported)
+        return r.texture;
+    return r.physical != kNone ? textures[r.physical].texture : nullptr;
+}
+
+FrameGraph::PassId FrameGraph::AddPass(const PassDesc& desc)
+{
+    SDL_assert(desc.function && desc.color.size() <= kMaxColorTargets);
+    Pass pass;
+    pass.desc = desc;
+    passes.push_back(pass);
+    compiled = false;
+    return (PassId)passes.size() - 1;
+}
+
+void FrameGraph::SetPassEnabled(PassId pass, bool enabled)
+{
+    if (passes[pass].enabled == enabled)
+        return;
+    passes[pass].enabled = enabled;
+    compiled = false;
+}
+
+bool FrameGraph::Compile()
+{
+    compiled = true;
+    valid = false;
+    stats = Stats();
+
+    // lifetimes: the first and last enabled pass touching each resource
+    for (Resource& resource : resources)
+    {
+        resource.first = kNone;
+        resource.last = kNone;
+        resource.physical = kNone;
+    }
+    for (uint32_t p = 0; p < passes.size(); p++)
+    {
+        const Pass& pass = passes[p];
+        if (!pass.enabled)
+            continue;
+        stats.passes++;
+        auto Use = [&](ResourceId id, bool sampled) -> bool
+        {
+            Resource& resource = resources[id];
+            if (resource.first == kNone)
+            {
+                // an imported texture may come in with contents, a transient one never does
+                if (sampled && !resource.imported)
+                {
+                    SDL_Log("Frame graph: pass %s samples %s before any pass writes it", pass.desc.name.c_str(), resource.name.c_str());
+                    return false;
+                }
+                resource.first = p;
+            }
+            resource.last = p;
+            return true;
+        };
+        for (ResourceId id : pass.desc.color)
+        {
+            if (!Use(id, false))
+                return false;
+        }
+        if (pass.desc.depth != kNone && !Use(pass.desc.depth, false))
+            return false;
+        for (ResourceId id : pass.desc.sampled)
+        {
+            if (!Use(id, true))
+                return false;
+        }
+    }
+
+    // Texture sharing, greedy in order of first use: a transient takes the first texture of
+    // the same description whose users are all done before it starts. Every frame uses the
+    // same assignment, so textures are only created again when the frame size changes
+    std::vector<Physical> assigned;
+    for (uint32_t p = 0; p < passes.size(); p++)
+    {
+        for (Resource& resource : resources)
+        {
+            if (resource.imported || resource.first != p)
+                continue;
+            for (uint32_t t = 0; t < assigned.size() && resource.physical == kNone; t++)
+            {
+                Physical& physical = assigned[t];
+                if (physical.last < p && physical.desc.format == resource.desc.format && physical.desc.usage == resource.desc.usage &&
+                    physical.desc.width == resource.desc.width && physical.desc.height == resource.desc.height)
+                    resource.physical = t;
+            }
+            if (resource.physical == kNone)
+            {
+                Physical physical;
+                physical.desc = resource.desc;
+                assigned.push_back(physical);
+                resource.physical = (uint32_t)assigned.size() - 1;
+            }
+            assigned[resource.physical].last = resource.last;
+            stats.transient++;
+        }
+    }
+    stats.textures = (uint32_t)assigned.size();
+
+    // keep the textures that still fit their slot, frames in flight hold on to the others
+    for (uint32_t t = 0; t < assigned.size() && t < textures.size(); t++)
+    {
+        const TextureDesc& a = assigned[t].desc;
+        const TextureDesc& b = textures[t].desc;
+        if (a.format == b.format && a.usage == b.usage && a.width == b.width && a.height == b.height)
+        {
+            assigned[t].texture = textures[t].texture;
+            assigned[t].width = textures[t].width;
+            assigned[t].height = textures[t].height;
+            textures[t].texture = nullptr;
+        }
+    }
+    ReleaseTextures();
+    textures = std::move(assigned);
+
+    for (uint32_t p = 0; p < passes.size(); p++)
+    {
+        Pass& pass = passes[p];
+        pass.color.clear();
+        pass.depth = Target{ kNone, SDL_GPU_LOADOP_DONT_CARE, SDL_GPU_STOREOP_DONT_CARE, false };
+        if (!pass.enabled)
+            continue;
+        for (ResourceId id : pass.desc.color)
+            pass.color.push_back(MakeTarget(id, p));
+        if (pass.desc.depth != kNone)
+            pass.depth = MakeTarget(pass.desc.depth, p);
+    }
+    valid = true;
+    return true;
+}
+
+FrameGraph::Target FrameGraph::MakeTarget(ResourceId id, uint32_t pass) const
+{
+    const Resource& resource = resources[id];
+    Target target{ id, SDL_GPU_LOADOP_LOAD, SDL_GPU_STOREOP_STORE, false };
+    if (pass == resource.first)
+    {
+        if (resource.desc.clear)
+            target.load_op = SDL_GPU_LOADOP_CLEAR;
+        else if (!resource.imported)
+            target.load_op = SDL_GPU_LOADOP_DONT_CARE;
+        // nothing is loaded, so a texture an earlier frame is still using can be swapped for
+        // a fresh one instead of waiting. Only the texture's first user this frame may do
+        // that, a later one sharing it comes after a pass that rendered into the current one
+        bool first_user = true;
+        if (!resource.imported)
+        {
+            for (const Resource& other : resources)
+                first_user &= other.imported || other.physical != resource.physical || other.first == kNone || other.first >= pass;
+        }
+        target.cycle = !resource.imported && first_user && target.load_op != SDL_GPU_LOADOP_LOAD;
+    }
+    // nobody reads a transient after its last pass, tilers skip writing it out
+    if (pass == resource.last && !resource.imported)
+        target.store_op = SDL_GPU_STOREOP_DONT_CARE;
+    return target;
+}
+
+bool FrameGraph::CreateTextures(uint32_t width, uint32_t height)
+{
+    stats.transient_bytes = 0;
+    for (Physical& physical : textures)
+    {
+        uint32_t w = physical.desc.width ? physical.desc.width : width;
+        uint32_t h = physical.desc.height ? physical.desc.height : height;
+        if (!physical.texture || physical.width != w || physical.height != h)
+        {
+            // resized, SDL keeps the old texture alive for frames still using it
+            if (physical.texture)
+                SDL_ReleaseGPUTexture(device, physical.texture);
+            SDL_GPUTextureCreateInfo info{};
+            info.type = SDL_GPU_TEXTURETYPE_2D;
+            info.format = physical.desc.format;
+            info.width = w;
+            info.height = h;
+            info.layer_count_or_depth = 1;
+            info.num_levels = 1;
+            info.usage = physical.desc.usage;
+            physical.texture = SDL_CreateGPUTexture(device, &info);
+            physical.width = w;
+            physical.height = h;
+            if (!physical.texture)
+            {
+                SDL_Log("Frame graph: failed to create a %ux%u target: %s", w, h, SDL_GetError());
+                return false;
+            }
+        }
+        stats.transient_bytes += SDL_CalculateGPUTextureFormatSize(physical.desc.format, w, h, 1);
+    }
+    return true;
+}
+
+void FrameGraph::ReleaseTextures()
+{
+    for (Physical& physical : textures)
+    {
+        if (physical.texture)
+            SDL_ReleaseGPUTexture(device, physical.texture);
+        physical.texture = nullptr;
+    }
+}
+
+bool FrameGraph::Execute(SDL_GPUCommandBuffer* commands, uint32_t width, uint32_t height)
+{
+    if (!compiled)
+        Compile();
+    if (!valid)
+        return false;
+    for (const Resource& resource : resources)
+    {
+        if (resource.imported && resource.first != kNone && !resource.texture)
+        {
+            SDL_Log("Frame graph: %s has no texture this frame", resource.name.c_str());
+            return false;
+        }
+    }
+    if (!CreateTextures(width, height))
+        return false;
+
+    for (const Pass& pass : passes)
+    {
+        if (!pass.enabled)
+            continue;
+        SDL_GPUColorTargetInfo color_infos[kMaxColorTargets] = {};
+        for (size_t i = 0; i < pass.color.size(); i++)
+        {
+            const Target& target = pass.color[i];
+            SDL_GPUColorTargetInfo& info = color_infos[i];
+            info.texture = GetTexture(target.resource);
+            info.clear_color = resources[target.resource].desc.clear_color;
+            info.load_op = target.load_op;
+            info.store_op = target.store_op;
+            info.cycle = target.cycle;
+        }
+        SDL_GPUDepthStencilTargetInfo depth_info{};
+        if (pass.depth.resource != kNone)
+        {
+            depth_info.texture = GetTexture(pass.depth.resource);
+            depth_info.clear_depth = resources[pass.depth.resource].desc.clear_depth;
+            depth_info.load_op = pass.depth.load_op;
+            depth_info.store_op = pass.depth.store_op;
+            depth_info.stencil_load_op = SDL_GPU_LOADOP_DONT_CARE;
+            depth_info.stencil_store_op = SDL_GPU_STOREOP_DONT_CARE;
+            depth_info.cycle = pass.depth.cycle;
+        }
+
+        SDL_GPURenderPass* render_pass = SDL_BeginGPURenderPass(commands, color_infos, (Uint32)pass.color.size(),
+            pass.depth.resource != kNone ? &depth_info : nullptr);
+        pass.desc.function(render_pass, commands, pass.desc.data);
+        SDL_EndGPURenderPass(render_pass);
+    }
+    return true;
+}
+
+std::string FrameGraph::Describe() const
+{
+    static const char* const load_names[] = { "load", "clear", "discard" };
+    static const char* const store_names[] = { "store", "discard", "resolve", "resolve+store" };
+    std::string text;
+    for (const Pass& pass : passes)
+    {
+        if (!text.empty())
+            text += "\n";
+        text += pass.desc.name + ":";
+        if (!pass.enabled)
+        {
+            text += " disabled";
+            continue;
+        }
+        auto Add = [&](const Target& target)
+        {
+            const Resource& resource = resources[target.resource];
+            text += " " + resource.name;
+            if (!resource.imported)
+                text += "#" + std::to_string(resource.physical);
+            text += std::string(" (") + load_names[target.load_op] + "/" + store_names[target.store_op] + (target.cycle ? ", cycled)" : ")");
+        };
+        for (const Target& target : pass.color)
+            Add(target);
+        if (pass.depth.resource != kNone)
+            Add(pass.depth);
+        for (ResourceId id : pass.desc.sampled)
+            text += " samples " + resources[id].name;
+    }
+    return text;
+}
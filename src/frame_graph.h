@@ -0,0 +1,145 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The render passes of a frame and the targets they draw into, declared once
+// up front instead of being spelled out inline every frame. Compile walks the
+// enabled passes in order and works out from that alone:
+//
+// - how each attachment loads and stores: the first pass using a target
+//   clears it (or loads an imported one that asks for it), later passes load
+//   it, and a transient target's last pass does not store it at all;
+// - which transient targets can share a texture: two with the same
+//   description whose pass ranges do not overlap get the same one, so a
+//   target that is dead before another is born costs no memory of its own.
+//
+// SDL_gpu has no memory aliasing between resources, so sharing is done at
+// texture granularity. Transient textures are created on the first Execute
+// and follow the frame size, imported ones (the swapchain image) are bound
+// per frame with SetTexture. Passes record render passes only, copy and
+// compute work is recorded by the caller before Execute.
+class FrameGraph
+{
+public:
+    using ResourceId = uint32_t;
+    using PassId = uint32_t;
+    static const uint32_t kNone = UINT32_MAX;
+
+    // records the draws of a pass inside its render pass
+    using PassFunction = void (*)(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void* data);
+
+    struct TextureDesc
+    {
+        SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        SDL_GPUTextureUsageFlags usage = 0;
+        uint32_t width = 0;             // 0: the frame size
+        uint32_t height = 0;
+        // cleared by the first pass using it each frame. Otherwise a transient
+        // starts undefined and an imported texture keeps what it had
+        bool clear = true;
+        SDL_FColor clear_color = { 0.0f, 0.0f, 0.0f, 0.0f };
+        float clear_depth = 1.0f;
+    };
+
+    struct PassDesc
+    {
+        std::string name;
+        std::vector<ResourceId> color;          // render targets, in slot order
+        ResourceId depth = kNone;
+        std::vector<ResourceId> sampled;        // read in shaders, written by an earlier pass
+        PassFunction function = nullptr;
+        void* data = nullptr;
+    };
+
+    struct Stats
+    {
+        uint32_t passes = 0;            // enabled
+        uint32_t transient = 0;         // transient targets used by enabled passes
+        uint32_t textures = 0;          // textures backing them
+        uint64_t transient_bytes = 0;   // of those textures, at the last frame size
+    };
+
+    explicit FrameGraph(SDL_GPUDevice* _device) : device(_device) {}
+    ~FrameGraph();
+
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+
+    ResourceId CreateTexture(const std::string& name, const TextureDesc& desc);
+    // a texture the graph does not own, stored after its last pass. desc.format and usage are unused
+    ResourceId ImportTexture(const std::string& name, const TextureDesc& desc);
+    void SetTexture(ResourceId resource, SDL_GPUTexture* texture);
+    // the texture behind a resource this frame, for passes sampling it. Valid during Execute
+    SDL_GPUTexture* GetTexture(ResourceId resource) const;
+
+    // passes run in the order they were added
+    PassId AddPass(const PassDesc& pass);
+    void SetPassEnabled(PassId pass, bool enabled);
+    bool IsPassEnabled(PassId pass) const { return passes[pass].enabled; }
+
+    // Lifetimes, load and store operations and texture sharing of the enabled
+    // passes. Runs by itself in Execute after passes or resources changed, false
+    // when a pass samples a target no earlier pass wrote
+    bool Compile();
+
+    // Records every enabled pass for a width x height frame. False when compiling
+    // failed, an imported texture is missing or a transient one could not be created
+    bool Execute(SDL_GPUCommandBuffer* commands, uint32_t width, uint32_t height);
+
+    const Stats& GetStats() const { return stats; }
+    // one line per pass with its attachments and their operations, for logs
+    std::string Describe() const;
+
+private:
+    struct Resource
+    {
+        std::string name;
+        TextureDesc desc;
+        bool imported = false;
+        SDL_GPUTexture* texture = nullptr;      // imported only, transients live in textures
+        uint32_t first = kNone;                 // enabled passes using it, from Compile
+        uint32_t last = kNone;
+        uint32_t physical = kNone;              // into textures
+    };
+
+    // a color or depth target of a compiled pass
+    struct Target
+    {
+        ResourceId resource;
+        SDL_GPULoadOp load_op;
+        SDL_GPUStoreOp store_op;
+        bool cycle;
+    };
+
+    struct Pass
+    {
+        PassDesc desc;
+        bool enabled = true;
+        std::vector<Target> color;              // from Compile
+        Target depth = {};
+    };
+
+    struct Physical
+    {
+        TextureDesc desc;
+        uint32_t last = kNone;                  // last pass of the resources sharing it
+        SDL_GPUTexture* texture = nullptr;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    Target MakeTarget(ResourceId resource, uint32_t pass) const;
+    bool CreateTextures(uint32_t width, uint32_t height);
+    void ReleaseTextures();
+
+    SDL_GPUDevice* device;
+    std::vector<Resource> resources;
+    std::vector<Pass> passes;
+    std::vector<Physical> textures;
+    bool compiled = false;
+    bool valid = false;
+    Stats stats;
+};
@@ -0,0 +1,353 @@
+#include "gpu_culling.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <unordered_map>
+#include "profiler.h"
+#include "shader.h"
+
+static uint32_t IndexBytes(SDL_GPUIndexElementSize index_size)
+{
+    return index_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+}
+
+GpuCulling::GpuCulling(SDL_GPUDevice* _device, UploadRing* _uploads)
+    : device(_device), uploads(_uploads)
+{
+    // objects that passed, next to the per-command instance counts
+    SDL_GPUBufferCreateInfo info{};
+    info.size = 16;
+    info.usage = SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE;
+    counter_buffer = SDL_CreateGPUBuffer(device, &info);
+}
+
+GpuCulling::~GpuCulling()
+{
+    // released buffers stay alive until the frames using them complete
+    if (pipeline)
+        SDL_ReleaseGPUComputePipeline(device, pipeline);
+    for (SDL_GPUBuffer* buffer : { object_buffer, mesh_buffer, command_buffer, visible_buffer, lod_buffer, counter_buffer })
+    {
+        if (buffer)
+            SDL_ReleaseGPUBuffer(device, buffer);
+    }
+}
+
+bool GpuCulling::LoadShader(const char* path)
+{
+    spirv::Reflection reflection;
+    SDL_GPUComputePipeline* loaded = shader::LoadComputePipeline(device, path, &reflection);
+    if (!loaded)
+        return false;
+    if (pipeline)
+        SDL_ReleaseGPUComputePipeline(device, pipeline);
+    pipeline = loaded;
+    threadcount = reflection.threadcount_x;
+    return true;
+}
+
+bool GpuCulling::SetMeshes(const std::vector<MeshInfo>& _meshes, uint32_t _vertex_stride)
+{
+    for (const MeshInfo& mesh : _meshes)
+    {
+        if (mesh.vertex_offset % _vertex_stride != 0 || mesh.index_offset % IndexBytes(mesh.index_size) != 0)
+        {
+            SDL_Log("GPU culling needs meshes aligned to their vertex and index size, one starts at %u (stride %u)",
+                mesh.vertex_offset, _vertex_stride);
+            return false;
+        }
+    }
+    meshes = _meshes;
+    vertex_stride = _vertex_stride;
+    meshes_dirty = true;
+    commands_dirty = true;
+    // LOD chains may differ, every object starts over from LOD 0 like on the CPU
+    lods_cleared = 0;
+    return true;
+}
+
+GpuCulling::GpuObject GpuCulling::MakeObject(uint32_t mesh, const glm::mat4& transform, const Aabb& world_bounds)
+{
+    glm::vec3 size = world_bounds.max - world_bounds.min;
+    GpuObject object{};
+    object.transform = transform;
+    object.center = glm::vec4(world_bounds.Center(), SDL_max(SDL_max(size.x, size.y), size.z));
+    object.extent = glm::vec4(world_bounds.Extent(), 0.0f);
+    object.mesh = mesh;
+    return object;
+}
+
+void GpuCulling::AddObject(uint32_t mesh, uint32_t material, const glm::mat4& transform, const Aabb& world_bounds)
+{
+    objects.push_back(MakeObject(mesh, transform, world_bounds));
+    materials.push_back(material);
+    // a new object may need new commands, and it shifts the visible ranges
+    commands_dirty = true;
+}
+
+void GpuCulling::SetObject(uint32_t object, const glm::mat4& transform, const Aabb& world_bounds)
+{
+    GpuObject& target = objects[object];
+    uint32_t command = target.command;
+    target = MakeObject(target.mesh, transform, world_bounds);
+    target.command = command;
+    dirty_first = SDL_min(dirty_first, object);
+    dirty_end = SDL_max(dirty_end, object + 1);
+}
+
+void GpuCulling::BuildCommands()
+{
+    // objects per (material, mesh) pair, each pair gets one command per LOD
+    struct Pair
+    {
+        uint32_t material;
+        uint32_t mesh;
+        uint32_t objects;
+        uint32_t command;
+    };
+    std::vector<Pair> pairs;
+    std::unordered_map<uint64_t, uint32_t> pair_index;
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        uint64_t key = (uint64_t)materials[i] << 32 | objects[i].mesh;
+        auto [found, inserted] = pair_index.try_emplace(key, (uint32_t)pairs.size());
+        if (inserted)
+            pairs.push_back({ materials[i], objects[i].mesh, 0, 0 });
+        pairs[found->second].objects++;
+    }
+
+    // buckets are runs of one material and index size, one indirect draw each
+    std::sort(pairs.begin(), pairs.end(), [this](const Pair& a, const Pair& b) {
+        if (a.material != b.material)
+            return a.material < b.material;
+        if (meshes[a.mesh].index_size != meshes[b.mesh].index_size)
+            return meshes[a.mesh].index_size < meshes[b.mesh].index_size;
+        return a.mesh < b.mesh;
+    });
+
+    commands.clear();
+    command_lods.clear();
+    buckets.clear();
+    visible_capacity = 0;
+    for (Pair& pair : pairs)
+    {
+        const MeshInfo& mesh = meshes[pair.mesh];
+        if (buckets.empty() || buckets.back().material != pair.material || buckets.back().index_size != mesh.index_size)
+            buckets.push_back({ pair.material, mesh.index_size, (uint32_t)commands.size(), 0 });
+        buckets.back().command_count += mesh.lod_count;
+
+        // the index buffer is bound once at offset 0, so indices and vertices count from its start
+        pair.command = (uint32_t)commands.size();
+        for (uint32_t lod = 0; lod < mesh.lod_count; lod++)
+        {
+            SDL_GPUIndexedIndirectDrawCommand command{};
+            command.num_indices = mesh.lods[lod].index_count;
+            command.first_index = mesh.index_offset / IndexBytes(mesh.index_size) + mesh.lods[lod].first_index;
+            command.vertex_offset = (Sint32)(mesh.vertex_offset / vertex_stride);
+            command.first_instance = visible_capacity;
+            commands.push_back(command);
+            command_lods.push_back(lod);
+            // any of the pair's objects may pick this LOD
+            visible_capacity += pair.objects;
+        }
+        pair_index[(uint64_t)pair.material << 32 | pair.mesh] = pair.command;
+    }
+
+    for (size_t i = 0; i < objects.size(); i++)
+        objects[i].command = pair_index[(uint64_t)materials[i] << 32 | objects[i].mesh];
+    dirty_first = 0;
+    dirty_end = (uint32_t)objects.size();
+}
+
+bool GpuCulling::EnsureBuffer(SDL_GPUBuffer*& buffer, uint32_t& capacity, uint32_t size, SDL_GPUBufferUsageFlags usage)
+{
+    if (buffer && size <= capacity)
+        return false;
+    if (buffer)
+        SDL_ReleaseGPUBuffer(device, buffer);
+    capacity = SDL_max(size, capacity * 2);
+
+    SDL_GPUBufferCreateInfo info{};
+    info.size = capacity;
+    info.usage = usage;
+    buffer = SDL_CreateGPUBuffer(device, &info);
+    if (!buffer)
+    {
+        SDL_Log("Failed to create a GPU culling buffer: %s", SDL_GetError());
+        capacity = 0;
+    }
+    return true;
+}
+
+void GpuCulling::Upload()
+{
+    if (objects.empty())
+        return;
+    PROFILE_ZONE("gpu culling upload");
+
+    if (commands_dirty)
+    {
+        BuildCommands();
+        commands_dirty = false;
+    }
+
+    if (meshes_dirty)
+    {
+        std::vector<GpuMesh> packed(meshes.size());
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const MeshInfo& mesh = meshes[i];
+            GpuMesh& out = packed[i];
+            out = GpuMesh{};
+            out.position_offset = glm::vec4(mesh.quantization.offset, 0.0f);
+            out.position_scale = glm::vec4(mesh.quantization.scale, 0.0f);
+            for (uint32_t lod = 0; lod < mesh.lod_count; lod++)
+                out.errors[lod] = mesh.lods[lod].error;
+            out.lod_count = mesh.lod_count;
+        }
+        uint32_t bytes = (uint32_t)(packed.size() * sizeof(GpuMesh));
+        EnsureBuffer(mesh_buffer, mesh_capacity, bytes, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
+        if (mesh_buffer)
+            uploads->UploadToBuffer(packed.data(), bytes, mesh_buffer, 0, true);
+        meshes_dirty = false;
+    }
+
+    // a new buffer starts out empty, everything goes up again
+    uint32_t object_bytes = (uint32_t)(objects.size() * sizeof(GpuObject));
+    if (EnsureBuffer(object_buffer, object_capacity, object_bytes, SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_READ | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ))
+    {
+        dirty_first = 0;
+        dirty_end = (uint32_t)objects.size();
+    }
+    if (object_buffer && dirty_first < dirty_end)
+    {
+        // only a whole rewrite may cycle, a cycled buffer keeps none of the old contents
+        bool whole = dirty_first == 0 && dirty_end == objects.size();
+        uploads->UploadToBuffer(&objects[dirty_first], (dirty_end - dirty_first) * (uint32_t)sizeof(GpuObject), object_buffer,
+            dirty_first * (uint32_t)sizeof(GpuObject), whole);
+    }
+    dirty_first = UINT32_MAX;
+    dirty_end = 0;
+
+    // LOD state persists across frames, growing the buffer starts every object over from LOD 0
+    if (EnsureBuffer(lod_buffer, lod_capacity, (uint32_t)objects.size() * sizeof(uint32_t), SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE))
+        lods_cleared = 0;
+    if (lod_buffer && lods_cleared < objects.size())
+    {
+        std::vector<uint32_t> zeros(objects.size() - lods_cleared, 0);
+        uploads->UploadToBuffer(zeros.data(), (uint32_t)(zeros.size() * sizeof(uint32_t)), lod_buffer,
+            lods_cleared * (uint32_t)sizeof(uint32_t));
+        lods_cleared = (uint32_t)objects.size();
+    }
+
+    // every frame starts from the templates with no instances, cycled so the last frame keeps drawing its own
+    uint32_t command_bytes = (uint32_t)(commands.size() * sizeof(SDL_GPUIndexedIndirectDrawCommand));
+    EnsureBuffer(command_buffer, command_capacity, command_bytes, SDL_GPU_BUFFERUSAGE_INDIRECT | SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE);
+    if (command_buffer)
+        uploads->UploadToBuffer(commands.data(), command_bytes, command_buffer, 0, true);
+    EnsureBuffer(visible_buffer, visible_buffer_capacity, SDL_max(visible_capacity, 1u) * (uint32_t)sizeof(uint32_t),
+        SDL_GPU_BUFFERUSAGE_COMPUTE_STORAGE_WRITE | SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ);
+    const uint32_t zero[4] = {};
+    if (counter_buffer)
+        uploads->UploadToBuffer(zero, sizeof(zero), counter_buffer, 0, true);
+}
+
+void GpuCulling::Dispatch(SDL_GPUCommandBuffer* commandBuffer, const View& view)
+{
+    if (!pipeline || objects.empty() || !object_buffer || !mesh_buffer || !command_buffer || !visible_buffer || !lod_buffer || !counter_buffer)
+        return;
+    PROFILE_ZONE("gpu cull");
+
+    CullUniforms uniforms{};
+    for (uint32_t p = 0; p < Frustum::PLANE_COUNT; p++)
+        uniforms.planes[p] = view.frustum.planes[p];
+    uniforms.camera = glm::vec4(view.camera_position, view.pixels_per_unit);
+    uniforms.max_pixel_error = view.max_pixel_error;
+    uniforms.hysteresis = view.hysteresis;
+    uniforms.object_count = (uint32_t)objects.size();
+
+    // commands and counters were just uploaded, the visible list is rewritten in full
+    SDL_GPUStorageBufferReadWriteBinding writes[4] = {};
+    writes[0].buffer = command_buffer;
+    writes[1].buffer = visible_buffer;
+    writes[1].cycle = true;
+    writes[2].buffer = lod_buffer;
+    writes[3].buffer = counter_buffer;
+    SDL_GPUComputePass* pass = SDL_BeginGPUComputePass(commandBuffer, nullptr, 0, writes, 4);
+    SDL_BindGPUComputePipeline(pass, pipeline);
+    SDL_GPUBuffer* reads[2] = { object_buffer, mesh_buffer };
+    SDL_BindGPUComputeStorageBuffers(pass, 0, reads, 2);
+    SDL_PushGPUComputeUniformData(commandBuffer, 0, &uniforms, sizeof(uniforms));
+    SDL_DispatchGPUCompute(pass, (uniforms.object_count + threadcount - 1) / threadcount, 1, 1);
+    SDL_EndGPUComputePass(pass);
+}
+
+bool GpuCulling::Readback(std::vector<uint32_t>& visible, std::vector<uint32_t>& lods)
+{
+    visible.clear();
+    lods.clear();
+    if (commands.empty() || !command_buffer || !visible_buffer || !counter_buffer)
+        return true;
+
+    uint32_t command_bytes = (uint32_t)(commands.size() * sizeof(SDL_GPUIndexedIndirectDrawCommand));
+    uint32_t visible_bytes = visible_capacity * (uint32_t)sizeof(uint32_t);
+    SDL_GPUTransferBufferCreateInfo transferInfo{};
+    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+    transferInfo.size = command_bytes + visible_bytes + sizeof(uint32_t);
+    SDL_GPUTransferBuffer* transfer = SDL_CreateGPUTransferBuffer(device, &transferInfo);
+    if (!transfer)
+    {
+        SDL_Log("Failed to create the readback buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    // submitted after the frame, so the copies see what its culling pass wrote
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    SDL_GPUBufferRegion source{ command_buffer, 0, command_bytes };
+    SDL_GPUTransferBufferLocation destination{ transfer, 0 };
+    SDL_DownloadFromGPUBuffer(copyPass, &source, &destination);
+    if (visible_bytes)
+    {
+        source = { visible_buffer, 0, visible_bytes };
+        destination.offset = command_bytes;
+        SDL_DownloadFromGPUBuffer(copyPass, &source, &destination);
+    }
+    source = { counter_buffer, 0, sizeof(uint32_t) };
+    destination.offset = command_bytes + visible_bytes;
+    SDL_DownloadFromGPUBuffer(copyPass, &source, &destination);
+    SDL_EndGPUCopyPass(copyPass);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+    SDL_ReleaseGPUFence(device, fence);
+
+    const Uint8* mapped = (const Uint8*)SDL_MapGPUTransferBuffer(device, transfer, false);
+    const SDL_GPUIndexedIndirectDrawCommand* results = (const SDL_GPUIndexedIndirectDrawCommand*)mapped;
+    const uint32_t* list = (const uint32_t*)(mapped + command_bytes);
+    uint32_t visible_count;
+    SDL_memcpy(&visible_count, mapped + command_bytes + visible_bytes, sizeof(visible_count));
+    std::vector<std::pair<uint32_t, uint32_t>> found;
+    for (size_t c = 0; c < commands.size(); c++)
+    {
+        for (uint32_t i = 0; i < results[c].num_instances; i++)
+            found.push_back({ list[commands[c].first_instance + i], command_lods[c] });
+    }
+    SDL_UnmapGPUTransferBuffer(device, transfer);
+    SDL_ReleaseGPUTransferBuffer(device, transfer);
+
+    // the commands' instances and the counter are written by separate atomics
+    if (visible_count != found.size())
+    {
+        SDL_Log("GPU culling counted %u visible objects, its draws hold %zu", visible_count, found.size());
+        return false;
+    }
+
+    std::sort(found.begin(), found.end());
+    for (const auto& [object, lod] : found)
+    {
+        visible.push_back(object);
+        lods.push_back(lod);
+    }
+    return true;
+}
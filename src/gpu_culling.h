@@ -0,0 +1,163 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "bounds.h"
+#include "mesh.h"
+#include "upload_ring.h"
+#include "vertex_format.h"
+
+// Frustum culling and LOD selection in a compute pass. Objects and meshes
+// live in storage buffers. One thread per object tests its world bounds
+// against the frustum, picks a LOD with the rule of lod::SelectLod and adds
+// an instance to the indirect draw command of its (material, mesh, LOD). The
+// renderer then issues one SDL_DrawGPUIndexedPrimitivesIndirect per bucket,
+// a run of commands sharing a material and index size.
+//
+// SDL_gpu has no draw count buffer, so a bucket always draws all of its
+// commands and those no object landed in have zero instances. Each command
+// owns a range of the visible list big enough for every object that could
+// land in it, which saves the prefix sum a compacted list would need. The
+// CPU cost per frame is the command templates (one per mesh and LOD in use)
+// and whatever objects changed, not the object count.
+class GpuCulling
+{
+public:
+    // a mesh in the shared vertex and index buffers, offsets in bytes
+    struct MeshInfo
+    {
+        uint32_t vertex_offset = 0;
+        uint32_t index_offset = 0;
+        SDL_GPUIndexElementSize index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+        Mesh::MeshLod lods[Mesh::kMaxLods] = {};
+        uint32_t lod_count = 1;
+        vtx::Quantization quantization;
+    };
+
+    // commands [first_command, first_command + command_count) of CommandBuffer
+    struct Bucket
+    {
+        uint32_t material;
+        SDL_GPUIndexElementSize index_size;
+        uint32_t first_command;
+        uint32_t command_count;
+    };
+
+    struct View
+    {
+        Frustum frustum;
+        glm::vec3 camera_position;
+        float pixels_per_unit;      // projected size of a unit size at distance 1, see lod::ProjectedSize
+        float max_pixel_error;
+        float hysteresis;
+    };
+
+    GpuCulling(SDL_GPUDevice* _device, UploadRing* _uploads);
+    ~GpuCulling();
+
+    GpuCulling(const GpuCulling&) = delete;
+    GpuCulling& operator=(const GpuCulling&) = delete;
+
+    // (re)creates the compute pipeline from cull.comp, the current one stays on failure
+    bool LoadShader(const char* path);
+    bool IsReady() const { return pipeline != nullptr; }
+
+    // Replaces the meshes, objects keep their mesh index. Draws address vertices by
+    // index, so every mesh has to start at a multiple of vertex_stride; false otherwise
+    bool SetMeshes(const std::vector<MeshInfo>& _meshes, uint32_t _vertex_stride);
+
+    void AddObject(uint32_t mesh, uint32_t material, const glm::mat4& transform, const Aabb& world_bounds);
+    void SetObject(uint32_t object, const glm::mat4& transform, const Aabb& world_bounds);
+    uint32_t ObjectCount() const { return (uint32_t)objects.size(); }
+
+    // queues this frame's uploads, before the copy pass they go out with
+    void Upload();
+    // records the culling pass, after that copy pass and before the draws
+    void Dispatch(SDL_GPUCommandBuffer* commandBuffer, const View& view);
+
+    const std::vector<Bucket>& Buckets() const { return buckets; }
+    SDL_GPUBuffer* CommandBuffer() const { return command_buffer; }
+    // what the indirect vertex shaders read: objects, the visible list and, for compact vertices, meshes
+    SDL_GPUBuffer* ObjectBuffer() const { return object_buffer; }
+    SDL_GPUBuffer* VisibleBuffer() const { return visible_buffer; }
+    SDL_GPUBuffer* MeshBuffer() const { return mesh_buffer; }
+
+    // Visible objects of the last Dispatch in ascending order and the LOD each
+    // was drawn with. Copies the results back and waits for the GPU, for tests
+    bool Readback(std::vector<uint32_t>& visible, std::vector<uint32_t>& lods);
+
+private:
+    // std430 layouts of cull.comp
+    struct GpuObject
+    {
+        glm::mat4 transform;
+        glm::vec4 center;           // w: largest side
+        glm::vec4 extent;
+        uint32_t mesh;
+        uint32_t command;
+        uint32_t padding[2];
+    };
+
+    struct GpuMesh
+    {
+        glm::vec4 position_offset;
+        glm::vec4 position_scale;
+        float errors[Mesh::kMaxLods];
+        uint32_t lod_count;
+        uint32_t padding[2];
+    };
+    // the shaders declare errors[5] by hand, a new kMaxLods has to be carried over to them
+    static_assert(Mesh::kMaxLods == 5, "MeshLods.errors in cull.comp and the packed indirect shaders");
+    static_assert(offsetof(GpuMesh, lod_count) == 52 && sizeof(GpuMesh) == 64, "std430 layout of MeshLods");
+    static_assert(sizeof(GpuObject) == 112, "std430 layout of Object");
+
+    struct CullUniforms
+    {
+        glm::vec4 planes[Frustum::PLANE_COUNT];
+        glm::vec4 camera;
+        float max_pixel_error;
+        float hysteresis;
+        uint32_t object_count;
+        uint32_t padding;
+    };
+
+    static GpuObject MakeObject(uint32_t mesh, const glm::mat4& transform, const Aabb& world_bounds);
+    // assigns every (material, mesh) pair its commands and visible ranges
+    void BuildCommands();
+    bool EnsureBuffer(SDL_GPUBuffer*& buffer, uint32_t& capacity, uint32_t size, SDL_GPUBufferUsageFlags usage);
+
+    SDL_GPUDevice* device;
+    UploadRing* uploads;
+    SDL_GPUComputePipeline* pipeline = nullptr;
+    uint32_t threadcount = 64;
+
+    std::vector<MeshInfo> meshes;
+    std::vector<GpuObject> objects;
+    std::vector<uint32_t> materials;                    // per object
+    std::vector<SDL_GPUIndexedIndirectDrawCommand> commands;    // templates, no instances
+    std::vector<uint32_t> command_lods;
+    std::vector<Bucket> buckets;
+    uint32_t vertex_stride = 0;
+    uint32_t visible_capacity = 0;
+
+    bool commands_dirty = false;    // objects were added or meshes replaced
+    bool meshes_dirty = false;
+    uint32_t dirty_first = UINT32_MAX;  // object range to upload
+    uint32_t dirty_end = 0;
+    uint32_t lods_cleared = 0;      // objects whose LOD state starts at 0 on the GPU
+
+    SDL_GPUBuffer* object_buffer = nullptr;
+    SDL_GPUBuffer* mesh_buffer = nullptr;
+    SDL_GPUBuffer* command_buffer = nullptr;
+    SDL_GPUBuffer* visible_buffer = nullptr;
+    SDL_GPUBuffer* lod_buffer = nullptr;
+    SDL_GPUBuffer* counter_buffer = nullptr;
+    uint32_t object_capacity = 0;
+    uint32_t mesh_capacity = 0;
+    uint32_t command_capacity = 0;
+    uint32_t visible_buffer_capacity = 0;
+    uint32_t lod_capacity = 0;
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hash
+{
+    // MurmurHash64A, fast enough to key asset caches on whole file contents
+    uint64_t Murmur64(const void* data, size_t size, uint64_t seed = 0);
+
+    inline uint64_t Combine(uint64_t seed, uint64_t value)
+    {
+        return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+    }
+}
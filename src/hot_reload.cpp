@@ -0,0 +1,450 @@
+#include "hot_reload.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include "mesh_cache.h"
+#include "profiler.h"
+
+// the stages res/shaders/compile_shaders.sh compiles
+static const char* const kShaderStages[] = { "vert", "frag", "comp", "geom", "tesc", "tese", "mesh", "task" };
+
+static bool ModifyTime(const std::string& path, Sint64& time)
+{
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path.c_str(), &info) || info.type != SDL_PATHTYPE_FILE)
+        return false;
+    time = info.modify_time;
+    return true;
+}
+
+// missing, or older than any input that exists
+static bool IsOutOfDate(const std::string& output, const std::vector<std::string>& inputs)
+{
+    Sint64 output_time, input_time;
+    if (!ModifyTime(output, output_time))
+        return true;
+    for (const std::string& input : inputs)
+    {
+        if (ModifyTime(input, input_time) && input_time > output_time)
+            return true;
+    }
+    return false;
+}
+
+static void ScanFile(const std::string& path, std::vector<std::string>& found)
+{
+    size_t size;
+    char* text = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (!text)
+        return;
+
+    // #include "name", whitespace allowed around the #. Angle brackets search the
+    // compiler's include paths, which builds here do not set
+    std::vector<std::string> names;
+    for (size_t at = 0; at < size;)
+    {
+        size_t end = at;
+        while (end < size && text[end] != '\n')
+            end++;
+        size_t i = at;
+        while (i < end && (text[i] == ' ' || text[i] == '\t'))
+            i++;
+        if (i < end && text[i] == '#')
+        {
+            i++;
+            while (i < end && (text[i] == ' ' || text[i] == '\t'))
+                i++;
+            if (end - i > 7 && SDL_strncmp(text + i, "include", 7) == 0)
+            {
+                i += 7;
+                while (i < end && (text[i] == ' ' || text[i] == '\t'))
+                    i++;
+                size_t close = i + 1;
+                while (close < end && text[close] != '"')
+                    close++;
+                if (i < end && text[i] == '"' && close < end)
+                    names.emplace_back(text + i + 1, close - i - 1);
+            }
+        }
+        at = end + 1;
+    }
+    SDL_free(text);
+
+    std::string directory = path.substr(0, path.find_last_of('/') + 1);
+    for (const std::string& name : names)
+    {
+        std::string include = HotReload::NormalizePath(directory + name);
+        if (std::find(found.begin(), found.end(), include) == found.end())
+        {
+            found.push_back(include);
+            ScanFile(include, found);
+        }
+    }
+}
+
+struct ShaderDirectory
+{
+    HotReload* reload;
+    std::string code;
+    std::string compiled;
+    uint32_t count = 0;
+};
+
+static SDL_EnumerationResult SDLCALL AddShaderEntry(void* userdata, const char* dirname, const char* fname)
+{
+    ShaderDirectory& directory = *(ShaderDirectory*)userdata;
+    std::string path = std::string(dirname) + fname;
+    SDL_PathInfo info;
+    if (!SDL_GetPathInfo(path.c_str(), &info))
+        return SDL_ENUM_CONTINUE;
+
+    // subdirectories keep their place in the compiled tree
+    std::string relative = path.substr(directory.code.size() + 1);
+    if (info.type == SDL_PATHTYPE_DIRECTORY)
+    {
+        SDL_EnumerateDirectory(path.c_str(), AddShaderEntry, userdata);
+        return SDL_ENUM_CONTINUE;
+    }
+
+    size_t dot = relative.find_last_of('.');
+    if (dot == std::string::npos)
+        return SDL_ENUM_CONTINUE;
+    std::string stage = relative.substr(dot + 1);
+    for (const char* known : kShaderStages)
+    {
+        if (stage == known)
+        {
+            directory.reload->AddShader(path, directory.compiled + "/" + relative.substr(0, dot) + stage + ".spv");
+            directory.count++;
+            break;
+        }
+    }
+    return SDL_ENUM_CONTINUE;
+}
+
+HotReload::HotReload(const Settings& _settings)
+    : settings(_settings)
+{
+    uint32_t thread_count = settings.build_threads;
+    if (thread_count == 0)
+        thread_count = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores() / 2, 1);
+
+    threads.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+        threads.emplace_back(&HotReload::WorkerMain, this);
+}
+
+HotReload::~HotReload()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+bool HotReload::Watch(const std::string& directory, bool recursive)
+{
+    return watcher.Watch(directory, recursive);
+}
+
+void HotReload::Track(const std::string& path, Kind kind)
+{
+    tracked[NormalizePath(path)] = kind;
+}
+
+void HotReload::AddShader(const std::string& source, const std::string& output)
+{
+    Build build;
+    build.step = STEP_COMPILE_SHADER;
+    build.source = NormalizePath(source);
+    build.output = NormalizePath(output);
+
+    std::vector<std::string> inputs = ScanIncludes(build.source);
+    inputs.insert(inputs.begin(), build.source);
+    bool stale = IsOutOfDate(build.output, inputs);
+
+    uint32_t index = AddBuild(std::move(build));
+    Link(index, inputs);
+    if (stale)
+        Queue(index);
+    else
+        stats.up_to_date++;
+}
+
+uint32_t HotReload::AddShaderDirectory(const std::string& code_directory, const std::string& compiled_directory)
+{
+    ShaderDirectory directory{ this, NormalizePath(code_directory), NormalizePath(compiled_directory) };
+    SDL_EnumerateDirectory(directory.code.c_str(), AddShaderEntry, &directory);
+    return directory.count;
+}
+
+void HotReload::AddModel(const std::string& source, const std::string& cache, const model::ImportSettings& import,
+    vtx::LayoutId layout)
+{
+    Build build;
+    build.step = STEP_BAKE_MODEL;
+    build.source = NormalizePath(source);
+    build.output = NormalizePath(cache);
+    build.import = import;
+    build.layout = layout;
+
+    meshcache::MeshCache existing;
+    bool stale = !existing.Open(build.output.c_str()) || !existing.IsUpToDate(build.source.c_str(), import)
+        || existing.VertexLayout() != layout;
+    existing.Close();
+
+    std::vector<std::string> inputs = { build.source };
+    uint32_t index = AddBuild(std::move(build));
+    Link(index, inputs);
+    if (stale)
+        Queue(index);
+    else
+        stats.up_to_date++;
+}
+
+void HotReload::NotifyChanged(const std::string& path)
+{
+    pending[NormalizePath(path)] = SDL_GetTicksNS();
+}
+
+void HotReload::Poll(std::vector<Change>& changes)
+{
+    PROFILE_ZONE("hot reload");
+    uint64_t now = SDL_GetTicksNS();
+
+    // a write restarts the file's settle time
+    events.clear();
+    watcher.Poll(events);
+    for (const std::string& path : events)
+    {
+        pending[NormalizePath(path)] = now;
+        stats.file_events++;
+    }
+
+    std::vector<Result> finished;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.swap(results);
+    }
+    for (Result& result : finished)
+    {
+        Build& build = builds[result.build];
+        build.busy = false;
+        builds_in_flight--;
+        if (result.ok)
+        {
+            // the edit may have changed what the source includes
+            Link(result.build, result.inputs);
+            // reloaded even when the output is outside the watched directories
+            pending[build.output] = now;
+            stats.builds++;
+            SDL_Log("Rebuilt %s", build.output.c_str());
+        }
+        else
+        {
+            stats.build_failures++;
+            SDL_Log("Failed to build %s, keeping the last good one%s%s", build.output.c_str(),
+                result.log.empty() ? "" : ":\n", result.log.c_str());
+        }
+        if (build.rerun)
+        {
+            build.rerun = false;
+            Queue(result.build);
+        }
+    }
+
+    uint64_t settle = (uint64_t)settings.settle_ms * 1000000;
+    for (auto it = pending.begin(); it != pending.end();)
+    {
+        if (now - it->second < settle)
+        {
+            ++it;
+            continue;
+        }
+        auto kind = tracked.find(it->first);
+        if (kind != tracked.end())
+        {
+            changes.push_back({ kind->second, it->first });
+            stats.changes++;
+        }
+        auto readers = dependents.find(it->first);
+        if (readers != dependents.end())
+        {
+            for (uint32_t build : readers->second)
+                Queue(build);
+        }
+        it = pending.erase(it);
+    }
+}
+
+bool HotReload::IsIdle() const
+{
+    return pending.empty() && builds_in_flight == 0;
+}
+
+std::vector<std::string> HotReload::ScanIncludes(const std::string& source)
+{
+    std::vector<std::string> found;
+    ScanFile(NormalizePath(source), found);
+    return found;
+}
+
+std::string HotReload::NormalizePath(const std::string& path)
+{
+    std::vector<std::string> parts;
+    bool absolute = !path.empty() && (path[0] == '/' || path[0] == '\\');
+    size_t start = 0;
+    for (size_t i = 0; i <= path.size(); i++)
+    {
+        if (i < path.size() && path[i] != '/' && path[i] != '\\')
+            continue;
+        std::string part = path.substr(start, i - start);
+        start = i + 1;
+        if (part.empty() || part == ".")
+            continue;
+        if (part == ".." && !parts.empty() && parts.back() != "..")
+            parts.pop_back();
+        else
+            parts.push_back(std::move(part));
+    }
+
+    std::string normalized = absolute ? "/" : "";
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        if (i > 0)
+            normalized += '/';
+        normalized += parts[i];
+    }
+    return normalized;
+}
+
+uint32_t HotReload::AddBuild(Build build)
+{
+    builds.push_back(std::move(build));
+    return (uint32_t)builds.size() - 1;
+}
+
+void HotReload::Link(uint32_t index, const std::vector<std::string>& inputs)
+{
+    Build& build = builds[index];
+    for (const std::string& input : build.inputs)
+    {
+        std::vector<uint32_t>& readers = dependents[input];
+        readers.erase(std::remove(readers.begin(), readers.end(), index), readers.end());
+    }
+    build.inputs = inputs;
+    for (const std::string& input : build.inputs)
+        dependents[input].push_back(index);
+}
+
+void HotReload::Queue(uint32_t index)
+{
+    Build& build = builds[index];
+    if (build.busy)
+    {
+        // a build still waiting for a thread reads the latest inputs anyway,
+        // one already running may have read the old ones
+        std::lock_guard<std::mutex> lock(mutex);
+        bool waiting = std::any_of(jobs.begin(), jobs.end(), [index](const Job& job) { return job.build == index; });
+        build.rerun |= !waiting;
+        return;
+    }
+
+    build.busy = true;
+    builds_in_flight++;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back({ index, build.step, build.source, build.output, build.import, build.layout });
+    }
+    wake.notify_one();
+}
+
+void HotReload::WorkerMain()
+{
+    PROFILE_THREAD("asset builder");
+    for (;;)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !jobs.empty(); });
+            if (quit)
+                return;
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Result result;
+        result.build = job.build;
+        Run(job, result);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(std::move(result));
+        }
+    }
+}
+
+void HotReload::Run(const Job& job, Result& result) const
+{
+    // written next to the output and renamed over it once complete
+    std::string temporary = job.output + ".tmp";
+    size_t slash = job.output.find_last_of('/');
+    if (slash != std::string::npos)
+        SDL_CreateDirectory(job.output.substr(0, slash).c_str());
+
+    if (job.step == STEP_COMPILE_SHADER)
+    {
+        PROFILE_ZONE("compile shader");
+        const char* args[] = { settings.shader_compiler.c_str(), job.source.c_str(), "-o", temporary.c_str(), nullptr };
+        SDL_PropertiesID props = SDL_CreateProperties();
+        SDL_SetPointerProperty(props, SDL_PROP_PROCESS_CREATE_ARGS_POINTER, (void*)args);
+        SDL_SetNumberProperty(props, SDL_PROP_PROCESS_CREATE_STDOUT_NUMBER, SDL_PROCESS_STDIO_APP);
+        SDL_SetBooleanProperty(props, SDL_PROP_PROCESS_CREATE_STDERR_TO_STDOUT_BOOLEAN, true);
+        SDL_Process* process = SDL_CreateProcessWithProperties(props);
+        SDL_DestroyProperties(props);
+
+        result.ok = false;
+        if (process)
+        {
+            // the compiler's messages, read until it exits
+            size_t size = 0;
+            int exit_code = -1;
+            char* output = (char*)SDL_ReadProcess(process, &size, &exit_code);
+            if (output)
+            {
+                result.log.assign(output, size);
+                SDL_free(output);
+            }
+            SDL_DestroyProcess(process);
+            result.ok = exit_code == 0;
+        }
+        else
+        {
+            result.log = std::string("cannot run ") + settings.shader_compiler + ": " + SDL_GetError();
+        }
+
+        result.inputs = ScanIncludes(job.source);
+        result.inputs.insert(result.inputs.begin(), job.source);
+    }
+    else
+    {
+        PROFILE_ZONE("bake model");
+        std::vector<Mesh> meshes = model::LoadModel(job.source.c_str(), job.import);
+        result.ok = !meshes.empty() && meshcache::Bake(temporary.c_str(), meshes, meshcache::HashFile(job.source.c_str()),
+            meshcache::HashSettings(job.import), job.layout);
+        result.inputs = { job.source };
+    }
+
+    if (result.ok && !SDL_RenamePath(temporary.c_str(), job.output.c_str()))
+    {
+        result.ok = false;
+        result.log = SDL_GetError();
+    }
+    if (!result.ok)
+        SDL_RemovePath(temporary.c_str());
+}
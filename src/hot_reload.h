@@ -0,0 +1,165 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "file_watcher.h"
+#include "model.h"
+#include "vertex_format.h"
+
+// Turns file changes into asset reloads. Tracked files (SPIR-V, textures, mesh
+// caches) are handed back to the caller to reload once they settle. Build
+// steps keep derived files current: GLSL sources compile to SPIR-V with an
+// external compiler and models bake to .skmesh, each on a pool of build
+// threads, so only what an edit invalidates is rebuilt and independent builds
+// run in parallel. A shader is rebuilt when its source or any file it
+// includes changes; what it includes is scanned again after every build.
+// Outputs are written under a temporary name and renamed into place, so a
+// failed build keeps the last good file and a reload never sees half of one.
+//
+// Nothing here touches the GPU: Poll only reports what changed, the owner of
+// each resource swaps it at a frame boundary.
+class HotReload
+{
+public:
+    enum Kind
+    {
+        KIND_SHADER,                // compiled SPIR-V, see PipelineCache::ReloadShader
+        KIND_TEXTURE,               // see TextureStreamer::Reload
+        KIND_MESH_CACHE,            // a baked .skmesh
+    };
+
+    struct Settings
+    {
+        // run as <compiler> <source> -o <output>, includes resolve next to the source
+        std::string shader_compiler = "glslc";
+        // concurrent builds, 0 leaves half of the logical cores to the frame
+        uint32_t build_threads = 0;
+        // a file only counts as changed once it has not been written for this long,
+        // editors and compilers often write in several steps
+        uint32_t settle_ms = 100;
+    };
+
+    struct Change
+    {
+        Kind kind;
+        std::string path;
+    };
+
+    struct Stats
+    {
+        uint32_t file_events = 0;
+        uint32_t builds = 0;            // finished successfully
+        uint32_t build_failures = 0;
+        uint32_t up_to_date = 0;        // registered outputs that needed no build
+        uint32_t changes = 0;           // reported by Poll
+    };
+
+    explicit HotReload(const Settings& _settings);
+    ~HotReload();
+
+    HotReload(const HotReload&) = delete;
+    HotReload& operator=(const HotReload&) = delete;
+
+    // the directory and, when recursive, everything below it
+    bool Watch(const std::string& directory, bool recursive = true);
+
+    // Poll reports the file once it changes
+    void Track(const std::string& path, Kind kind);
+
+    // output is compiled from source, and again whenever source or an include changes.
+    // Compiled right away when output is missing or older than any of them
+    void AddShader(const std::string& source, const std::string& output);
+    // every name.stage below code_directory to compiled_directory/namestage.spv, the
+    // naming of res/shaders/compile_shaders.sh. Returns the number of shaders added
+    uint32_t AddShaderDirectory(const std::string& code_directory, const std::string& compiled_directory);
+
+    // cache is baked from the source model, again whenever it changes. Baked right
+    // away when the cache is missing or was baked from other contents or settings
+    void AddModel(const std::string& source, const std::string& cache, const model::ImportSettings& import,
+        vtx::LayoutId layout = vtx::LAYOUT_FULL);
+
+    // a change the watcher cannot see, e.g. to a file outside the watched directories
+    void NotifyChanged(const std::string& path);
+
+    // main thread, once per frame: takes in file events and finished builds, starts the
+    // builds that settled changes invalidate and appends the tracked files among them
+    void Poll(std::vector<Change>& changes);
+
+    // no change waiting to settle and no build queued or running
+    bool IsIdle() const;
+    const Stats& GetStats() const { return stats; }
+
+    // every file source pulls in through #include "...", transitively, resolved relative to the including file
+    static std::vector<std::string> ScanIncludes(const std::string& source);
+    // forward slashes, no "." or "dir/.." components, so paths from different places compare equal
+    static std::string NormalizePath(const std::string& path);
+
+private:
+    enum Step
+    {
+        STEP_COMPILE_SHADER,
+        STEP_BAKE_MODEL,
+    };
+
+    struct Build
+    {
+        Step step;
+        std::string source;
+        std::string output;
+        model::ImportSettings import;
+        vtx::LayoutId layout = vtx::LAYOUT_FULL;
+        std::vector<std::string> inputs;    // source and its includes
+        bool busy = false;                  // queued or running
+        bool rerun = false;                 // an input changed after the build started
+    };
+
+    // what a build thread needs, copied so builds can be added while others run
+    struct Job
+    {
+        uint32_t build;
+        Step step;
+        std::string source;
+        std::string output;
+        model::ImportSettings import;
+        vtx::LayoutId layout;
+    };
+
+    struct Result
+    {
+        uint32_t build;
+        bool ok;
+        std::string log;
+        std::vector<std::string> inputs;
+    };
+
+    uint32_t AddBuild(Build build);
+    void Link(uint32_t build, const std::vector<std::string>& inputs);
+    void Queue(uint32_t build);
+    void WorkerMain();
+    void Run(const Job& job, Result& result) const;
+
+    Settings settings;
+    FileWatcher watcher;
+
+    // main thread only
+    std::unordered_map<std::string, Kind> tracked;
+    std::vector<Build> builds;
+    std::unordered_map<std::string, std::vector<uint32_t>> dependents;     // input -> builds reading it
+    std::unordered_map<std::string, uint64_t> pending;                      // changed path -> last write
+    std::vector<std::string> events;
+    uint32_t builds_in_flight = 0;
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Job> jobs;
+    std::vector<Result> results;
+    bool quit = false;
+
+    Stats stats;
+};
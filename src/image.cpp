@@ -44,4 +44,9 @@ namespace image
     {
         return stbi_load(path, width, height, channels, desired_channels);
     }
+
+    void FreeImage(unsigned char* pixels)
+    {
+        stbi_image_free(pixels);
+    }
 }
\ No newline at end of file
@@ -6,4 +6,6 @@ namespace image
 {
     SDL_Surface* LoadImage(const char* path, int desired_channels);
     unsigned char* LoadImage(const char* imageFilename, int* pWidth, int* pHeight, int* pChannels, int desiredChannels);
+    // releases pixels returned by LoadImage
+    void FreeImage(unsigned char* pixels);
 }
\ No newline at end of file
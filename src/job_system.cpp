@@ -0,0 +1,211 @@
+#include "job_system.h"
+
+#include <SDL3/SDL.h>
+#include <string>
+#include "profiler.h"
+#include "simd.h"
+
+static thread_local const JobSystem* t_system = nullptr;
+static thread_local uint32_t t_index = ~0u;
+
+static inline void CpuRelax()
+{
+#if SKELETAL_SSE
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+JobSystem::JobSystem(uint32_t _thread_count)
+{
+    thread_count = _thread_count ? _thread_count : (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+
+    states.resize(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+    {
+        states[i] = new ThreadState();
+        states[i]->rng = 0x9E3779B9u * (i + 1);
+    }
+
+    t_system = this;
+    t_index = 0;
+
+    workers.reserve(thread_count - 1);
+    for (uint32_t i = 1; i < thread_count; i++)
+        workers.emplace_back(&JobSystem::WorkerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        quit.store(true);
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+
+    for (ThreadState* state : states)
+        delete state;
+
+    if (t_system == this)
+    {
+        t_system = nullptr;
+        t_index = ~0u;
+    }
+}
+
+uint32_t JobSystem::CurrentThreadIndex() const
+{
+    return t_system == this ? t_index : ~0u;
+}
+
+void JobSystem::Schedule(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter)
+{
+    if (counter)
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+
+    uint32_t index = CurrentThreadIndex();
+    SDL_assert(index != ~0u);
+
+    ThreadState* state = states[index];
+    Job* job = &state->jobs[state->next_job & (kMaxJobsPerThread - 1)];
+    // only the owner pushes, thieves can only make room, so the push below cannot fail
+    if (job->busy.load(std::memory_order_acquire) || state->queue.Size() >= (int64_t)kQueueCapacity)
+    {
+        // running inline keeps progress without unbounded growth or overwriting a queued job
+        Job inline_job{ function, data, begin, end, counter };
+        Execute(&inline_job);
+        return;
+    }
+    state->next_job++;
+    job->function = function;
+    job->data = data;
+    job->begin = begin;
+    job->end = end;
+    job->counter = counter;
+    job->busy.store(true, std::memory_order_relaxed);
+
+    bool pushed = state->queue.Push(job);
+    SDL_assert(pushed);
+    (void)pushed;
+
+    queued.fetch_add(1);
+    if (sleeping.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+        wake.notify_one();
+    }
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t grain, JobFunction function, void* data, JobCounter* counter)
+{
+    if (count == 0)
+        return;
+
+    if (grain == 0)
+    {
+        // a few chunks per thread leaves room to balance uneven work by stealing
+        uint32_t chunks = thread_count * 4;
+        grain = (count + chunks - 1) / chunks;
+    }
+    // never create more chunks than one queue can hold
+    uint32_t min_grain = (count + kQueueCapacity / 2 - 1) / (kQueueCapacity / 2);
+    grain = SDL_max(grain, SDL_max(min_grain, 1u));
+
+    for (uint32_t begin = 0; begin < count; begin += grain)
+    {
+        uint32_t end = begin + grain < count ? begin + grain : count;
+        Schedule(function, data, begin, end, counter);
+    }
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+    uint32_t index = CurrentThreadIndex();
+    SDL_assert(index != ~0u);
+
+    while (!counter->IsDone())
+    {
+        Job* job = FindJob(index);
+        if (job)
+            Execute(job);
+        else
+            CpuRelax();
+    }
+}
+
+JobSystem::Job* JobSystem::FindJob(uint32_t index)
+{
+    ThreadState* state = states[index];
+    Job* job = state->queue.Pop();
+    if (job == nullptr && thread_count > 1)
+    {
+        // xorshift picks the first victim so thieves spread out
+        uint32_t x = state->rng;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state->rng = x;
+
+        uint32_t start = x % thread_count;
+        for (uint32_t i = 0; i < thread_count && job == nullptr; i++)
+        {
+            uint32_t victim = (start + i) % thread_count;
+            if (victim != index)
+                job = states[victim]->queue.Steal();
+        }
+    }
+
+    if (job)
+        queued.fetch_sub(1);
+    return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+    PROFILE_ZONE("job");
+    // the slot is recycled as soon as it is released, nothing may read it after that
+    JobFunction function = job->function;
+    void* data = job->data;
+    uint32_t begin = job->begin, end = job->end;
+    JobCounter* counter = job->counter;
+    job->busy.store(false, std::memory_order_release);
+
+    function(data, begin, end);
+    if (counter)
+        counter->value.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerMain(uint32_t index)
+{
+    t_system = this;
+    t_index = index;
+    PROFILE_THREAD(("job worker " + std::to_string(index)).c_str());
+
+    while (!quit.load(std::memory_order_relaxed))
+    {
+        Job* job = FindJob(index);
+        if (job)
+        {
+            Execute(job);
+            continue;
+        }
+
+        // spin briefly before sleeping, frame work tends to arrive in bursts
+        bool found = false;
+        for (int spin = 0; spin < 256 && !found; spin++)
+        {
+            CpuRelax();
+            found = queued.load(std::memory_order_relaxed) > 0;
+        }
+        if (found)
+            continue;
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        sleeping.fetch_add(1);
+        wake.wait(lock, [this] { return queued.load() > 0 || quit.load(); });
+        sleeping.fetch_sub(1);
+    }
+}
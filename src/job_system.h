@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "work_stealing_queue.h"
+
+// Jobs decrement their counter when done. Waiting on a counter doubles as a
+// dependency: work scheduled after Wait(counter) returns sees all of its results.
+struct JobCounter
+{
+    std::atomic<uint32_t> value{ 0 };
+
+    bool IsDone() const { return value.load(std::memory_order_acquire) == 0; }
+};
+
+// Processes the index range [begin, end).
+using JobFunction = void (*)(void* data, uint32_t begin, uint32_t end);
+
+// Fixed pool of worker threads with one work stealing deque per thread. The
+// thread that creates the system is thread 0 and takes part in the work while
+// it waits. Only that thread and the workers may schedule jobs.
+class JobSystem
+{
+public:
+    static const uint32_t kQueueCapacity = 4096;
+    // jobs are recycled from a per-thread ring. A slot is free once its job started running,
+    // a job that finds its slot taken or the queue full runs inline instead
+    static const uint32_t kMaxJobsPerThread = 2 * kQueueCapacity;
+
+    struct Job
+    {
+        JobFunction function;
+        void* data;
+        uint32_t begin;
+        uint32_t end;
+        JobCounter* counter;
+        std::atomic<bool> busy{ false };    // queued, the slot must not be reused yet
+    };
+
+    // thread_count includes the calling thread, 0 picks the number of logical cores
+    explicit JobSystem(uint32_t thread_count = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    uint32_t ThreadCount() const { return thread_count; }
+    // 0 on the owning thread, 1..N-1 on workers, ~0u on foreign threads
+    uint32_t CurrentThreadIndex() const;
+
+    void Schedule(JobFunction function, void* data, uint32_t begin, uint32_t end, JobCounter* counter);
+
+    // Splits [0, count) into chunks of grain items (0 picks one from the thread count)
+    // and schedules them, counter tracks all chunks.
+    void ParallelFor(uint32_t count, uint32_t grain, JobFunction function, void* data, JobCounter* counter);
+
+    // Runs queued jobs until counter reaches zero.
+    void Wait(JobCounter* counter);
+
+    // Blocking convenience wrapper, f is called as f(begin, end).
+    template<typename F>
+    void ParallelFor(uint32_t count, uint32_t grain, F&& f)
+    {
+        JobCounter counter;
+        ParallelFor(count, grain, [](void* data, uint32_t begin, uint32_t end) { (*(F*)data)(begin, end); }, (void*)&f, &counter);
+        Wait(&counter);
+    }
+
+private:
+    struct alignas(64) ThreadState
+    {
+        WorkStealingQueue<Job, kQueueCapacity> queue;
+        Job jobs[kMaxJobsPerThread];
+        uint32_t next_job = 0;
+        uint32_t rng = 0;
+    };
+
+    void WorkerMain(uint32_t index);
+    Job* FindJob(uint32_t index);
+    void Execute(Job* job);
+
+    uint32_t thread_count = 0;
+    std::vector<ThreadState*> states;
+    std::vector<std::thread> workers;
+
+    std::atomic<int32_t> queued{ 0 };
+    std::atomic<int32_t> sleeping{ 0 };
+    std::atomic<bool> quit{ false };
+    std::mutex wake_mutex;
+    std::condition_variable wake;
+};
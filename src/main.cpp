@@ -2,11 +2,31 @@
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 #include <SDL3/SDL_gpu.h>
+#include "profiler.h"
 #include "renderer.h"
 
 SDL_AppResult SDL_AppInit(void** appstate, int argc, char* argv[])
 {
-    Renderer::Init();
+    // SKELETAL_TRACE=trace.json captures the whole run for chrome://tracing or Tracy's import-chrome
+    if (SDL_getenv("SKELETAL_TRACE"))
+        profiler::BeginCapture();
+    PROFILE_THREAD("main");
+
+    // optional baked mesh (.skmesh) to draw instead of the built-in quad
+    Renderer::Settings settings;
+    settings.mesh_cache_path = argc > 1 ? argv[1] : nullptr;
+    // SKELETAL_HOT_RELOAD=1 rebuilds and reloads shaders, textures and the mesh cache as
+    // they are edited. The optional model it was baked from is rebaked when it changes
+    settings.hot_reload = SDL_getenv("SKELETAL_HOT_RELOAD") != nullptr;
+    settings.mesh_source_path = argc > 2 ? argv[2] : nullptr;
+    // SKELETAL_GPU_CULLING=1 culls and picks LODs in a compute pass, drawn with indirect commands
+    settings.gpu_culling = SDL_getenv("SKELETAL_GPU_CULLING") != nullptr;
+    if (!Renderer::Init(settings))
+        return SDL_APP_FAILURE;
+
+    // every mesh once, untransformed
+    for (Uint32 mesh = 0; mesh < Renderer::MeshCount(); mesh++)
+        Renderer::AddObject(mesh, 0, glm::mat4(1.0f));
 
     return SDL_APP_CONTINUE;
 }
@@ -22,6 +42,7 @@ SDL_AppResult SDL_AppEvent(void* appstate, SDL_Event* event)
 /* This function runs once per frame, and is the heart of the program. */
 SDL_AppResult SDL_AppIterate(void* appstate)
 {
+    PROFILE_ZONE("frame");
     Renderer::PreRender();
     Renderer::Render();
     Renderer::PostRender();
@@ -32,4 +53,10 @@ SDL_AppResult SDL_AppIterate(void* appstate)
 void SDL_AppQuit(void* appstate, SDL_AppResult result)
 {
     Renderer::Shutdown();
+
+    if (const char* trace = SDL_getenv("SKELETAL_TRACE"))
+    {
+        profiler::EndCapture();
+        profiler::WriteChromeTrace(trace);
+    }
 }
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first touch,
+// so opening a large file is O(1) and untouched data never leaves the disk cache.
+class MappedFile
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const char* path);
+    void Close();
+
+    bool IsOpen() const { return data != nullptr; }
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+};
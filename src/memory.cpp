@@ -0,0 +1,209 @@
+#include "memory.h"
+
+#include <SDL3/SDL.h>
+#include <atomic>
+
+namespace mem
+{
+    struct CategoryCounters
+    {
+        std::atomic<uint64_t> bytes{ 0 };
+        std::atomic<uint64_t> peak_bytes{ 0 };
+        std::atomic<uint64_t> allocations{ 0 };
+        std::atomic<uint64_t> frees{ 0 };
+    };
+
+    static CategoryCounters g_counters[CATEGORY_COUNT];
+
+    const char* CategoryName(Category category)
+    {
+        switch (category)
+        {
+        case CATEGORY_GENERAL: return "general";
+        case CATEGORY_FRAME: return "frame";
+        case CATEGORY_MESH: return "mesh";
+        case CATEGORY_TEXTURE: return "texture";
+        case CATEGORY_RENDERER: return "renderer";
+        case CATEGORY_IMPORT: return "import";
+        default: return "unknown";
+        }
+    }
+
+    void Track(Category category, size_t bytes)
+    {
+        CategoryCounters& counters = g_counters[category];
+        uint64_t now = counters.bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        counters.allocations.fetch_add(1, std::memory_order_relaxed);
+        uint64_t peak = counters.peak_bytes.load(std::memory_order_relaxed);
+        while (now > peak && !counters.peak_bytes.compare_exchange_weak(peak, now, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void Untrack(Category category, size_t bytes)
+    {
+        CategoryCounters& counters = g_counters[category];
+        counters.bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        counters.frees.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    CategoryStats GetCategoryStats(Category category)
+    {
+        const CategoryCounters& counters = g_counters[category];
+        CategoryStats stats;
+        stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+        stats.peak_bytes = counters.peak_bytes.load(std::memory_order_relaxed);
+        stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+        stats.frees = counters.frees.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void LogCategoryStats()
+    {
+        SDL_Log("category      current KB     peak KB   allocations");
+        for (int c = 0; c < CATEGORY_COUNT; c++)
+        {
+            CategoryStats stats = GetCategoryStats((Category)c);
+            SDL_Log("%-10s %12.1f %11.1f %13llu", CategoryName((Category)c), stats.bytes / 1024.0,
+                stats.peak_bytes / 1024.0, (unsigned long long)stats.allocations);
+        }
+    }
+
+    void* Allocate(size_t size, size_t alignment, Category category)
+    {
+        void* ptr = ::operator new(size, std::align_val_t(alignment));
+        Track(category, size);
+        return ptr;
+    }
+
+    void Free(void* ptr, size_t size, size_t alignment, Category category)
+    {
+        if (ptr == nullptr)
+            return;
+        Untrack(category, size);
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+
+    class HeapResourceImpl : public std::pmr::memory_resource
+    {
+    public:
+        Category category = CATEGORY_GENERAL;
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment, category); }
+        void do_deallocate(void* ptr, size_t bytes, size_t alignment) override { Free(ptr, bytes, alignment, category); }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+    };
+
+    std::pmr::memory_resource* HeapResource(Category category)
+    {
+        // leaked on purpose, containers freed during static destruction may still use them
+        static HeapResourceImpl* resources = []
+        {
+            HeapResourceImpl* r = new HeapResourceImpl[CATEGORY_COUNT];
+            for (int c = 0; c < CATEGORY_COUNT; c++)
+                r[c].category = (Category)c;
+            return r;
+        }();
+        return &resources[category];
+    }
+
+    // the header is padded to max_align_t, block data starts aligned for any ordinary type
+    static const size_t kBlockHeader = (sizeof(void*) * 3 + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    Arena::Arena(size_t _block_size, Category _category)
+        : block_size(_block_size), category(_category)
+    {
+    }
+
+    Arena::~Arena()
+    {
+        Release();
+    }
+
+    Arena::Block* Arena::NewBlock(size_t size)
+    {
+        Block* block = (Block*)mem::Allocate(kBlockHeader + size, alignof(std::max_align_t), category);
+        block->next = nullptr;
+        block->size = kBlockHeader + size;
+        block->used = kBlockHeader;
+        reserved += size;
+        return block;
+    }
+
+    void Arena::FreeBlocks(Block* block)
+    {
+        while (block)
+        {
+            Block* next = block->next;
+            mem::Free(block, block->size, alignof(std::max_align_t), category);
+            block = next;
+        }
+    }
+
+    void* Arena::Allocate(size_t size, size_t alignment)
+    {
+        if (current)
+        {
+            uintptr_t base = (uintptr_t)current;
+            uintptr_t aligned = (base + current->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+            if (aligned + size <= base + current->size)
+            {
+                current->used = aligned + size - base;
+                return (void*)aligned;
+            }
+        }
+
+        // the rest of the current block is wasted, Reset folds the chain into one block later
+        Block* block = NewBlock(SDL_max(block_size, size + alignment));
+        if (current)
+            current->next = block;
+        else
+            first = block;
+        current = block;
+
+        uintptr_t base = (uintptr_t)block;
+        uintptr_t aligned = (base + block->used + alignment - 1) & ~(uintptr_t)(alignment - 1);
+        block->used = aligned + size - base;
+        return (void*)aligned;
+    }
+
+    void Arena::Reset()
+    {
+        if (first && first->next)
+        {
+            // one block big enough for everything the last round needed
+            size_t total = reserved;
+            Release();
+            first = current = NewBlock(total);
+            return;
+        }
+
+        if (first)
+            first->used = kBlockHeader;
+        current = first;
+    }
+
+    void Arena::Release()
+    {
+        FreeBlocks(first);
+        first = current = nullptr;
+        reserved = 0;
+    }
+
+    size_t Arena::BytesUsed() const
+    {
+        size_t used = 0;
+        for (const Block* block = first; block; block = block->next)
+            used += block->used - kBlockHeader;
+        return used;
+    }
+
+    uint32_t Arena::BlockCount() const
+    {
+        uint32_t count = 0;
+        for (const Block* block = first; block; block = block->next)
+            count++;
+        return count;
+    }
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Allocators for the three lifetimes the engine has: per frame (an Arena reset
+// in Renderer::PostRender), per asset or level (an Arena released with it) and
+// long-lived fixed-size objects addressed by handle (Pool). Every byte any of
+// them takes from the system heap is counted against a category.
+//
+// Arena and the heap resources derive from std::pmr::memory_resource, so
+// std::pmr containers (Mesh storage among them) can live in any of them.
+namespace mem
+{
+    enum Category
+    {
+        CATEGORY_GENERAL,
+        CATEGORY_FRAME,         // per-frame scratch
+        CATEGORY_MESH,          // vertex, index and skin data on the CPU
+        CATEGORY_TEXTURE,       // streamer bookkeeping, not the decoded pixels
+        CATEGORY_RENDERER,      // renderer state and subsystems
+        CATEGORY_IMPORT,        // model import scratch
+        CATEGORY_COUNT,
+    };
+
+    struct CategoryStats
+    {
+        uint64_t bytes = 0;             // currently held from the heap
+        uint64_t peak_bytes = 0;
+        uint64_t allocations = 0;       // heap allocations made so far
+        uint64_t frees = 0;
+    };
+
+    const char* CategoryName(Category category);
+    void Track(Category category, size_t bytes);
+    void Untrack(Category category, size_t bytes);
+    CategoryStats GetCategoryStats(Category category);
+    void LogCategoryStats();
+
+    // tracked system heap, the counterpart of free/delete
+    void* Allocate(size_t size, size_t alignment, Category category);
+    void Free(void* ptr, size_t size, size_t alignment, Category category);
+
+    template<typename T, typename... Args>
+    T* New(Category category, Args&&... args)
+    {
+        void* ptr = Allocate(sizeof(T), alignof(T), category);
+        return new (ptr) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void Delete(Category category, T* object)
+    {
+        if (object == nullptr)
+            return;
+        object->~T();
+        Free(object, sizeof(T), alignof(T), category);
+    }
+
+    // plain heap behind a memory_resource, counted against its category. One per category, never destroyed
+    std::pmr::memory_resource* HeapResource(Category category);
+
+    // Linear allocator: allocations bump a pointer through a chain of blocks and
+    // are only given back all at once. Reset keeps the memory for the next round
+    // and merges a chain that grew into one block of the combined size, so a
+    // per-frame arena stops touching the heap after its first frames.
+    // Not thread safe.
+    class Arena : public std::pmr::memory_resource
+    {
+    public:
+        explicit Arena(size_t block_size = 64 * 1024, Category category = CATEGORY_GENERAL);
+        ~Arena();
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        // uninitialized, for trivially constructible types
+        template<typename T>
+        T* AllocateArray(size_t count) { return (T*)Allocate(count * sizeof(T), alignof(T)); }
+
+        // everything allocated so far becomes invalid, destructors are not run
+        void Reset();
+        // Reset and give every block back to the heap
+        void Release();
+
+        size_t BytesUsed() const;
+        size_t BytesReserved() const { return reserved; }
+        uint32_t BlockCount() const;
+        Category GetCategory() const { return category; }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override { return Allocate(bytes, alignment); }
+        void do_deallocate(void*, size_t, size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    private:
+        struct Block
+        {
+            Block* next;
+            size_t size;                // bytes including this header
+            size_t used;                // from the block start, header included
+        };
+
+        Block* NewBlock(size_t size);
+        void FreeBlocks(Block* block);
+
+        Block* first = nullptr;
+        Block* current = nullptr;
+        size_t block_size;
+        size_t reserved = 0;
+        Category category;
+    };
+
+    // Fixed-size slots for objects that live until destroyed and are addressed
+    // by a 32-bit handle, like GPU resource entries. Slots come in chunks of
+    // kChunkSize, so growing never moves an object and a pointer handed to
+    // another thread stays valid while the owner creates more. Not thread safe
+    // itself. Handles of destroyed objects are reused.
+    template<typename T>
+    class Pool
+    {
+    public:
+        static const uint32_t kChunkSize = 256;
+
+        explicit Pool(Category _category = CATEGORY_GENERAL) : category(_category) {}
+        ~Pool()
+        {
+            for (uint32_t handle = 0; handle < slots; handle++)
+            {
+                if (alive[handle])
+                    (*this)[handle].~T();
+            }
+            for (T* chunk : chunks)
+                Free(chunk, sizeof(T) * kChunkSize, alignof(T), category);
+        }
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        template<typename... Args>
+        uint32_t Create(Args&&... args)
+        {
+            uint32_t handle;
+            if (!free_handles.empty())
+            {
+                handle = free_handles.back();
+                free_handles.pop_back();
+            }
+            else
+            {
+                handle = slots++;
+                if (handle / kChunkSize >= chunks.size())
+                    chunks.push_back((T*)Allocate(sizeof(T) * kChunkSize, alignof(T), category));
+                alive.push_back(0);
+            }
+            new (&(*this)[handle]) T(std::forward<Args>(args)...);
+            alive[handle] = 1;
+            count++;
+            return handle;
+        }
+
+        void Destroy(uint32_t handle)
+        {
+            if (handle >= slots || !alive[handle])
+                return;
+            (*this)[handle].~T();
+            alive[handle] = 0;
+            free_handles.push_back(handle);
+            count--;
+        }
+
+        T& operator[](uint32_t handle) { return chunks[handle / kChunkSize][handle % kChunkSize]; }
+        const T& operator[](uint32_t handle) const { return chunks[handle / kChunkSize][handle % kChunkSize]; }
+
+        bool IsAlive(uint32_t handle) const { return handle < slots && alive[handle]; }
+        // every handle handed out so far is below this
+        uint32_t Slots() const { return slots; }
+        uint32_t Count() const { return count; }
+
+    private:
+        std::vector<T*> chunks;
+        std::vector<uint8_t> alive;
+        std::vector<uint32_t> free_handles;
+        uint32_t slots = 0;
+        uint32_t count = 0;
+        Category category;
+    };
+}
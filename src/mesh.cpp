@@ -0,0 +1,52 @@
+#include "mesh.h"
+
+Mesh::Mesh(std::span<const Vertex> _vertices, std::span<const uint32_t> _indices, std::span<const Texture> _textures,
+	std::pmr::memory_resource* resource)
+	: vertices(_vertices.begin(), _vertices.end(), resource), indices(resource),
+	textures(_textures.begin(), _textures.end(), resource), skin(resource), lods(resource)
+{
+	index_count = (uint32_t)_indices.size();
+	lods.push_back({ 0, index_count, 0.0f });
+
+	// 16 bit indices halve index fetch bandwidth, use them whenever every vertex is addressable
+	if (vertices.size() <= 0xFFFF)
+	{
+		index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+		indices.resize(_indices.size() * sizeof(uint16_t));
+		uint16_t* dst = (uint16_t*)indices.data();
+		for (size_t i = 0; i < _indices.size(); i++)
+			dst[i] = (uint16_t)_indices[i];
+	}
+	else
+	{
+		index_size = SDL_GPU_INDEXELEMENTSIZE_32BIT;
+		indices.resize(_indices.size() * sizeof(uint32_t));
+		SDL_memcpy(indices.data(), _indices.data(), indices.size());
+	}
+}
+
+void Mesh::AddLod(std::span<const uint32_t> lod_indices, float error)
+{
+	SDL_assert(lods.size() < kMaxLods);
+	size_t element = index_size == SDL_GPU_INDEXELEMENTSIZE_16BIT ? sizeof(uint16_t) : sizeof(uint32_t);
+	size_t first = indices.size() / element;
+	indices.resize(indices.size() + lod_indices.size() * element);
+	if (element == sizeof(uint16_t))
+	{
+		uint16_t* dst = (uint16_t*)indices.data() + first;
+		for (size_t i = 0; i < lod_indices.size(); i++)
+			dst[i] = (uint16_t)lod_indices[i];
+	}
+	else
+	{
+		SDL_memcpy((uint32_t*)indices.data() + first, lod_indices.data(), lod_indices.size() * sizeof(uint32_t));
+	}
+	lods.push_back({ (uint32_t)first, (uint32_t)lod_indices.size(), error });
+}
+
+uint32_t Mesh::Index(size_t i) const
+{
+	if (index_size == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+		return ((const uint16_t*)indices.data())[i];
+	return ((const uint32_t*)indices.data())[i];
+}
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include "glm/glm.hpp"
 #include <string>
+#include "memory.h"
 #include "shader.h"
 
 struct Vertex
@@ -12,21 +15,76 @@ struct Vertex
 	glm::vec2 tex_coords;
 };
 
+// Per-vertex skinning influences, kept in a separate stream so static meshes
+// don't pay for them and the skinned output keeps the plain Vertex layout.
+struct VertexSkin
+{
+	uint8_t joints[4];
+	float weights[4];
+};
+
 struct Texture
 {
 	uint32_t id;
-	std::string type;
+	const char* type = "";	// static string, "texture_diffuse" and the like
+	std::string path;
 };
 
+// Vertices are stored interleaved in one contiguous array and indices are packed
+// to 16 bits whenever the vertex count allows it, so both can be copied into a
+// transfer buffer with a single memcpy each.
+//
+// Levels of detail share the vertex array: every LOD is a range of the one
+// index array, LOD 0 first (see lod::GenerateLods).
+//
+// All arrays live in the memory resource given at construction: the tracked
+// mesh heap by default, or an asset Arena that frees a whole level's meshes at
+// once. The resource must outlive the mesh.
 class Mesh
 {
-	std::vector<Vertex> vertices;
-	std::vector<uint32_t> indices;
-	std::vector<Texture> textures;
 public:
-	Mesh(std::vector<Vertex> _vertices, std::vector<uint32_t> _indices, std::vector<Texture> _textures);
+	static const uint32_t kMaxLods = 5;
+
+	struct MeshLod
+	{
+		uint32_t first_index;
+		uint32_t index_count;
+		float error;		// geometric error relative to the largest extent of the bounds, 0 for LOD 0
+	};
+
+private:
+	std::pmr::vector<Vertex> vertices;
+	std::pmr::vector<uint8_t> indices;
+	SDL_GPUIndexElementSize index_size;
+	uint32_t index_count;
+	std::pmr::vector<Texture> textures;
+	std::pmr::vector<VertexSkin> skin;
+	std::pmr::vector<MeshLod> lods;
+public:
+	Mesh(std::span<const Vertex> _vertices, std::span<const uint32_t> _indices, std::span<const Texture> _textures,
+		std::pmr::memory_resource* resource = mem::HeapResource(mem::CATEGORY_MESH));
 
-	std::vector<Vertex>& Vertices() { return vertices; }
-	std::vector<uint32_t>& Indices() { return indices; }
-	std::vector<Texture>& Textures() { return textures; }
-};
\ No newline at end of file
+	std::pmr::vector<Vertex>& Vertices() { return vertices; }
+	std::pmr::vector<Texture>& Textures() { return textures; }
+	const std::pmr::vector<Vertex>& Vertices() const { return vertices; }
+	const std::pmr::vector<Texture>& Textures() const { return textures; }
+
+	// empty for static meshes, otherwise one entry per vertex
+	void SetSkin(std::span<const VertexSkin> _skin) { skin.assign(_skin.begin(), _skin.end()); }
+	const std::pmr::vector<VertexSkin>& Skin() const { return skin; }
+	bool IsSkinned() const { return !skin.empty(); }
+
+	const uint8_t* IndexData() const { return indices.data(); }
+	// of LOD 0
+	uint32_t IndexCount() const { return index_count; }
+	uint32_t Index(size_t i) const;
+	SDL_GPUIndexElementSize IndexSize() const { return index_size; }
+
+	size_t VertexBytes() const { return vertices.size() * sizeof(Vertex); }
+	size_t IndexBytes() const { return indices.size(); }		// every LOD
+
+	// appends a coarser LOD, its indices refer to the shared vertices
+	void AddLod(std::span<const uint32_t> lod_indices, float error);
+	uint32_t LodCount() const { return (uint32_t)lods.size(); }
+	const MeshLod& Lod(uint32_t lod) const { return lods[lod]; }
+};
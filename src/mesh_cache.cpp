@@ -0,0 +1,344 @@
+#include "mesh_cache.h"
+#include "hash.h"
+
+#include <SDL3/SDL.h>
+
+namespace meshcache
+{
+    // On-disk layout, native endian:
+    // FileHeader | MeshRecord[] | TextureRecord[] | strings | vertex section | index section
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t source_hash;
+        uint64_t settings_hash;
+        uint32_t mesh_count;
+        uint32_t texture_count;
+        uint32_t vertex_stride;
+        uint32_t strings_size;
+        uint32_t vertex_layout;     // vtx::LayoutId, never skinned
+        uint32_t padding;
+        uint64_t vertex_data_offset;
+        uint64_t vertex_data_size;
+        uint64_t index_data_offset;
+        uint64_t index_data_size;
+    };
+
+    struct LodRecord
+    {
+        uint32_t first_index;
+        uint32_t index_count;
+        float error;
+    };
+
+    struct MeshRecord
+    {
+        uint64_t vertex_offset;
+        uint64_t index_offset;
+        uint32_t vertex_count;
+        uint32_t index_count;       // of LOD 0
+        uint32_t index_size;        // bytes per index, 2 or 4
+        uint32_t first_texture;
+        uint32_t texture_count;
+        float bounds_min[3];
+        float bounds_max[3];
+        uint32_t lod_count;
+        LodRecord lods[Mesh::kMaxLods];
+        uint32_t padding;
+    };
+
+    struct TextureRecord
+    {
+        uint32_t type_offset;
+        uint32_t type_length;
+        uint32_t path_offset;
+        uint32_t path_length;
+    };
+
+    static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // [offset, offset + size) lies inside [0, limit), without overflowing on corrupt values
+    static bool InRange(uint64_t offset, uint64_t size, uint64_t limit)
+    {
+        return offset <= limit && size <= limit - offset;
+    }
+
+    // a string of the table and its terminator
+    static bool IsValidString(const char* strings, uint32_t strings_size, uint32_t offset, uint32_t length)
+    {
+        return InRange(offset, (uint64_t)length + 1, strings_size) && strings[offset + length] == '\0';
+    }
+
+    bool MeshCache::Open(const char* path)
+    {
+        Close();
+
+        if (!file.Open(path))
+            return false;
+
+        const uint8_t* base = file.Data();
+        size_t size = file.Size();
+        if (size < sizeof(FileHeader))
+        {
+            SDL_Log("Mesh cache %s is truncated", path);
+            file.Close();
+            return false;
+        }
+
+        const FileHeader* h = (const FileHeader*)base;
+        if (h->magic != kMagic || h->version != kVersion || h->vertex_layout >= vtx::LAYOUT_COUNT
+            || h->vertex_stride != vtx::MakeLayout((vtx::LayoutId)h->vertex_layout, false).stride)
+        {
+            SDL_Log("Mesh cache %s has an incompatible format", path);
+            file.Close();
+            return false;
+        }
+
+        uint64_t tables_end = sizeof(FileHeader)
+            + (uint64_t)h->mesh_count * sizeof(MeshRecord)
+            + (uint64_t)h->texture_count * sizeof(TextureRecord)
+            + h->strings_size;
+        if (tables_end > h->vertex_data_offset
+            || !InRange(h->vertex_data_offset, h->vertex_data_size, h->index_data_offset)
+            || !InRange(h->index_data_offset, h->index_data_size, size))
+        {
+            SDL_Log("Mesh cache %s is corrupt", path);
+            file.Close();
+            return false;
+        }
+
+        // every record is checked once here, GetMesh and GetTexture hand out pointers without checks
+        const MeshRecord* mesh_records = (const MeshRecord*)(base + sizeof(FileHeader));
+        const TextureRecord* texture_records = (const TextureRecord*)(mesh_records + h->mesh_count);
+        const char* string_table = (const char*)(texture_records + h->texture_count);
+        for (uint32_t i = 0; i < h->mesh_count; i++)
+        {
+            const MeshRecord& record = mesh_records[i];
+            bool valid = (record.index_size == 2 || record.index_size == 4)
+                && record.lod_count >= 1 && record.lod_count <= Mesh::kMaxLods
+                && InRange(record.vertex_offset, (uint64_t)record.vertex_count * h->vertex_stride, h->vertex_data_size)
+                && InRange(record.index_offset, (uint64_t)record.index_count * record.index_size, h->index_data_size)
+                && InRange(record.first_texture, record.texture_count, h->texture_count);
+            // LODs are ranges of the mesh's indices, which start at index_offset
+            for (uint32_t l = 0; valid && l < record.lod_count; l++)
+            {
+                const LodRecord& lod = record.lods[l];
+                uint64_t end = ((uint64_t)lod.first_index + lod.index_count) * record.index_size;
+                valid = InRange(record.index_offset, end, h->index_data_size);
+            }
+            if (!valid)
+            {
+                SDL_Log("Mesh cache %s is corrupt: mesh %u is out of bounds", path, i);
+                file.Close();
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < h->texture_count; i++)
+        {
+            const TextureRecord& record = texture_records[i];
+            if (!IsValidString(string_table, h->strings_size, record.type_offset, record.type_length)
+                || !IsValidString(string_table, h->strings_size, record.path_offset, record.path_length))
+            {
+                SDL_Log("Mesh cache %s is corrupt: texture %u names are out of bounds", path, i);
+                file.Close();
+                return false;
+            }
+        }
+
+        header = h;
+        meshes = mesh_records;
+        textures = texture_records;
+        strings = string_table;
+        return true;
+    }
+
+    void MeshCache::Close()
+    {
+        file.Close();
+        header = nullptr;
+        meshes = nullptr;
+        textures = nullptr;
+        strings = nullptr;
+    }
+
+    uint64_t MeshCache::SourceHash() const { return header ? header->source_hash : 0; }
+    uint64_t MeshCache::SettingsHash() const { return header ? header->settings_hash : 0; }
+
+    bool MeshCache::IsUpToDate(const char* source_path, const model::ImportSettings& settings) const
+    {
+        if (!header || header->settings_hash != HashSettings(settings))
+            return false;
+        return header->source_hash == HashFile(source_path);
+    }
+
+    vtx::LayoutId MeshCache::VertexLayout() const { return header ? (vtx::LayoutId)header->vertex_layout : vtx::LAYOUT_FULL; }
+    uint32_t MeshCache::MeshCount() const { return header ? header->mesh_count : 0; }
+    uint32_t MeshCache::TextureCount() const { return header ? header->texture_count : 0; }
+
+    MeshView MeshCache::GetMesh(uint32_t index) const
+    {
+        const MeshRecord& record = meshes[index];
+
+        MeshView view{};
+        view.vertex_offset = record.vertex_offset;
+        view.index_offset = record.index_offset;
+        view.vertices = VertexData() + record.vertex_offset;
+        view.vertex_count = record.vertex_count;
+        view.indices = IndexData() + record.index_offset;
+        view.index_count = record.index_count;
+        view.index_size = record.index_size == 2 ? SDL_GPU_INDEXELEMENTSIZE_16BIT : SDL_GPU_INDEXELEMENTSIZE_32BIT;
+        view.first_texture = record.first_texture;
+        view.texture_count = record.texture_count;
+        view.bounds_min = glm::vec3(record.bounds_min[0], record.bounds_min[1], record.bounds_min[2]);
+        view.bounds_max = glm::vec3(record.bounds_max[0], record.bounds_max[1], record.bounds_max[2]);
+        // full layouts ignore it, quantized ones are relative to the bounds
+        view.quantization.offset = view.bounds_min;
+        view.quantization.scale = view.bounds_max - view.bounds_min;
+        view.lod_count = record.lod_count;
+        for (uint32_t i = 0; i < view.lod_count; i++)
+            view.lods[i] = { record.lods[i].first_index, record.lods[i].index_count, record.lods[i].error };
+        return view;
+    }
+
+    TextureView MeshCache::GetTexture(uint32_t index) const
+    {
+        const TextureRecord& record = textures[index];
+        TextureView view;
+        view.type = std::string_view(strings + record.type_offset, record.type_length);
+        view.path = std::string_view(strings + record.path_offset, record.path_length);
+        return view;
+    }
+
+    const uint8_t* MeshCache::VertexData() const { return file.Data() + header->vertex_data_offset; }
+    uint64_t MeshCache::VertexDataSize() const { return header->vertex_data_size; }
+    const uint8_t* MeshCache::IndexData() const { return file.Data() + header->index_data_offset; }
+    uint64_t MeshCache::IndexDataSize() const { return header->index_data_size; }
+
+    bool Bake(const char* path, const std::vector<Mesh>& meshes, uint64_t source_hash, uint64_t settings_hash, vtx::LayoutId layout_id)
+    {
+        // the cache holds no skin stream, skinned meshes bake their bind pose only
+        vtx::Layout layout = vtx::MakeLayout(layout_id, false);
+        std::vector<vtx::Quantization> quantizations;
+        std::vector<MeshRecord> mesh_records;
+        std::vector<TextureRecord> texture_records;
+        std::string string_table;
+
+        uint64_t vertex_size = 0;
+        uint64_t index_size = 0;
+        for (const Mesh& mesh : meshes)
+        {
+            MeshRecord record{};
+            // per-mesh ranges stay aligned so they can be bound at their offset directly
+            record.vertex_offset = vertex_size;
+            record.vertex_count = (uint32_t)mesh.Vertices().size();
+            record.index_offset = index_size;
+            record.index_count = mesh.IndexCount();
+            record.index_size = mesh.IndexSize() == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 2 : 4;
+            record.first_texture = (uint32_t)texture_records.size();
+            record.texture_count = (uint32_t)mesh.Textures().size();
+            record.lod_count = mesh.LodCount();
+            for (uint32_t i = 0; i < mesh.LodCount(); i++)
+                record.lods[i] = { mesh.Lod(i).first_index, mesh.Lod(i).index_count, mesh.Lod(i).error };
+            vtx::Quantization quantization = vtx::ComputeQuantization(mesh.Vertices().data(), mesh.Vertices().size());
+            for (int k = 0; k < 3; k++)
+            {
+                record.bounds_min[k] = quantization.offset[k];
+                record.bounds_max[k] = quantization.offset[k] + quantization.scale[k];
+                // exactly what GetMesh will hand the decoder
+                quantization.scale[k] = record.bounds_max[k] - record.bounds_min[k];
+            }
+            quantizations.push_back(quantization);
+            mesh_records.push_back(record);
+
+            vertex_size = AlignUp(vertex_size + (uint64_t)record.vertex_count * layout.stride, 16);
+            index_size = AlignUp(index_size + mesh.IndexBytes(), 16);
+
+            for (const Texture& texture : mesh.Textures())
+            {
+                TextureRecord tex{};
+                tex.type_offset = (uint32_t)string_table.size();
+                // NUL terminated, the views can be used as C strings
+                tex.type_length = (uint32_t)SDL_strlen(texture.type);
+                string_table += texture.type;
+                string_table += '\0';
+                tex.path_offset = (uint32_t)string_table.size();
+                tex.path_length = (uint32_t)texture.path.size();
+                string_table += texture.path;
+                string_table += '\0';
+                texture_records.push_back(tex);
+            }
+        }
+
+        FileHeader header{};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.source_hash = source_hash;
+        header.settings_hash = settings_hash;
+        header.mesh_count = (uint32_t)mesh_records.size();
+        header.texture_count = (uint32_t)texture_records.size();
+        header.vertex_stride = layout.stride;
+        header.vertex_layout = layout_id;
+        header.strings_size = (uint32_t)string_table.size();
+
+        uint64_t tables_end = sizeof(FileHeader)
+            + mesh_records.size() * sizeof(MeshRecord)
+            + texture_records.size() * sizeof(TextureRecord)
+            + string_table.size();
+        header.vertex_data_offset = AlignUp(tables_end, kSectionAlignment);
+        header.vertex_data_size = vertex_size;
+        header.index_data_offset = AlignUp(header.vertex_data_offset + vertex_size, kSectionAlignment);
+        header.index_data_size = index_size;
+
+        // the file is assembled in memory once and written with a single call
+        std::vector<uint8_t> blob(header.index_data_offset + index_size, 0);
+        uint8_t* out = blob.data();
+        SDL_memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+        if (!mesh_records.empty())
+            SDL_memcpy(out, mesh_records.data(), mesh_records.size() * sizeof(MeshRecord));
+        out += mesh_records.size() * sizeof(MeshRecord);
+        if (!texture_records.empty())
+            SDL_memcpy(out, texture_records.data(), texture_records.size() * sizeof(TextureRecord));
+        out += texture_records.size() * sizeof(TextureRecord);
+        if (!string_table.empty())
+            SDL_memcpy(out, string_table.data(), string_table.size());
+
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const Mesh& mesh = meshes[i];
+            vtx::Encode(layout, quantizations[i], mesh.Vertices().data(), nullptr, mesh.Vertices().size(),
+                blob.data() + header.vertex_data_offset + mesh_records[i].vertex_offset);
+            if (mesh.IndexBytes())
+                SDL_memcpy(blob.data() + header.index_data_offset + mesh_records[i].index_offset, mesh.IndexData(), mesh.IndexBytes());
+        }
+
+        if (!SDL_SaveFile(path, blob.data(), blob.size()))
+        {
+            SDL_Log("Failed to write mesh cache %s: %s", path, SDL_GetError());
+            return false;
+        }
+        return true;
+    }
+
+    uint64_t HashFile(const char* path)
+    {
+        MappedFile source;
+        if (!source.Open(path))
+            return 0;
+        return hash::Murmur64(source.Data(), source.Size());
+    }
+
+    uint64_t HashSettings(const model::ImportSettings& settings)
+    {
+        uint64_t h = hash::Combine(kMagic, kVersion);
+        h = hash::Combine(h, settings.generate_normals);
+        h = hash::Combine(h, settings.flip_uvs);
+        h = hash::Combine(h, settings.optimize);
+        h = hash::Combine(h, settings.lod_count);
+        return h;
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+#include "mesh.h"
+#include "model.h"
+#include "vertex_format.h"
+
+// Baked mesh cache (.skmesh). Produced offline by the mesh_bake tool, loaded at
+// runtime with a single mmap. All vertex data lives in one section and all index
+// data in another, so a whole model uploads with two memcpys straight from the
+// mapping. Vertices are stored in one vtx layout for the whole file, quantized
+// layouts decode with the per-mesh bounds. A mesh's LODs are ranges of its
+// index data, all over the same vertices.
+namespace meshcache
+{
+    static const uint32_t kMagic = 0x434D4B53; // "SKMC"
+    static const uint32_t kVersion = 4;     // 4: NUL terminated texture strings
+    static const uint32_t kSectionAlignment = 64;
+
+    struct FileHeader;
+    struct MeshRecord;
+    struct TextureRecord;
+
+    struct MeshView
+    {
+        const uint8_t* vertices;    // in the file's VertexLayout()
+        uint32_t vertex_count;
+        const uint8_t* indices;
+        uint32_t index_count;       // of LOD 0
+        SDL_GPUIndexElementSize index_size;
+        uint64_t vertex_offset;     // byte offset inside VertexData()
+        uint64_t index_offset;      // byte offset inside IndexData()
+        uint32_t first_texture;
+        uint32_t texture_count;
+        glm::vec3 bounds_min;       // object space, exact
+        glm::vec3 bounds_max;
+        vtx::Quantization quantization;
+        uint32_t lod_count;         // at least 1
+        Mesh::MeshLod lods[Mesh::kMaxLods];    // first_index relative to indices
+    };
+
+    // both point into the string table and are NUL terminated
+    struct TextureView
+    {
+        std::string_view type;
+        std::string_view path;
+    };
+
+    class MeshCache
+    {
+        MappedFile file;
+        const FileHeader* header = nullptr;
+        const MeshRecord* meshes = nullptr;
+        const TextureRecord* textures = nullptr;
+        const char* strings = nullptr;
+    public:
+        bool Open(const char* path);
+        void Close();
+
+        bool IsOpen() const { return header != nullptr; }
+        uint64_t SourceHash() const;
+        uint64_t SettingsHash() const;
+        // true when the cache was baked from this exact source file with these settings
+        bool IsUpToDate(const char* source_path, const model::ImportSettings& settings) const;
+
+        vtx::LayoutId VertexLayout() const;
+        uint32_t MeshCount() const;
+        MeshView GetMesh(uint32_t index) const;
+        uint32_t TextureCount() const;
+        TextureView GetTexture(uint32_t index) const;
+
+        const uint8_t* VertexData() const;
+        uint64_t VertexDataSize() const;
+        const uint8_t* IndexData() const;
+        uint64_t IndexDataSize() const;
+    };
+
+    bool Bake(const char* path, const std::vector<Mesh>& meshes, uint64_t source_hash, uint64_t settings_hash,
+        vtx::LayoutId layout = vtx::LAYOUT_FULL);
+
+    // Cache keys. HashSettings also covers the format version so a bump invalidates old files.
+    uint64_t HashFile(const char* path);
+    uint64_t HashSettings(const model::ImportSettings& settings);
+}
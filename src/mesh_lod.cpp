@@ -0,0 +1,618 @@
+#include "mesh_lod.h"
+#include "bounds.h"
+#include "mesh_optimizer.h"
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <vector>
+
+namespace lod
+{
+    enum VertexKind : uint8_t
+    {
+        KIND_MANIFOLD,
+        KIND_BORDER,        // on an open boundary, slides along it
+        KIND_SEAM,          // on a line where two wedges split the attributes, slides along it
+        KIND_LOCKED,        // corners, seam ends, non-manifold, never moves
+    };
+
+    // boundary planes are this much stiffer than the surface, so borders and seams keep their shape
+    static const float kBoundaryWeight = 10.0f;
+    static const uint32_t kNone = ~0u;
+
+    // sum over planes of weight * (dot(n, p) + d)^2 = p'Ap + 2b'p + c
+    struct Quadric
+    {
+        float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f, a01 = 0.0f, a12 = 0.0f, a02 = 0.0f;
+        float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, c = 0.0f;
+        float area = 0.0f;  // of the triangles in it, normalizes the error to a mean squared distance
+    };
+
+    static void AddPlane(Quadric& q, const glm::vec3& n, float d, float weight)
+    {
+        q.a00 += weight * n.x * n.x;
+        q.a11 += weight * n.y * n.y;
+        q.a22 += weight * n.z * n.z;
+        q.a01 += weight * n.x * n.y;
+        q.a12 += weight * n.y * n.z;
+        q.a02 += weight * n.x * n.z;
+        q.b0 += weight * n.x * d;
+        q.b1 += weight * n.y * d;
+        q.b2 += weight * n.z * d;
+        q.c += weight * d * d;
+    }
+
+    static Quadric Sum(const Quadric& a, const Quadric& b)
+    {
+        Quadric q;
+        q.a00 = a.a00 + b.a00; q.a11 = a.a11 + b.a11; q.a22 = a.a22 + b.a22;
+        q.a01 = a.a01 + b.a01; q.a12 = a.a12 + b.a12; q.a02 = a.a02 + b.a02;
+        q.b0 = a.b0 + b.b0; q.b1 = a.b1 + b.b1; q.b2 = a.b2 + b.b2;
+        q.c = a.c + b.c;
+        q.area = a.area + b.area;
+        return q;
+    }
+
+    static float Evaluate(const Quadric& q, const glm::vec3& p)
+    {
+        float rx = q.a00 * p.x + q.a01 * p.y + q.a02 * p.z;
+        float ry = q.a01 * p.x + q.a11 * p.y + q.a12 * p.z;
+        float rz = q.a02 * p.x + q.a12 * p.y + q.a22 * p.z;
+        float r = rx * p.x + ry * p.y + rz * p.z + 2.0f * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+        return fabsf(r);
+    }
+
+    // a face edge from one vertex to the next, listed under the position it leaves
+    struct HalfEdge
+    {
+        uint32_t to;        // position id of the end
+        uint32_t from_vertex;
+        uint32_t to_vertex;
+    };
+
+    // first vertex of each distinct position, so wedges of one position share an id
+    static void BuildPositionRemap(const Vertex* vertices, size_t vertex_count, std::vector<uint32_t>& remap, std::vector<uint32_t>& next_wedge)
+    {
+        size_t table_size = 1;
+        while (table_size < vertex_count * 2)
+            table_size <<= 1;
+        std::vector<uint32_t> table(table_size, kNone);
+
+        remap.resize(vertex_count);
+        next_wedge.resize(vertex_count);
+        for (size_t i = 0; i < vertex_count; i++)
+        {
+            uint32_t bits[3];
+            SDL_memcpy(bits, &vertices[i].position, sizeof(bits));
+            uint32_t h = (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+            size_t slot = h & (table_size - 1);
+            while (table[slot] != kNone && SDL_memcmp(&vertices[table[slot]].position, bits, sizeof(bits)) != 0)
+                slot = (slot + 1) & (table_size - 1);
+
+            if (table[slot] == kNone)
+            {
+                table[slot] = (uint32_t)i;
+                remap[i] = (uint32_t)i;
+                next_wedge[i] = (uint32_t)i;
+            }
+            else
+            {
+                // splice into the circular list of the position's wedges
+                uint32_t first = table[slot];
+                remap[i] = first;
+                next_wedge[i] = next_wedge[first];
+                next_wedge[first] = (uint32_t)i;
+            }
+        }
+    }
+
+    static float AttributeDistance(const Vertex* vertices, const VertexSkin* skin, uint32_t a, uint32_t b, const SimplifySettings& settings)
+    {
+        glm::vec3 dn = vertices[a].normal - vertices[b].normal;
+        glm::vec2 duv = vertices[a].tex_coords - vertices[b].tex_coords;
+        float distance = settings.normal_weight * glm::dot(dn, dn) + settings.uv_weight * glm::dot(duv, duv);
+        if (skin)
+        {
+            // difference of the two influence vectors over the union of their joints
+            uint8_t joints[8];
+            float deltas[8];
+            int count = 0;
+            auto add = [&](uint8_t joint, float weight)
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    if (joints[i] == joint)
+                    {
+                        deltas[i] += weight;
+                        return;
+                    }
+                }
+                joints[count] = joint;
+                deltas[count++] = weight;
+            };
+            for (int k = 0; k < 4; k++)
+            {
+                if (skin[a].weights[k] > 0.0f)
+                    add(skin[a].joints[k], skin[a].weights[k]);
+            }
+            for (int k = 0; k < 4; k++)
+            {
+                if (skin[b].weights[k] > 0.0f)
+                    add(skin[b].joints[k], -skin[b].weights[k]);
+            }
+            float skin_distance = 0.0f;
+            for (int i = 0; i < count; i++)
+                skin_distance += deltas[i] * deltas[i];
+            distance += settings.skin_weight * skin_distance;
+        }
+        return distance;
+    }
+
+    static void AddLineNeighbor(uint32_t* line, uint32_t neighbor, bool& locked)
+    {
+        if (line[0] == neighbor || line[1] == neighbor)
+            return;
+        if (line[0] == kNone)
+            line[0] = neighbor;
+        else if (line[1] == kNone)
+            line[1] = neighbor;
+        else
+            locked = true;
+    }
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float error;        // orders the collapses, attribute penalty included
+        float distance;     // geometric part, what the LOD error reports
+    };
+
+    // counting sort on the top 16 bits of the error: positive floats order like their
+    // bit patterns, and the greedy pass does not need a finer order than that
+    static void SortCollapses(std::vector<Collapse>& collapses, std::vector<Collapse>& scratch, std::vector<uint32_t>& histogram)
+    {
+        histogram.assign(1 << 16, 0);
+        for (const Collapse& collapse : collapses)
+        {
+            uint32_t bits;
+            SDL_memcpy(&bits, &collapse.error, sizeof(bits));
+            histogram[bits >> 16]++;
+        }
+        uint32_t offset = 0;
+        for (uint32_t& bucket : histogram)
+        {
+            uint32_t size = bucket;
+            bucket = offset;
+            offset += size;
+        }
+        scratch.resize(collapses.size());
+        for (const Collapse& collapse : collapses)
+        {
+            uint32_t bits;
+            SDL_memcpy(&bits, &collapse.error, sizeof(bits));
+            scratch[histogram[bits >> 16]++] = collapse;
+        }
+        collapses.swap(scratch);
+    }
+
+    size_t Simplify(const Vertex* vertices, const VertexSkin* skin, size_t vertex_count, const uint32_t* indices, size_t index_count,
+        size_t target_index_count, const SimplifySettings& settings, uint32_t* out, float* error)
+    {
+        if (error)
+            *error = 0.0f;
+
+        std::vector<uint32_t> remap, next_wedge;
+        BuildPositionRemap(vertices, vertex_count, remap, next_wedge);
+
+        // work in bounds relative positions so errors come out relative to the extent
+        Aabb bounds = ComputeBounds(vertices, (uint32_t)vertex_count);
+        glm::vec3 size = vertex_count ? bounds.max - bounds.min : glm::vec3(0.0f);
+        float extent = SDL_max(SDL_max(size.x, size.y), size.z);
+        float inverse_extent = extent > 0.0f ? 1.0f / extent : 1.0f;
+        std::vector<glm::vec3> positions(vertex_count);
+        for (size_t i = 0; i < vertex_count; i++)
+            positions[i] = (vertices[i].position - bounds.min) * inverse_extent;
+
+        // triangles collapsed to a line or point at the start are invisible, drop them
+        std::vector<uint32_t> result;
+        result.reserve(index_count);
+        for (size_t i = 0; i + 2 < index_count; i += 3)
+        {
+            uint32_t a = remap[indices[i]], b = remap[indices[i + 1]], c = remap[indices[i + 2]];
+            if (a != b && b != c && a != c)
+                result.insert(result.end(), indices + i, indices + i + 3);
+        }
+
+        // classify positions by their open (border) and attribute split (seam) edges
+        std::vector<uint8_t> kinds(vertex_count, KIND_MANIFOLD);
+        std::vector<uint32_t> lines(vertex_count * 2, kNone);
+        // boundary planes only steer the collapse order, the reported error comes from the faces
+        std::vector<Quadric> quadrics(vertex_count), boundary_quadrics(vertex_count);
+        {
+            std::vector<uint8_t> locked(vertex_count, 0), border_edges(vertex_count, 0), seam_edges(vertex_count, 0);
+
+            // outgoing half-edges per position, twins are found in the short list of the other end
+            std::vector<uint32_t> edge_offsets(vertex_count + 1, 0);
+            std::vector<HalfEdge> edges(result.size());
+            for (uint32_t index : result)
+                edge_offsets[remap[index] + 1]++;
+            for (size_t v = 0; v < vertex_count; v++)
+                edge_offsets[v + 1] += edge_offsets[v];
+            {
+                std::vector<uint32_t> edge_fill(edge_offsets.begin(), edge_offsets.end() - 1);
+                for (size_t i = 0; i < result.size(); i += 3)
+                {
+                    for (int k = 0; k < 3; k++)
+                    {
+                        uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                        edges[edge_fill[remap[a]]++] = { remap[b], a, b };
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t r[3] = { remap[result[i]], remap[result[i + 1]], remap[result[i + 2]] };
+                glm::vec3 normal = glm::cross(positions[r[1]] - positions[r[0]], positions[r[2]] - positions[r[0]]);
+                float length = glm::length(normal);
+                if (length > 0.0f)
+                {
+                    normal /= length;
+                    float d = -glm::dot(normal, positions[r[0]]);
+                    for (int k = 0; k < 3; k++)
+                    {
+                        AddPlane(quadrics[r[k]], normal, d, length * 0.5f);
+                        quadrics[r[k]].area += length * 0.5f;
+                    }
+                }
+
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t a = result[i + k], b = result[i + (k + 1) % 3];
+                    uint32_t ra = r[k], rb = r[(k + 1) % 3];
+
+                    // more than two faces on an edge
+                    uint32_t same = 0;
+                    for (uint32_t e = edge_offsets[ra]; e < edge_offsets[ra + 1]; e++)
+                        same += edges[e].to == rb;
+                    if (same > 1)
+                        locked[ra] = locked[rb] = 1;
+
+                    bool twin = false, attribute_twin = false;
+                    for (uint32_t e = edge_offsets[rb]; e < edge_offsets[rb + 1]; e++)
+                    {
+                        twin |= edges[e].to == ra;
+                        attribute_twin |= edges[e].from_vertex == b && edges[e].to_vertex == a;
+                    }
+                    bool border = !twin;
+                    bool seam = twin && !attribute_twin;
+                    if (!border && !seam)
+                        continue;
+
+                    uint8_t* counts = border ? border_edges.data() : seam_edges.data();
+                    counts[ra] = (uint8_t)SDL_min(counts[ra] + 1, 255);
+                    counts[rb] = (uint8_t)SDL_min(counts[rb] + 1, 255);
+                    bool lock_a = false, lock_b = false;
+                    AddLineNeighbor(&lines[ra * 2], rb, lock_a);
+                    AddLineNeighbor(&lines[rb * 2], ra, lock_b);
+                    locked[ra] |= lock_a;
+                    locked[rb] |= lock_b;
+
+                    // a plane through the edge, perpendicular to the face, holds the line in place
+                    glm::vec3 edge = positions[rb] - positions[ra];
+                    glm::vec3 side = glm::cross(edge, normal);
+                    float side_length = glm::length(side);
+                    if (length > 0.0f && side_length > 0.0f)
+                    {
+                        side /= side_length;
+                        float d = -glm::dot(side, positions[ra]);
+                        float weight = glm::dot(edge, edge) * kBoundaryWeight;
+                        AddPlane(boundary_quadrics[ra], side, d, weight);
+                        AddPlane(boundary_quadrics[rb], side, d, weight);
+                    }
+                }
+            }
+
+            for (size_t v = 0; v < vertex_count; v++)
+            {
+                if (remap[v] != v)
+                    continue;
+                uint32_t wedges = 1;
+                for (uint32_t w = next_wedge[v]; w != v; w = next_wedge[w])
+                    wedges++;
+
+                // a simple border passes through twice, a simple seam four times, once per side
+                if (locked[v])
+                    kinds[v] = KIND_LOCKED;
+                else if (border_edges[v] == 0 && seam_edges[v] == 0)
+                    kinds[v] = wedges == 1 ? KIND_MANIFOLD : KIND_LOCKED;
+                else if (seam_edges[v] == 0 && border_edges[v] == 2 && wedges == 1)
+                    kinds[v] = KIND_BORDER;
+                else if (border_edges[v] == 0 && seam_edges[v] == 4 && wedges == 2)
+                    kinds[v] = KIND_SEAM;
+                else
+                    kinds[v] = KIND_LOCKED;
+            }
+        }
+
+        auto can_move = [&](uint32_t from, uint32_t to)
+        {
+            uint8_t kind = kinds[from];
+            if (kind == KIND_MANIFOLD)
+                return true;
+            if (kind == KIND_LOCKED)
+                return false;
+            bool along_line = lines[from * 2] == to || lines[from * 2 + 1] == to;
+            return along_line && (kinds[to] == kind || kinds[to] == KIND_LOCKED);
+        };
+
+        auto evaluate = [&](uint32_t from, uint32_t to)
+        {
+            const glm::vec3& p = positions[to];
+            float area = SDL_max(quadrics[from].area + quadrics[to].area, 1e-20f);
+            float distance = (Evaluate(quadrics[from], p) + Evaluate(quadrics[to], p)) / area;
+            // manifold positions never carry boundary planes
+            float boundary = 0.0f;
+            if (kinds[from] != KIND_MANIFOLD || kinds[to] != KIND_MANIFOLD)
+                boundary = (Evaluate(boundary_quadrics[from], p) + Evaluate(boundary_quadrics[to], p)) / area;
+
+            // every wedge moves onto the closest wedge of the target
+            float attribute = 0.0f;
+            uint32_t w = from;
+            do
+            {
+                float closest = FLT_MAX;
+                uint32_t t = to;
+                do
+                {
+                    closest = SDL_min(closest, AttributeDistance(vertices, skin, w, t, settings));
+                    t = next_wedge[t];
+                } while (t != to);
+                attribute = SDL_max(attribute, closest);
+                w = next_wedge[w];
+            } while (w != from);
+            return Collapse{ from, to, sqrtf(distance + boundary + attribute), sqrtf(distance) };
+        };
+
+        size_t target_triangles = target_index_count / 3;
+        float max_error = 0.0f;
+        std::vector<uint32_t> offsets(vertex_count + 1), adjacency, fill;
+        std::vector<Collapse> collapses, sort_scratch;
+        std::vector<uint32_t> histogram;
+        std::vector<uint8_t> touched(vertex_count), moved(vertex_count);
+        std::vector<uint32_t> vertex_target(vertex_count);
+        // only manifold (one wedge) and seam (two wedges) positions ever move
+        uint32_t wedge_moves[2][2];
+
+        while (result.size() / 3 > target_triangles)
+        {
+            size_t triangles = result.size() / 3;
+
+            // triangles around each position
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (uint32_t index : result)
+                offsets[remap[index] + 1]++;
+            for (size_t v = 0; v < vertex_count; v++)
+                offsets[v + 1] += offsets[v];
+            adjacency.resize(result.size());
+            fill.assign(offsets.begin(), offsets.end() - 1);
+            for (size_t t = 0; t < triangles; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                    adjacency[fill[remap[result[t * 3 + k]]]++] = (uint32_t)t;
+            }
+
+            // the cheaper allowed direction of every edge, cheapest first. An inner edge is
+            // seen from both its faces and taken from the one where it runs up; border and
+            // seam edges from both, they may have only one face
+            collapses.clear();
+            for (size_t t = 0; t < triangles; t++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t a = remap[result[t * 3 + k]], b = remap[result[t * 3 + (k + 1) % 3]];
+                    bool on_line = lines[a * 2] == b || lines[a * 2 + 1] == b || lines[b * 2] == a || lines[b * 2 + 1] == a;
+                    if (a > b && !on_line)
+                        continue;
+
+                    Collapse best{ kNone, kNone, FLT_MAX, 0.0f };
+                    if (can_move(a, b))
+                        best = evaluate(a, b);
+                    if (can_move(b, a))
+                    {
+                        Collapse reverse = evaluate(b, a);
+                        if (reverse.error < best.error)
+                            best = reverse;
+                    }
+                    if (best.from != kNone && best.error <= settings.max_error)
+                        collapses.push_back(best);
+                }
+            }
+            SortCollapses(collapses, sort_scratch, histogram);
+
+            // collapse greedily. At most one corner of a face moves per pass, so every
+            // flip test sees current positions, and neither end of a collapse takes
+            // part in another one until the adjacency is rebuilt
+            std::fill(touched.begin(), touched.end(), 0);
+            std::fill(moved.begin(), moved.end(), 0);
+            for (size_t v = 0; v < vertex_count; v++)
+                vertex_target[v] = (uint32_t)v;
+            size_t made = 0;
+            for (const Collapse& collapse : collapses)
+            {
+                if (triangles <= target_triangles)
+                    break;
+                uint32_t from = collapse.from, to = collapse.to;
+                if (touched[from] || touched[to])
+                    continue;
+
+                bool valid = true;
+                size_t removed = 0;
+                for (uint32_t a = offsets[from]; a < offsets[from + 1] && valid; a++)
+                {
+                    const uint32_t* tri = &result[adjacency[a] * 3];
+                    uint32_t r[3] = { remap[tri[0]], remap[tri[1]], remap[tri[2]] };
+                    if (r[0] == to || r[1] == to || r[2] == to)
+                    {
+                        removed++;
+                        continue;
+                    }
+
+                    // the faces that stay must not fold over
+                    glm::vec3 p[3], q[3];
+                    for (int k = 0; k < 3; k++)
+                    {
+                        valid &= r[k] == from || !moved[r[k]];
+                        p[k] = positions[r[k]];
+                        q[k] = r[k] == from ? positions[to] : p[k];
+                    }
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+                    // and must not turn by more than about 75 degrees
+                    float turn = glm::dot(before, after);
+                    valid &= turn > 0.0f && turn * turn > 0.0625f * glm::dot(before, before) * glm::dot(after, after);
+                }
+                if (!valid || removed == 0)
+                    continue;
+
+                // each wedge of from lands on the wedge of to it shares a face with
+                uint32_t moves = 0;
+                uint32_t w = from;
+                do
+                {
+                    uint32_t target = kNone;
+                    bool used = false;
+                    for (uint32_t a = offsets[from]; a < offsets[from + 1]; a++)
+                    {
+                        const uint32_t* tri = &result[adjacency[a] * 3];
+                        if (tri[0] != w && tri[1] != w && tri[2] != w)
+                            continue;
+                        used = true;
+                        for (int k = 0; k < 3; k++)
+                        {
+                            if (remap[tri[k]] == to)
+                                target = tri[k];
+                        }
+                        if (target != kNone)
+                            break;
+                    }
+                    if (used && (target == kNone || moves == 2))
+                    {
+                        valid = false;
+                        break;
+                    }
+                    if (used)
+                    {
+                        wedge_moves[0][moves] = w;
+                        wedge_moves[1][moves] = target;
+                        moves++;
+                    }
+                    w = next_wedge[w];
+                } while (w != from);
+                if (!valid)
+                    continue;
+
+                for (uint32_t m = 0; m < moves; m++)
+                    vertex_target[wedge_moves[0][m]] = wedge_moves[1][m];
+                quadrics[to] = Sum(quadrics[from], quadrics[to]);
+                boundary_quadrics[to] = Sum(boundary_quadrics[from], boundary_quadrics[to]);
+                touched[from] = touched[to] = 1;
+                moved[from] = 1;
+
+                // the line now runs from the other neighbor of from straight to to
+                if (kinds[from] == KIND_BORDER || kinds[from] == KIND_SEAM)
+                {
+                    uint32_t other = lines[from * 2] == to ? lines[from * 2 + 1] : lines[from * 2];
+                    for (int k = 0; k < 2; k++)
+                    {
+                        if (lines[to * 2 + k] == from)
+                            lines[to * 2 + k] = other;
+                        if (other != kNone && lines[other * 2 + k] == from)
+                            lines[other * 2 + k] = to;
+                    }
+                }
+
+                triangles -= removed;
+                max_error = SDL_max(max_error, collapse.distance);
+                made++;
+            }
+            if (made == 0)
+                break;
+
+            // apply the pass and drop the faces that collapsed
+            size_t write = 0;
+            for (size_t i = 0; i < result.size(); i += 3)
+            {
+                uint32_t a = vertex_target[result[i]], b = vertex_target[result[i + 1]], c = vertex_target[result[i + 2]];
+                if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+                    continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (!result.empty())
+            SDL_memcpy(out, result.data(), result.size() * sizeof(uint32_t));
+        if (error)
+            *error = max_error;
+        return result.size();
+    }
+
+    uint32_t GenerateLods(Mesh& mesh, const LodSettings& settings)
+    {
+        const std::pmr::vector<Vertex>& vertices = mesh.Vertices();
+        const VertexSkin* skin = mesh.IsSkinned() ? mesh.Skin().data() : nullptr;
+        uint32_t count = SDL_min(settings.count, (uint32_t)Mesh::kMaxLods);
+
+        const Mesh::MeshLod& last = mesh.Lod(mesh.LodCount() - 1);
+        std::vector<uint32_t> source(last.index_count);
+        for (uint32_t i = 0; i < last.index_count; i++)
+            source[i] = mesh.Index(last.first_index + i);
+        std::vector<uint32_t> simplified(source.size());
+        float error = last.error;
+
+        while (mesh.LodCount() < count)
+        {
+            size_t target = (size_t)(source.size() / 3 * settings.ratio);
+            if (target < settings.min_triangles)
+                break;
+
+            float lod_error = 0.0f;
+            size_t index_count = Simplify(vertices.data(), skin, vertices.size(), source.data(), source.size(), target * 3,
+                settings.simplify, simplified.data(), &lod_error);
+            if (index_count * 6 > source.size() * 5)
+                break;
+
+            optimizer::OptimizeVertexCache(simplified.data(), index_count, vertices.size());
+            error += lod_error;
+            mesh.AddLod(std::span<const uint32_t>(simplified.data(), index_count), error);
+            source.assign(simplified.begin(), simplified.begin() + index_count);
+        }
+        return mesh.LodCount();
+    }
+
+    float ProjectedSize(float extent, float distance, float fov_y, float viewport_height)
+    {
+        // from inside the bounds it covers the whole view anyway
+        distance = SDL_max(distance, 1e-6f);
+        return extent / (2.0f * distance * tanf(fov_y * 0.5f)) * viewport_height;
+    }
+
+    uint32_t SelectLod(const Mesh::MeshLod* lods, uint32_t lod_count, float projected_size, float max_pixel_error,
+        uint32_t current, float hysteresis)
+    {
+        // errors grow along the chain, stop at the first LOD that is too coarse
+        uint32_t lod = 0;
+        for (uint32_t i = 1; i < lod_count; i++)
+        {
+            float limit = i <= current ? max_pixel_error : max_pixel_error * (1.0f - hysteresis);
+            if (lods[i].error * projected_size > limit)
+                break;
+            lod = i;
+        }
+        return lod;
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "mesh.h"
+
+// Level of detail: mesh simplification at import/bake time and the runtime
+// choice between the resulting LODs.
+//
+// Simplify collapses edges in the order of their quadric error (Garland and
+// Heckbert) plus a penalty for the normal, texture coordinate and skin weight
+// change, and always onto an existing vertex, so every LOD indexes the vertex
+// array of LOD 0. Vertices sharing a position with different attributes form
+// a seam; seam and open border vertices only slide along their seam or border,
+// corners where several meet never move.
+namespace lod
+{
+    struct SimplifySettings
+    {
+        // collapses above this error, relative to the largest extent of the bounds and
+        // attribute penalty included, are never made
+        float max_error = 0.05f;
+        // squared attribute differences are added to the squared geometric error with these weights
+        float normal_weight = 0.0025f;
+        float uv_weight = 0.0025f;
+        float skin_weight = 0.01f;
+    };
+
+    // Simplifies the triangles in indices towards target_index_count and writes
+    // them to out, which must hold index_count indices. Returns the new index
+    // count, which stays above the target when max_error stops the collapses.
+    // error receives the largest geometric error of the collapses made (the
+    // quadric's area weighted RMS distance), relative to the extent.
+    size_t Simplify(const Vertex* vertices, const VertexSkin* skin, size_t vertex_count, const uint32_t* indices, size_t index_count,
+        size_t target_index_count, const SimplifySettings& settings, uint32_t* out, float* error = nullptr);
+
+    struct LodSettings
+    {
+        uint32_t count = 4;             // including LOD 0, at most Mesh::kMaxLods
+        float ratio = 0.5f;             // triangles of each LOD against the previous one
+        uint32_t min_triangles = 32;    // no LOD is made below this
+        SimplifySettings simplify;
+    };
+
+    // Appends LODs 1.. to a mesh that has only LOD 0, each simplified from the
+    // previous one and reordered for the vertex cache. The chain ends early
+    // when a LOD would not lose at least a sixth of the previous triangles.
+    // LOD errors add up along the chain, so they bound the distance to LOD 0.
+    // Returns the LOD count.
+    uint32_t GenerateLods(Mesh& mesh, const LodSettings& settings = {});
+
+    // height in pixels of something extent across at distance from a camera with this vertical field of view
+    float ProjectedSize(float extent, float distance, float fov_y, float viewport_height);
+
+    // The coarsest LOD whose error, scaled to projected_size pixels, stays
+    // within max_pixel_error. Moving to a coarser LOD than current needs the
+    // error to be a hysteresis fraction below the limit, so objects near a
+    // switching distance don't flicker between two LODs.
+    uint32_t SelectLod(const Mesh::MeshLod* lods, uint32_t lod_count, float projected_size, float max_pixel_error,
+        uint32_t current, float hysteresis);
+}
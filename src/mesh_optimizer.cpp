@@ -0,0 +1,279 @@
+#include "mesh_optimizer.h"
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <vector>
+
+namespace optimizer
+{
+    static uint32_t HashVertex(const uint8_t* v, size_t stride)
+    {
+        // MurmurHash2 over 32 bit words, vertex strides are always a multiple of 4
+        const uint32_t m = 0x5bd1e995;
+        uint32_t h = (uint32_t)stride;
+        for (size_t i = 0; i + 4 <= stride; i += 4)
+        {
+            uint32_t k;
+            SDL_memcpy(&k, v + i, 4);
+            k *= m;
+            k ^= k >> 24;
+            k *= m;
+            h *= m;
+            h ^= k;
+        }
+        h ^= h >> 13;
+        h *= m;
+        h ^= h >> 15;
+        return h;
+    }
+
+    size_t DeduplicateVertices(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count)
+    {
+        uint8_t* data = (uint8_t*)vertices;
+
+        size_t table_size = 1;
+        while (table_size < vertex_count * 2)
+            table_size <<= 1;
+        std::vector<uint32_t> table(table_size, ~0u);
+        std::vector<uint32_t> remap(vertex_count);
+
+        size_t unique = 0;
+        for (size_t i = 0; i < vertex_count; i++)
+        {
+            const uint8_t* v = data + i * stride;
+            size_t slot = HashVertex(v, stride) & (table_size - 1);
+
+            // linear probing, table entries point at already compacted vertices
+            while (table[slot] != ~0u && SDL_memcmp(data + (size_t)table[slot] * stride, v, stride) != 0)
+                slot = (slot + 1) & (table_size - 1);
+
+            if (table[slot] == ~0u)
+            {
+                if (unique != i)
+                    SDL_memcpy(data + unique * stride, v, stride);
+                table[slot] = (uint32_t)unique;
+                unique++;
+            }
+            remap[i] = table[slot];
+        }
+
+        for (size_t i = 0; i < index_count; i++)
+            indices[i] = remap[indices[i]];
+
+        return unique;
+    }
+
+    // Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+    static const int kCacheSize = 32;
+    static const int kMaxValence = 32;
+    static const float kCacheDecayPower = 1.5f;
+    static const float kLastTriScore = 0.75f;
+    static const float kValenceBoostScale = 2.0f;
+    static const float kValenceBoostPower = 0.5f;
+
+    struct ScoreTables
+    {
+        float cache[kCacheSize];
+        float valence[kMaxValence];
+
+        ScoreTables()
+        {
+            for (int i = 0; i < kCacheSize; i++)
+            {
+                if (i < 3)
+                {
+                    // the last triangle's vertices get a fixed score so the next triangle doesn't reuse all three
+                    cache[i] = kLastTriScore;
+                }
+                else
+                {
+                    float scaler = 1.0f / (kCacheSize - 3);
+                    cache[i] = powf(1.0f - (i - 3) * scaler, kCacheDecayPower);
+                }
+            }
+            for (int i = 0; i < kMaxValence; i++)
+                valence[i] = i == 0 ? 0.0f : kValenceBoostScale * powf((float)i, -kValenceBoostPower);
+        }
+    };
+
+    static float VertexScore(const ScoreTables& tables, int cache_position, uint32_t live_triangles)
+    {
+        if (live_triangles == 0)
+            return -1.0f;
+
+        float score = cache_position >= 0 && cache_position < kCacheSize ? tables.cache[cache_position] : 0.0f;
+        // rare high valence vertices all get the same boost, the table covers the common range
+        score += tables.valence[live_triangles < kMaxValence ? live_triangles : kMaxValence - 1];
+        return score;
+    }
+
+    void OptimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count)
+    {
+        static const ScoreTables tables;
+
+        size_t tri_count = index_count / 3;
+        if (tri_count == 0)
+            return;
+
+        // triangle adjacency per vertex, emitted triangles are swap-removed from the live range
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (size_t i = 0; i < tri_count * 3; i++)
+            live[indices[i]]++;
+
+        std::vector<uint32_t> offsets(vertex_count + 1, 0);
+        for (size_t v = 0; v < vertex_count; v++)
+            offsets[v + 1] = offsets[v] + live[v];
+
+        std::vector<uint32_t> adjacency(tri_count * 3);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < tri_count; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+
+        std::vector<int32_t> cache_position(vertex_count, -1);
+        std::vector<float> vertex_score(vertex_count);
+        for (size_t v = 0; v < vertex_count; v++)
+            vertex_score[v] = VertexScore(tables, -1, live[v]);
+
+        std::vector<uint8_t> emitted(tri_count, 0);
+        size_t best = 0;
+        float best_score = -1.0f;
+        for (size_t t = 0; t < tri_count; t++)
+        {
+            const uint32_t* tri = indices + t * 3;
+            float score = vertex_score[tri[0]] + vertex_score[tri[1]] + vertex_score[tri[2]];
+            if (score > best_score)
+            {
+                best_score = score;
+                best = t;
+            }
+        }
+
+        std::vector<uint32_t> result(tri_count * 3);
+        uint32_t cache[kCacheSize + 3];
+        uint32_t new_cache[kCacheSize + 3];
+        int cache_count = 0;
+        size_t scan = 0;
+
+        for (size_t out = 0; out < tri_count; out++)
+        {
+            if (best == ~(size_t)0)
+            {
+                // nothing adjacent to the cache is left, continue with the next unemitted triangle in input order
+                while (emitted[scan])
+                    scan++;
+                best = scan;
+            }
+
+            const uint32_t* tri = indices + best * 3;
+            result[out * 3 + 0] = tri[0];
+            result[out * 3 + 1] = tri[1];
+            result[out * 3 + 2] = tri[2];
+            emitted[best] = 1;
+
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t v = tri[k];
+                uint32_t* begin = adjacency.data() + offsets[v];
+                uint32_t* end = begin + live[v];
+                for (uint32_t* it = begin; it != end; ++it)
+                {
+                    if (*it == best)
+                    {
+                        *it = *(end - 1);
+                        break;
+                    }
+                }
+                live[v]--;
+            }
+
+            // the emitted triangle moves to the front, the rest of the cache shifts back
+            int new_count = 0;
+            new_cache[new_count++] = tri[0];
+            new_cache[new_count++] = tri[1];
+            new_cache[new_count++] = tri[2];
+            for (int i = 0; i < cache_count; i++)
+            {
+                uint32_t v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                    new_cache[new_count++] = v;
+            }
+
+            for (int i = 0; i < new_count; i++)
+            {
+                uint32_t v = new_cache[i];
+                cache_position[v] = i < kCacheSize ? i : -1;
+                vertex_score[v] = VertexScore(tables, cache_position[v], live[v]);
+            }
+
+            best = ~(size_t)0;
+            best_score = -1.0f;
+            for (int i = 0; i < new_count; i++)
+            {
+                uint32_t v = new_cache[i];
+                const uint32_t* adj = adjacency.data() + offsets[v];
+                for (uint32_t j = 0; j < live[v]; j++)
+                {
+                    uint32_t t = adj[j];
+                    const uint32_t* other = indices + (size_t)t * 3;
+                    float score = vertex_score[other[0]] + vertex_score[other[1]] + vertex_score[other[2]];
+                    if (score > best_score)
+                    {
+                        best_score = score;
+                        best = t;
+                    }
+                }
+            }
+
+            cache_count = new_count < kCacheSize ? new_count : kCacheSize;
+            SDL_memcpy(cache, new_cache, cache_count * sizeof(uint32_t));
+        }
+
+        SDL_memcpy(indices, result.data(), result.size() * sizeof(uint32_t));
+    }
+
+    size_t OptimizeVertexFetch(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count)
+    {
+        std::vector<uint32_t> remap(vertex_count, ~0u);
+        uint32_t next = 0;
+        for (size_t i = 0; i < index_count; i++)
+        {
+            uint32_t& r = remap[indices[i]];
+            if (r == ~0u)
+                r = next++;
+            indices[i] = r;
+        }
+
+        uint8_t* data = (uint8_t*)vertices;
+        std::vector<uint8_t> source(data, data + vertex_count * stride);
+        for (size_t v = 0; v < vertex_count; v++)
+        {
+            if (remap[v] != ~0u)
+                SDL_memcpy(data + (size_t)remap[v] * stride, source.data() + v * stride, stride);
+        }
+
+        return next;
+    }
+
+    float ComputeACMR(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size)
+    {
+        if (index_count < 3)
+            return 0.0f;
+
+        // FIFO cache simulated with per-vertex insertion timestamps
+        std::vector<uint32_t> timestamp(vertex_count, 0);
+        uint32_t time = cache_size + 1;
+        size_t misses = 0;
+        for (size_t i = 0; i < index_count; i++)
+        {
+            uint32_t v = indices[i];
+            if (time - timestamp[v] > cache_size)
+            {
+                timestamp[v] = time++;
+                misses++;
+            }
+        }
+
+        return (float)misses / (float)(index_count / 3);
+    }
+}
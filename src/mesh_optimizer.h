@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Index/vertex buffer optimizations run at import time. All functions work on
+// raw interleaved vertex memory with an explicit stride so they apply to any
+// vertex layout, not only the default Vertex.
+namespace optimizer
+{
+    // Merges bitwise identical vertices in place and remaps the indices.
+    // Returns the new vertex count; the tail of the vertex array is garbage.
+    size_t DeduplicateVertices(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count);
+
+    // Reorders triangles for post-transform vertex cache reuse (Forsyth).
+    void OptimizeVertexCache(uint32_t* indices, size_t index_count, size_t vertex_count);
+
+    // Reorders vertices in first-use order of the index buffer so vertex fetch
+    // walks memory linearly. Unreferenced vertices are dropped, returns the new vertex count.
+    size_t OptimizeVertexFetch(void* vertices, size_t vertex_count, size_t stride, uint32_t* indices, size_t index_count);
+
+    // Average cache miss ratio (transformed vertices per triangle) for a FIFO cache.
+    float ComputeACMR(const uint32_t* indices, size_t index_count, size_t vertex_count, uint32_t cache_size = 16);
+}
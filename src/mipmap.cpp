@@ -0,0 +1,126 @@
+#include "mipmap.h"
+
+#include <SDL3/SDL.h>
+#include "simd.h"
+
+namespace mip
+{
+    uint32_t LevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t size = SDL_max(width, height);
+        uint32_t levels = 1;
+        while (size > 1)
+        {
+            size >>= 1;
+            levels++;
+        }
+        return levels;
+    }
+
+    size_t ChainSize(uint32_t width, uint32_t height, uint32_t levels)
+    {
+        size_t size = 0;
+        for (uint32_t level = 0; level < levels; level++)
+        {
+            size += (size_t)width * height * 4;
+            width = SDL_max(width >> 1, 1u);
+            height = SDL_max(height >> 1, 1u);
+        }
+        return size;
+    }
+
+    void DownsampleScalar(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst)
+    {
+        uint32_t dst_width = SDL_max(width >> 1, 1u);
+        uint32_t dst_height = SDL_max(height >> 1, 1u);
+        for (uint32_t y = 0; y < dst_height; y++)
+        {
+            const uint8_t* row0 = src + (size_t)(y * 2) * width * 4;
+            const uint8_t* row1 = src + (size_t)SDL_min(y * 2 + 1, height - 1) * width * 4;
+            uint8_t* out = dst + (size_t)y * dst_width * 4;
+            for (uint32_t x = 0; x < dst_width; x++)
+            {
+                uint32_t x0 = x * 2 * 4;
+                uint32_t x1 = SDL_min(x * 2 + 1, width - 1) * 4;
+                for (uint32_t c = 0; c < 4; c++)
+                    out[x * 4 + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+            }
+        }
+    }
+
+    void Downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst)
+    {
+#if SKELETAL_SSE
+        // 1 pixel wide or tall levels need the clamped scalar path
+        if (width < 2 || height < 2)
+        {
+            DownsampleScalar(src, width, height, dst);
+            return;
+        }
+
+        uint32_t dst_width = width >> 1;
+        uint32_t dst_height = height >> 1;
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i round = _mm_set1_epi16(2);
+        for (uint32_t y = 0; y < dst_height; y++)
+        {
+            const uint8_t* row0 = src + (size_t)(y * 2) * width * 4;
+            const uint8_t* row1 = row0 + (size_t)width * 4;
+            uint8_t* out = dst + (size_t)y * dst_width * 4;
+
+            // 8 source pixels from each of the two rows -> 4 output pixels
+            uint32_t x = 0;
+            for (; x + 4 <= dst_width; x += 4)
+            {
+                __m128i a0 = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+                __m128i a1 = _mm_loadu_si128((const __m128i*)(row0 + x * 8 + 16));
+                __m128i b0 = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+                __m128i b1 = _mm_loadu_si128((const __m128i*)(row1 + x * 8 + 16));
+
+                // vertical sums widened to 16 bits, one pixel pair per register
+                __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+                __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+                __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+                __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+                // horizontal: add the two pixels of each register
+                __m128i h0 = _mm_add_epi16(s0, _mm_srli_si128(s0, 8));
+                __m128i h1 = _mm_add_epi16(s1, _mm_srli_si128(s1, 8));
+                __m128i h2 = _mm_add_epi16(s2, _mm_srli_si128(s2, 8));
+                __m128i h3 = _mm_add_epi16(s3, _mm_srli_si128(s3, 8));
+
+                __m128i p01 = _mm_unpacklo_epi64(h0, h1);
+                __m128i p23 = _mm_unpacklo_epi64(h2, h3);
+                p01 = _mm_srli_epi16(_mm_add_epi16(p01, round), 2);
+                p23 = _mm_srli_epi16(_mm_add_epi16(p23, round), 2);
+                _mm_storeu_si128((__m128i*)(out + x * 4), _mm_packus_epi16(p01, p23));
+            }
+            for (; x < dst_width; x++)
+            {
+                for (uint32_t c = 0; c < 4; c++)
+                    out[x * 4 + c] = (uint8_t)((row0[x * 8 + c] + row0[x * 8 + 4 + c] + row1[x * 8 + c] + row1[x * 8 + 4 + c] + 2) >> 2);
+            }
+        }
+#else
+        DownsampleScalar(src, width, height, dst);
+#endif
+    }
+
+    void GenerateChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levels, std::vector<size_t>* offsets)
+    {
+        if (offsets)
+            offsets->assign(1, 0);
+
+        size_t offset = 0;
+        for (uint32_t level = 1; level < levels; level++)
+        {
+            size_t level_size = (size_t)width * height * 4;
+            Downsample(chain + offset, width, height, chain + offset + level_size);
+            offset += level_size;
+            width = SDL_max(width >> 1, 1u);
+            height = SDL_max(height >> 1, 1u);
+            if (offsets)
+                offsets->push_back(offset);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU mip chain generation for RGBA8 images with a 2x2 box filter.
+namespace mip
+{
+    // full chain down to 1x1
+    uint32_t LevelCount(uint32_t width, uint32_t height);
+
+    // bytes of the whole chain when levels are stored back to back, level 0 first
+    size_t ChainSize(uint32_t width, uint32_t height, uint32_t levels);
+
+    // dst is max(width / 2, 1) x max(height / 2, 1), odd trailing rows/columns are dropped
+    void Downsample(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst);
+    void DownsampleScalar(const uint8_t* src, uint32_t width, uint32_t height, uint8_t* dst);
+
+    // chain must hold ChainSize bytes with level 0 already in place,
+    // offsets receives the byte offset of each level
+    void GenerateChain(uint8_t* chain, uint32_t width, uint32_t height, uint32_t levels, std::vector<size_t>* offsets = nullptr);
+}
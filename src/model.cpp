@@ -0,0 +1,404 @@
+#include "model.h"
+#include "mesh_lod.h"
+#include "mesh_optimizer.h"
+
+#include <SDL3/SDL.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <assimp/postprocess.h>
+#include <string>
+#include <unordered_map>
+
+namespace model
+{
+    // vertex used while importing skinned meshes, so dedup and reordering keep the skin stream in sync
+    struct SkinnedImportVertex
+    {
+        Vertex vertex;
+        VertexSkin skin;
+    };
+
+    struct GeometryStats
+    {
+        double acmr_before = 0.0;
+        double acmr_after = 0.0;
+        size_t triangles = 0;
+    };
+
+    static unsigned int ImportFlags(const ImportSettings& settings)
+    {
+        // JoinIdenticalVertices and ImproveCacheLocality are left out on purpose,
+        // optimizer:: does both faster on the packed vertex data
+        unsigned int flags = aiProcess_Triangulate | aiProcess_SortByPType | aiProcess_LimitBoneWeights;
+        if (settings.generate_normals)
+            flags |= aiProcess_GenSmoothNormals;
+        if (settings.flip_uvs)
+            flags |= aiProcess_FlipUVs;
+        return flags;
+    }
+
+    static std::string Directory(const char* path)
+    {
+        std::string dir(path);
+        size_t slash = dir.find_last_of("/\\");
+        return slash == std::string::npos ? std::string() : dir.substr(0, slash + 1);
+    }
+
+    static glm::mat4 ToGlm(const aiMatrix4x4& m)
+    {
+        // assimp matrices are row major
+        return glm::mat4(
+            glm::vec4(m.a1, m.b1, m.c1, m.d1),
+            glm::vec4(m.a2, m.b2, m.c2, m.d2),
+            glm::vec4(m.a3, m.b3, m.c3, m.d3),
+            glm::vec4(m.a4, m.b4, m.c4, m.d4));
+    }
+
+    static void LoadMaterialTextures(const aiMaterial* material, aiTextureType type, const char* type_name, const std::string& directory, std::pmr::vector<Texture>& textures)
+    {
+        for (unsigned int i = 0; i < material->GetTextureCount(type); i++)
+        {
+            aiString str;
+            material->GetTexture(type, i, &str);
+
+            Texture texture{};
+            texture.id = 0;
+            texture.type = type_name;
+            texture.path = directory + str.C_Str();
+            textures.push_back(texture);
+        }
+    }
+
+    template<typename V>
+    static void ProcessGeometry(std::pmr::vector<V>& vertices, std::pmr::vector<uint32_t>& indices, const ImportSettings& settings, GeometryStats& stats)
+    {
+        size_t unique = optimizer::DeduplicateVertices(vertices.data(), vertices.size(), sizeof(V), indices.data(), indices.size());
+        vertices.resize(unique);
+
+        size_t tri_count = indices.size() / 3;
+        float before = optimizer::ComputeACMR(indices.data(), indices.size(), vertices.size());
+        float after = before;
+        if (settings.optimize)
+        {
+            optimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+            unique = optimizer::OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(V), indices.data(), indices.size());
+            vertices.resize(unique);
+            after = optimizer::ComputeACMR(indices.data(), indices.size(), vertices.size());
+        }
+        stats.acmr_before += before * tri_count;
+        stats.acmr_after += after * tri_count;
+        stats.triangles += tri_count;
+    }
+
+    static void ReadVertex(const aiMesh* src, unsigned int i, Vertex& v)
+    {
+        v.position = glm::vec3(src->mVertices[i].x, src->mVertices[i].y, src->mVertices[i].z);
+        v.normal = src->mNormals ? glm::vec3(src->mNormals[i].x, src->mNormals[i].y, src->mNormals[i].z) : glm::vec3(0.0f);
+        v.tex_coords = src->mTextureCoords[0] ? glm::vec2(src->mTextureCoords[0][i].x, src->mTextureCoords[0][i].y) : glm::vec2(0.0f);
+    }
+
+    static void ReadSkin(const aiMesh* src, const std::unordered_map<std::string, int>& joints, std::pmr::vector<VertexSkin>& skin)
+    {
+        skin.assign(src->mNumVertices, VertexSkin{});
+        for (unsigned int b = 0; b < src->mNumBones; b++)
+        {
+            const aiBone* bone = src->mBones[b];
+            auto it = joints.find(bone->mName.C_Str());
+            if (it == joints.end() || it->second > 255)
+            {
+                SDL_Log("Bone %s cannot be addressed by 8 bit joint indices, ignoring it", bone->mName.C_Str());
+                continue;
+            }
+
+            for (unsigned int w = 0; w < bone->mNumWeights; w++)
+            {
+                VertexSkin& s = skin[bone->mWeights[w].mVertexId];
+                float weight = bone->mWeights[w].mWeight;
+
+                // keep the 4 largest influences, LimitBoneWeights normally guarantees there are no more
+                int slot = 0;
+                for (int k = 1; k < 4; k++)
+                {
+                    if (s.weights[k] < s.weights[slot])
+                        slot = k;
+                }
+                if (weight > s.weights[slot])
+                {
+                    s.joints[slot] = (uint8_t)it->second;
+                    s.weights[slot] = weight;
+                }
+            }
+        }
+
+        for (VertexSkin& s : skin)
+        {
+            float sum = s.weights[0] + s.weights[1] + s.weights[2] + s.weights[3];
+            if (sum > 0.0f)
+            {
+                for (int k = 0; k < 4; k++)
+                    s.weights[k] /= sum;
+            }
+            else
+            {
+                s.weights[0] = 1.0f;
+            }
+        }
+    }
+
+    static void ImportSkeleton(const aiScene* scene, anim::Skeleton& skeleton)
+    {
+        std::unordered_map<std::string, aiMatrix4x4> offsets;
+        for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+        {
+            const aiMesh* mesh = scene->mMeshes[m];
+            for (unsigned int b = 0; b < mesh->mNumBones; b++)
+                offsets[mesh->mBones[b]->mName.C_Str()] = mesh->mBones[b]->mOffsetMatrix;
+        }
+
+        // a node becomes a joint when it is a bone or has a bone below it
+        std::unordered_map<const aiNode*, bool> needed;
+        auto mark = [&](auto&& self, const aiNode* node) -> bool
+        {
+            bool keep = offsets.count(node->mName.C_Str()) > 0;
+            for (unsigned int c = 0; c < node->mNumChildren; c++)
+                keep |= self(self, node->mChildren[c]);
+            needed[node] = keep;
+            return keep;
+        };
+        mark(mark, scene->mRootNode);
+
+        // preorder walk keeps parents ahead of their children
+        std::vector<glm::vec3> translations, scales;
+        std::vector<glm::vec4> rotations;
+        auto visit = [&](auto&& self, const aiNode* node, int parent) -> void
+        {
+            int joint = parent;
+            if (needed[node])
+            {
+                joint = (int)skeleton.parents.size();
+                skeleton.parents.push_back((int16_t)parent);
+                skeleton.names.push_back(node->mName.C_Str());
+
+                auto it = offsets.find(node->mName.C_Str());
+                skeleton.inverse_bind.push_back(it != offsets.end() ? ToGlm(it->second) : glm::mat4(1.0f));
+
+                aiVector3D scaling, position;
+                aiQuaternion rotation;
+                node->mTransformation.Decompose(scaling, rotation, position);
+                translations.push_back(glm::vec3(position.x, position.y, position.z));
+                rotations.push_back(glm::vec4(rotation.x, rotation.y, rotation.z, rotation.w));
+                scales.push_back(glm::vec3(scaling.x, scaling.y, scaling.z));
+            }
+            for (unsigned int c = 0; c < node->mNumChildren; c++)
+                self(self, node->mChildren[c], joint);
+        };
+        visit(visit, scene->mRootNode, anim::kNoParent);
+
+        skeleton.bind_pose.Resize(skeleton.JointCount());
+        for (uint32_t j = 0; j < skeleton.JointCount(); j++)
+            skeleton.bind_pose.SetJoint(j, translations[j], rotations[j], scales[j]);
+    }
+
+    static void ImportClips(const aiScene* scene, const anim::Skeleton& skeleton, const std::unordered_map<std::string, int>& joints, std::vector<anim::AnimationClip>& clips)
+    {
+        for (unsigned int a = 0; a < scene->mNumAnimations; a++)
+        {
+            const aiAnimation* src = scene->mAnimations[a];
+            double ticks_per_second = src->mTicksPerSecond > 0.0 ? src->mTicksPerSecond : 25.0;
+
+            anim::AnimationClip clip;
+            clip.name = src->mName.C_Str();
+            clip.duration = (float)(src->mDuration / ticks_per_second);
+            clip.joint_count = skeleton.JointCount();
+
+            std::vector<std::vector<float>> times(clip.TrackCount());
+            std::vector<std::vector<glm::vec4>> values(clip.TrackCount());
+            for (unsigned int c = 0; c < src->mNumChannels; c++)
+            {
+                const aiNodeAnim* channel = src->mChannels[c];
+                auto it = joints.find(channel->mNodeName.C_Str());
+                if (it == joints.end())
+                    continue;
+
+                uint32_t base = (uint32_t)it->second * anim::TRACK_COUNT;
+                for (unsigned int k = 0; k < channel->mNumPositionKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mPositionKeys[k];
+                    times[base + anim::TRACK_TRANSLATION].push_back((float)(key.mTime / ticks_per_second));
+                    values[base + anim::TRACK_TRANSLATION].push_back(glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, 0.0f));
+                }
+                for (unsigned int k = 0; k < channel->mNumRotationKeys; k++)
+                {
+                    const aiQuatKey& key = channel->mRotationKeys[k];
+                    times[base + anim::TRACK_ROTATION].push_back((float)(key.mTime / ticks_per_second));
+                    values[base + anim::TRACK_ROTATION].push_back(glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w));
+                }
+                for (unsigned int k = 0; k < channel->mNumScalingKeys; k++)
+                {
+                    const aiVectorKey& key = channel->mScalingKeys[k];
+                    times[base + anim::TRACK_SCALE].push_back((float)(key.mTime / ticks_per_second));
+                    values[base + anim::TRACK_SCALE].push_back(glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, 0.0f));
+                }
+            }
+
+            clip.key_offsets.push_back(0);
+            for (uint32_t t = 0; t < clip.TrackCount(); t++)
+            {
+                clip.times.insert(clip.times.end(), times[t].begin(), times[t].end());
+                clip.values.insert(clip.values.end(), values[t].begin(), values[t].end());
+                clip.key_offsets.push_back((uint32_t)clip.times.size());
+            }
+            clips.push_back(std::move(clip));
+        }
+    }
+
+    static bool Import(const char* path, const ImportSettings& settings, ImportStats* stats, std::vector<Mesh>& meshes, SkinnedModel* skinned,
+        std::pmr::memory_resource* resource)
+    {
+        ImportStats local{};
+
+        Uint64 start = SDL_GetTicksNS();
+
+        Assimp::Importer importer;
+        // points and lines end up in their own meshes after SortByPType, drop them entirely
+        importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, aiPrimitiveType_POINT | aiPrimitiveType_LINE);
+        importer.SetPropertyInteger(AI_CONFIG_PP_LBW_MAX_WEIGHTS, 4);
+        const aiScene* scene = importer.ReadFile(path, ImportFlags(settings));
+        if (scene == nullptr || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || scene->mRootNode == nullptr)
+        {
+            SDL_Log("Failed to import model %s: %s", path, importer.GetErrorString());
+            return false;
+        }
+
+        Uint64 parsed = SDL_GetTicksNS();
+
+        std::unordered_map<std::string, int> joints;
+        if (skinned)
+        {
+            ImportSkeleton(scene, skinned->skeleton);
+            for (uint32_t j = 0; j < skinned->skeleton.JointCount(); j++)
+                joints[skinned->skeleton.names[j]] = (int)j;
+            ImportClips(scene, skinned->skeleton, joints, skinned->clips);
+        }
+
+        std::string directory = Directory(path);
+        GeometryStats geometry;
+        if (resource == nullptr)
+            resource = mem::HeapResource(mem::CATEGORY_MESH);
+
+        // per-mesh working copies live in a scratch arena, only the finished Mesh touches resource
+        mem::Arena scratch(1024 * 1024, mem::CATEGORY_IMPORT);
+
+        meshes.reserve(scene->mNumMeshes);
+        for (unsigned int m = 0; m < scene->mNumMeshes; m++)
+        {
+            const aiMesh* src = scene->mMeshes[m];
+            if (!(src->mPrimitiveTypes & aiPrimitiveType_TRIANGLE))
+                continue;
+
+            // the previous mesh's working copies are gone, their memory is reused
+            scratch.Reset();
+
+            std::pmr::vector<uint32_t> indices(&scratch);
+            indices.reserve((size_t)src->mNumFaces * 3);
+            for (unsigned int f = 0; f < src->mNumFaces; f++)
+            {
+                const aiFace& face = src->mFaces[f];
+                if (face.mNumIndices != 3)
+                    continue;
+                indices.push_back(face.mIndices[0]);
+                indices.push_back(face.mIndices[1]);
+                indices.push_back(face.mIndices[2]);
+            }
+            if (indices.empty())
+                continue;
+
+            local.source_vertices += src->mNumVertices;
+
+            std::pmr::vector<Vertex> vertices(&scratch);
+            std::pmr::vector<VertexSkin> skin(&scratch);
+            if (skinned && src->mNumBones > 0)
+            {
+                std::pmr::vector<VertexSkin> source_skin(&scratch);
+                ReadSkin(src, joints, source_skin);
+                std::pmr::vector<SkinnedImportVertex> combined(src->mNumVertices, &scratch);
+                for (unsigned int i = 0; i < src->mNumVertices; i++)
+                {
+                    ReadVertex(src, i, combined[i].vertex);
+                    combined[i].skin = source_skin[i];
+                }
+
+                ProcessGeometry(combined, indices, settings, geometry);
+
+                vertices.resize(combined.size());
+                skin.resize(combined.size());
+                for (size_t i = 0; i < combined.size(); i++)
+                {
+                    vertices[i] = combined[i].vertex;
+                    skin[i] = combined[i].skin;
+                }
+            }
+            else
+            {
+                vertices.resize(src->mNumVertices);
+                for (unsigned int i = 0; i < src->mNumVertices; i++)
+                    ReadVertex(src, i, vertices[i]);
+
+                ProcessGeometry(vertices, indices, settings, geometry);
+            }
+
+            std::pmr::vector<Texture> textures(&scratch);
+            if (scene->mMaterials && src->mMaterialIndex < scene->mNumMaterials)
+            {
+                const aiMaterial* material = scene->mMaterials[src->mMaterialIndex];
+                LoadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", directory, textures);
+                LoadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular", directory, textures);
+                LoadMaterialTextures(material, aiTextureType_NORMALS, "texture_normal", directory, textures);
+            }
+
+            local.vertices += vertices.size();
+            local.indices += indices.size();
+            meshes.emplace_back(vertices, indices, textures, resource);
+            if (!skin.empty())
+                meshes.back().SetSkin(skin);
+            if (settings.lod_count > 1)
+            {
+                Uint64 lod_start = SDL_GetTicksNS();
+                lod::LodSettings lods;
+                lods.count = settings.lod_count;
+                local.lods += lod::GenerateLods(meshes.back(), lods) - 1;
+                local.lod_ms += (SDL_GetTicksNS() - lod_start) / 1e6;
+            }
+            if (meshes.back().IndexSize() == SDL_GPU_INDEXELEMENTSIZE_16BIT)
+                local.meshes_16bit++;
+        }
+
+        Uint64 done = SDL_GetTicksNS();
+
+        local.meshes = meshes.size();
+        local.parse_ms = (parsed - start) / 1e6;
+        local.process_ms = (done - parsed) / 1e6;
+        if (geometry.triangles > 0)
+        {
+            local.acmr_before = (float)(geometry.acmr_before / geometry.triangles);
+            local.acmr_after = (float)(geometry.acmr_after / geometry.triangles);
+        }
+        if (stats)
+            *stats = local;
+
+        return true;
+    }
+
+    std::vector<Mesh> LoadModel(const char* path, const ImportSettings& settings, ImportStats* stats, std::pmr::memory_resource* resource)
+    {
+        std::vector<Mesh> meshes;
+        Import(path, settings, stats, meshes, nullptr, resource);
+        return meshes;
+    }
+
+    bool LoadSkinnedModel(const char* path, SkinnedModel& out, const ImportSettings& settings, ImportStats* stats, std::pmr::memory_resource* resource)
+    {
+        out = SkinnedModel{};
+        return Import(path, settings, stats, out.meshes, &out, resource);
+    }
+}
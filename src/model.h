@@ -0,0 +1,51 @@
+#pragma once
+
+#include <memory_resource>
+#include <vector>
+#include "animation.h"
+#include "memory.h"
+#include "mesh.h"
+#include "skeleton.h"
+
+namespace model
+{
+    struct ImportSettings
+    {
+        bool generate_normals = true;
+        bool flip_uvs = false;
+        bool optimize = true;        // vertex cache + vertex fetch reordering
+        uint32_t lod_count = 4;      // LODs per mesh including the full one, 1 for none (see lod::GenerateLods)
+    };
+
+    struct ImportStats
+    {
+        double parse_ms = 0.0;       // Assimp ReadFile incl. post-processing
+        double process_ms = 0.0;     // dedup, optimization and Mesh packing
+        size_t meshes = 0;
+        size_t source_vertices = 0;  // before deduplication
+        size_t vertices = 0;
+        size_t indices = 0;
+        size_t meshes_16bit = 0;
+        float acmr_before = 0.0f;    // triangle weighted over all meshes
+        float acmr_after = 0.0f;
+        size_t lods = 0;             // generated, LOD 0 not counted
+        double lod_ms = 0.0;         // part of process_ms
+    };
+
+    struct SkinnedModel
+    {
+        std::vector<Mesh> meshes;       // skin joint indices refer to skeleton joints
+        anim::Skeleton skeleton;
+        std::vector<anim::AnimationClip> clips;
+    };
+
+    // Mesh data is allocated from resource, the tracked mesh heap when null. Pass
+    // an asset Arena to free everything a level loaded at once.
+    std::vector<Mesh> LoadModel(const char* path, const ImportSettings& settings = {}, ImportStats* stats = nullptr,
+        std::pmr::memory_resource* resource = nullptr);
+
+    // Like LoadModel, additionally importing the bone hierarchy, per-vertex skin
+    // weights (at most 4, normalized) and all animation clips.
+    bool LoadSkinnedModel(const char* path, SkinnedModel& out, const ImportSettings& settings = {}, ImportStats* stats = nullptr,
+        std::pmr::memory_resource* resource = nullptr);
+}
@@ -0,0 +1,421 @@
+#include "pipeline_cache.h"
+
+#include <SDL3/SDL.h>
+#include "hash.h"
+#include "profiler.h"
+#include "shader.h"
+
+// ---------------------------------------------------------------------------
+// description
+
+void PipelineDesc::SetVertexLayout(const vtx::Layout& layout)
+{
+    SDL_GPUVertexAttribute attributes[vtx::ATTRIBUTE_COUNT];
+    uint32_t count = vtx::BuildAttributes(layout, 0, attributes);
+    vertex_pitch = layout.stride;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        attribute_offsets[attributes[i].location] = attributes[i].offset;
+        attribute_formats[attributes[i].location] = attributes[i].format;
+    }
+}
+
+uint64_t PipelineDesc::Hash() const
+{
+    uint64_t h = hash::Murmur64(vertex_shader.data(), vertex_shader.size());
+    h = hash::Combine(h, hash::Murmur64(fragment_shader.data(), fragment_shader.size()));
+    h = hash::Combine(h, primitive_type);
+    h = hash::Combine(h, fill_mode);
+    h = hash::Combine(h, cull_mode);
+    h = hash::Combine(h, front_face);
+    h = hash::Combine(h, color_format);
+    h = hash::Combine(h, blend);
+    h = hash::Combine(h, depth_format);
+    h = hash::Combine(h, depth_test);
+    h = hash::Combine(h, depth_write);
+    h = hash::Combine(h, depth_compare);
+    h = hash::Combine(h, vertex_pitch);
+    for (uint32_t i = 0; i < kMaxVertexAttributes; i++)
+    {
+        h = hash::Combine(h, attribute_offsets[i]);
+        h = hash::Combine(h, attribute_formats[i]);
+    }
+    return h;
+}
+
+bool PipelineDesc::operator==(const PipelineDesc& other) const
+{
+    for (uint32_t i = 0; i < kMaxVertexAttributes; i++)
+    {
+        if (attribute_offsets[i] != other.attribute_offsets[i] || attribute_formats[i] != other.attribute_formats[i])
+            return false;
+    }
+    return vertex_shader == other.vertex_shader && fragment_shader == other.fragment_shader &&
+           primitive_type == other.primitive_type && fill_mode == other.fill_mode &&
+           cull_mode == other.cull_mode && front_face == other.front_face &&
+           color_format == other.color_format && blend == other.blend &&
+           depth_format == other.depth_format && depth_test == other.depth_test &&
+           depth_write == other.depth_write && depth_compare == other.depth_compare &&
+           vertex_pitch == other.vertex_pitch;
+}
+
+// ---------------------------------------------------------------------------
+// cache
+
+PipelineCache::PipelineCache(SDL_GPUDevice* _device, uint32_t thread_count)
+    : device(_device)
+{
+    // SDL serializes resource creation internally, pipelines may be built off the render thread
+    threads.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+        threads.emplace_back(&PipelineCache::WorkerMain, this);
+}
+
+PipelineCache::~PipelineCache()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        queue.clear();
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (PipelineHandle handle = 0; handle < entries.Slots(); handle++)
+    {
+        if (entries[handle].pipeline)
+            SDL_ReleaseGPUGraphicsPipeline(device, entries[handle].pipeline);
+        if (entries[handle].replacement)
+            SDL_ReleaseGPUGraphicsPipeline(device, entries[handle].replacement);
+    }
+    for (auto& [path, shader] : shaders)
+    {
+        if (shader->shader)
+            SDL_ReleaseGPUShader(device, shader->shader);
+    }
+    for (std::unique_ptr<Shader>& shader : retired_shaders)
+    {
+        if (shader->shader)
+            SDL_ReleaseGPUShader(device, shader->shader);
+    }
+}
+
+PipelineHandle PipelineCache::Request(const PipelineDesc& desc)
+{
+    stats.requests++;
+    uint64_t h = desc.Hash();
+    auto found = by_hash.find(h);
+    if (found != by_hash.end() && entries[found->second].desc == desc)
+    {
+        stats.hits++;
+        return found->second;
+    }
+
+    PipelineHandle handle = entries.Create();
+    Entry& entry = entries[handle];
+    entry.desc = desc;
+    entry.hash = h;
+    // a colliding description still works, it just never gets deduplicated
+    by_hash.emplace(h, handle);
+
+    if (!threads.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(&entry);
+        }
+        wake.notify_one();
+    }
+    return handle;
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Get(PipelineHandle handle)
+{
+    Entry& entry = entries[handle];
+    if (entry.reload.load(std::memory_order_acquire) == RELOAD_DONE)
+        SwapRebuilt(entry);
+    uint32_t state = entry.state.load(std::memory_order_acquire);
+    if (entry.reload_again && (state == STATE_READY || state == STATE_FAILED))
+    {
+        // the build that just finished may have read the shader before it was reloaded
+        entry.reload_again = false;
+        QueueRebuild(entry);
+    }
+    if (state == STATE_READY)
+        return entry.pipeline;
+    if (threads.empty() && state == STATE_QUEUED)
+        return Wait(handle);
+    return nullptr;
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Wait(PipelineHandle handle)
+{
+    Entry& entry = entries[handle];
+    if (!TryCreate(entry))
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&entry] {
+            uint32_t state = entry.state.load(std::memory_order_acquire);
+            return state == STATE_READY || state == STATE_FAILED;
+        });
+    }
+    return entry.state.load(std::memory_order_acquire) == STATE_READY ? entry.pipeline : nullptr;
+}
+
+void PipelineCache::WaitIdle()
+{
+    if (threads.empty())
+    {
+        for (PipelineHandle handle = 0; handle < entries.Slots(); handle++)
+            Wait(handle);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return queue.empty() && in_progress == 0; });
+}
+
+bool PipelineCache::IsReady(PipelineHandle handle) const
+{
+    return entries[handle].state.load(std::memory_order_acquire) == STATE_READY;
+}
+
+bool PipelineCache::IsDone(PipelineHandle handle) const
+{
+    uint32_t state = entries[handle].state.load(std::memory_order_acquire);
+    return threads.empty() || state == STATE_READY || state == STATE_FAILED;
+}
+
+const spirv::Reflection* PipelineCache::GetReflection(const std::string& path)
+{
+    std::lock_guard<std::mutex> lock(shader_mutex);
+    auto found = shaders.find(path);
+    return found != shaders.end() && found->second->shader ? &found->second->reflection : nullptr;
+}
+
+uint32_t PipelineCache::ReloadShader(const std::string& path)
+{
+    {
+        // nothing loaded it yet: whoever does reads the new file
+        std::lock_guard<std::mutex> lock(shader_mutex);
+        auto found = shaders.find(path);
+        if (found == shaders.end())
+            return 0;
+        retired_shaders.push_back(std::move(found->second));
+        shaders.erase(found);
+    }
+
+    uint32_t count = 0;
+    for (PipelineHandle handle = 0; handle < entries.Slots(); handle++)
+    {
+        Entry& entry = entries[handle];
+        if (entry.desc.vertex_shader != path && entry.desc.fragment_shader != path)
+            continue;
+        count++;
+
+        // builds that have not started load the new shader, running ones go again when done
+        uint32_t state = entry.state.load(std::memory_order_acquire);
+        uint32_t reload = entry.reload.load(std::memory_order_acquire);
+        if (state == STATE_QUEUED || reload == RELOAD_QUEUED)
+            continue;
+        if (state == STATE_CREATING || reload == RELOAD_CREATING)
+        {
+            entry.reload_again = true;
+            continue;
+        }
+        if (reload == RELOAD_DONE && entry.replacement)
+        {
+            // built from the shader being replaced, never used
+            SDL_ReleaseGPUGraphicsPipeline(device, entry.replacement);
+            entry.replacement = nullptr;
+        }
+        QueueRebuild(entry);
+    }
+    return count;
+}
+
+void PipelineCache::QueueRebuild(Entry& entry)
+{
+    entry.reload.store(RELOAD_QUEUED, std::memory_order_release);
+    if (threads.empty())
+    {
+        TryRebuild(entry);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push_back(&entry);
+    }
+    wake.notify_one();
+}
+
+void PipelineCache::SwapRebuilt(Entry& entry)
+{
+    // a failed rebuild keeps the old pipeline, its error is already logged
+    if (entry.replacement)
+    {
+        // frames in flight keep the old one alive until they complete
+        if (entry.pipeline)
+            SDL_ReleaseGPUGraphicsPipeline(device, entry.pipeline);
+        entry.pipeline = entry.replacement;
+        entry.replacement = nullptr;
+        entry.state.store(STATE_READY, std::memory_order_release);
+        stats.reloaded++;
+    }
+    entry.reload.store(RELOAD_NONE, std::memory_order_release);
+}
+
+void PipelineCache::WorkerMain()
+{
+    PROFILE_THREAD("pipeline compiler");
+    for (;;)
+    {
+        Entry* entry;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !queue.empty(); });
+            if (quit)
+                return;
+            entry = queue.front();
+            queue.pop_front();
+            in_progress++;
+        }
+
+        // Wait may have built it on the main thread already
+        if (!TryCreate(*entry))
+            TryRebuild(*entry);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            in_progress--;
+        }
+        done.notify_all();
+    }
+}
+
+bool PipelineCache::TryCreate(Entry& entry)
+{
+    uint32_t expected = STATE_QUEUED;
+    if (!entry.state.compare_exchange_strong(expected, STATE_CREATING, std::memory_order_acq_rel))
+        return false;
+
+    entry.pipeline = Create(entry.desc);
+    {
+        // state changes under the lock so a waiter cannot miss the notification
+        std::lock_guard<std::mutex> lock(mutex);
+        entry.state.store(entry.pipeline ? STATE_READY : STATE_FAILED, std::memory_order_release);
+    }
+    done.notify_all();
+    return true;
+}
+
+bool PipelineCache::TryRebuild(Entry& entry)
+{
+    uint32_t expected = RELOAD_QUEUED;
+    if (!entry.reload.compare_exchange_strong(expected, RELOAD_CREATING, std::memory_order_acq_rel))
+        return false;
+
+    entry.replacement = Create(entry.desc);
+    entry.reload.store(RELOAD_DONE, std::memory_order_release);
+    return true;
+}
+
+SDL_GPUGraphicsPipeline* PipelineCache::Create(const PipelineDesc& desc)
+{
+    PROFILE_ZONE("create pipeline");
+    const Shader* vertex = LoadShader(desc.vertex_shader);
+    const Shader* fragment = LoadShader(desc.fragment_shader);
+    if (!vertex || !fragment)
+    {
+        stats.failed++;
+        return nullptr;
+    }
+    if (vertex->reflection.stage != SDL_GPU_SHADERSTAGE_VERTEX || fragment->reflection.stage != SDL_GPU_SHADERSTAGE_FRAGMENT)
+    {
+        SDL_Log("Failed to create pipeline %s + %s: shader stages do not match", desc.vertex_shader.c_str(), desc.fragment_shader.c_str());
+        stats.failed++;
+        return nullptr;
+    }
+
+    // attributes straight from the vertex shader inputs, formats overridable per location
+    SDL_GPUVertexAttribute attributes[PipelineDesc::kMaxVertexAttributes];
+    uint32_t attribute_count = 0;
+    for (const spirv::VertexInput& input : vertex->reflection.inputs)
+    {
+        if (input.location >= PipelineDesc::kMaxVertexAttributes)
+        {
+            SDL_Log("Failed to create pipeline %s: vertex input %s at location %u is out of range", desc.vertex_shader.c_str(), input.name.c_str(), input.location);
+            stats.failed++;
+            return nullptr;
+        }
+        SDL_GPUVertexAttribute& attribute = attributes[attribute_count++];
+        attribute.location = input.location;
+        attribute.buffer_slot = 0;
+        attribute.format = desc.attribute_formats[input.location] != SDL_GPU_VERTEXELEMENTFORMAT_INVALID ? desc.attribute_formats[input.location] : input.format;
+        attribute.offset = desc.attribute_offsets[input.location];
+    }
+
+    SDL_GPUVertexBufferDescription buffer{};
+    buffer.slot = 0;
+    buffer.input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
+    buffer.pitch = desc.vertex_pitch;
+
+    SDL_GPUColorTargetDescription color_target{};
+    color_target.format = desc.color_format;
+    if (desc.blend)
+    {
+        SDL_GPUColorTargetBlendState& blend = color_target.blend_state;
+        blend.enable_blend = true;
+        blend.src_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend.dst_color_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        blend.color_blend_op = SDL_GPU_BLENDOP_ADD;
+        blend.src_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE;
+        blend.dst_alpha_blendfactor = SDL_GPU_BLENDFACTOR_ONE_MINUS_SRC_ALPHA;
+        blend.alpha_blend_op = SDL_GPU_BLENDOP_ADD;
+    }
+
+    SDL_GPUGraphicsPipelineCreateInfo info{};
+    info.vertex_shader = vertex->shader;
+    info.fragment_shader = fragment->shader;
+    info.primitive_type = desc.primitive_type;
+    info.vertex_input_state.vertex_buffer_descriptions = &buffer;
+    info.vertex_input_state.num_vertex_buffers = attribute_count ? 1 : 0;
+    info.vertex_input_state.vertex_attributes = attributes;
+    info.vertex_input_state.num_vertex_attributes = attribute_count;
+    info.rasterizer_state.fill_mode = desc.fill_mode;
+    info.rasterizer_state.cull_mode = desc.cull_mode;
+    info.rasterizer_state.front_face = desc.front_face;
+    info.depth_stencil_state.enable_depth_test = desc.depth_test;
+    info.depth_stencil_state.enable_depth_write = desc.depth_write;
+    info.depth_stencil_state.compare_op = desc.depth_compare;
+    info.target_info.color_target_descriptions = &color_target;
+    info.target_info.num_color_targets = desc.color_format != SDL_GPU_TEXTUREFORMAT_INVALID ? 1 : 0;
+    info.target_info.depth_stencil_format = desc.depth_format;
+    info.target_info.has_depth_stencil_target = desc.depth_format != SDL_GPU_TEXTUREFORMAT_INVALID;
+
+    SDL_GPUGraphicsPipeline* pipeline = SDL_CreateGPUGraphicsPipeline(device, &info);
+    if (!pipeline)
+    {
+        SDL_Log("Failed to create pipeline %s + %s: %s", desc.vertex_shader.c_str(), desc.fragment_shader.c_str(), SDL_GetError());
+        stats.failed++;
+        return nullptr;
+    }
+    stats.created++;
+    return pipeline;
+}
+
+const PipelineCache::Shader* PipelineCache::LoadShader(const std::string& path)
+{
+    // held across the load, two pipelines sharing a new shader must not both create it
+    std::lock_guard<std::mutex> lock(shader_mutex);
+    auto found = shaders.find(path);
+    if (found == shaders.end())
+    {
+        std::unique_ptr<Shader> shader = std::make_unique<Shader>();
+        shader->shader = shader::LoadShader(device, path.c_str(), &shader->reflection);
+        stats.shaders++;
+        found = shaders.emplace(path, std::move(shader)).first;
+    }
+    // failures stay cached too, no point reading a broken file again per variant
+    return found->second->shader ? found->second.get() : nullptr;
+}
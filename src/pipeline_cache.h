@@ -0,0 +1,170 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "memory.h"
+#include "spirv_reflect.h"
+#include "vertex_format.h"
+
+// Everything that makes two graphics pipelines different, by value. Vertex
+// attribute formats default to what the vertex shader declares, only the
+// buffer layout has to be spelled out, by hand or from a vtx::Layout.
+struct PipelineDesc
+{
+    static const uint32_t kMaxVertexAttributes = 8;
+
+    std::string vertex_shader;
+    std::string fragment_shader;
+
+    SDL_GPUPrimitiveType primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
+    SDL_GPUFillMode fill_mode = SDL_GPU_FILLMODE_FILL;
+    SDL_GPUCullMode cull_mode = SDL_GPU_CULLMODE_NONE;
+    SDL_GPUFrontFace front_face = SDL_GPU_FRONTFACE_COUNTER_CLOCKWISE;
+
+    SDL_GPUTextureFormat color_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+    bool blend = false;                 // premultiplied alpha over
+    SDL_GPUTextureFormat depth_format = SDL_GPU_TEXTUREFORMAT_INVALID;   // INVALID: no depth target
+    bool depth_test = false;
+    bool depth_write = false;
+    SDL_GPUCompareOp depth_compare = SDL_GPU_COMPAREOP_LESS;
+
+    // one interleaved vertex buffer in slot 0, indexed by shader location
+    uint32_t vertex_pitch = 0;
+    uint32_t attribute_offsets[kMaxVertexAttributes] = {};
+    SDL_GPUVertexElementFormat attribute_formats[kMaxVertexAttributes] = {};  // INVALID: reflected
+
+    // pitch, offsets and formats of every attribute the layout has
+    void SetVertexLayout(const vtx::Layout& layout);
+
+    uint64_t Hash() const;
+    bool operator==(const PipelineDesc& other) const;
+};
+
+using PipelineHandle = uint32_t;
+
+// Shader and graphics pipeline cache. Shaders are loaded and reflected once
+// per path. Pipelines are deduplicated on their description, so requesting a
+// material variant that already exists costs a hash lookup, and new ones are
+// created on background threads: Get returns nullptr until the pipeline is
+// ready and the caller skips those draws for the frame rather than stalling.
+// With no threads, pipelines are created on first Get instead. Reloading a
+// shader rebuilds the pipelines using it the same way, and Get keeps returning
+// the old pipeline until the new one is ready to take its place.
+class PipelineCache
+{
+public:
+    struct Stats
+    {
+        uint32_t requests = 0;
+        uint32_t hits = 0;              // requests answered by an existing pipeline
+        std::atomic<uint32_t> shaders{ 0 };    // distinct shader modules loaded
+        std::atomic<uint32_t> created{ 0 };
+        std::atomic<uint32_t> failed{ 0 };
+        uint32_t reloaded = 0;          // pipelines swapped for a rebuild after a shader reload
+    };
+
+    // thread_count background creation threads, 0 creates lazily on the calling thread
+    PipelineCache(SDL_GPUDevice* _device, uint32_t thread_count = 1);
+    ~PipelineCache();
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // same description, same handle. Starts creation in the background
+    PipelineHandle Request(const PipelineDesc& desc);
+
+    // nullptr while the pipeline is still being created or when creation failed
+    SDL_GPUGraphicsPipeline* Get(PipelineHandle handle);
+
+    // creates the pipeline now if no thread has picked it up yet, otherwise waits for it
+    SDL_GPUGraphicsPipeline* Wait(PipelineHandle handle);
+    void WaitIdle();
+
+    bool IsReady(PipelineHandle handle) const;
+    // ready or failed, or left for the first Get when there are no threads
+    bool IsDone(PipelineHandle handle) const;
+    uint32_t PipelineCount() const { return entries.Count(); }
+    const Stats& GetStats() const { return stats; }
+
+    // reflection of a shader loaded through this cache, nullptr if it is not loaded (yet)
+    const spirv::Reflection* GetReflection(const std::string& path);
+
+    // Reads the shader at path again and rebuilds every pipeline using it in the
+    // background. Pipelines whose rebuild fails keep the old version. Returns the
+    // number of pipelines being rebuilt
+    uint32_t ReloadShader(const std::string& path);
+
+private:
+    enum State : uint32_t
+    {
+        STATE_QUEUED,
+        STATE_CREATING,
+        STATE_READY,
+        STATE_FAILED,
+    };
+
+    enum Reload : uint32_t
+    {
+        RELOAD_NONE,
+        RELOAD_QUEUED,
+        RELOAD_CREATING,
+        RELOAD_DONE,                // replacement built, the next Get swaps it in
+    };
+
+    struct Entry
+    {
+        PipelineDesc desc;
+        uint64_t hash = 0;
+        std::atomic<uint32_t> state{ STATE_QUEUED };
+        SDL_GPUGraphicsPipeline* pipeline = nullptr;
+        // a rebuild after a shader reload, made while pipeline stays in use
+        std::atomic<uint32_t> reload{ RELOAD_NONE };
+        SDL_GPUGraphicsPipeline* replacement = nullptr;
+        bool reload_again = false;      // main thread: the shader changed while a build was running
+    };
+
+    struct Shader
+    {
+        SDL_GPUShader* shader = nullptr;
+        spirv::Reflection reflection;
+    };
+
+    void WorkerMain();
+    // whoever moves the entry from QUEUED to CREATING builds it
+    bool TryCreate(Entry& entry);
+    bool TryRebuild(Entry& entry);
+    SDL_GPUGraphicsPipeline* Create(const PipelineDesc& desc);
+    void QueueRebuild(Entry& entry);
+    void SwapRebuilt(Entry& entry);
+    const Shader* LoadShader(const std::string& path);
+
+    SDL_GPUDevice* device;
+
+    // pool: entries keep their address while the main thread appends
+    mem::Pool<Entry> entries{ mem::CATEGORY_RENDERER };
+    std::unordered_map<uint64_t, PipelineHandle> by_hash;
+
+    // shaders never move, reloads retire the old version until the cache goes away
+    // since a creation thread may still be using it
+    std::mutex shader_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Shader>> shaders;
+    std::vector<std::unique_ptr<Shader>> retired_shaders;
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::deque<Entry*> queue;
+    uint32_t in_progress = 0;
+    bool quit = false;
+
+    Stats stats;
+};
@@ -0,0 +1,155 @@
+#include "pose.h"
+#include "skeleton.h"
+#include "simd.h"
+
+#include <cmath>
+
+namespace anim
+{
+    void LocalPose::Resize(uint32_t joints)
+    {
+        joint_count = joints;
+        uint32_t padded = (joints + 3) & ~3u;
+        tx.assign(padded, 0.0f);
+        ty.assign(padded, 0.0f);
+        tz.assign(padded, 0.0f);
+        rx.assign(padded, 0.0f);
+        ry.assign(padded, 0.0f);
+        rz.assign(padded, 0.0f);
+        rw.assign(padded, 1.0f);
+        sx.assign(padded, 1.0f);
+        sy.assign(padded, 1.0f);
+        sz.assign(padded, 1.0f);
+    }
+
+    void LocalPose::SetJoint(uint32_t joint, const glm::vec3& translation, const glm::vec4& rotation, const glm::vec3& scale)
+    {
+        tx[joint] = translation.x;
+        ty[joint] = translation.y;
+        tz[joint] = translation.z;
+        rx[joint] = rotation.x;
+        ry[joint] = rotation.y;
+        rz[joint] = rotation.z;
+        rw[joint] = rotation.w;
+        sx[joint] = scale.x;
+        sy[joint] = scale.y;
+        sz[joint] = scale.z;
+    }
+
+    void BlendPosesScalar(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out)
+    {
+        if (out.PaddedCount() != a.PaddedCount())
+            out.Resize(a.joint_count);
+
+        float inv = 1.0f - weight;
+        for (uint32_t i = 0; i < a.PaddedCount(); i++)
+        {
+            out.tx[i] = a.tx[i] * inv + b.tx[i] * weight;
+            out.ty[i] = a.ty[i] * inv + b.ty[i] * weight;
+            out.tz[i] = a.tz[i] * inv + b.tz[i] * weight;
+            out.sx[i] = a.sx[i] * inv + b.sx[i] * weight;
+            out.sy[i] = a.sy[i] * inv + b.sy[i] * weight;
+            out.sz[i] = a.sz[i] * inv + b.sz[i] * weight;
+
+            float d = a.rx[i] * b.rx[i] + a.ry[i] * b.ry[i] + a.rz[i] * b.rz[i] + a.rw[i] * b.rw[i];
+            float wb = d < 0.0f ? -weight : weight;
+            float x = a.rx[i] * inv + b.rx[i] * wb;
+            float y = a.ry[i] * inv + b.ry[i] * wb;
+            float z = a.rz[i] * inv + b.rz[i] * wb;
+            float w = a.rw[i] * inv + b.rw[i] * wb;
+            float len = sqrtf(x * x + y * y + z * z + w * w);
+            out.rx[i] = x / len;
+            out.ry[i] = y / len;
+            out.rz[i] = z / len;
+            out.rw[i] = w / len;
+        }
+        out.joint_count = a.joint_count;
+    }
+
+    void BlendPoses(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out)
+    {
+#if SKELETAL_SSE
+        if (out.PaddedCount() != a.PaddedCount())
+            out.Resize(a.joint_count);
+
+        const __m128 w = _mm_set1_ps(weight);
+        const __m128 inv = _mm_set1_ps(1.0f - weight);
+        const __m128 sign_bit = _mm_set1_ps(-0.0f);
+
+        auto lerp = [&](const std::vector<float>& va, const std::vector<float>& vb, std::vector<float>& vo, uint32_t i)
+        {
+            __m128 x = _mm_loadu_ps(&va[i]);
+            __m128 y = _mm_loadu_ps(&vb[i]);
+            _mm_storeu_ps(&vo[i], SKELETAL_MADD(y, w, _mm_mul_ps(x, inv)));
+        };
+
+        for (uint32_t i = 0; i < a.PaddedCount(); i += 4)
+        {
+            lerp(a.tx, b.tx, out.tx, i);
+            lerp(a.ty, b.ty, out.ty, i);
+            lerp(a.tz, b.tz, out.tz, i);
+            lerp(a.sx, b.sx, out.sx, i);
+            lerp(a.sy, b.sy, out.sy, i);
+            lerp(a.sz, b.sz, out.sz, i);
+
+            __m128 ax = _mm_loadu_ps(&a.rx[i]), ay = _mm_loadu_ps(&a.ry[i]);
+            __m128 az = _mm_loadu_ps(&a.rz[i]), aw = _mm_loadu_ps(&a.rw[i]);
+            __m128 bx = _mm_loadu_ps(&b.rx[i]), by = _mm_loadu_ps(&b.ry[i]);
+            __m128 bz = _mm_loadu_ps(&b.rz[i]), bw = _mm_loadu_ps(&b.rw[i]);
+
+            // flip b's weight where the quaternions are in opposite hemispheres
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+            __m128 wb = _mm_xor_ps(w, _mm_and_ps(d, sign_bit));
+
+            __m128 x = SKELETAL_MADD(bx, wb, _mm_mul_ps(ax, inv));
+            __m128 y = SKELETAL_MADD(by, wb, _mm_mul_ps(ay, inv));
+            __m128 z = SKELETAL_MADD(bz, wb, _mm_mul_ps(az, inv));
+            __m128 qw = SKELETAL_MADD(bw, wb, _mm_mul_ps(aw, inv));
+
+            __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_add_ps(_mm_mul_ps(z, z), _mm_mul_ps(qw, qw))));
+            _mm_storeu_ps(&out.rx[i], _mm_div_ps(x, len));
+            _mm_storeu_ps(&out.ry[i], _mm_div_ps(y, len));
+            _mm_storeu_ps(&out.rz[i], _mm_div_ps(z, len));
+            _mm_storeu_ps(&out.rw[i], _mm_div_ps(qw, len));
+        }
+        out.joint_count = a.joint_count;
+#else
+        BlendPosesScalar(a, b, weight, out);
+#endif
+    }
+
+    void LocalToModel(const Skeleton& skeleton, const LocalPose& pose, glm::mat4* model)
+    {
+        for (uint32_t i = 0; i < skeleton.JointCount(); i++)
+        {
+            float x = pose.rx[i], y = pose.ry[i], z = pose.rz[i], w = pose.rw[i];
+            float xx = x * x, yy = y * y, zz = z * z;
+            float xy = x * y, xz = x * z, yz = y * z;
+            float wx = w * x, wy = w * y, wz = w * z;
+
+            glm::mat4 local(
+                glm::vec4(1.0f - 2.0f * (yy + zz), 2.0f * (xy + wz), 2.0f * (xz - wy), 0.0f) * pose.sx[i],
+                glm::vec4(2.0f * (xy - wz), 1.0f - 2.0f * (xx + zz), 2.0f * (yz + wx), 0.0f) * pose.sy[i],
+                glm::vec4(2.0f * (xz + wy), 2.0f * (yz - wx), 1.0f - 2.0f * (xx + yy), 0.0f) * pose.sz[i],
+                glm::vec4(pose.tx[i], pose.ty[i], pose.tz[i], 1.0f));
+
+            int parent = skeleton.parents[i];
+            model[i] = parent == kNoParent ? local : model[parent] * local;
+        }
+    }
+
+    void BuildSkinningPalette(const Skeleton& skeleton, const glm::mat4* model, SkinMatrix* palette)
+    {
+        for (uint32_t i = 0; i < skeleton.JointCount(); i++)
+        {
+            glm::mat4 m = model[i] * skeleton.inverse_bind[i];
+            for (int c = 0; c < 4; c++)
+            {
+                palette[i].cols[c][0] = m[c][0];
+                palette[i].cols[c][1] = m[c][1];
+                palette[i].cols[c][2] = m[c][2];
+                palette[i].cols[c][3] = 0.0f;
+            }
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "glm/glm.hpp"
+
+namespace anim
+{
+    struct Skeleton;
+
+    // Joint local transforms in SoA layout. Every array is padded to a multiple
+    // of 4 joints so SIMD loops run without tail handling; padding joints hold
+    // the identity transform.
+    struct LocalPose
+    {
+        uint32_t joint_count = 0;
+        std::vector<float> tx, ty, tz;
+        std::vector<float> rx, ry, rz, rw;
+        std::vector<float> sx, sy, sz;
+
+        void Resize(uint32_t joints);
+        uint32_t PaddedCount() const { return (uint32_t)tx.size(); }
+
+        void SetJoint(uint32_t joint, const glm::vec3& translation, const glm::vec4& rotation, const glm::vec3& scale);
+    };
+
+    // Object space skinning transform, stored as four xyz_ columns so the
+    // skinning kernel blends and applies it without horizontal SIMD ops.
+    struct alignas(16) SkinMatrix
+    {
+        float cols[4][4];
+    };
+
+    // Translation/scale lerp and rotation nlerp (shortest path) between two poses.
+    void BlendPoses(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out);
+    void BlendPosesScalar(const LocalPose& a, const LocalPose& b, float weight, LocalPose& out);
+
+    // Concatenates local transforms down the hierarchy. Relies on parents preceding children.
+    void LocalToModel(const Skeleton& skeleton, const LocalPose& pose, glm::mat4* model);
+
+    // palette[i] = model[i] * inverse_bind[i]
+    void BuildSkinningPalette(const Skeleton& skeleton, const glm::mat4* model, SkinMatrix* palette);
+}
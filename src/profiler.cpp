@@ -0,0 +1,203 @@
+#include "profiler.h"
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace profiler
+{
+    // single producer (the owning thread), single consumer (whoever calls Frame)
+    struct ThreadRing
+    {
+        Event events[kRingCapacity];
+        std::atomic<uint32_t> head{ 0 };
+        std::atomic<uint32_t> tail{ 0 };
+        uint32_t thread_id = 0;
+        std::string name;
+    };
+
+    struct CapturedEvent
+    {
+        Event event;
+        uint32_t thread_id;
+    };
+
+    // rings outlive their threads, a finished thread's last events still get drained
+    static std::mutex g_rings_mutex;
+    static std::vector<ThreadRing*> g_rings;
+    static std::atomic<uint64_t> g_dropped{ 0 };
+
+    static std::mutex g_capture_mutex;
+    static bool g_capturing = false;
+    static std::vector<CapturedEvent> g_capture;
+
+    static ThreadRing* CreateRing()
+    {
+        ThreadRing* ring = new ThreadRing();
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        ring->thread_id = (uint32_t)g_rings.size() + 1;
+        ring->name = "thread " + std::to_string(ring->thread_id);
+        g_rings.push_back(ring);
+        return ring;
+    }
+
+    static ThreadRing* LocalRing()
+    {
+        static thread_local ThreadRing* ring = CreateRing();
+        return ring;
+    }
+
+    static void Push(const Event& event)
+    {
+        ThreadRing* ring = LocalRing();
+        uint32_t head = ring->head.load(std::memory_order_relaxed);
+        if (head - ring->tail.load(std::memory_order_acquire) >= kRingCapacity)
+        {
+            g_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        ring->events[head & (kRingCapacity - 1)] = event;
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    uint64_t Now()
+    {
+        return SDL_GetPerformanceCounter();
+    }
+
+    void RecordZone(const char* name, uint64_t begin, uint64_t end)
+    {
+        Push({ name, begin, end, EVENT_ZONE });
+    }
+
+    void RecordCounter(const char* name, uint64_t value)
+    {
+        Push({ name, Now(), value, EVENT_COUNTER });
+    }
+
+    void SetThreadName(const char* name)
+    {
+        ThreadRing* ring = LocalRing();
+        std::lock_guard<std::mutex> lock(g_rings_mutex);
+        ring->name = name;
+    }
+
+    void Frame()
+    {
+        Push({ "frame", Now(), 0, EVENT_FRAME });
+
+        std::lock_guard<std::mutex> rings_lock(g_rings_mutex);
+        std::lock_guard<std::mutex> capture_lock(g_capture_mutex);
+        for (ThreadRing* ring : g_rings)
+        {
+            uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+            uint32_t head = ring->head.load(std::memory_order_acquire);
+            if (g_capturing)
+            {
+                for (uint32_t i = tail; i != head; i++)
+                    g_capture.push_back({ ring->events[i & (kRingCapacity - 1)], ring->thread_id });
+            }
+            ring->tail.store(head, std::memory_order_release);
+        }
+    }
+
+    void BeginCapture()
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        g_capture.clear();
+        g_capturing = true;
+    }
+
+    void EndCapture()
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        g_capturing = false;
+    }
+
+    bool IsCapturing()
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        return g_capturing;
+    }
+
+    size_t CapturedEvents()
+    {
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        return g_capture.size();
+    }
+
+    uint64_t DroppedEvents()
+    {
+        return g_dropped.load(std::memory_order_relaxed);
+    }
+
+    static void AppendEscaped(std::string& out, const char* text)
+    {
+        for (; *text; text++)
+        {
+            if (*text == '"' || *text == '\\')
+                out += '\\';
+            if ((unsigned char)*text >= 0x20)
+                out += *text;
+        }
+    }
+
+    bool WriteChromeTrace(const char* path)
+    {
+        std::string json = "{\"traceEvents\":[\n";
+        char line[256];
+        {
+            std::lock_guard<std::mutex> rings_lock(g_rings_mutex);
+            for (ThreadRing* ring : g_rings)
+            {
+                json += "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" + std::to_string(ring->thread_id) + ",\"args\":{\"name\":\"";
+                AppendEscaped(json, ring->name.c_str());
+                json += "\"}},\n";
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(g_capture_mutex);
+        uint64_t origin = g_capture.empty() ? 0 : g_capture[0].event.begin;
+        for (const CapturedEvent& captured : g_capture)
+            origin = SDL_min(origin, captured.event.begin);
+
+        // microseconds, relative to the first event so the doubles keep their precision
+        double to_us = 1e6 / (double)SDL_GetPerformanceFrequency();
+        for (const CapturedEvent& captured : g_capture)
+        {
+            const Event& event = captured.event;
+            json += "{\"name\":\"";
+            AppendEscaped(json, event.name);
+            double ts = (event.begin - origin) * to_us;
+            switch (event.type)
+            {
+            case EVENT_ZONE:
+                SDL_snprintf(line, sizeof(line), "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+                    captured.thread_id, ts, (event.end_or_value - event.begin) * to_us);
+                break;
+            case EVENT_COUNTER:
+                SDL_snprintf(line, sizeof(line), "\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%llu}},\n",
+                    captured.thread_id, ts, (unsigned long long)event.end_or_value);
+                break;
+            case EVENT_FRAME:
+                SDL_snprintf(line, sizeof(line), "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":%u,\"ts\":%.3f},\n",
+                    captured.thread_id, ts);
+                break;
+            }
+            json += line;
+        }
+        // strip the trailing comma, JSON has no use for it
+        if (json.size() >= 2 && json[json.size() - 2] == ',')
+            json.erase(json.size() - 2, 1);
+        json += "]}\n";
+
+        if (!SDL_SaveFile(path, json.data(), json.size()))
+        {
+            SDL_Log("Failed to write trace %s: %s", path, SDL_GetError());
+            return false;
+        }
+        return true;
+    }
+}
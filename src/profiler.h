@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Lightweight CPU profiler. Zones, counters and frame markers are recorded
+// into a lock-free ring owned by the recording thread, a single timestamp
+// read and one ring write per zone. Frame() drains every ring into the
+// capture, if one is running, and discards the events otherwise.
+//
+// Captures export as Chrome trace JSON (chrome://tracing, Perfetto). Tracy
+// reads the same file through its import-chrome tool.
+//
+// Building with SKELETAL_PROFILE=0 turns every macro below into nothing.
+#ifndef SKELETAL_PROFILE
+#define SKELETAL_PROFILE 0
+#endif
+
+namespace profiler
+{
+    enum EventType : uint32_t
+    {
+        EVENT_ZONE,
+        EVENT_COUNTER,
+        EVENT_FRAME,
+    };
+
+    struct Event
+    {
+        const char* name;           // string literal, never copied
+        uint64_t begin;             // performance counter ticks
+        uint64_t end_or_value;      // zone end ticks or counter value
+        EventType type;
+    };
+
+    uint64_t Now();
+
+    void RecordZone(const char* name, uint64_t begin, uint64_t end);
+    void RecordCounter(const char* name, uint64_t value);
+    // names the calling thread in captures, the string is copied
+    void SetThreadName(const char* name);
+
+    // Frame boundary: records a marker and drains every thread's ring.
+    // Call from one thread only, once per frame.
+    void Frame();
+
+    void BeginCapture();
+    void EndCapture();
+    bool IsCapturing();
+    size_t CapturedEvents();
+    // events lost to full rings since start, a ring holds kRingCapacity events between Frame calls
+    uint64_t DroppedEvents();
+    static const uint32_t kRingCapacity = 1 << 16;
+
+    // writes the capture as Chrome trace JSON
+    bool WriteChromeTrace(const char* path);
+
+    class Zone
+    {
+    public:
+        explicit Zone(const char* _name) : name(_name), begin(Now()) {}
+        ~Zone() { RecordZone(name, begin, Now()); }
+
+        Zone(const Zone&) = delete;
+        Zone& operator=(const Zone&) = delete;
+
+    private:
+        const char* name;
+        uint64_t begin;
+    };
+}
+
+#define SKELETAL_PROFILE_CONCAT2(a, b) a##b
+#define SKELETAL_PROFILE_CONCAT(a, b) SKELETAL_PROFILE_CONCAT2(a, b)
+
+#if SKELETAL_PROFILE
+#define PROFILE_ZONE(name) profiler::Zone SKELETAL_PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) profiler::RecordCounter(name, (uint64_t)(value))
+#define PROFILE_FRAME() profiler::Frame()
+#define PROFILE_THREAD(name) profiler::SetThreadName(name)
+#else
+#define PROFILE_ZONE(name) ((void)0)
+#define PROFILE_COUNTER(name, value) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,194 @@
+#include "render_queue.h"
+
+#include <SDL3/SDL.h>
+#include <cstring>
+
+static const uint32_t kDepthBits = 16;
+static const uint32_t kLodBits = 3;
+static const uint32_t kMeshBits = 21;
+static const uint32_t kMaterialBits = 16;
+static const uint32_t kStateBits = 8 + kMaterialBits + kMeshBits + kLodBits;
+static const uint64_t kStateMask = (1ull << kStateBits) - 1;
+// ORDER_FRONT_TO_BACK: sign, exponent and 3 mantissa bits, then 4 more below the state
+static const uint32_t kSliceBits = 12;
+static const uint32_t kFineDepthBits = 4;
+
+// the state part of a key, whatever the order
+static uint64_t KeyState(uint64_t key, RenderQueue::Order order)
+{
+    switch (order)
+    {
+    case RenderQueue::ORDER_FRONT_TO_BACK:
+        return key >> kFineDepthBits & kStateMask;
+    case RenderQueue::ORDER_BACK_TO_FRONT:
+        return key & kStateMask;
+    default:
+        return key >> kDepthBits;
+    }
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod, float depth, Order order)
+{
+    SDL_assert(pipeline < kMaxPipelines && material < kMaxMaterials && mesh < kMaxMeshes && lod < kMaxLods);
+
+    // positive floats order like their bit patterns, keep the top 16 bits
+    uint32_t bits;
+    depth = depth > 0.0f ? depth : 0.0f;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    uint64_t depth_key = bits >> (32 - kDepthBits);
+
+    uint64_t state = (uint64_t)pipeline << (kMaterialBits + kMeshBits + kLodBits) |
+                     (uint64_t)material << (kMeshBits + kLodBits) |
+                     (uint64_t)mesh << kLodBits |
+                     lod;
+    switch (order)
+    {
+    case ORDER_FRONT_TO_BACK:
+        return depth_key >> (kDepthBits - kSliceBits) << (kStateBits + kFineDepthBits) | state << kFineDepthBits |
+               (depth_key & ((1u << kFineDepthBits) - 1));
+    case ORDER_BACK_TO_FRONT:
+        return (0xFFFFull - depth_key) << kStateBits | state;
+    default:
+        return state << kDepthBits | depth_key;
+    }
+}
+
+void RenderQueue::SetOrder(Order _order)
+{
+    SDL_assert(keys.empty());
+    order = _order;
+}
+
+void RenderQueue::Clear()
+{
+    keys.clear();
+    transforms.clear();
+}
+
+void RenderQueue::Reserve(uint32_t count)
+{
+    keys.reserve(count);
+    transforms.reserve(count);
+}
+
+void RenderQueue::Submit(uint32_t pipeline, uint32_t material, uint32_t mesh, const glm::mat4& transform, float depth, uint32_t lod)
+{
+    keys.push_back(MakeKey(pipeline, material, mesh, lod, depth, order));
+    transforms.push_back(transform);
+}
+
+void RenderQueue::Append(const RenderQueue& other)
+{
+    // keys already carry the order's layout
+    SDL_assert(other.order == order);
+    keys.insert(keys.end(), other.keys.begin(), other.keys.end());
+    transforms.insert(transforms.end(), other.transforms.begin(), other.transforms.end());
+}
+
+void RenderQueue::Build()
+{
+    uint32_t count = (uint32_t)keys.size();
+    batches.clear();
+    instances.resize(count);
+    stats = {};
+    stats.items = count;
+    if (count == 0)
+        return;
+
+    sorted_keys.assign(keys.begin(), keys.end());
+    sorted_items.resize(count);
+    for (uint32_t i = 0; i < count; i++)
+        sorted_items[i] = i;
+    RadixSort(sorted_keys, sorted_items, scratch_keys, scratch_order);
+
+    // the state bits identify the batch, with depth first only neighbours of the same state merge
+    DrawBatch* batch = nullptr;
+    uint64_t batch_state = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint64_t state = KeyState(sorted_keys[i], order);
+        if (!batch || state != batch_state)
+        {
+            DrawBatch next{};
+            next.pipeline = (uint32_t)(state >> (kMaterialBits + kMeshBits + kLodBits));
+            next.material = (uint32_t)(state >> (kMeshBits + kLodBits)) & (kMaxMaterials - 1);
+            next.mesh = (uint32_t)(state >> kLodBits) & (kMaxMeshes - 1);
+            next.lod = (uint32_t)state & (kMaxLods - 1);
+            next.first_instance = i;
+            next.bind_pipeline = !batch || batch->pipeline != next.pipeline;
+            next.bind_material = !batch || batch->material != next.material;
+            // another LOD of the same mesh only changes the index range
+            next.bind_mesh = !batch || batch->mesh != next.mesh;
+
+            stats.pipeline_binds += next.bind_pipeline;
+            stats.material_binds += next.bind_material;
+            stats.mesh_binds += next.bind_mesh;
+
+            batches.push_back(next);
+            batch = &batches.back();
+            batch_state = state;
+        }
+        batch->instance_count++;
+        instances[i].transform = transforms[sorted_items[i]];
+    }
+    stats.draws = (uint32_t)batches.size();
+}
+
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint64_t>& scratch_keys, std::vector<uint32_t>& scratch_values)
+{
+    size_t count = keys.size();
+    scratch_keys.resize(count);
+    scratch_values.resize(count);
+
+    // all eight histograms in a single read of the keys
+    static thread_local uint32_t histograms[8][256];
+    std::memset(histograms, 0, sizeof(histograms));
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t key = keys[i];
+        for (uint32_t pass = 0; pass < 8; pass++)
+            histograms[pass][(key >> (pass * 8)) & 0xFF]++;
+    }
+
+    uint64_t* source_keys = keys.data();
+    uint32_t* source_values = values.data();
+    uint64_t* target_keys = scratch_keys.data();
+    uint32_t* target_values = scratch_values.data();
+
+    for (uint32_t pass = 0; pass < 8; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        uint32_t shift = pass * 8;
+
+        // a byte shared by every key does not reorder anything
+        if (histogram[(source_keys[0] >> shift) & 0xFF] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; bucket++)
+        {
+            uint32_t size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += size;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t key = source_keys[i];
+            uint32_t slot = histogram[(key >> shift) & 0xFF]++;
+            target_keys[slot] = key;
+            target_values[slot] = source_values[i];
+        }
+
+        std::swap(source_keys, target_keys);
+        std::swap(source_values, target_values);
+    }
+
+    // an odd number of passes leaves the result in the scratch buffers
+    if (source_keys != keys.data())
+    {
+        keys.swap(scratch_keys);
+        values.swap(scratch_values);
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Per-instance data read by the instanced vertex shader from a storage buffer.
+struct InstanceData
+{
+    glm::mat4 transform;
+};
+
+// One instanced draw produced by RenderQueue::Build. The bind flags say which
+// state differs from the previous batch, the renderer rebinds nothing else.
+struct DrawBatch
+{
+    uint32_t pipeline;
+    uint32_t material;
+    uint32_t mesh;
+    uint32_t lod;
+    uint32_t first_instance;        // into RenderQueue::Instances()
+    uint32_t instance_count;
+    bool bind_pipeline;
+    bool bind_material;
+    bool bind_mesh;
+};
+
+// Collects (pipeline, material, mesh, LOD, transform) items for a frame, sorts
+// them by a 64-bit key and merges runs of the same mesh, LOD and material into
+// instanced draws. Key layout of ORDER_STATE, most significant first:
+//
+//   | pipeline 8 | material 16 | mesh 21 | lod 3 | depth 16 |
+//
+// so state changes are grouped coarsest first, the LODs of a mesh share its
+// vertex and index binding, and instances inside a batch go front to back.
+// The other orders put depth first and give up batching for it:
+//
+//   ORDER_FRONT_TO_BACK  | depth slice 12 | state 48 | depth 4 |
+//   ORDER_BACK_TO_FRONT  | far to near 16 | state 48 |
+//
+// Front to back sorts by slices an eighth of an octave of distance deep and by
+// state inside a slice, so early depth testing rejects most hidden pixels while
+// a slice still batches. Back to front is exact to 16 bits, what blending needs.
+class RenderQueue
+{
+public:
+    static const uint32_t kMaxPipelines = 1u << 8;
+    static const uint32_t kMaxMaterials = 1u << 16;
+    static const uint32_t kMaxMeshes = 1u << 21;
+    static const uint32_t kMaxLods = 1u << 3;
+
+    enum Order
+    {
+        ORDER_STATE,            // fewest state changes
+        ORDER_FRONT_TO_BACK,    // opaque draws without a depth prepass
+        ORDER_BACK_TO_FRONT,    // blended draws
+    };
+
+    struct Stats
+    {
+        uint32_t items = 0;
+        uint32_t draws = 0;
+        uint32_t pipeline_binds = 0;
+        uint32_t material_binds = 0;
+        uint32_t mesh_binds = 0;
+    };
+
+    static uint64_t MakeKey(uint32_t pipeline, uint32_t material, uint32_t mesh, uint32_t lod, float depth,
+        Order order = ORDER_STATE);
+
+    // resource holds the submitted items, a frame arena can take them when the queue only
+    // lives for a frame. It is not asked for memory once Reserve covers everything submitted
+    explicit RenderQueue(Order _order = ORDER_STATE, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : order(_order), keys(resource), transforms(resource) {}
+
+    // the queue has to be empty, keys are made as items are submitted
+    void SetOrder(Order _order);
+    Order GetOrder() const { return order; }
+
+    void Clear();
+    void Reserve(uint32_t count);
+
+    // depth is the view space distance, only used for ordering;
+    // lod picks a range of the mesh's indices (see Mesh::Lod)
+    void Submit(uint32_t pipeline, uint32_t material, uint32_t mesh, const glm::mat4& transform, float depth = 0.0f, uint32_t lod = 0);
+
+    // adds other's items after this queue's, as if they had been submitted here. Lets
+    // several threads fill queues of their own that are merged before Build
+    void Append(const RenderQueue& other);
+
+    // sorts the submitted items and fills Batches() and Instances()
+    void Build();
+
+    const std::vector<DrawBatch>& Batches() const { return batches; }
+    const std::vector<InstanceData>& Instances() const { return instances; }
+    const Stats& GetStats() const { return stats; }
+    uint32_t Size() const { return (uint32_t)keys.size(); }
+
+private:
+    Order order;
+    std::pmr::vector<uint64_t> keys;
+    std::pmr::vector<glm::mat4> transforms;
+
+    // radix sort ping-pong buffers, kept around to avoid per-frame allocations
+    std::vector<uint64_t> sorted_keys;
+    std::vector<uint32_t> sorted_items;
+    std::vector<uint64_t> scratch_keys;
+    std::vector<uint32_t> scratch_order;
+
+    std::vector<DrawBatch> batches;
+    std::vector<InstanceData> instances;
+    Stats stats;
+};
+
+// LSD radix sort of 64-bit keys carrying a 32-bit payload, 8 bits per pass.
+// Passes where every key has the same byte are skipped. Results end up in
+// keys/values, the scratch vectors are resized as needed.
+void RadixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values,
+    std::vector<uint64_t>& scratch_keys, std::vector<uint32_t>& scratch_values);
@@ -1,20 +1,51 @@
 #include "renderer.h"
 
 #include "shader.h"
-#include "image.h"
+#include "mesh.h"
+#include "hot_reload.h"
+#include "mesh_cache.h"
+#include "mesh_lod.h"
+#include "profiler.h"
 
+// staging memory shared by all frames in flight, bigger uploads get their own buffer
+static const Uint32 kUploadRingSize = 32 * 1024 * 1024;
+// fewer visible objects per thread than this are queued on the main thread alone
+static const Uint32 kMinSegmentDraws = 1024;
 
-struct Vertex {
-    float x, y, z;
-    float u, v;     // texture coords
+static const char* const kVertexShader = "res/shaders/compiled/instancedvert.spv";
+static const char* const kPackedVertexShader = "res/shaders/compiled/instancedpackedvert.spv";
+static const char* const kFragmentShader = "res/shaders/compiled/texposfrag.spv";
+// GPU culling: the culling pass and the vertex shaders reading what it wrote
+static const char* const kCullShader = "res/shaders/compiled/cullcomp.spv";
+static const char* const kIndirectVertexShader = "res/shaders/compiled/instancedindirectvert.spv";
+static const char* const kPackedIndirectVertexShader = "res/shaders/compiled/instancedpackedindirectvert.spv";
+// blended materials, the depth prepass, and the overdraw view replacing both fragment shaders
+static const char* const kBlendFragmentShader = "res/shaders/compiled/texposblendfrag.spv";
+static const char* const kPrepassVertexShader = "res/shaders/compiled/depthprepassvert.spv";
+static const char* const kPackedPrepassVertexShader = "res/shaders/compiled/depthprepasspackedvert.spv";
+static const char* const kIndirectPrepassVertexShader = "res/shaders/compiled/depthprepassindirectvert.spv";
+static const char* const kPackedIndirectPrepassVertexShader = "res/shaders/compiled/depthprepasspackedindirectvert.spv";
+static const char* const kPrepassFragmentShader = "res/shaders/compiled/depthprepassfrag.spv";
+static const char* const kOverdrawFragmentShader = "res/shaders/compiled/overdrawfrag.spv";
+
+struct MaterialInfo
+{
+    const char* texture;
+    float opacity;
+};
+
+// a material is one streamed texture for now, the second one is see-through
+static const MaterialInfo kMaterials[] = {
+    { "res/textures/container.jpg", 1.0f },
+    { "res/textures/container.jpg", 0.5f },
 };
 
 static Vertex vertices[] = {
-    //  x      y     z    u    v
-    { -0.5f,  0.5f, 0.0f, 0.0f, 1.0f }, // top-left
-    { -0.5f, -0.5f, 0.0f, 0.0f, 0.0f }, // bottom-left
-    {  0.5f, -0.5f, 0.0f, 1.0f, 0.0f }, // bottom-right
-    {  0.5f,  0.5f, 0.0f, 1.0f, 1.0f }  // top-right
+    //  position              normal               uv
+    { { -0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 1.0f } }, // top-left
+    { { -0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f } }, // bottom-left
+    { {  0.5f, -0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f } }, // bottom-right
+    { {  0.5f,  0.5f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f } }  // top-right
 };
 
 static uint16_t indices[] = {
@@ -22,264 +53,1142 @@ static uint16_t indices[] = {
     0, 2, 3   // second triangle
 };
 
+// per-batch vertex uniforms, the Draw block of the instanced shaders
+struct DrawUniforms
+{
+    Uint32 base_instance;
+    Uint32 padding[3];
+    glm::vec4 position_offset;
+    glm::vec4 position_scale;
+};
+
+// fragment uniforms of texposblend.frag
+struct MaterialUniforms
+{
+    float opacity;
+    float padding[3];
+};
+
 Renderer::RenderData* Renderer::s_Data = nullptr;
 
-bool Renderer::Init()
-{
-    s_Data = new RenderData();
-
-    // create a window
-    s_Data->window = SDL_CreateWindow("Skeletal Animations", 1280, 720, SDL_WINDOW_RESIZABLE);
-
-    // create the device
-    s_Data->device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, true, NULL);
-    SDL_ClaimWindowForGPUDevice(s_Data->device, s_Data->window);
-
-    SDL_GPUShader* vertexShader = shader::LoadShader(s_Data->device, "res/shaders/compiled/texposvert.spv", 0, 0, 0, 0);
-    SDL_GPUShader* fragmentShader = shader::LoadShader(s_Data->device, "res/shaders/compiled/texposfrag.spv", 1, 0, 0, 0);
-
-    // create the graphics pipeline
-    SDL_GPUGraphicsPipelineCreateInfo pipelineInfo{};
-    pipelineInfo.vertex_shader = vertexShader;
-    pipelineInfo.fragment_shader = fragmentShader;
-    pipelineInfo.primitive_type = SDL_GPU_PRIMITIVETYPE_TRIANGLELIST;
-
-    // describe the vertex buffers
-    SDL_GPUVertexBufferDescription vertexBufferDesctiptions[1];
-    vertexBufferDesctiptions[0].slot = 0;
-    vertexBufferDesctiptions[0].input_rate = SDL_GPU_VERTEXINPUTRATE_VERTEX;
-    vertexBufferDesctiptions[0].instance_step_rate = 0;
-    vertexBufferDesctiptions[0].pitch = sizeof(Vertex);
-
-    pipelineInfo.vertex_input_state.num_vertex_buffers = 1;
-    pipelineInfo.vertex_input_state.vertex_buffer_descriptions = vertexBufferDesctiptions;
-
-    // describe the vertex attribute
-    SDL_GPUVertexAttribute vertexAttributes[2];
-
-    // a_position
-    vertexAttributes[0].buffer_slot = 0;
-    vertexAttributes[0].location = 0;
-    vertexAttributes[0].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
-    vertexAttributes[0].offset = 0;
-
-    // a_texcoord
-    vertexAttributes[1].buffer_slot = 0;
-    vertexAttributes[1].location = 1;
-    vertexAttributes[1].format = SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
-    vertexAttributes[1].offset = sizeof(float) * 3;
-
-    // describe the color target
-    SDL_GPUColorTargetDescription colorTargetDescriptions[1];
-    colorTargetDescriptions[0] = {};
-    colorTargetDescriptions[0].format = SDL_GetGPUSwapchainTextureFormat(s_Data->device, s_Data->window);
-
-    pipelineInfo.target_info.num_color_targets = 1;
-    pipelineInfo.target_info.color_target_descriptions = colorTargetDescriptions;
-
-
-    pipelineInfo.vertex_input_state.num_vertex_attributes = 2;
-    pipelineInfo.vertex_input_state.vertex_attributes = vertexAttributes;
-
-    // create the pipeline
-    s_Data->graphicsPipeline = SDL_CreateGPUGraphicsPipeline(s_Data->device, &pipelineInfo);
-
-    // we don't need to store the shaders after creating the pipeline
-    SDL_ReleaseGPUShader(s_Data->device, vertexShader);
-    SDL_ReleaseGPUShader(s_Data->device, fragmentShader);
-
-    // Load 2d tex
-    int width, height, channels;
-    //SDL_Surface *img_data = image::LoadImage("res/textures/tex.bmp", 4);
-    unsigned char* img_data = image::LoadImage("res/textures/container.jpg", &width, &height, &channels, 4);
-    //width = img_data->w;
-    //height = img_data->h;
-    SDL_GPUTextureCreateInfo tex_info{};
-    tex_info.type = SDL_GPU_TEXTURETYPE_2D;
-    tex_info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
-    tex_info.width = width;
-    tex_info.height = height;
-    tex_info.layer_count_or_depth = 1;
-    tex_info.num_levels = 1;
-    tex_info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
-
-    s_Data->texture = SDL_CreateGPUTexture(s_Data->device, &tex_info);
-	SDL_SetGPUTextureName(
-		s_Data->device,
-		s_Data->texture,
-		"container"
-	);
-
-    SDL_GPUSamplerCreateInfo sampler_info{};
-    sampler_info.min_filter = SDL_GPU_FILTER_NEAREST;
-    sampler_info.mag_filter = SDL_GPU_FILTER_NEAREST;
-    sampler_info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_NEAREST;
-    sampler_info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-    sampler_info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-    sampler_info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_CLAMP_TO_EDGE;
-    s_Data->sampler = SDL_CreateGPUSampler(s_Data->device, &sampler_info);
+static std::string DirectoryOf(const char* path)
+{
+    std::string directory = HotReload::NormalizePath(path);
+    size_t slash = directory.find_last_of('/');
+    return slash == std::string::npos ? "." : directory.substr(0, slash);
+}
+
+bool Renderer::Init(const Settings& settings)
+{
+    const char* mesh_cache_path = settings.mesh_cache_path;
+    s_Data = mem::New<RenderData>(mem::CATEGORY_RENDERER);
+    s_Data->jobs = mem::New<JobSystem>(mem::CATEGORY_RENDERER);
+    s_Data->headless = settings.headless;
+    s_Data->lod_pixel_error = settings.lod_pixel_error;
+    s_Data->lod_hysteresis = settings.lod_hysteresis;
+    s_Data->depth_prepass = settings.depth_prepass;
+    s_Data->overdraw_view = settings.overdraw_view;
+    s_Data->frames_in_flight = SDL_clamp(settings.frames_in_flight, 1u, kMaxFramesInFlight);
+    s_Data->segments.reserve(s_Data->jobs->ThreadCount());
+
+    // create the device, any SPIR-V driver works headless, lavapipe included
+    s_Data->device = SDL_CreateGPUDevice(SDL_GPU_SHADERFORMAT_SPIRV, s_Data->debug_mode, NULL);
+    if (!s_Data->device)
+    {
+        SDL_Log("Failed to create the GPU device: %s", SDL_GetError());
+        return false;
+    }
+
+    // the swapchain's size replaces these once frames come in, culling uses the last one
+    s_Data->target_width = settings.width;
+    s_Data->target_height = settings.height;
+    if (s_Data->headless)
+    {
+        // sampler usage too so a frame can be inspected or blitted by tools
+        s_Data->color_format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+        SDL_GPUTextureCreateInfo colorInfo{};
+        colorInfo.type = SDL_GPU_TEXTURETYPE_2D;
+        colorInfo.format = s_Data->color_format;
+        colorInfo.width = settings.width;
+        colorInfo.height = settings.height;
+        colorInfo.layer_count_or_depth = 1;
+        colorInfo.num_levels = 1;
+        colorInfo.usage = SDL_GPU_TEXTUREUSAGE_COLOR_TARGET | SDL_GPU_TEXTUREUSAGE_SAMPLER;
+        s_Data->colorTarget = SDL_CreateGPUTexture(s_Data->device, &colorInfo);
+        if (!s_Data->colorTarget)
+        {
+            SDL_Log("Failed to create the offscreen target: %s", SDL_GetError());
+            return false;
+        }
+    }
+    else
+    {
+        // create a window
+        s_Data->window = SDL_CreateWindow("Skeletal Animations", settings.width, settings.height, SDL_WINDOW_RESIZABLE);
+        SDL_ClaimWindowForGPUDevice(s_Data->device, s_Data->window);
+        s_Data->color_format = SDL_GetGPUSwapchainTextureFormat(s_Data->device, s_Data->window);
+        // the swapchain holds back its images by the same rule as the frame slots
+        if (!SDL_SetGPUAllowedFramesInFlight(s_Data->device, s_Data->frames_in_flight))
+            SDL_Log("Failed to allow %u frames in flight: %s", s_Data->frames_in_flight, SDL_GetError());
+    }
+
+    // D32 where available, D24 or D16 otherwise (at least one of the first two is guaranteed)
+    const SDL_GPUTextureFormat depthFormats[] = { SDL_GPU_TEXTUREFORMAT_D32_FLOAT, SDL_GPU_TEXTUREFORMAT_D24_UNORM, SDL_GPU_TEXTUREFORMAT_D16_UNORM };
+    for (SDL_GPUTextureFormat format : depthFormats)
+    {
+        if (SDL_GPUTextureSupportsFormat(s_Data->device, format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET))
+        {
+            s_Data->depth_format = format;
+            break;
+        }
+    }
+
+    s_Data->upload_backend = mem::New<SDLUploadBackend>(mem::CATEGORY_RENDERER, s_Data->device);
+    s_Data->uploads = mem::New<UploadRing>(mem::CATEGORY_RENDERER, s_Data->upload_backend, kUploadRingSize);
+
+    // textures decode and stream in the background, material 0 shows a placeholder until its mips land
+    s_Data->textures = mem::New<TextureStreamer>(mem::CATEGORY_RENDERER, s_Data->device, s_Data->uploads, TextureStreamer::Settings());
+    for (const MaterialInfo& material : kMaterials)
+        s_Data->materials.push_back({ s_Data->textures->Load(material.texture), material.opacity });
+
+    s_Data->graph = mem::New<FrameGraph>(mem::CATEGORY_RENDERER, s_Data->device);
+    BuildFrameGraph();
+
+    // geometry comes from the baked mesh cache when one is given, otherwise the built-in quad
+    if (!LoadGeometry(mesh_cache_path))
+        return false;
+
+    // instances come from a storage buffer, frame and per-batch data from two uniform slots.
+    // Shader resource counts are reflected from the SPIR-V, the vertex input follows the
+    // geometry's layout and compact vertices get the shader that decodes them
+    s_Data->pipelines = mem::New<PipelineCache>(mem::CATEGORY_RENDERER, s_Data->device);
+    if (settings.gpu_culling)
+    {
+        s_Data->culling = mem::New<GpuCulling>(mem::CATEGORY_RENDERER, s_Data->device, s_Data->uploads);
+        if (!s_Data->culling->LoadShader(kCullShader) || !SetCullingMeshes())
+            DisableGpuCulling();
+    }
+    RequestDefaultPipeline();
+    // without its pipeline the culled objects would never be drawn, better to know now
+    if (s_Data->culling && !s_Data->pipelines->Wait(s_Data->indirect_pipeline))
+        DisableGpuCulling();
+    // nor would anything opaque pass the equal depth test without the prepass
+    if (s_Data->depth_prepass && (!s_Data->pipelines->Wait(s_Data->prepass_pipeline) ||
+                                  (s_Data->culling && !s_Data->pipelines->Wait(s_Data->indirect_prepass_pipeline))))
+        DisableDepthPrepass();
+
+    // start with the whole model in view
+    Aabb model_bounds;
+    for (const MeshDraw& draw : s_Data->draws)
+        model_bounds.Merge(draw.bounds);
+    s_Data->camera.Frame(model_bounds);
+
+    if (settings.hot_reload)
+    {
+        // stale SPIR-V is compiled right away, then every edit under res/ rebuilds what it
+        // affects and reloads at the start of a frame. The mesh cache and its source model
+        // usually live elsewhere, only their own directories are watched
+        s_Data->reload = mem::New<HotReload>(mem::CATEGORY_RENDERER, HotReload::Settings());
+        HotReload& reload = *s_Data->reload;
+        reload.Watch("res");
+        reload.AddShaderDirectory("res/shaders/code", "res/shaders/compiled");
+        for (const char* shader : { kVertexShader, kPackedVertexShader, kFragmentShader, kCullShader,
+                 kIndirectVertexShader, kPackedIndirectVertexShader, kBlendFragmentShader, kPrepassVertexShader,
+                 kPackedPrepassVertexShader, kIndirectPrepassVertexShader, kPackedIndirectPrepassVertexShader,
+                 kPrepassFragmentShader, kOverdrawFragmentShader })
+            reload.Track(shader, HotReload::KIND_SHADER);
+        for (const MaterialInfo& material : kMaterials)
+            reload.Track(material.texture, HotReload::KIND_TEXTURE);
+        if (mesh_cache_path)
+        {
+            reload.Watch(DirectoryOf(mesh_cache_path), false);
+            reload.Track(mesh_cache_path, HotReload::KIND_MESH_CACHE);
+            if (settings.mesh_source_path)
+            {
+                reload.Watch(DirectoryOf(settings.mesh_source_path), false);
+                reload.AddModel(settings.mesh_source_path, mesh_cache_path, model::ImportSettings(), s_Data->vertex_layout);
+            }
+        }
+    }
+
+    // one copy pass for all of the above
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(s_Data->device);
+    s_Data->uploads->Flush(commandBuffer);
+    s_Data->textures->RecordGpuWork(commandBuffer);
+    s_Data->uploads->EndFrame(SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer));
+
+    return true;
+}
+
+bool Renderer::LoadGeometry(const char* mesh_cache_path)
+{
+    // cache sections are copied straight from the mapping into staging memory
+    bool reload = s_Data->vertexBuffer != nullptr;
+    meshcache::MeshCache cache;
+    const void* vertex_data = vertices;
+    Uint32 vertex_data_size = sizeof(vertices);
+    const void* index_data = indices;
+    Uint32 index_data_size = sizeof(indices);
+    vtx::LayoutId layout = vtx::LAYOUT_FULL;
+    std::vector<MeshDraw> draws;
+    if (mesh_cache_path && cache.Open(mesh_cache_path) && cache.MeshCount() > 0)
+    {
+        vertex_data = cache.VertexData();
+        vertex_data_size = (Uint32)cache.VertexDataSize();
+        index_data = cache.IndexData();
+        index_data_size = (Uint32)cache.IndexDataSize();
+        layout = cache.VertexLayout();
+        for (uint32_t i = 0; i < cache.MeshCount(); i++)
+        {
+            meshcache::MeshView mesh = cache.GetMesh(i);
+            MeshDraw draw;
+            draw.vertex_offset = (Uint32)mesh.vertex_offset;
+            draw.index_offset = (Uint32)mesh.index_offset;
+            draw.lod_count = mesh.lod_count;
+            for (uint32_t l = 0; l < mesh.lod_count; l++)
+                draw.lods[l] = mesh.lods[l];
+            draw.index_size = mesh.index_size;
+            draw.bounds.min = mesh.bounds_min;
+            draw.bounds.max = mesh.bounds_max;
+            draw.quantization = mesh.quantization;
+            draws.push_back(draw);
+        }
+    }
+    else if (reload)
+    {
+        SDL_Log("Failed to reload mesh cache %s, keeping the current geometry", mesh_cache_path);
+        return false;
+    }
+    else
+    {
+        if (mesh_cache_path)
+            SDL_Log("Failed to load mesh cache %s, drawing the default quad", mesh_cache_path);
+        MeshDraw draw;
+        draw.lods[0] = { 0, SDL_arraysize(indices), 0.0f };
+        draw.index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+        draw.bounds = ComputeBounds(vertices, SDL_arraysize(vertices));
+        draws.push_back(draw);
+    }
+
+    // objects refer to meshes by index, all of them must still be there
+    for (const SceneObject& object : s_Data->objects)
+    {
+        if (object.mesh >= draws.size())
+        {
+            SDL_Log("Failed to reload mesh cache %s: it has %zu meshes, objects use mesh %u", mesh_cache_path, draws.size(), object.mesh);
+            return false;
+        }
+    }
 
     //////////// VERTEXES //////////////////////////////////////////
     // create the vertex buffer
     SDL_GPUBufferCreateInfo bufferInfo{};
-    bufferInfo.size = sizeof(vertices);
+    bufferInfo.size = vertex_data_size;
     bufferInfo.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
-    s_Data->vertexBuffer = SDL_CreateGPUBuffer(s_Data->device, &bufferInfo);
+    SDL_GPUBuffer* vertexBuffer = SDL_CreateGPUBuffer(s_Data->device, &bufferInfo);
 
     //////////// INDICES  //////////////////////////////////////////
     SDL_GPUBufferCreateInfo indicesInfo{};
-    indicesInfo.size = sizeof(indices);
+    indicesInfo.size = index_data_size;
     indicesInfo.usage = SDL_GPU_BUFFERUSAGE_INDEX;
-    s_Data->indexBuffer = SDL_CreateGPUBuffer(s_Data->device, &indicesInfo);
+    SDL_GPUBuffer* indexBuffer = SDL_CreateGPUBuffer(s_Data->device, &indicesInfo);
 
-    // create a transfer buffer to upload vertices + indices
-    SDL_GPUTransferBufferCreateInfo transferInfo{};
-    transferInfo.size = sizeof(vertices) + sizeof(indices);
-    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-    s_Data->transfer_buff = SDL_CreateGPUTransferBuffer(s_Data->device, &transferInfo);
-
-    // fill the transfer buffer: first vertices, then indices
-    uint8_t* mapped = (uint8_t*)SDL_MapGPUTransferBuffer(s_Data->device, s_Data->transfer_buff, false);
-    SDL_memcpy(mapped, vertices, sizeof(vertices));
-    SDL_memcpy(mapped + sizeof(vertices), indices, sizeof(indices));
-    SDL_UnmapGPUTransferBuffer(s_Data->device, s_Data->transfer_buff);
-    ////////////////////////////////////////////////////////////////
-
-    SDL_GPUTransferBufferCreateInfo transfer_tex{};
-    transfer_tex.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
-    transfer_tex.size = height * width * 4;
-
-    SDL_GPUTransferBuffer* textureTransferBuffer = SDL_CreateGPUTransferBuffer(s_Data->device, &transfer_tex);
-    Uint8* tex_data = (Uint8*)SDL_MapGPUTransferBuffer(s_Data->device, textureTransferBuffer, false);
-    //SDL_memcpy(tex_data, img_data->pixels, width * height * 4);
-    SDL_memcpy(tex_data, img_data, width * height * 4);
-    SDL_UnmapGPUTransferBuffer(s_Data->device, textureTransferBuffer);
-
-    // start a copy pass
-    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(s_Data->device);
-    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    //////////// POSITIONS /////////////////////////////////////////
+    // the depth prepass fetches positions alone, from a stream of just those rather than
+    // whole vertices. Same encoding and vertex numbering, so they decode identically
+    vtx::Layout vertex_layout = vtx::MakeLayout(layout, false);
+    const vtx::Element* position = vertex_layout.Find(vtx::ATTRIBUTE_POSITION);
+    Uint32 position_size = vtx::EncodingSize(position->encoding);
+    Uint32 vertex_count = vertex_data_size / vertex_layout.stride;
+    bool whole_vertices = true;
+    for (MeshDraw& draw : draws)
+    {
+        whole_vertices &= draw.vertex_offset % vertex_layout.stride == 0;
+        draw.position_offset = draw.vertex_offset / vertex_layout.stride * position_size;
+    }
+    if (s_Data->depth_prepass && !whole_vertices)
+    {
+        SDL_Log("Meshes in %s do not start on whole vertices, drawing without a depth prepass", mesh_cache_path);
+        DisableDepthPrepass();
+    }
+    SDL_GPUBuffer* positionBuffer = nullptr;
+    if (s_Data->depth_prepass)
+    {
+        SDL_GPUBufferCreateInfo positionInfo{};
+        positionInfo.size = SDL_max(vertex_count * position_size, 1u);
+        positionInfo.usage = SDL_GPU_BUFFERUSAGE_VERTEX;
+        positionBuffer = SDL_CreateGPUBuffer(s_Data->device, &positionInfo);
+    }
 
-    /// VERTEX
-    // where is the data
-    SDL_GPUTransferBufferLocation location{};
-    location.transfer_buffer = s_Data->transfer_buff;
-    location.offset = 0;
-    // where to upload the data
-    SDL_GPUBufferRegion region{};
-    region.buffer = s_Data->vertexBuffer;
-    region.size = sizeof(vertices);
-    region.offset = 0;
-    // upload the data
-    SDL_UploadToGPUBuffer(copyPass, &location, &region, false);
-    /// INDEX
-    SDL_GPUTransferBufferLocation location_indices{};
-    location_indices.transfer_buffer = s_Data->transfer_buff;
-    location_indices.offset = sizeof(vertices);
-    SDL_GPUBufferRegion region_indices{};
-    region_indices.buffer = s_Data->indexBuffer;
-    region_indices.size = sizeof(indices);
-    region_indices.offset = 0;
-    SDL_UploadToGPUBuffer(copyPass, &location_indices, &region_indices, false);
-
-    SDL_GPUTextureTransferInfo texture_transfer_info{};
-    texture_transfer_info.transfer_buffer = textureTransferBuffer;
-    texture_transfer_info.offset = 0;
-    SDL_GPUTextureRegion tex_region{};
-    tex_region.texture = s_Data->texture;
-    tex_region.w = width;
-    tex_region.h = height;
-    tex_region.d = 1;
-    SDL_UploadToGPUTexture(
-		copyPass,
-		&texture_transfer_info,
-        &tex_region,
-		false
-	);
-
-    // end the copy pass
-    SDL_EndGPUCopyPass(copyPass);
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    if (!vertexBuffer || !indexBuffer || (s_Data->depth_prepass && !positionBuffer))
+    {
+        SDL_Log("Failed to create geometry buffers: %s", SDL_GetError());
+        if (vertexBuffer)
+            SDL_ReleaseGPUBuffer(s_Data->device, vertexBuffer);
+        if (indexBuffer)
+            SDL_ReleaseGPUBuffer(s_Data->device, indexBuffer);
+        if (positionBuffer)
+            SDL_ReleaseGPUBuffer(s_Data->device, positionBuffer);
+        return false;
+    }
+    s_Data->uploads->UploadToBuffer(vertex_data, vertex_data_size, vertexBuffer);
+    s_Data->uploads->UploadToBuffer(index_data, index_data_size, indexBuffer);
+    if (positionBuffer && vertex_count > 0)
+    {
+        // gathered straight into staging memory
+        UploadRing::Allocation staging = s_Data->uploads->Allocate(vertex_count * position_size);
+        if (staging.IsValid())
+        {
+            const Uint8* source = (const Uint8*)vertex_data + position->offset;
+            for (Uint32 v = 0; v < vertex_count; v++)
+                SDL_memcpy(staging.data + v * position_size, source + (size_t)v * vertex_layout.stride, position_size);
+            s_Data->uploads->CopyToBuffer(staging, positionBuffer, 0);
+        }
+    }
+
+    // frames still in flight keep drawing from the old buffers until they complete
+    if (s_Data->vertexBuffer)
+        SDL_ReleaseGPUBuffer(s_Data->device, s_Data->vertexBuffer);
+    if (s_Data->indexBuffer)
+        SDL_ReleaseGPUBuffer(s_Data->device, s_Data->indexBuffer);
+    if (s_Data->positionBuffer)
+        SDL_ReleaseGPUBuffer(s_Data->device, s_Data->positionBuffer);
+    s_Data->vertexBuffer = vertexBuffer;
+    s_Data->indexBuffer = indexBuffer;
+    s_Data->positionBuffer = positionBuffer;
+    s_Data->draws = std::move(draws);
+    s_Data->vertex_layout = layout;
 
+    // new bounds, and the LOD chains may be different
+    if (s_Data->culling && !SetCullingMeshes())
+        DisableGpuCulling();
+    for (Uint32 i = 0; i < s_Data->objects.size(); i++)
+    {
+        SceneObject& object = s_Data->objects[i];
+        object.lod = 0;
+        s_Data->object_bounds[i] = TransformBounds(s_Data->draws[object.mesh].bounds, object.transform);
+        if (s_Data->culling)
+            s_Data->culling->SetObject(i, object.transform, s_Data->object_bounds[i]);
+    }
+    s_Data->bvh_rebuild = !s_Data->objects.empty();
     return true;
 }
 
+bool Renderer::SetCullingMeshes()
+{
+    std::vector<GpuCulling::MeshInfo> meshes;
+    meshes.reserve(s_Data->draws.size());
+    for (const MeshDraw& draw : s_Data->draws)
+    {
+        GpuCulling::MeshInfo mesh;
+        mesh.vertex_offset = draw.vertex_offset;
+        mesh.index_offset = draw.index_offset;
+        mesh.index_size = draw.index_size;
+        mesh.lod_count = draw.lod_count;
+        for (Uint32 l = 0; l < draw.lod_count; l++)
+            mesh.lods[l] = draw.lods[l];
+        mesh.quantization = draw.quantization;
+        meshes.push_back(mesh);
+    }
+    return s_Data->culling->SetMeshes(meshes, vtx::MakeLayout(s_Data->vertex_layout, false).stride);
+}
+
+void Renderer::DisableGpuCulling()
+{
+    // the BVH kept tracking every object, the CPU path takes over from the next frame
+    SDL_Log("GPU culling unavailable, culling on the CPU");
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->culling);
+    s_Data->culling = nullptr;
+}
+
+void Renderer::BuildFrameGraph()
+{
+    FrameGraph& graph = *s_Data->graph;
+    FrameGraph::TextureDesc color;
+    color.clear_color = s_Data->overdraw_view ? SDL_FColor{ 0.0f, 0.0f, 0.0f, 0.0f } : SDL_FColor{ 240/255.0f, 240/255.0f, 240/255.0f, 255/255.0f };
+    s_Data->color_resource = graph.ImportTexture("color", color);
+
+    FrameGraph::TextureDesc depth;
+    depth.format = s_Data->depth_format;
+    depth.usage = SDL_GPU_TEXTUREUSAGE_DEPTH_STENCIL_TARGET;
+    depth.clear_depth = 1.0f;
+    s_Data->depth_resource = graph.CreateTexture("depth", depth);
+
+    FrameGraph::PassDesc prepass;
+    prepass.name = "depth prepass";
+    prepass.depth = s_Data->depth_resource;
+    prepass.function = DrawDepthPrepass;
+    s_Data->prepass = graph.AddPass(prepass);
+    graph.SetPassEnabled(s_Data->prepass, s_Data->depth_prepass);
+
+    FrameGraph::PassDesc opaque;
+    opaque.name = "opaque";
+    opaque.color = { s_Data->color_resource };
+    opaque.depth = s_Data->depth_resource;
+    opaque.function = DrawOpaque;
+    graph.AddPass(opaque);
+
+    FrameGraph::PassDesc transparent = opaque;
+    transparent.name = "transparent";
+    transparent.function = DrawTransparent;
+    graph.AddPass(transparent);
+
+    s_Data->queue.SetOrder(s_Data->depth_prepass ? RenderQueue::ORDER_STATE : RenderQueue::ORDER_FRONT_TO_BACK);
+}
+
+void Renderer::DisableDepthPrepass()
+{
+    // opaque pipelines go back to testing and writing depth themselves
+    SDL_Log("Depth prepass unavailable, drawing opaque objects front to back");
+    s_Data->depth_prepass = false;
+    s_Data->graph->SetPassEnabled(s_Data->prepass, false);
+    s_Data->queue.SetOrder(RenderQueue::ORDER_FRONT_TO_BACK);
+    if (s_Data->pipelines)
+        RequestDefaultPipeline();
+}
+
+void Renderer::RequestDefaultPipeline()
+{
+    bool compact = s_Data->vertex_layout == vtx::LAYOUT_COMPACT;
+    PipelineDesc opaque;
+    opaque.vertex_shader = compact ? kPackedVertexShader : kVertexShader;
+    opaque.fragment_shader = s_Data->overdraw_view ? kOverdrawFragmentShader : kFragmentShader;
+    opaque.color_format = s_Data->color_format;
+    opaque.blend = s_Data->overdraw_view;
+    opaque.depth_format = s_Data->depth_format;
+    opaque.depth_test = true;
+    // after the prepass the depth buffer holds the nearest surface already, only it is shaded
+    opaque.depth_write = !s_Data->depth_prepass;
+    opaque.depth_compare = s_Data->depth_prepass ? SDL_GPU_COMPAREOP_EQUAL : SDL_GPU_COMPAREOP_LESS;
+    opaque.SetVertexLayout(vtx::MakeLayout(s_Data->vertex_layout, false));
+
+    // blended over the opaque surfaces in front of them, without hiding each other
+    PipelineDesc transparent = opaque;
+    transparent.fragment_shader = s_Data->overdraw_view ? kOverdrawFragmentShader : kBlendFragmentShader;
+    transparent.blend = true;
+    transparent.depth_write = false;
+    transparent.depth_compare = SDL_GPU_COMPAREOP_LESS;
+
+    // depth only, the position attribute alone from the position stream
+    const vtx::Element* position = vtx::MakeLayout(s_Data->vertex_layout, false).Find(vtx::ATTRIBUTE_POSITION);
+    PipelineDesc prepass;
+    prepass.vertex_shader = compact ? kPackedPrepassVertexShader : kPrepassVertexShader;
+    prepass.fragment_shader = kPrepassFragmentShader;
+    prepass.depth_format = s_Data->depth_format;
+    prepass.depth_test = true;
+    prepass.depth_write = true;
+    prepass.vertex_pitch = vtx::EncodingSize(position->encoding);
+    prepass.attribute_formats[vtx::ATTRIBUTE_POSITION] = vtx::ElementFormat(position->encoding);
+
+    s_Data->default_pipeline = s_Data->pipelines->Request(opaque);
+    s_Data->transparent_pipeline = s_Data->pipelines->Request(transparent);
+    if (s_Data->depth_prepass)
+        s_Data->prepass_pipeline = s_Data->pipelines->Request(prepass);
+
+    if (s_Data->culling)
+    {
+        opaque.vertex_shader = compact ? kPackedIndirectVertexShader : kIndirectVertexShader;
+        transparent.vertex_shader = opaque.vertex_shader;
+        prepass.vertex_shader = compact ? kPackedIndirectPrepassVertexShader : kIndirectPrepassVertexShader;
+        s_Data->indirect_pipeline = s_Data->pipelines->Request(opaque);
+        s_Data->indirect_transparent_pipeline = s_Data->pipelines->Request(transparent);
+        if (s_Data->depth_prepass)
+            s_Data->indirect_prepass_pipeline = s_Data->pipelines->Request(prepass);
+    }
+}
+
+void Renderer::ApplyReloads()
+{
+    s_Data->reload_changes.clear();
+    s_Data->reload->Poll(s_Data->reload_changes);
+    for (const HotReload::Change& change : s_Data->reload_changes)
+    {
+        switch (change.kind)
+        {
+        case HotReload::KIND_SHADER:
+        {
+            if (s_Data->culling && change.path == kCullShader)
+            {
+                // compute pipelines are not cached, the old one stays if this fails
+                if (s_Data->culling->LoadShader(kCullShader))
+                    SDL_Log("Reloaded %s", change.path.c_str());
+                break;
+            }
+            // the old pipelines keep drawing until their rebuilds are ready
+            uint32_t rebuilt = s_Data->pipelines->ReloadShader(change.path);
+            SDL_Log("Reloaded %s, rebuilding %u pipelines", change.path.c_str(), rebuilt);
+            break;
+        }
+        case HotReload::KIND_TEXTURE:
+            if (s_Data->textures->Reload(change.path.c_str()))
+                SDL_Log("Reloading %s", change.path.c_str());
+            break;
+        case HotReload::KIND_MESH_CACHE:
+        {
+            // a cache baked with the other vertex layout needs the other pipeline
+            vtx::LayoutId layout = s_Data->vertex_layout;
+            if (LoadGeometry(change.path.c_str()))
+            {
+                SDL_Log("Reloaded %s: %zu meshes", change.path.c_str(), s_Data->draws.size());
+                if (s_Data->vertex_layout != layout)
+                    RequestDefaultPipeline();
+            }
+            break;
+        }
+        }
+    }
+}
+
 void Renderer::PreRender()
 {
+    PROFILE_ZONE("PreRender");
+    // this frame reuses the slot of the frame frames_in_flight back, wait until the GPU is
+    // done with that one. Staging memory of every finished frame is reclaimed on the way
+    Uint64 wait_start = SDL_GetTicksNS();
+    {
+        PROFILE_ZONE("wait frame slot");
+        s_Data->uploads->WaitFrames(s_Data->frames_in_flight - 1);
+    }
+    Uint64 now = SDL_GetTicksNS();
+    s_Data->frame_wait_ns = now - wait_start;
+    s_Data->frame_start_ns = now;
+    // what is still queued now runs on the GPU while the CPU works on this frame
+    s_Data->frames_busy = (Uint32)s_Data->uploads->FramesInFlight();
+
+    // edited assets swap in here, between frames, their uploads go out with this frame's
+    if (s_Data->reload)
+        ApplyReloads();
+
+    // finished decodes become textures and queue their next mip levels
+    s_Data->textures->Update();
 
+    // Culling and the aspect ratio go by the last frame's size, a resize shows up one frame late
+    Uint32 width = s_Data->target_width, height = s_Data->target_height;
+    if (height > 0)
+        s_Data->camera.aspect = (float)width / (float)height;
+    s_Data->view_projection = s_Data->camera.ViewProjection();
+    CullObjects((float)height);
+}
+
+void Renderer::CullObjects(float height)
+{
+    s_Data->visible.clear();
+    s_Data->frame_segments = 0;
+    // culled on the GPU after the copy pass
+    if (s_Data->culling)
+        return;
+
+    PROFILE_ZONE("cull");
+    if (s_Data->bvh_rebuild)
+        s_Data->bvh.Build(s_Data->object_bounds.data(), (Uint32)s_Data->object_bounds.size());
+    else if (s_Data->bvh_refit)
+        s_Data->bvh.Refit();
+    s_Data->bvh_rebuild = false;
+    s_Data->bvh_refit = false;
+    s_Data->bvh.Cull(Frustum::FromMatrix(s_Data->view_projection), s_Data->visible);
+
+    // LODs and draws of the visible objects. Split over the workers when there are enough,
+    // those run while the caller finishes the frame and Render records, until it needs them
+    Uint32 visible = (Uint32)s_Data->visible.size();
+    Uint32 segments = SDL_clamp(visible / kMinSegmentDraws, 1u, s_Data->jobs->ThreadCount());
+    s_Data->frame_segments = segments;
+    s_Data->frame_height = height;
+    if (segments == 1)
+    {
+        QueueVisible(s_Data->queue, s_Data->transparent_queue, 0, visible, height);
+        return;
+    }
+
+    SDL_assert(s_Data->segments.empty());
+    // Every visible object queues one draw, opaque or transparent, so reserving its range in
+    // both queues means the jobs never touch the arena, which is not thread safe
+    for (Uint32 i = 0; i < segments; i++)
+    {
+        DrawSegment& segment = s_Data->segments.emplace_back(s_Data->queue.GetOrder(), &s_Data->frame_arena);
+        Uint32 count = (Uint32)((Uint64)visible * (i + 1) / segments - (Uint64)visible * i / segments);
+        segment.queue.Reserve(count);
+        segment.transparent_queue.Reserve(count);
+    }
+    s_Data->jobs->ParallelFor(segments, 1, QueueSegments, nullptr, &s_Data->frame_jobs);
 }
 
 void Renderer::Render()
 {
-    // acquire the command buffer
+    PROFILE_ZONE("Render");
+
+    // The CPU side of the frame comes first and the swapchain image last, acquiring it can
+    // block until an earlier frame is presented
+    Uint32 width = s_Data->target_width, height = s_Data->target_height;
+    Frustum frustum = Frustum::FromMatrix(s_Data->view_projection);
+    RenderQueue& queue = s_Data->queue;
+    RenderQueue& transparent_queue = s_Data->transparent_queue;
     SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(s_Data->device);
+    // only objects that changed go up
+    if (s_Data->culling)
+        s_Data->culling->Upload();
+
+    // the draw segments PreRender started, appended in order they are the serial pass's queues
+    {
+        PROFILE_ZONE("wait frame jobs");
+        s_Data->jobs->Wait(&s_Data->frame_jobs);
+    }
+    Uint32 segments = s_Data->frame_segments;
+    for (Uint32 i = 0; segments > 1 && i < segments; i++)
+    {
+        DrawSegment& segment = s_Data->segments[i];
+        queue.Append(segment.queue);
+        transparent_queue.Append(segment.transparent_queue);
+    }
+
+    // sort and batch the frame's draws, their instance data goes out with the other uploads
+    {
+        PROFILE_ZONE("build queue");
+        queue.Build();
+        transparent_queue.Build();
+    }
+    FrameStats& stats = s_Data->stats;
+    stats = FrameStats();
+    stats.objects = (Uint32)s_Data->objects.size();
+    stats.visible = (Uint32)s_Data->visible.size();
+    stats.batches = (Uint32)(queue.Batches().size() + transparent_queue.Batches().size());
+    stats.draw_segments = segments;
+
+    // the slot is free since PreRender, so the buffer is written in place, no cycling
+    FrameResources& frame = CurrentFrame();
+    Uint32 opaque_bytes = (Uint32)(queue.Instances().size() * sizeof(InstanceData));
+    Uint32 instance_bytes = opaque_bytes + (Uint32)(transparent_queue.Instances().size() * sizeof(InstanceData));
+    if (instance_bytes > frame.instance_capacity)
+    {
+        if (frame.instanceBuffer)
+            SDL_ReleaseGPUBuffer(s_Data->device, frame.instanceBuffer);
+        frame.instance_capacity = SDL_max(instance_bytes, frame.instance_capacity * 2);
+
+        SDL_GPUBufferCreateInfo instanceInfo{};
+        instanceInfo.size = frame.instance_capacity;
+        instanceInfo.usage = SDL_GPU_BUFFERUSAGE_GRAPHICS_STORAGE_READ;
+        frame.instanceBuffer = SDL_CreateGPUBuffer(s_Data->device, &instanceInfo);
+        if (!frame.instanceBuffer)
+            frame.instance_capacity = 0;
+    }
+    UploadRing::Allocation staging;
+    if (instance_bytes && frame.instanceBuffer)
+        staging = s_Data->uploads->Allocate(instance_bytes);
+    if (staging.IsValid())
+    {
+        SDL_memcpy(staging.data, queue.Instances().data(), opaque_bytes);
+        SDL_memcpy(staging.data + opaque_bytes, transparent_queue.Instances().data(), instance_bytes - opaque_bytes);
+        s_Data->uploads->CopyToBuffer(staging, frame.instanceBuffer, 0);
+    }
+    else if (instance_bytes)
+    {
+        // the buffer still holds an older frame's instances, drawing the batches would put
+        // them in the wrong places. The frame goes without the queued draws instead
+        SDL_Log("Failed to upload %u bytes of instance data, skipping the frame's draws", instance_bytes);
+        queue.Clear();
+        transparent_queue.Clear();
+        queue.Build();
+        transparent_queue.Build();
+        stats.batches = 0;
+    }
 
-    // get the swapchain texture
-    SDL_GPUTexture* swapchainTexture;
-    Uint32 width, height;
-    SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, s_Data->window, &swapchainTexture, &width, &height);
+    // all uploads queued this frame go into one copy pass ahead of the draws
+    {
+        PROFILE_ZONE("copy pass");
+        s_Data->uploads->Flush(commandBuffer);
+        s_Data->textures->RecordGpuWork(commandBuffer);
+    }
+    PROFILE_COUNTER("bytes uploaded", s_Data->uploads->GetStats().bytes - s_Data->counted_upload_bytes);
+    s_Data->counted_upload_bytes = s_Data->uploads->GetStats().bytes;
+
+    // get the swapchain texture, headless frames always have their target
+    SDL_GPUTexture* swapchainTexture = s_Data->colorTarget;
+    if (!s_Data->headless)
+    {
+        PROFILE_ZONE("acquire swapchain");
+        Uint64 wait_start = SDL_GetTicksNS();
+        SDL_WaitAndAcquireGPUSwapchainTexture(commandBuffer, s_Data->window, &swapchainTexture, &width, &height);
+        stats.wait_ns = SDL_GetTicksNS() - wait_start;
+        if (swapchainTexture)
+        {
+            s_Data->target_width = width;
+            s_Data->target_height = height;
+        }
+    }
 
     // end the frame early if a swapchain texture is not available
     if (swapchainTexture == NULL)
     {
         // you must always submit the command buffer
-        SDL_SubmitGPUCommandBuffer(commandBuffer);
+        SubmitFrame(commandBuffer);
         return;
     }
 
-    // create the color target
-    SDL_GPUColorTargetInfo colorTargetInfo{};
-    colorTargetInfo.clear_color = {240/255.0f, 240/255.0f, 240/255.0f, 255/255.0f};
-    colorTargetInfo.load_op = SDL_GPU_LOADOP_CLEAR;
-    colorTargetInfo.store_op = SDL_GPU_STOREOP_STORE;
-    colorTargetInfo.texture = swapchainTexture;
-
-    // begin a render pass
-    SDL_GPURenderPass* renderPass = SDL_BeginGPURenderPass(commandBuffer, &colorTargetInfo, 1, NULL);
-
-    // bind the pipeline
-    SDL_BindGPUGraphicsPipeline(renderPass, s_Data->graphicsPipeline);
-
-    SDL_GPUTextureSamplerBinding binding{};
-    binding.texture = s_Data->texture;
-    binding.sampler = s_Data->sampler;
-    
-    SDL_BindGPUFragmentSamplers(renderPass, 0, &binding, 1);
-    // bind the buffers
-    SDL_GPUBufferBinding vertex_bindings[1];
-    vertex_bindings[0].buffer = s_Data->vertexBuffer; // index 0 is slot 0 in this example
-    vertex_bindings[0].offset = 0; // start from the first byte
-    SDL_GPUBufferBinding index_bindings[1];
-    index_bindings[0].buffer = s_Data->indexBuffer;
-    index_bindings[0].offset = 0;
-    
-    SDL_BindGPUVertexBuffers(renderPass, 0, vertex_bindings, 1); // bind one buffer starting from slot 0
-    SDL_BindGPUIndexBuffer(renderPass, index_bindings, SDL_GPU_INDEXELEMENTSIZE_16BIT);
-    SDL_DrawGPUIndexedPrimitives(renderPass, 6, 1, 0, 0, 0);
-
-    SDL_EndGPURenderPass(renderPass);
-    SDL_SubmitGPUCommandBuffer(commandBuffer);
+    if (s_Data->culling)
+    {
+        const Camera& camera = s_Data->camera;
+        GpuCulling::View view;
+        view.frustum = frustum;
+        view.camera_position = camera.position;
+        view.pixels_per_unit = lod::ProjectedSize(1.0f, 1.0f, camera.fov_y, (float)height);
+        view.max_pixel_error = s_Data->lod_pixel_error;
+        view.hysteresis = s_Data->lod_hysteresis;
+        s_Data->culling->Dispatch(commandBuffer, view);
+    }
+
+    // depth prepass, opaque and transparent passes, their targets as the graph laid them out
+    s_Data->graph->SetTexture(s_Data->color_resource, swapchainTexture);
+    {
+        PROFILE_ZONE("draw");
+        s_Data->graph->Execute(commandBuffer, width, height);
+    }
+    if (s_Data->culling)
+        stats.batches += (Uint32)s_Data->culling->Buckets().size();
+
+    PROFILE_COUNTER("draws", stats.draws);
+    PROFILE_COUNTER("prepass draws", stats.prepass_draws);
+    PROFILE_COUNTER("instances", stats.instances);
+    PROFILE_COUNTER("triangles", stats.triangles);
+    PROFILE_COUNTER("visible objects", stats.visible);
+    PROFILE_COUNTER("pipeline binds", queue.GetStats().pipeline_binds + transparent_queue.GetStats().pipeline_binds);
+    PROFILE_COUNTER("material binds", queue.GetStats().material_binds + transparent_queue.GetStats().material_binds);
+    PROFILE_COUNTER("mesh binds", queue.GetStats().mesh_binds + transparent_queue.GetStats().mesh_binds);
+    PROFILE_COUNTER("pipelines created", s_Data->pipelines->GetStats().created.load());
+
+    SubmitFrame(commandBuffer);
+}
+
+void Renderer::SubmitFrame(SDL_GPUCommandBuffer* commands)
+{
+    PROFILE_ZONE("submit");
+    s_Data->uploads->EndFrame(SDL_SubmitGPUCommandBufferAndAcquireFence(commands));
+    s_Data->frame_index++;
+
+    // wait_ns holds the swapchain wait so far, which falls inside the frame. The slot wait came before it
+    FrameStats& stats = s_Data->stats;
+    Uint64 elapsed = SDL_GetTicksNS() - s_Data->frame_start_ns;
+    stats.cpu_ns = elapsed - SDL_min(elapsed, stats.wait_ns);
+    stats.wait_ns += s_Data->frame_wait_ns;
+    stats.frames_busy = s_Data->frames_busy;
+    PROFILE_COUNTER("frames busy", stats.frames_busy);
+}
+
+Renderer::FrameResources& Renderer::CurrentFrame()
+{
+    return s_Data->frames[s_Data->frame_index % s_Data->frames_in_flight];
+}
+
+void Renderer::DrawDepthPrepass(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void*)
+{
+    PROFILE_ZONE("depth prepass");
+    SDL_PushGPUVertexUniformData(commands, 0, &s_Data->view_projection, sizeof(glm::mat4));
+    DrawQueue(pass, commands, s_Data->queue, 0, true);
+    if (s_Data->culling)
+        DrawCulled(pass, commands, false, true);
+}
+
+void Renderer::DrawOpaque(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void*)
+{
+    PROFILE_ZONE("opaque");
+    SDL_PushGPUVertexUniformData(commands, 0, &s_Data->view_projection, sizeof(glm::mat4));
+    DrawQueue(pass, commands, s_Data->queue, 0, false);
+    if (s_Data->culling)
+        DrawCulled(pass, commands, false, false);
+}
+
+void Renderer::DrawTransparent(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void*)
+{
+    PROFILE_ZONE("transparent");
+    SDL_PushGPUVertexUniformData(commands, 0, &s_Data->view_projection, sizeof(glm::mat4));
+    // their instances follow the opaque ones in the instance buffer
+    DrawQueue(pass, commands, s_Data->transparent_queue, (Uint32)s_Data->queue.Instances().size(), false);
+    if (s_Data->culling)
+        DrawCulled(pass, commands, true, false);
+}
+
+void Renderer::DrawQueue(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, const RenderQueue& queue,
+    Uint32 first_instance, bool depth_only)
+{
+    FrameStats& stats = s_Data->stats;
+    // batches come sorted by pipeline, material and mesh, only rebind what changed.
+    // Pipelines still being created in the background skip their draws this frame
+    bool pipeline_ready = false;
+    for (const DrawBatch& batch : queue.Batches())
+    {
+        const MeshDraw& draw = s_Data->draws[batch.mesh];
+        if (batch.bind_pipeline)
+        {
+            SDL_GPUGraphicsPipeline* pipeline = s_Data->pipelines->Get(batch.pipeline);
+            // the prepass covers exactly what gets shaded, nothing the shading pass skips
+            if (depth_only && pipeline)
+                pipeline = s_Data->pipelines->Get(s_Data->prepass_pipeline);
+            pipeline_ready = pipeline != nullptr;
+            if (pipeline_ready)
+            {
+                SDL_BindGPUGraphicsPipeline(pass, pipeline);
+                SDL_BindGPUVertexStorageBuffers(pass, 0, &CurrentFrame().instanceBuffer, 1);
+            }
+        }
+        if (!pipeline_ready)
+            continue;
+        const Material& material = s_Data->materials[batch.material];
+        if (batch.bind_material && !depth_only)
+        {
+            SDL_GPUTextureSamplerBinding binding = s_Data->textures->Binding(material.texture);
+            SDL_BindGPUFragmentSamplers(pass, 0, &binding, 1);
+            if (material.opacity < 1.0f)
+            {
+                MaterialUniforms uniforms{ material.opacity, {} };
+                SDL_PushGPUFragmentUniformData(commands, 0, &uniforms, sizeof(uniforms));
+            }
+        }
+        if (batch.bind_mesh)
+        {
+            SDL_GPUBufferBinding vertex_bindings[1];
+            vertex_bindings[0].buffer = depth_only ? s_Data->positionBuffer : s_Data->vertexBuffer;
+            vertex_bindings[0].offset = depth_only ? draw.position_offset : draw.vertex_offset;
+            SDL_GPUBufferBinding index_bindings[1];
+            index_bindings[0].buffer = s_Data->indexBuffer;
+            index_bindings[0].offset = draw.index_offset;
+
+            SDL_BindGPUVertexBuffers(pass, 0, vertex_bindings, 1);
+            SDL_BindGPUIndexBuffer(pass, index_bindings, draw.index_size);
+        }
+
+        // std140: base_instance, then the position decode as two vec4s
+        DrawUniforms uniforms{};
+        uniforms.base_instance = first_instance + batch.first_instance;
+        uniforms.position_offset = glm::vec4(draw.quantization.offset, 0.0f);
+        uniforms.position_scale = glm::vec4(draw.quantization.scale, 0.0f);
+        SDL_PushGPUVertexUniformData(commands, 1, &uniforms, sizeof(uniforms));
+        const Mesh::MeshLod& lod = draw.lods[batch.lod];
+        SDL_DrawGPUIndexedPrimitives(pass, lod.index_count, batch.instance_count, lod.first_index, 0, 0);
+        if (depth_only)
+        {
+            stats.prepass_draws++;
+            continue;
+        }
+        stats.draws++;
+        stats.instances += batch.instance_count;
+        stats.triangles += (Uint64)lod.index_count / 3 * batch.instance_count;
+    }
+}
+
+void Renderer::DrawCulled(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, bool transparent, bool depth_only)
+{
+    // GPU culled objects: every mesh sits in the bound buffers at the offsets its commands
+    // carry, so one indirect draw covers a whole material. The prepass again only covers
+    // what the opaque pass will shade
+    const GpuCulling& culling = *s_Data->culling;
+    SDL_GPUGraphicsPipeline* pipeline = s_Data->pipelines->Get(transparent ? s_Data->indirect_transparent_pipeline : s_Data->indirect_pipeline);
+    if (depth_only && pipeline)
+        pipeline = s_Data->pipelines->Get(s_Data->indirect_prepass_pipeline);
+    if (!pipeline || culling.Buckets().empty())
+        return;
+
+    SDL_BindGPUGraphicsPipeline(pass, pipeline);
+    // the packed shaders also decode positions with the mesh table
+    SDL_GPUBuffer* storage[3] = { culling.ObjectBuffer(), culling.VisibleBuffer(), culling.MeshBuffer() };
+    SDL_BindGPUVertexStorageBuffers(pass, 0, storage, s_Data->vertex_layout == vtx::LAYOUT_COMPACT ? 3 : 2);
+    SDL_GPUBufferBinding vertex_binding{ depth_only ? s_Data->positionBuffer : s_Data->vertexBuffer, 0 };
+    SDL_BindGPUVertexBuffers(pass, 0, &vertex_binding, 1);
+
+    // blended buckets are drawn in the order the culling pass filled them, not sorted by depth
+    const GpuCulling::Bucket* previous = nullptr;
+    for (const GpuCulling::Bucket& bucket : culling.Buckets())
+    {
+        const Material& material = s_Data->materials[bucket.material];
+        if ((material.opacity < 1.0f) != transparent)
+            continue;
+        if (!depth_only && (!previous || previous->material != bucket.material))
+        {
+            SDL_GPUTextureSamplerBinding binding = s_Data->textures->Binding(material.texture);
+            SDL_BindGPUFragmentSamplers(pass, 0, &binding, 1);
+            if (transparent)
+            {
+                MaterialUniforms uniforms{ material.opacity, {} };
+                SDL_PushGPUFragmentUniformData(commands, 0, &uniforms, sizeof(uniforms));
+            }
+        }
+        if (!previous || previous->index_size != bucket.index_size)
+        {
+            SDL_GPUBufferBinding index_binding{ s_Data->indexBuffer, 0 };
+            SDL_BindGPUIndexBuffer(pass, &index_binding, bucket.index_size);
+        }
+        SDL_DrawGPUIndexedPrimitivesIndirect(pass, culling.CommandBuffer(),
+            bucket.first_command * (Uint32)sizeof(SDL_GPUIndexedIndirectDrawCommand), bucket.command_count);
+        previous = &bucket;
+        if (depth_only)
+            s_Data->stats.prepass_draws++;
+        else
+            s_Data->stats.draws++;
+    }
 }
 
 void Renderer::PostRender()
 {
+    // Render can be skipped, never let a frame's jobs run into the next one
+    s_Data->jobs->Wait(&s_Data->frame_jobs);
+    s_Data->queue.Clear();
+    s_Data->transparent_queue.Clear();
+
+    // the draw segments are the arena's, they go before it is reset
+    s_Data->segments.clear();
+    PROFILE_COUNTER("frame arena bytes", s_Data->frame_arena.BytesUsed());
+    s_Data->frame_arena.Reset();
+
+    // drains every thread's profiler ring into the capture, if one runs
+    PROFILE_FRAME();
+}
+
+void Renderer::Submit(Uint32 mesh, Uint32 material, const glm::mat4& transform)
+{
+    SDL_assert(mesh < s_Data->draws.size() && material < s_Data->materials.size());
+    glm::vec3 position = glm::vec3(transform[3]);
+    float depth = glm::dot(s_Data->camera.Forward(), position - s_Data->camera.position);
+    QueueDraw(s_Data->queue, s_Data->transparent_queue, mesh, material, transform, depth, 0);
+}
+
+void Renderer::QueueDraw(RenderQueue& queue, RenderQueue& transparent_queue, Uint32 mesh, Uint32 material,
+    const glm::mat4& transform, float depth, Uint32 lod)
+{
+    if (IsTransparent(material))
+        transparent_queue.Submit(s_Data->transparent_pipeline, material, mesh, transform, depth, lod);
+    else
+        queue.Submit(s_Data->default_pipeline, material, mesh, transform, depth, lod);
+}
+
+void Renderer::QueueVisible(RenderQueue& queue, RenderQueue& transparent_queue, Uint32 begin, Uint32 end, float height)
+{
+    // LODs by the screen height of each object's world bounds at its distance
+    const Camera& camera = s_Data->camera;
+    for (Uint32 i = begin; i < end; i++)
+    {
+        Uint32 index = s_Data->visible[i];
+        SceneObject& object = s_Data->objects[index];
+        const Aabb& bounds = s_Data->object_bounds[index];
+        glm::vec3 center = bounds.Center();
+        float depth = glm::dot(camera.Forward(), center - camera.position);
+
+        const MeshDraw& draw = s_Data->draws[object.mesh];
+        if (draw.lod_count > 1)
+        {
+            glm::vec3 size = bounds.max - bounds.min;
+            float extent = SDL_max(SDL_max(size.x, size.y), size.z);
+            float projected = lod::ProjectedSize(extent, glm::length(center - camera.position), camera.fov_y, height);
+            object.lod = lod::SelectLod(draw.lods, draw.lod_count, projected, s_Data->lod_pixel_error, object.lod,
+                s_Data->lod_hysteresis);
+        }
+        QueueDraw(queue, transparent_queue, object.mesh, object.material, object.transform, depth, object.lod);
+    }
+}
+
+void Renderer::QueueSegments(void*, Uint32 begin, Uint32 end)
+{
+    PROFILE_ZONE("queue draws");
+    Uint32 visible = (Uint32)s_Data->visible.size();
+    Uint32 segments = s_Data->frame_segments;
+    for (Uint32 i = begin; i < end; i++)
+    {
+        DrawSegment& segment = s_Data->segments[i];
+        QueueVisible(segment.queue, segment.transparent_queue, (Uint32)((Uint64)visible * i / segments),
+            (Uint32)((Uint64)visible * (i + 1) / segments), s_Data->frame_height);
+    }
+}
+
+Uint32 Renderer::MeshCount()
+{
+    return (Uint32)s_Data->draws.size();
+}
+
+Uint32 Renderer::MaterialCount()
+{
+    return (Uint32)s_Data->materials.size();
+}
+
+bool Renderer::IsTransparent(Uint32 material)
+{
+    return s_Data->materials[material].opacity < 1.0f;
+}
+
+Uint32 Renderer::AddObject(Uint32 mesh, Uint32 material, const glm::mat4& transform)
+{
+    SDL_assert(mesh < s_Data->draws.size() && material < s_Data->materials.size());
+    s_Data->objects.push_back({ mesh, material, transform });
+    s_Data->object_bounds.push_back(TransformBounds(s_Data->draws[mesh].bounds, transform));
+    s_Data->bvh_rebuild = true;
+    if (s_Data->culling)
+        s_Data->culling->AddObject(mesh, material, transform, s_Data->object_bounds.back());
+    return (Uint32)s_Data->objects.size() - 1;
+}
+
+void Renderer::SetObjectTransform(Uint32 object, const glm::mat4& transform)
+{
+    SceneObject& scene_object = s_Data->objects[object];
+    scene_object.transform = transform;
+    Aabb bounds = TransformBounds(s_Data->draws[scene_object.mesh].bounds, transform);
+    s_Data->object_bounds[object] = bounds;
+    if (s_Data->culling)
+        s_Data->culling->SetObject(object, transform, bounds);
+
+    // a pending rebuild picks the new bounds up anyway
+    if (!s_Data->bvh_rebuild)
+    {
+        s_Data->bvh.Update(object, bounds);
+        s_Data->bvh_refit = true;
+    }
+}
+
+Camera& Renderer::GetCamera()
+{
+    return s_Data->camera;
+}
 
+mem::Arena& Renderer::FrameArena()
+{
+    return s_Data->frame_arena;
+}
+
+const Renderer::FrameStats& Renderer::GetFrameStats()
+{
+    return s_Data->stats;
+}
+
+bool Renderer::IsLoading()
+{
+    for (const Material& material : s_Data->materials)
+    {
+        if (!s_Data->textures->IsResident(material.texture) && !s_Data->textures->IsFailed(material.texture))
+            return true;
+    }
+    for (PipelineHandle pipeline = 0; pipeline < s_Data->pipelines->PipelineCount(); pipeline++)
+    {
+        if (!s_Data->pipelines->IsDone(pipeline))
+            return true;
+    }
+    return false;
+}
+
+void Renderer::WaitIdle()
+{
+    SDL_WaitForGPUIdle(s_Data->device);
+}
+
+bool Renderer::ReadbackFrame(std::vector<Uint8>& rgba, Uint32& width, Uint32& height)
+{
+    // a swapchain image is gone once presented, only the offscreen target can be read back
+    if (!s_Data->headless)
+    {
+        SDL_Log("ReadbackFrame needs a headless renderer");
+        return false;
+    }
+
+    width = s_Data->target_width;
+    height = s_Data->target_height;
+    Uint32 size = width * height * 4;
+    SDL_GPUTransferBufferCreateInfo transferInfo{};
+    transferInfo.usage = SDL_GPU_TRANSFERBUFFERUSAGE_DOWNLOAD;
+    transferInfo.size = size;
+    SDL_GPUTransferBuffer* transfer = SDL_CreateGPUTransferBuffer(s_Data->device, &transferInfo);
+    if (!transfer)
+    {
+        SDL_Log("Failed to create the readback buffer: %s", SDL_GetError());
+        return false;
+    }
+
+    // submitted after the frame, so the copy sees everything it rendered
+    SDL_GPUCommandBuffer* commandBuffer = SDL_AcquireGPUCommandBuffer(s_Data->device);
+    SDL_GPUCopyPass* copyPass = SDL_BeginGPUCopyPass(commandBuffer);
+    SDL_GPUTextureRegion region{};
+    region.texture = s_Data->colorTarget;
+    region.w = width;
+    region.h = height;
+    region.d = 1;
+    SDL_GPUTextureTransferInfo destination{};
+    destination.transfer_buffer = transfer;
+    SDL_DownloadFromGPUTexture(copyPass, &region, &destination);
+    SDL_EndGPUCopyPass(copyPass);
+
+    SDL_GPUFence* fence = SDL_SubmitGPUCommandBufferAndAcquireFence(commandBuffer);
+    SDL_WaitForGPUFences(s_Data->device, true, &fence, 1);
+    SDL_ReleaseGPUFence(s_Data->device, fence);
+
+    rgba.resize(size);
+    void* mapped = SDL_MapGPUTransferBuffer(s_Data->device, transfer, false);
+    SDL_memcpy(rgba.data(), mapped, size);
+    SDL_UnmapGPUTransferBuffer(s_Data->device, transfer);
+    SDL_ReleaseGPUTransferBuffer(s_Data->device, transfer);
+    return true;
+}
+
+bool Renderer::ReadbackCulling(std::vector<Uint32>& visible, std::vector<Uint32>& lods)
+{
+    if (s_Data->culling)
+        return s_Data->culling->Readback(visible, lods);
+
+    visible = s_Data->visible;
+    std::sort(visible.begin(), visible.end());
+    lods.clear();
+    for (Uint32 index : visible)
+        lods.push_back(s_Data->objects[index].lod);
+    return true;
+}
+
+bool Renderer::IsGpuCulling()
+{
+    return s_Data->culling != nullptr;
+}
+
+bool Renderer::IsDepthPrepass()
+{
+    return s_Data->depth_prepass;
+}
+
+const FrameGraph& Renderer::GetFrameGraph()
+{
+    return *s_Data->graph;
 }
 
 void Renderer::Shutdown()
 {
-    // release the pipeline
-    SDL_ReleaseGPUGraphicsPipeline(s_Data->device, s_Data->graphicsPipeline);
+    s_Data->jobs->Wait(&s_Data->frame_jobs);
+    s_Data->segments.clear();
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->jobs);
+    // lets running builds finish, their results are dropped
+    if (s_Data->reload)
+        mem::Delete(mem::CATEGORY_RENDERER, s_Data->reload);
+
+    // releases the staging memory once the GPU is done with it
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->textures);
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->uploads);
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->upload_backend);
+
+    // release the pipelines and their shaders
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->pipelines);
+    if (s_Data->culling)
+        mem::Delete(mem::CATEGORY_RENDERER, s_Data->culling);
 
-    SDL_ReleaseGPUTransferBuffer(s_Data->device, s_Data->transfer_buff);
     SDL_ReleaseGPUBuffer(s_Data->device, s_Data->vertexBuffer);
-    
+    SDL_ReleaseGPUBuffer(s_Data->device, s_Data->indexBuffer);
+    if (s_Data->positionBuffer)
+        SDL_ReleaseGPUBuffer(s_Data->device, s_Data->positionBuffer);
+    // the transient targets
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data->graph);
+    if (s_Data->colorTarget)
+        SDL_ReleaseGPUTexture(s_Data->device, s_Data->colorTarget);
+    for (FrameResources& frame : s_Data->frames)
+    {
+        if (frame.instanceBuffer)
+            SDL_ReleaseGPUBuffer(s_Data->device, frame.instanceBuffer);
+    }
+
     // destroy the GPU device
     SDL_DestroyGPUDevice(s_Data->device);
 
     // destroy the window
-    SDL_DestroyWindow(s_Data->window);
+    if (s_Data->window)
+        SDL_DestroyWindow(s_Data->window);
 
-    delete s_Data;
+    mem::Delete(mem::CATEGORY_RENDERER, s_Data);
 }
 
 
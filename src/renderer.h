@@ -1,6 +1,20 @@
 #pragma once
 
 #include <SDL3/SDL_gpu.h>
+#include <vector>
+#include "bvh.h"
+#include "camera.h"
+#include "frame_graph.h"
+#include "gpu_culling.h"
+#include "hot_reload.h"
+#include "job_system.h"
+#include "memory.h"
+#include "mesh.h"
+#include "pipeline_cache.h"
+#include "render_queue.h"
+#include "texture_streamer.h"
+#include "upload_ring.h"
+#include "vertex_format.h"
 
 class SDL_Window;
 class SDL_GPUDevice;
@@ -14,23 +28,266 @@ class SDL_GPUShader;
 class Renderer
 {
 public:
-    static bool Init();
+    static const Uint32 kMaxFramesInFlight = 3;
+
+    struct Settings
+    {
+        // optional baked mesh (.skmesh) to draw instead of the built-in quad
+        const char* mesh_cache_path = nullptr;
+        // no window: render into an offscreen color/depth target of this size, for CI and benchmarks
+        bool headless = false;
+        Uint32 width = 1280;
+        Uint32 height = 720;
+        // culled objects draw the coarsest LOD whose error stays under this many pixels,
+        // coarser LODs are only taken once the error is a hysteresis fraction below it
+        float lod_pixel_error = 1.0f;
+        float lod_hysteresis = 0.25f;
+        // watch res/ and the mesh cache: edited GLSL is recompiled (glslc) and reloaded, as are
+        // textures and the cache. With mesh_source_path, edits to that model rebake the cache
+        bool hot_reload = false;
+        const char* mesh_source_path = nullptr;
+        // cull objects and pick their LODs in a compute pass and draw them with one indirect
+        // call per material. Falls back to CPU culling when the shaders or geometry don't allow it
+        bool gpu_culling = false;
+        // shade every pixel of opaque geometry once: a depth-only pass over the opaque draws from
+        // a position-only vertex stream, then the shading pass tests for equal depth. Without it
+        // opaque draws go front to back and early depth testing rejects what it can
+        bool depth_prepass = true;
+        // the color passes add 1/255 to red for every fragment they shade instead of drawing
+        // materials, so the frame's red channel counts overdraw (up to 255). For benchmarks
+        bool overdraw_view = false;
+        // frames the CPU may run ahead of the GPU, 1 to kMaxFramesInFlight. A frame's CPU work
+        // (culling, draw lists) overlaps the GPU work of up to this many minus one
+        // earlier frames, each with its own instance buffer. More hides slower GPU frames behind
+        // the CPU at the cost of latency, 1 has the CPU wait for the GPU every frame
+        Uint32 frames_in_flight = 2;
+    };
+
+    // what the last Render call drew. With GPU culling, objects are counted on the GPU
+    // only: visible, instances and triangles cover submissions, see ReadbackCulling
+    struct FrameStats
+    {
+        Uint32 objects = 0;
+        Uint32 visible = 0;
+        Uint32 batches = 0;         // queue batches, plus indirect buckets with GPU culling
+        Uint32 draws = 0;           // draw calls issued, batches whose pipeline was ready
+        Uint32 prepass_draws = 0;   // depth prepass draw calls, not counted in draws
+        Uint32 instances = 0;
+        Uint64 triangles = 0;
+        Uint32 draw_segments = 0;   // parts the CPU culled draws were queued in across threads, 0 with GPU culling
+        // frame pipelining: earlier frames still on the GPU when this one's CPU work started,
+        // the time from PreRender to submission without waits, and the time spent waiting for
+        // a frame slot to free up or for the swapchain
+        Uint32 frames_busy = 0;
+        Uint64 cpu_ns = 0;
+        Uint64 wait_ns = 0;
+    };
+
+    static bool Init(const Settings& settings);
     static void Render();
+    // culls the objects and starts queuing their draws on the workers. Objects and the camera
+    // must not change until Render, Submit can be called in between
     static void PreRender();
     static void PostRender();
     static void Shutdown();
+
+    // queue one instance of a mesh for this frame, between PreRender and Render. Not culled
+    static void Submit(Uint32 mesh, Uint32 material, const glm::mat4& transform);
+    static Uint32 MeshCount();
+    // transparent materials are blended back to front after every opaque draw
+    static Uint32 MaterialCount();
+    static bool IsTransparent(Uint32 material);
+
+    // persistent objects, frustum culled every frame before they reach the render queue
+    static Uint32 AddObject(Uint32 mesh, Uint32 material, const glm::mat4& transform);
+    static void SetObjectTransform(Uint32 object, const glm::mat4& transform);
+    static Camera& GetCamera();
+
+    // scratch memory for the current frame, the draw segments use it too. Not thread safe,
+    // everything in it is gone after PostRender
+    static mem::Arena& FrameArena();
+
+    static const FrameStats& GetFrameStats();
+    // true while textures are still streaming in or pipelines are still being created
+    static bool IsLoading();
+    // blocks until the GPU has finished every submitted frame
+    static void WaitIdle();
+    // headless only: copies the last rendered frame back as tightly packed RGBA8, waits for the GPU
+    static bool ReadbackFrame(std::vector<Uint8>& rgba, Uint32& width, Uint32& height);
+    // the objects the last frame drew, ascending, and the LOD of each, from whichever path
+    // culled them. Waits for the GPU with GPU culling
+    static bool ReadbackCulling(std::vector<Uint32>& visible, std::vector<Uint32>& lods);
+    static bool IsGpuCulling();
+    static bool IsDepthPrepass();
+    // the frame's passes and their targets, as built from the settings
+    static const FrameGraph& GetFrameGraph();
 private:
+    static void BuildFrameGraph();
+    static void DisableDepthPrepass();
+    // fills new vertex/index buffers and swaps them in, the current ones stay on failure
+    static bool LoadGeometry(const char* mesh_cache_path);
+    static void RequestDefaultPipeline();
+    static void ApplyReloads();
+    // hands the meshes to GPU culling, false when it cannot draw them
+    static bool SetCullingMeshes();
+    static void DisableGpuCulling();
+    // queues one instance for the opaque or the transparent pass, by material
+    static void QueueDraw(RenderQueue& queue, RenderQueue& transparent_queue, Uint32 mesh, Uint32 material,
+        const glm::mat4& transform, float depth, Uint32 lod);
+    // picks LODs for visible[begin, end) and queues their draws. Threads may run disjoint ranges
+    static void QueueVisible(RenderQueue& queue, RenderQueue& transparent_queue, Uint32 begin, Uint32 end, float height);
+    // CPU culling, kicks the draw segment jobs when there is more than one
+    static void CullObjects(float height);
+    // job: fills draw segments [begin, end), see RenderData::segments
+    static void QueueSegments(void* data, Uint32 begin, Uint32 end);
+    // submits the frame and starts recycling its slot once the GPU is done with it
+    static void SubmitFrame(SDL_GPUCommandBuffer* commands);
+
+    // the frame graph's passes and what they draw: the render queue's batches, then
+    // with GPU culling the indirect buckets of the matching materials
+    static void DrawDepthPrepass(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void* data);
+    static void DrawOpaque(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void* data);
+    static void DrawTransparent(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, void* data);
+    static void DrawQueue(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, const RenderQueue& queue,
+        Uint32 first_instance, bool depth_only);
+    static void DrawCulled(SDL_GPURenderPass* pass, SDL_GPUCommandBuffer* commands, bool transparent, bool depth_only);
+
+    // one indexed draw into the shared vertex/index buffers, offsets in bytes.
+    // Each LOD is an index range from index_offset, over the same vertices
+    struct MeshDraw
+    {
+        Uint32 vertex_offset = 0;
+        Uint32 index_offset = 0;
+        Uint32 position_offset = 0;         // into the depth prepass's position stream
+        Mesh::MeshLod lods[Mesh::kMaxLods] = {};
+        Uint32 lod_count = 1;
+        SDL_GPUIndexElementSize index_size = SDL_GPU_INDEXELEMENTSIZE_16BIT;
+        Aabb bounds;                // object space, computed at load
+        vtx::Quantization quantization;     // decodes compact positions, unused by the full layout
+    };
+
+    struct SceneObject
+    {
+        Uint32 mesh;
+        Uint32 material;
+        glm::mat4 transform;
+        Uint32 lod = 0;             // picked last frame, the starting point of the hysteresis
+    };
+
+    // a material is one streamed texture for now
+    struct Material
+    {
+        TextureHandle texture;
+        float opacity;              // below 1: blended in the transparent pass
+    };
+
+    // what a frame in flight holds on to until the GPU has finished it
+    struct FrameResources
+    {
+        SDL_GPUBuffer* instanceBuffer = nullptr;
+        Uint32 instance_capacity = 0;
+    };
+
+    // draws one job queued from a range of the visible objects
+    struct DrawSegment
+    {
+        DrawSegment(RenderQueue::Order order, std::pmr::memory_resource* resource)
+            : queue(order, resource), transparent_queue(RenderQueue::ORDER_BACK_TO_FRONT, resource) {}
+
+        RenderQueue queue;
+        RenderQueue transparent_queue;
+    };
+
+    // the resources of the frame being recorded
+    static FrameResources& CurrentFrame();
+
     struct RenderData
     {
         SDL_Window* window = nullptr;
         bool debug_mode = true;
         SDL_GPUDevice* device = nullptr;
-        SDL_GPUTexture* texture = nullptr;
-        SDL_GPUSampler* sampler = nullptr;
+
+        // the window's swapchain, or in headless mode an offscreen texture of the requested size
+        bool headless = false;
+        SDL_GPUTexture* colorTarget = nullptr;
+        SDL_GPUTextureFormat color_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        Uint32 target_width = 0;
+        Uint32 target_height = 0;
+        SDL_GPUTextureFormat depth_format = SDL_GPU_TEXTUREFORMAT_INVALID;
+        // depth prepass, opaque and transparent passes over the color target and a transient
+        // depth buffer that follows its size
+        FrameGraph* graph = nullptr;
+        FrameGraph::ResourceId color_resource = FrameGraph::kNone;
+        FrameGraph::ResourceId depth_resource = FrameGraph::kNone;
+        FrameGraph::PassId prepass = FrameGraph::kNone;
+        bool depth_prepass = false;
+        bool overdraw_view = false;
+        glm::mat4 view_projection = glm::mat4(1.0f);    // of the frame being recorded
+        FrameStats stats;
+        float lod_pixel_error = 1.0f;
+        float lod_hysteresis = 0.25f;
+        Uint64 counted_upload_bytes = 0;   // upload ring total at the last profiler counter
+
         SDL_GPUBuffer* vertexBuffer = nullptr;
         SDL_GPUBuffer* indexBuffer  = nullptr;
-        SDL_GPUTransferBuffer* transfer_buff = nullptr;
-        SDL_GPUGraphicsPipeline* graphicsPipeline = nullptr;
+        // vertexBuffer's positions alone, in the same encoding, for the depth prepass
+        SDL_GPUBuffer* positionBuffer = nullptr;
+        vtx::LayoutId vertex_layout = vtx::LAYOUT_FULL;     // of every mesh in vertexBuffer
+        PipelineCache* pipelines = nullptr;
+        PipelineHandle default_pipeline = 0;        // opaque
+        PipelineHandle transparent_pipeline = 0;
+        PipelineHandle prepass_pipeline = 0;
+        // GPU culling only
+        PipelineHandle indirect_pipeline = 0;
+        PipelineHandle indirect_transparent_pipeline = 0;
+        PipelineHandle indirect_prepass_pipeline = 0;
+        std::vector<Material> materials;
+        std::vector<MeshDraw> draws;
+
+        // the frame's sorted draws, their per-instance data goes into the frame's instance buffer
+        // with the opaque ones first. Opaque draws sort by state after a prepass, front to back otherwise
+        RenderQueue queue;
+        RenderQueue transparent_queue{ RenderQueue::ORDER_BACK_TO_FRONT };
+        // CPU culled draws are queued by up to one job per thread, each over a contiguous range
+        // of the visible objects, and appended in range order: the same queues as a serial pass.
+        // Made per frame in the frame arena, reserved up front so the jobs never allocate from it
+        std::vector<DrawSegment> segments;
+        Uint32 frame_segments = 0;      // used this frame, 1 queues into the frame's queues directly
+        float frame_height = 0.0f;      // for LOD selection
+
+        // frame frame_index records into frames[frame_index % frames_in_flight], which PreRender
+        // frees by waiting for the submission frames_in_flight frames back. The upload ring holds
+        // the fence of every submission, so its frames double as the renderer's
+        FrameResources frames[kMaxFramesInFlight];
+        Uint32 frames_in_flight = 2;
+        Uint64 frame_index = 0;
+        Uint64 frame_start_ns = 0;      // PreRender, after waiting for the slot
+        Uint64 frame_wait_ns = 0;
+        Uint32 frames_busy = 0;
+
+        // objects and the BVH culling them, rebuilt when objects are added, refit when they move
+        Camera camera;
+        std::vector<SceneObject> objects;
+        std::vector<Aabb> object_bounds;
+        Bvh bvh;
+        bool bvh_rebuild = false;
+        bool bvh_refit = false;
+        std::vector<Uint32> visible;
+        // replaces the BVH when Settings::gpu_culling is on, which still tracks objects in case of a fallback
+        GpuCulling* culling = nullptr;
+
+        // staging for every upload, recycled per frame through the submission fence
+        SDLUploadBackend* upload_backend = nullptr;
+        UploadRing* uploads = nullptr;
+        TextureStreamer* textures = nullptr;
+        // only with Settings::hot_reload
+        HotReload* reload = nullptr;
+        std::vector<HotReload::Change> reload_changes;
+
+        // the draw segment jobs run from PreRender until Render needs their queues
+        JobSystem* jobs = nullptr;
+        JobCounter frame_jobs;
+        mem::Arena frame_arena{ 1024 * 1024, mem::CATEGORY_FRAME };
     };
     static RenderData* s_Data;
 };
\ No newline at end of file
@@ -6,42 +6,107 @@ namespace shader
     SDL_GPUShader* LoadShader(
         SDL_GPUDevice* device,
         const char* shader_filename,
-        Uint32 samplers,
-        Uint32 uniform_buffers,
-        Uint32 storage_buffers,
-        Uint32 storage_textures
+        spirv::Reflection* reflection
     )
     {
-        // load the vertex shader code
+        // load the shader code
         size_t shader_code_size;
         void* shader_code = SDL_LoadFile(shader_filename, &shader_code_size);
+        if (shader_code == nullptr)
+        {
+            SDL_Log("Failed to load shader %s: %s", shader_filename, SDL_GetError());
+            return nullptr;
+        }
 
-        SDL_GPUShaderStage stage;
-        if(SDL_strstr(shader_filename, "vert"))
-            stage = SDL_GPU_SHADERSTAGE_VERTEX;
-        if(SDL_strstr(shader_filename, "frag"))
-            stage = SDL_GPU_SHADERSTAGE_FRAGMENT;
+        SDL_GPUShader* shader = CreateShader(device, shader_code, shader_code_size, shader_filename, reflection);
+        SDL_free(shader_code);
+        return shader;
+    }
+
+    SDL_GPUShader* CreateShader(
+        SDL_GPUDevice* device,
+        const void* code,
+        size_t code_size,
+        const char* name,
+        spirv::Reflection* reflection
+    )
+    {
+        spirv::Reflection local;
+        spirv::Reflection& info = reflection ? *reflection : local;
+        if (!spirv::Reflect(code, code_size, info) || info.compute)
+        {
+            SDL_Log("Failed to create shader %s: not a vertex or fragment SPIR-V module", name);
+            return nullptr;
+        }
+        spirv::ValidateLayout(info, name);
 
         SDL_GPUShaderCreateInfo shader_info{};
-        shader_info.code = (Uint8*)shader_code;
-        shader_info.code_size = shader_code_size;
-        shader_info.entrypoint = "main";
+        shader_info.code = (const Uint8*)code;
+        shader_info.code_size = code_size;
+        shader_info.entrypoint = info.entry_point.c_str();
         shader_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
-        shader_info.stage = stage;
-        shader_info.num_samplers = samplers;
-        shader_info.num_storage_buffers = storage_buffers;
-        shader_info.num_storage_textures = storage_textures;
-        shader_info.num_uniform_buffers = uniform_buffers;
+        shader_info.stage = info.stage;
+        shader_info.num_samplers = info.samplers;
+        shader_info.num_storage_buffers = info.storage_buffers;
+        shader_info.num_storage_textures = info.storage_textures;
+        shader_info.num_uniform_buffers = info.uniform_buffers;
 
         SDL_GPUShader* shader = SDL_CreateGPUShader(device, &shader_info);
         if (shader == nullptr)
         {
-            SDL_Log("Failed to create shader!");
-            SDL_free(shader_code);
+            SDL_Log("Failed to create shader %s: %s", name, SDL_GetError());
             return nullptr;
         }
-
-        SDL_free(shader_code);
         return shader;
     }
-}
\ No newline at end of file
+
+    SDL_GPUComputePipeline* LoadComputePipeline(
+        SDL_GPUDevice* device,
+        const char* shader_filename,
+        spirv::Reflection* reflection
+    )
+    {
+        size_t code_size;
+        void* code = SDL_LoadFile(shader_filename, &code_size);
+        if (code == nullptr)
+        {
+            SDL_Log("Failed to load shader %s: %s", shader_filename, SDL_GetError());
+            return nullptr;
+        }
+
+        spirv::Reflection local;
+        spirv::Reflection& info = reflection ? *reflection : local;
+        if (!spirv::Reflect(code, code_size, info) || !info.compute)
+        {
+            SDL_Log("Failed to create compute pipeline %s: not a compute SPIR-V module", shader_filename);
+            SDL_free(code);
+            return nullptr;
+        }
+        spirv::ValidateLayout(info, shader_filename);
+
+        // read-only resources in set 0, read-write ones in set 1
+        SDL_GPUComputePipelineCreateInfo pipeline_info{};
+        pipeline_info.code = (const Uint8*)code;
+        pipeline_info.code_size = code_size;
+        pipeline_info.entrypoint = info.entry_point.c_str();
+        pipeline_info.format = SDL_GPU_SHADERFORMAT_SPIRV;
+        pipeline_info.num_samplers = info.samplers;
+        pipeline_info.num_readonly_storage_textures = info.readonly_storage_textures;
+        pipeline_info.num_readonly_storage_buffers = info.readonly_storage_buffers;
+        pipeline_info.num_readwrite_storage_textures = info.storage_textures - info.readonly_storage_textures;
+        pipeline_info.num_readwrite_storage_buffers = info.storage_buffers - info.readonly_storage_buffers;
+        pipeline_info.num_uniform_buffers = info.uniform_buffers;
+        pipeline_info.threadcount_x = info.threadcount_x;
+        pipeline_info.threadcount_y = info.threadcount_y;
+        pipeline_info.threadcount_z = info.threadcount_z;
+
+        SDL_GPUComputePipeline* pipeline = SDL_CreateGPUComputePipeline(device, &pipeline_info);
+        SDL_free(code);
+        if (pipeline == nullptr)
+        {
+            SDL_Log("Failed to create compute pipeline %s: %s", shader_filename, SDL_GetError());
+            return nullptr;
+        }
+        return pipeline;
+    }
+}
@@ -2,15 +2,32 @@
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_gpu.h>
+#include "spirv_reflect.h"
 
 namespace shader
 {
+    // Loads a SPIR-V shader. The stage and resource counts come from reflecting
+    // the module, reflection receives the details when given.
     SDL_GPUShader* LoadShader(
         SDL_GPUDevice* device,
         const char* shader_filename,
-        Uint32 samplers,
-        Uint32 uniform_buffers,
-        Uint32 storage_buffers,
-        Uint32 storage_textures
+        spirv::Reflection* reflection = nullptr
     );
-}
\ No newline at end of file
+
+    // Same from code already in memory, name is only used in messages.
+    SDL_GPUShader* CreateShader(
+        SDL_GPUDevice* device,
+        const void* code,
+        size_t code_size,
+        const char* name,
+        spirv::Reflection* reflection = nullptr
+    );
+
+    // Loads a SPIR-V compute shader as a pipeline, resource counts and local
+    // size reflected like LoadShader's.
+    SDL_GPUComputePipeline* LoadComputePipeline(
+        SDL_GPUDevice* device,
+        const char* shader_filename,
+        spirv::Reflection* reflection = nullptr
+    );
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// SSE is part of the x86-64 baseline, other targets fall back to the scalar paths.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SKELETAL_SSE 1
+#include <emmintrin.h>
+#if defined(__FMA__) || defined(__AVX2__)
+#include <immintrin.h>
+#define SKELETAL_MADD(a, b, c) _mm_fmadd_ps(a, b, c)
+#else
+#define SKELETAL_MADD(a, b, c) _mm_add_ps(_mm_mul_ps(a, b), c)
+#endif
+#else
+#define SKELETAL_SSE 0
+#endif
@@ -0,0 +1,14 @@
+#include "skeleton.h"
+
+namespace anim
+{
+    int Skeleton::FindJoint(std::string_view name) const
+    {
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            if (names[i] == name)
+                return (int)i;
+        }
+        return -1;
+    }
+}
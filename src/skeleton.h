@@ -0,0 +1,25 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "glm/glm.hpp"
+#include "pose.h"
+
+namespace anim
+{
+    static const int16_t kNoParent = -1;
+
+    // Joint hierarchy as flat arrays, sorted so parents[i] < i for every joint.
+    // That order lets every hierarchy walk be a single forward loop.
+    struct Skeleton
+    {
+        std::vector<int16_t> parents;
+        std::vector<std::string> names;
+        std::vector<glm::mat4> inverse_bind;
+        LocalPose bind_pose;
+
+        uint32_t JointCount() const { return (uint32_t)parents.size(); }
+        int FindJoint(std::string_view name) const;
+    };
+}
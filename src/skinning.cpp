@@ -0,0 +1,100 @@
+#include "skinning.h"
+#include "simd.h"
+
+#include <cmath>
+
+namespace anim
+{
+    void SkinVerticesScalar(const SkinMatrix* palette, const Vertex* in, const VertexSkin* skin, Vertex* out, size_t count)
+    {
+        for (size_t v = 0; v < count; v++)
+        {
+            float m[4][3] = {};
+            for (int k = 0; k < 4; k++)
+            {
+                const SkinMatrix& joint = palette[skin[v].joints[k]];
+                float w = skin[v].weights[k];
+                for (int c = 0; c < 4; c++)
+                {
+                    m[c][0] += joint.cols[c][0] * w;
+                    m[c][1] += joint.cols[c][1] * w;
+                    m[c][2] += joint.cols[c][2] * w;
+                }
+            }
+
+            glm::vec3 p = in[v].position;
+            glm::vec3 n = in[v].normal;
+            glm::vec2 uv = in[v].tex_coords;
+
+            glm::vec3 pos(
+                m[0][0] * p.x + m[1][0] * p.y + m[2][0] * p.z + m[3][0],
+                m[0][1] * p.x + m[1][1] * p.y + m[2][1] * p.z + m[3][1],
+                m[0][2] * p.x + m[1][2] * p.y + m[2][2] * p.z + m[3][2]);
+            glm::vec3 nrm(
+                m[0][0] * n.x + m[1][0] * n.y + m[2][0] * n.z,
+                m[0][1] * n.x + m[1][1] * n.y + m[2][1] * n.z,
+                m[0][2] * n.x + m[1][2] * n.y + m[2][2] * n.z);
+
+            float len = sqrtf(nrm.x * nrm.x + nrm.y * nrm.y + nrm.z * nrm.z);
+            if (len > 0.0f)
+                nrm = nrm * (1.0f / len);
+
+            out[v].position = pos;
+            out[v].normal = nrm;
+            out[v].tex_coords = uv;
+        }
+    }
+
+    void SkinVertices(const SkinMatrix* palette, const Vertex* in, const VertexSkin* skin, Vertex* out, size_t count)
+    {
+#if SKELETAL_SSE
+        for (size_t v = 0; v < count; v++)
+        {
+            const VertexSkin& s = skin[v];
+            const SkinMatrix& m0 = palette[s.joints[0]];
+            const SkinMatrix& m1 = palette[s.joints[1]];
+            const SkinMatrix& m2 = palette[s.joints[2]];
+            const SkinMatrix& m3 = palette[s.joints[3]];
+            __m128 w0 = _mm_set1_ps(s.weights[0]);
+            __m128 w1 = _mm_set1_ps(s.weights[1]);
+            __m128 w2 = _mm_set1_ps(s.weights[2]);
+            __m128 w3 = _mm_set1_ps(s.weights[3]);
+
+            // blend the four joint matrices column by column
+            __m128 col[4];
+            for (int c = 0; c < 4; c++)
+            {
+                __m128 acc = _mm_mul_ps(_mm_load_ps(m0.cols[c]), w0);
+                acc = SKELETAL_MADD(_mm_load_ps(m1.cols[c]), w1, acc);
+                acc = SKELETAL_MADD(_mm_load_ps(m2.cols[c]), w2, acc);
+                col[c] = SKELETAL_MADD(_mm_load_ps(m3.cols[c]), w3, acc);
+            }
+
+            const Vertex& src = in[v];
+            glm::vec2 uv = src.tex_coords;
+            __m128 pos = SKELETAL_MADD(col[0], _mm_set1_ps(src.position.x), col[3]);
+            pos = SKELETAL_MADD(col[1], _mm_set1_ps(src.position.y), pos);
+            pos = SKELETAL_MADD(col[2], _mm_set1_ps(src.position.z), pos);
+            __m128 nrm = _mm_mul_ps(col[0], _mm_set1_ps(src.normal.x));
+            nrm = SKELETAL_MADD(col[1], _mm_set1_ps(src.normal.y), nrm);
+            nrm = SKELETAL_MADD(col[2], _mm_set1_ps(src.normal.z), nrm);
+
+            // w lanes are zero, so the full 4 wide dot product is the xyz length
+            __m128 sq = _mm_mul_ps(nrm, nrm);
+            sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(2, 3, 0, 1)));
+            sq = _mm_add_ps(sq, _mm_shuffle_ps(sq, sq, _MM_SHUFFLE(1, 0, 3, 2)));
+            __m128 len = _mm_sqrt_ps(sq);
+            nrm = _mm_and_ps(_mm_div_ps(nrm, len), _mm_cmpgt_ps(len, _mm_setzero_ps()));
+
+            alignas(16) float p[4], n[4];
+            _mm_store_ps(p, pos);
+            _mm_store_ps(n, nrm);
+            out[v].position = glm::vec3(p[0], p[1], p[2]);
+            out[v].normal = glm::vec3(n[0], n[1], n[2]);
+            out[v].tex_coords = uv;
+        }
+#else
+        SkinVerticesScalar(palette, in, skin, out, count);
+#endif
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include "mesh.h"
+#include "pose.h"
+
+namespace anim
+{
+    // Linear blend skinning of positions and normals with 4 influences per vertex.
+    // Texture coordinates are passed through, in and out may alias.
+    void SkinVertices(const SkinMatrix* palette, const Vertex* in, const VertexSkin* skin, Vertex* out, size_t count);
+    void SkinVerticesScalar(const SkinMatrix* palette, const Vertex* in, const VertexSkin* skin, Vertex* out, size_t count);
+}
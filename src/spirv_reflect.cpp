@@ -0,0 +1,389 @@
+#include "spirv_reflect.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <unordered_map>
+
+namespace spirv
+{
+    static const uint32_t kMagic = 0x07230203;
+    static const uint32_t kHeaderWords = 5;
+
+    enum Op : uint32_t
+    {
+        OP_NAME = 5,
+        OP_ENTRY_POINT = 15,
+        OP_EXECUTION_MODE = 16,
+        OP_TYPE_INT = 21,
+        OP_TYPE_FLOAT = 22,
+        OP_TYPE_VECTOR = 23,
+        OP_TYPE_IMAGE = 25,
+        OP_TYPE_SAMPLED_IMAGE = 27,
+        OP_TYPE_ARRAY = 28,
+        OP_TYPE_RUNTIME_ARRAY = 29,
+        OP_TYPE_STRUCT = 30,
+        OP_TYPE_POINTER = 32,
+        OP_CONSTANT = 43,
+        OP_VARIABLE = 59,
+        OP_DECORATE = 71,
+        OP_MEMBER_DECORATE = 72,
+    };
+
+    enum Decoration : uint32_t
+    {
+        DECORATION_BLOCK = 2,
+        DECORATION_BUFFER_BLOCK = 3,
+        DECORATION_BUILTIN = 11,
+        DECORATION_NON_WRITABLE = 24,
+        DECORATION_LOCATION = 30,
+        DECORATION_BINDING = 33,
+        DECORATION_DESCRIPTOR_SET = 34,
+    };
+
+    enum StorageClass : uint32_t
+    {
+        STORAGE_UNIFORM_CONSTANT = 0,
+        STORAGE_INPUT = 1,
+        STORAGE_UNIFORM = 2,
+        STORAGE_STORAGE_BUFFER = 12,
+    };
+
+    enum ExecutionModel : uint32_t
+    {
+        MODEL_VERTEX = 0,
+        MODEL_FRAGMENT = 4,
+        MODEL_GL_COMPUTE = 5,
+    };
+
+    static const uint32_t kExecutionModeLocalSize = 17;
+
+    // everything the passes below need to know about one id
+    struct Id
+    {
+        uint32_t op = 0;
+        uint32_t words[3] = {};     // operands after the result id, meaning depends on op
+        uint32_t set = ~0u;
+        uint32_t binding = ~0u;
+        uint32_t location = ~0u;
+        bool block = false;
+        bool buffer_block = false;
+        bool builtin = false;
+        bool non_writable = false;
+        uint32_t member_count = 0;
+        uint32_t non_writable_members = 0;
+        std::string name;
+    };
+
+    static std::string ReadString(const uint32_t* words, uint32_t count)
+    {
+        const char* chars = (const char*)words;
+        size_t length = 0;
+        while (length < count * 4 && chars[length])
+            length++;
+        return std::string(chars, length);
+    }
+
+    static SDL_GPUVertexElementFormat VertexFormat(const std::vector<Id>& ids, uint32_t type)
+    {
+        uint32_t components = 1;
+        if (ids[type].op == OP_TYPE_VECTOR)
+        {
+            components = ids[type].words[1];
+            type = ids[type].words[0];
+        }
+        if (components < 1 || components > 4)
+            return SDL_GPU_VERTEXELEMENTFORMAT_INVALID;
+
+        const Id& scalar = ids[type];
+        if (scalar.op == OP_TYPE_FLOAT && scalar.words[0] == 32)
+        {
+            static const SDL_GPUVertexElementFormat kFloat[] = { SDL_GPU_VERTEXELEMENTFORMAT_FLOAT, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4 };
+            return kFloat[components - 1];
+        }
+        if (scalar.op == OP_TYPE_FLOAT && scalar.words[0] == 16 && (components == 2 || components == 4))
+            return components == 2 ? SDL_GPU_VERTEXELEMENTFORMAT_HALF2 : SDL_GPU_VERTEXELEMENTFORMAT_HALF4;
+        if (scalar.op == OP_TYPE_INT && scalar.words[0] == 32)
+        {
+            static const SDL_GPUVertexElementFormat kInt[] = { SDL_GPU_VERTEXELEMENTFORMAT_INT, SDL_GPU_VERTEXELEMENTFORMAT_INT2, SDL_GPU_VERTEXELEMENTFORMAT_INT3, SDL_GPU_VERTEXELEMENTFORMAT_INT4 };
+            static const SDL_GPUVertexElementFormat kUint[] = { SDL_GPU_VERTEXELEMENTFORMAT_UINT, SDL_GPU_VERTEXELEMENTFORMAT_UINT2, SDL_GPU_VERTEXELEMENTFORMAT_UINT3, SDL_GPU_VERTEXELEMENTFORMAT_UINT4 };
+            return scalar.words[1] ? kInt[components - 1] : kUint[components - 1];
+        }
+        return SDL_GPU_VERTEXELEMENTFORMAT_INVALID;
+    }
+
+    bool Reflect(const void* code, size_t size, Reflection& out)
+    {
+        out = Reflection();
+        if (!code || size < kHeaderWords * 4 || size % 4 != 0)
+            return false;
+
+        const uint32_t* words = (const uint32_t*)code;
+        size_t word_count = size / 4;
+        if (words[0] != kMagic)
+            return false;
+        uint32_t bound = words[3];
+        if (bound == 0 || bound > (1u << 22))
+            return false;
+
+        std::vector<Id> ids(bound);
+        std::vector<uint32_t> variables;
+        uint32_t entry_id = ~0u;
+        bool has_entry = false;
+
+        for (size_t at = kHeaderWords; at < word_count;)
+        {
+            uint32_t op = words[at] & 0xFFFF;
+            uint32_t count = words[at] >> 16;
+            if (count == 0 || at + count > word_count)
+                return false;
+            const uint32_t* operands = words + at + 1;
+            uint32_t operand_count = count - 1;
+            at += count;
+
+            // the result id of the instructions below, range checked once
+            auto Target = [&](uint32_t index) -> Id* {
+                if (index >= operand_count || operands[index] >= bound)
+                    return nullptr;
+                return &ids[operands[index]];
+            };
+
+            switch (op)
+            {
+            case OP_NAME:
+                if (Id* id = Target(0))
+                    id->name = ReadString(operands + 1, operand_count - 1);
+                break;
+
+            case OP_ENTRY_POINT:
+                if (!has_entry && operand_count >= 3)
+                {
+                    has_entry = true;
+                    entry_id = operands[1];
+                    out.entry_point = ReadString(operands + 2, operand_count - 2);
+                    switch (operands[0])
+                    {
+                    case MODEL_VERTEX: out.stage = SDL_GPU_SHADERSTAGE_VERTEX; break;
+                    case MODEL_FRAGMENT: out.stage = SDL_GPU_SHADERSTAGE_FRAGMENT; break;
+                    case MODEL_GL_COMPUTE: out.compute = true; break;
+                    default:
+                        SDL_Log("Unsupported SPIR-V execution model %u", operands[0]);
+                        return false;
+                    }
+                }
+                break;
+
+            case OP_EXECUTION_MODE:
+                if (operand_count >= 5 && operands[0] == entry_id && operands[1] == kExecutionModeLocalSize)
+                {
+                    out.threadcount_x = operands[2];
+                    out.threadcount_y = operands[3];
+                    out.threadcount_z = operands[4];
+                }
+                break;
+
+            case OP_TYPE_INT:
+            case OP_TYPE_FLOAT:
+            case OP_TYPE_VECTOR:
+            case OP_TYPE_IMAGE:
+            case OP_TYPE_SAMPLED_IMAGE:
+            case OP_TYPE_ARRAY:
+            case OP_TYPE_RUNTIME_ARRAY:
+            case OP_TYPE_POINTER:
+                if (Id* id = Target(0))
+                {
+                    id->op = op;
+                    // OpTypeImage keeps its Sampled operand, the 7th, in place of the dimension
+                    if (op == OP_TYPE_IMAGE)
+                        id->words[0] = operand_count > 6 ? operands[6] : 0;
+                    else
+                    {
+                        for (uint32_t i = 0; i < 3 && i + 1 < operand_count; i++)
+                            id->words[i] = operands[i + 1];
+                    }
+                }
+                break;
+
+            case OP_TYPE_STRUCT:
+                if (Id* id = Target(0))
+                {
+                    id->op = op;
+                    id->member_count = operand_count - 1;
+                }
+                break;
+
+            case OP_CONSTANT:
+                if (Id* id = Target(1))
+                {
+                    id->op = op;
+                    id->words[0] = operand_count > 2 ? operands[2] : 0;
+                }
+                break;
+
+            case OP_VARIABLE:
+                if (Id* id = Target(1))
+                {
+                    id->op = op;
+                    id->words[0] = operands[0];                                  // pointer type
+                    id->words[1] = operand_count > 2 ? operands[2] : 0;          // storage class
+                    variables.push_back(operands[1]);
+                }
+                break;
+
+            case OP_DECORATE:
+                if (Id* id = Target(0))
+                {
+                    uint32_t value = operand_count > 2 ? operands[2] : 0;
+                    switch (operand_count > 1 ? operands[1] : ~0u)
+                    {
+                    case DECORATION_BLOCK: id->block = true; break;
+                    case DECORATION_BUFFER_BLOCK: id->buffer_block = true; break;
+                    case DECORATION_BUILTIN: id->builtin = true; break;
+                    case DECORATION_NON_WRITABLE: id->non_writable = true; break;
+                    case DECORATION_LOCATION: id->location = value; break;
+                    case DECORATION_BINDING: id->binding = value; break;
+                    case DECORATION_DESCRIPTOR_SET: id->set = value; break;
+                    }
+                }
+                break;
+
+            case OP_MEMBER_DECORATE:
+                if (Id* id = Target(0))
+                {
+                    // gl_PerVertex marks its members, glslang marks readonly buffers per member
+                    uint32_t decoration = operand_count > 2 ? operands[2] : ~0u;
+                    if (decoration == DECORATION_BUILTIN)
+                        id->builtin = true;
+                    else if (decoration == DECORATION_NON_WRITABLE)
+                        id->non_writable_members++;
+                }
+                break;
+            }
+        }
+
+        if (!has_entry)
+            return false;
+
+        for (uint32_t variable : variables)
+        {
+            const Id& var = ids[variable];
+            uint32_t storage = var.words[1];
+            if (var.words[0] >= bound || ids[var.words[0]].op != OP_TYPE_POINTER)
+                continue;
+
+            // peel pointer and arrays down to the interesting type
+            uint32_t type = ids[var.words[0]].words[1];
+            uint32_t count = 1;
+            while (type < bound && (ids[type].op == OP_TYPE_ARRAY || ids[type].op == OP_TYPE_RUNTIME_ARRAY))
+            {
+                if (ids[type].op == OP_TYPE_ARRAY)
+                {
+                    uint32_t length = ids[type].words[1];
+                    count *= length < bound && ids[length].op == OP_CONSTANT ? ids[length].words[0] : 1;
+                }
+                type = ids[type].words[0];
+            }
+            if (type >= bound)
+                continue;
+            const Id& pointee = ids[type];
+
+            if (storage == STORAGE_INPUT)
+            {
+                if (out.compute || out.stage != SDL_GPU_SHADERSTAGE_VERTEX || var.builtin || pointee.builtin || var.location == ~0u)
+                    continue;
+                out.inputs.push_back({ var.name, var.location, VertexFormat(ids, type) });
+                continue;
+            }
+
+            Resource resource{};
+            resource.name = var.name.empty() ? pointee.name : var.name;
+            resource.set = var.set == ~0u ? 0 : var.set;
+            resource.binding = var.binding == ~0u ? 0 : var.binding;
+            resource.count = count;
+
+            if (storage == STORAGE_UNIFORM_CONSTANT)
+            {
+                if (pointee.op == OP_TYPE_SAMPLED_IMAGE)
+                    resource.kind = RESOURCE_SAMPLER;
+                else if (pointee.op == OP_TYPE_IMAGE && pointee.words[0] == 2)
+                {
+                    resource.kind = RESOURCE_STORAGE_TEXTURE;
+                    resource.readonly = var.non_writable;
+                }
+                else if (pointee.op == OP_TYPE_IMAGE)
+                    resource.kind = RESOURCE_SAMPLER;   // separate image, SDL binds it as a sampler slot
+                else
+                    continue;
+            }
+            else if (storage == STORAGE_UNIFORM || storage == STORAGE_STORAGE_BUFFER)
+            {
+                // before SPIR-V 1.3 storage buffers are Uniform + BufferBlock
+                bool storage_buffer = storage == STORAGE_STORAGE_BUFFER || pointee.buffer_block;
+                resource.kind = storage_buffer ? RESOURCE_STORAGE_BUFFER : RESOURCE_UNIFORM_BUFFER;
+                resource.readonly = storage_buffer && (var.non_writable || (pointee.member_count > 0 && pointee.non_writable_members >= pointee.member_count));
+            }
+            else
+            {
+                continue;
+            }
+
+            switch (resource.kind)
+            {
+            case RESOURCE_SAMPLER: out.samplers += count; break;
+            case RESOURCE_STORAGE_TEXTURE:
+                out.storage_textures += count;
+                out.readonly_storage_textures += resource.readonly ? count : 0;
+                break;
+            case RESOURCE_STORAGE_BUFFER:
+                out.storage_buffers += count;
+                out.readonly_storage_buffers += resource.readonly ? count : 0;
+                break;
+            case RESOURCE_UNIFORM_BUFFER: out.uniform_buffers += count; break;
+            }
+            out.resources.push_back(std::move(resource));
+        }
+
+        std::sort(out.inputs.begin(), out.inputs.end(), [](const VertexInput& a, const VertexInput& b) { return a.location < b.location; });
+        std::sort(out.resources.begin(), out.resources.end(), [](const Resource& a, const Resource& b) {
+            return a.set != b.set ? a.set < b.set : a.binding < b.binding;
+        });
+        return true;
+    }
+
+    static uint32_t ExpectedSet(const Reflection& reflection, const Resource& resource)
+    {
+        // SDL_CreateGPUShader / SDL_CreateGPUComputePipeline descriptor set conventions
+        if (reflection.compute)
+        {
+            if (resource.kind == RESOURCE_UNIFORM_BUFFER)
+                return 2;
+            if (resource.kind == RESOURCE_SAMPLER || resource.readonly)
+                return 0;
+            return 1;
+        }
+        uint32_t base = reflection.stage == SDL_GPU_SHADERSTAGE_VERTEX ? 0 : 2;
+        return resource.kind == RESOURCE_UNIFORM_BUFFER ? base + 1 : base;
+    }
+
+    bool ValidateLayout(const Reflection& reflection, const char* name)
+    {
+        bool ok = true;
+        for (const Resource& resource : reflection.resources)
+        {
+            uint32_t expected = ExpectedSet(reflection, resource);
+            if (resource.set != expected)
+            {
+                SDL_Log("%s: %s is in set %u, SDL expects set %u", name, resource.name.c_str(), resource.set, expected);
+                ok = false;
+            }
+        }
+        for (const VertexInput& input : reflection.inputs)
+        {
+            if (input.format == SDL_GPU_VERTEXELEMENTFORMAT_INVALID)
+            {
+                SDL_Log("%s: vertex input %s at location %u has no SDL vertex format", name, input.name.c_str(), input.location);
+                ok = false;
+            }
+        }
+        return ok;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Minimal SPIR-V reflection: just enough to fill in SDL_GPUShaderCreateInfo,
+// SDL_GPUComputePipelineCreateInfo and the vertex attribute formats of a
+// pipeline without the caller repeating what the shader already says.
+namespace spirv
+{
+    enum ResourceKind
+    {
+        RESOURCE_SAMPLER,           // combined image sampler
+        RESOURCE_STORAGE_TEXTURE,
+        RESOURCE_STORAGE_BUFFER,
+        RESOURCE_UNIFORM_BUFFER,
+    };
+
+    struct Resource
+    {
+        std::string name;
+        ResourceKind kind;
+        uint32_t set;
+        uint32_t binding;
+        uint32_t count;             // array size, 1 for plain bindings
+        bool readonly;
+    };
+
+    struct VertexInput
+    {
+        std::string name;
+        uint32_t location;
+        SDL_GPUVertexElementFormat format;  // INVALID for types SDL cannot feed
+    };
+
+    struct Reflection
+    {
+        SDL_GPUShaderStage stage = SDL_GPU_SHADERSTAGE_VERTEX;
+        bool compute = false;
+        std::string entry_point;
+        std::vector<Resource> resources;
+        std::vector<VertexInput> inputs;    // vertex stage only, sorted by location
+
+        // per kind totals, array sizes included
+        uint32_t samplers = 0;
+        uint32_t storage_textures = 0;
+        uint32_t storage_buffers = 0;
+        uint32_t uniform_buffers = 0;
+        uint32_t readonly_storage_textures = 0;
+        uint32_t readonly_storage_buffers = 0;
+
+        // compute local size
+        uint32_t threadcount_x = 1;
+        uint32_t threadcount_y = 1;
+        uint32_t threadcount_z = 1;
+    };
+
+    // Reflects the first entry point of the module. Returns false on anything that
+    // is not a well formed little endian SPIR-V module.
+    bool Reflect(const void* code, size_t size, Reflection& out);
+
+    // Checks every resource sits in the descriptor set SDL expects for its stage
+    // and kind, logging each one that does not.
+    bool ValidateLayout(const Reflection& reflection, const char* name);
+}
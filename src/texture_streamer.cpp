@@ -0,0 +1,499 @@
+#include "texture_streamer.h"
+
+#include <SDL3/SDL.h>
+#include "dds.h"
+#include "image.h"
+#include "mipmap.h"
+#include "profiler.h"
+
+// ---------------------------------------------------------------------------
+// decoder
+
+TextureDecoder::TextureDecoder(uint32_t thread_count)
+{
+    if (thread_count == 0)
+        thread_count = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores() / 2, 1);
+
+    threads.reserve(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++)
+        threads.emplace_back(&TextureDecoder::WorkerMain, this);
+}
+
+TextureDecoder::~TextureDecoder()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+        requests.clear();
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads)
+        thread.join();
+}
+
+void TextureDecoder::Submit(uint32_t id, const std::string& path, bool generate_mips, uint32_t generation)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        requests.push_back({ id, path, generate_mips, generation });
+    }
+    wake.notify_one();
+}
+
+void TextureDecoder::Poll(std::vector<DecodedTexture>& out)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (DecodedTexture& texture : finished)
+        out.push_back(std::move(texture));
+    finished.clear();
+}
+
+void TextureDecoder::WaitIdle()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return requests.empty() && in_progress == 0; });
+}
+
+void TextureDecoder::WorkerMain()
+{
+    PROFILE_THREAD("texture decoder");
+    for (;;)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || !requests.empty(); });
+            if (quit)
+                return;
+            request = std::move(requests.front());
+            requests.pop_front();
+            in_progress++;
+        }
+
+        DecodedTexture texture;
+        texture.id = request.id;
+        texture.generation = request.generation;
+        Decode(request.path.c_str(), request.generate_mips, texture);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.push_back(std::move(texture));
+            in_progress--;
+        }
+        idle.notify_all();
+    }
+}
+
+static SDL_GPUTextureFormat CompressedFormat(bc::Format format, bool srgb)
+{
+    switch (format)
+    {
+    case bc::FORMAT_BC1: return srgb ? SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM_SRGB : SDL_GPU_TEXTUREFORMAT_BC1_RGBA_UNORM;
+    case bc::FORMAT_BC3: return srgb ? SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM_SRGB : SDL_GPU_TEXTUREFORMAT_BC3_RGBA_UNORM;
+    case bc::FORMAT_BC7: return srgb ? SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM_SRGB : SDL_GPU_TEXTUREFORMAT_BC7_RGBA_UNORM;
+    }
+    return SDL_GPU_TEXTUREFORMAT_INVALID;
+}
+
+void TextureDecoder::Decode(const char* path, bool generate_mips, DecodedTexture& out)
+{
+    PROFILE_ZONE("decode texture");
+    // cooked textures are already in their GPU layout, nothing to decode
+    if (dds::IsDDSPath(path))
+    {
+        dds::Image image;
+        out.ok = dds::Load(path, image);
+        if (!out.ok)
+            return;
+        out.format = CompressedFormat(image.format, image.srgb);
+        out.width = image.width;
+        out.height = image.height;
+        out.levels = image.levels;
+        out.pixels = std::move(image.data);
+        out.level_offsets = std::move(image.level_offsets);
+        return;
+    }
+
+    int width, height, channels;
+    unsigned char* pixels = image::LoadImage(path, &width, &height, &channels, 4);
+    if (!pixels)
+    {
+        SDL_Log("Failed to decode %s", path);
+        out.ok = false;
+        return;
+    }
+
+    out.width = (uint32_t)width;
+    out.height = (uint32_t)height;
+    out.levels = generate_mips ? mip::LevelCount(out.width, out.height) : 1;
+    out.pixels.resize(mip::ChainSize(out.width, out.height, out.levels));
+    SDL_memcpy(out.pixels.data(), pixels, (size_t)width * height * 4);
+    image::FreeImage(pixels);
+
+    mip::GenerateChain(out.pixels.data(), out.width, out.height, out.levels, &out.level_offsets);
+    out.ok = true;
+}
+
+// ---------------------------------------------------------------------------
+// streamer
+
+TextureStreamer::TextureStreamer(SDL_GPUDevice* _device, UploadRing* _uploads, const Settings& _settings)
+    : device(_device), uploads(_uploads), settings(_settings), decoder(_settings.decode_threads)
+{
+    // mid grey stand-in until the first levels of a texture land
+    SDL_GPUTextureCreateInfo info{};
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    info.width = 1;
+    info.height = 1;
+    info.layer_count_or_depth = 1;
+    info.num_levels = 1;
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    fallback = SDL_CreateGPUTexture(device, &info);
+
+    const uint8_t grey[4] = { 128, 128, 128, 255 };
+    SDL_GPUTextureRegion region{};
+    region.texture = fallback;
+    region.w = 1;
+    region.h = 1;
+    region.d = 1;
+    uploads->UploadToTexture(grey, sizeof(grey), region);
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    for (TextureHandle handle = 0; handle < entries.Slots(); handle++)
+        Release(entries[handle]);
+    for (SDL_GPUSampler* sampler : samplers)
+    {
+        if (sampler)
+            SDL_ReleaseGPUSampler(device, sampler);
+    }
+    SDL_ReleaseGPUTexture(device, fallback);
+}
+
+TextureHandle TextureStreamer::Load(const char* path)
+{
+    auto found = by_path.find(path);
+    if (found != by_path.end())
+        return found->second;
+
+    TextureHandle handle = entries.Create();
+    Entry& entry = entries[handle];
+    entry.path = path;
+    entry.state = STATE_DECODING;
+    entry.last_used = frame;
+    by_path.emplace(path, handle);
+
+    decoder.Submit(handle, path, !settings.gpu_mips);
+    return handle;
+}
+
+bool TextureStreamer::Reload(const char* path)
+{
+    auto found = by_path.find(path);
+    if (found == by_path.end())
+        return false;
+
+    // evicted textures decode the new file whenever they are bound again
+    Entry& entry = entries[found->second];
+    entry.generation++;
+    stats.reloads++;
+    if (entry.state == STATE_UNLOADED)
+        return true;
+    if (entry.state == STATE_FAILED)
+        entry.state = STATE_DECODING;
+    decoder.Submit(found->second, entry.path, !settings.gpu_mips, entry.generation);
+    return true;
+}
+
+SDL_GPUTextureSamplerBinding TextureStreamer::Binding(TextureHandle handle)
+{
+    Entry& entry = entries[handle];
+    entry.last_used = frame;
+
+    // evicted, bring it back
+    if (entry.state == STATE_UNLOADED)
+    {
+        entry.state = STATE_DECODING;
+        decoder.Submit(handle, entry.path, !settings.gpu_mips, entry.generation);
+    }
+
+    // gpu_mips chains are generated after the upload flush, ahead of any draw
+    SDL_GPUTextureSamplerBinding binding{};
+    if (entry.previous)
+    {
+        binding.texture = entry.previous;
+        binding.sampler = SamplerForLevel(entry.previous_level);
+    }
+    else if ((entry.state == STATE_STREAMING || entry.state == STATE_RESIDENT) && entry.finest_level < entry.levels)
+    {
+        binding.texture = entry.texture;
+        binding.sampler = SamplerForLevel(entry.finest_level);
+    }
+    else
+    {
+        binding.texture = fallback;
+        binding.sampler = SamplerForLevel(0);
+    }
+    return binding;
+}
+
+bool TextureStreamer::IsResident(TextureHandle handle) const
+{
+    return entries[handle].state == STATE_RESIDENT;
+}
+
+bool TextureStreamer::IsFailed(TextureHandle handle) const
+{
+    return entries[handle].state == STATE_FAILED;
+}
+
+void TextureStreamer::Update()
+{
+    PROFILE_ZONE("texture streaming");
+    frame++;
+
+    decoded.clear();
+    decoder.Poll(decoded);
+    for (DecodedTexture& texture : decoded)
+        Integrate(texture);
+
+    StreamLevels();
+    Evict();
+    PROFILE_COUNTER("texture bytes resident", stats.resident_bytes);
+
+    stats.resident = stats.streaming = stats.decoding = 0;
+    for (TextureHandle handle = 0; handle < entries.Slots(); handle++)
+    {
+        const Entry& entry = entries[handle];
+        stats.resident += entry.state == STATE_RESIDENT;
+        stats.streaming += entry.state == STATE_STREAMING;
+        stats.decoding += entry.state == STATE_DECODING;
+    }
+}
+
+void TextureStreamer::Integrate(DecodedTexture& texture)
+{
+    Entry& entry = entries[texture.id];
+    if (texture.generation != entry.generation)
+        return;
+    bool reload = entry.state == STATE_STREAMING || entry.state == STATE_RESIDENT;
+    if (!reload && entry.state != STATE_DECODING)
+        return;
+    if (!texture.ok)
+    {
+        // a broken edit keeps what is there
+        if (!reload)
+            entry.state = STATE_FAILED;
+        return;
+    }
+    if (reload)
+    {
+        // the old version stays bound until the new one is complete. A reload arriving
+        // while the last one still streams drops that one, the resident version stays
+        if (entry.previous)
+        {
+            SDL_ReleaseGPUTexture(device, entry.texture);
+            stats.resident_bytes -= entry.bytes;
+        }
+        else
+        {
+            entry.previous = entry.texture;
+            entry.previous_level = entry.finest_level;
+            entry.previous_bytes = entry.bytes;
+        }
+        entry.texture = nullptr;
+        entry.bytes = 0;
+        entry.mips_pending = false;
+        entry.state = STATE_DECODING;
+    }
+
+    // block compressed formats cannot be render targets, so no GPU blits for them
+    bool gpu_mips = settings.gpu_mips && !texture.IsCompressed();
+    if (texture.IsCompressed() && !SDL_GPUTextureSupportsFormat(device, texture.format, SDL_GPU_TEXTURETYPE_2D, SDL_GPU_TEXTUREUSAGE_SAMPLER))
+    {
+        SDL_Log("Failed to load %s: the device cannot sample its compressed format", entry.path.c_str());
+        entry.state = STATE_FAILED;
+        return;
+    }
+
+    uint32_t levels = gpu_mips ? mip::LevelCount(texture.width, texture.height) : texture.levels;
+    SDL_GPUTextureCreateInfo info{};
+    info.type = SDL_GPU_TEXTURETYPE_2D;
+    info.format = texture.format;
+    info.width = texture.width;
+    info.height = texture.height;
+    info.layer_count_or_depth = 1;
+    info.num_levels = levels;
+    info.usage = SDL_GPU_TEXTUREUSAGE_SAMPLER;
+    if (gpu_mips)
+        info.usage |= SDL_GPU_TEXTUREUSAGE_COLOR_TARGET;   // the mip blits render into each level
+    entry.texture = SDL_CreateGPUTexture(device, &info);
+    if (!entry.texture)
+    {
+        SDL_Log("Failed to create texture for %s: %s", entry.path.c_str(), SDL_GetError());
+        entry.state = STATE_FAILED;
+        return;
+    }
+    SDL_SetGPUTextureName(device, entry.texture, entry.path.c_str());
+
+    entry.levels = levels;
+    entry.finest_level = levels;
+    entry.gpu_mips = gpu_mips;
+    entry.bytes = gpu_mips ? mip::ChainSize(texture.width, texture.height, levels) : texture.pixels.size();
+    entry.decoded = std::move(texture);
+    entry.state = STATE_STREAMING;
+    stats.resident_bytes += entry.bytes;
+}
+
+void TextureStreamer::StreamLevels()
+{
+    // coarsest levels first across all textures, so everything gets a usable
+    // version before anything gets its full resolution
+    uint64_t budget = settings.upload_bytes_per_frame;
+    bool progress = true;
+    while (progress && budget > 0)
+    {
+        progress = false;
+        for (uint32_t handle = 0; handle < entries.Slots(); handle++)
+        {
+            Entry& entry = entries[handle];
+            if (entry.state != STATE_STREAMING)
+                continue;
+
+            const DecodedTexture& texture = entry.decoded;
+            uint32_t available = texture.levels;        // levels present in the decoded data
+            uint32_t level = entry.gpu_mips ? 0 : entry.finest_level - 1;
+            if (level >= available)
+                continue;
+
+            uint32_t width = SDL_max(texture.width >> level, 1u);
+            uint32_t height = SDL_max(texture.height >> level, 1u);
+            uint32_t size = (uint32_t)texture.LevelSize(level);
+            // one oversize level per frame is allowed, otherwise big textures never start
+            if (size > budget && budget != settings.upload_bytes_per_frame)
+                continue;
+
+            SDL_GPUTextureRegion region{};
+            region.texture = entry.texture;
+            region.mip_level = level;
+            region.w = width;
+            region.h = height;
+            region.d = 1;
+            if (!uploads->UploadToTexture(texture.pixels.data() + texture.level_offsets[level], size, region))
+                return;
+
+            budget = size > budget ? 0 : budget - size;
+            stats.uploaded_bytes += size;
+            progress = true;
+
+            if (entry.gpu_mips)
+            {
+                entry.finest_level = 0;
+                entry.mips_pending = entry.levels > 1;
+                if (entry.mips_pending)
+                    gpu_mip_queue.push_back(handle);
+            }
+            else
+            {
+                entry.finest_level = level;
+            }
+
+            if (entry.finest_level == 0)
+            {
+                entry.state = STATE_RESIDENT;
+                entry.decoded = DecodedTexture();
+                ReleasePrevious(entry);
+            }
+            if (budget == 0)
+                break;
+        }
+    }
+}
+
+void TextureStreamer::RecordGpuWork(SDL_GPUCommandBuffer* command_buffer)
+{
+    for (TextureHandle handle : gpu_mip_queue)
+    {
+        Entry& entry = entries[handle];
+        if (entry.texture && entry.mips_pending)
+            SDL_GenerateMipmapsForGPUTexture(command_buffer, entry.texture);
+        entry.mips_pending = false;
+    }
+    gpu_mip_queue.clear();
+}
+
+void TextureStreamer::Evict()
+{
+    // linear LRU scan, fine for the few thousand textures a scene holds. Anything
+    // bound last frame stays, Update runs before this frame's Binding calls
+    while (stats.resident_bytes > settings.budget_bytes)
+    {
+        Entry* oldest = nullptr;
+        for (TextureHandle handle = 0; handle < entries.Slots(); handle++)
+        {
+            Entry& entry = entries[handle];
+            bool evictable = (entry.state == STATE_STREAMING || entry.state == STATE_RESIDENT) && entry.last_used + 1 < frame;
+            if (evictable && (!oldest || entry.last_used < oldest->last_used))
+                oldest = &entry;
+        }
+        // everything resident is in use, stay over budget rather than thrash
+        if (!oldest)
+            break;
+
+        Release(*oldest);
+        stats.evictions++;
+    }
+}
+
+void TextureStreamer::ReleasePrevious(Entry& entry)
+{
+    if (entry.previous)
+    {
+        SDL_ReleaseGPUTexture(device, entry.previous);
+        stats.resident_bytes -= entry.previous_bytes;
+        entry.previous = nullptr;
+        entry.previous_level = 0;
+        entry.previous_bytes = 0;
+    }
+}
+
+void TextureStreamer::Release(Entry& entry)
+{
+    ReleasePrevious(entry);
+    if (entry.texture)
+    {
+        // SDL keeps it alive until in-flight frames are done with it
+        SDL_ReleaseGPUTexture(device, entry.texture);
+        entry.texture = nullptr;
+        stats.resident_bytes -= entry.bytes;
+    }
+    if (entry.state == STATE_STREAMING || entry.state == STATE_RESIDENT)
+        entry.state = STATE_UNLOADED;
+    entry.bytes = 0;
+    entry.levels = 0;
+    entry.finest_level = 0;
+    entry.gpu_mips = false;
+    entry.mips_pending = false;
+    entry.decoded = DecodedTexture();
+}
+
+SDL_GPUSampler* TextureStreamer::SamplerForLevel(uint32_t level)
+{
+    level = SDL_min(level, kMaxLevels - 1);
+    if (!samplers[level])
+    {
+        SDL_GPUSamplerCreateInfo info{};
+        info.min_filter = SDL_GPU_FILTER_LINEAR;
+        info.mag_filter = SDL_GPU_FILTER_LINEAR;
+        info.mipmap_mode = SDL_GPU_SAMPLERMIPMAPMODE_LINEAR;
+        info.address_mode_u = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        info.address_mode_v = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        info.address_mode_w = SDL_GPU_SAMPLERADDRESSMODE_REPEAT;
+        info.min_lod = (float)level;
+        info.max_lod = 1000.0f;
+        samplers[level] = SDL_CreateGPUSampler(device, &info);
+    }
+    return samplers[level];
+}
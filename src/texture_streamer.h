@@ -0,0 +1,198 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "memory.h"
+#include "upload_ring.h"
+
+// Image with its mip chain stored back to back, level 0 first. RGBA8 for
+// decoded image files, BC blocks straight from the file for cooked .dds textures.
+struct DecodedTexture
+{
+    uint32_t id = 0;
+    uint32_t generation = 0;        // as submitted, tells a reload's decode from an older one
+    bool ok = false;
+    SDL_GPUTextureFormat format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t levels = 0;
+    std::vector<uint8_t> pixels;
+    std::vector<size_t> level_offsets;
+
+    bool IsCompressed() const { return format != SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM; }
+    size_t LevelSize(uint32_t level) const
+    {
+        size_t end = level + 1 < levels ? level_offsets[level + 1] : pixels.size();
+        return end - level_offsets[level];
+    }
+};
+
+// Pool of threads decoding image files and building their mip chains. Kept
+// apart from the JobSystem on purpose: a decode takes milliseconds and
+// JobSystem::Wait would pick one up in the middle of a frame.
+class TextureDecoder
+{
+public:
+    // 0 leaves half of the logical cores to the frame
+    explicit TextureDecoder(uint32_t thread_count = 0);
+    ~TextureDecoder();
+
+    TextureDecoder(const TextureDecoder&) = delete;
+    TextureDecoder& operator=(const TextureDecoder&) = delete;
+
+    uint32_t ThreadCount() const { return (uint32_t)threads.size(); }
+
+    // generate_mips false decodes level 0 only, .dds files always come with their cooked chain
+    void Submit(uint32_t id, const std::string& path, bool generate_mips, uint32_t generation = 0);
+
+    // moves finished decodes into out, never blocks
+    void Poll(std::vector<DecodedTexture>& out);
+
+    // blocks until every submitted request has finished
+    void WaitIdle();
+
+    // the work a request does, usable on any thread
+    static void Decode(const char* path, bool generate_mips, DecodedTexture& out);
+
+private:
+    struct Request
+    {
+        uint32_t id;
+        std::string path;
+        bool generate_mips;
+        uint32_t generation;
+    };
+
+    void WorkerMain();
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<Request> requests;
+    std::vector<DecodedTexture> finished;
+    uint32_t in_progress = 0;
+    bool quit = false;
+};
+
+using TextureHandle = uint32_t;
+
+// Streams textures in the background. Load returns right away, decoding and
+// CPU mip generation happen on the decoder threads and Update uploads the
+// results smallest mip first, a few megabytes per frame, so a blurry version
+// is usable immediately. The sampler handed out clamps the minimum LOD to the
+// finest level uploaded so far. Residency is capped by an LRU budget: textures
+// not used for the longest time are released and decoded again on demand.
+// Cooked .dds textures (see tools/texture_cook) skip decoding and upload their
+// BC blocks as they are, at a quarter to an eighth of the RGBA8 size. A reloaded
+// texture keeps drawing its old version until the new one is fully uploaded.
+class TextureStreamer
+{
+public:
+    struct Settings
+    {
+        uint64_t budget_bytes = 256ull * 1024 * 1024;
+        uint32_t upload_bytes_per_frame = 8 * 1024 * 1024;
+        uint32_t decode_threads = 0;
+        // upload level 0 only and let the GPU blit the chain, for when CPU time is scarcer than GPU time.
+        // Compressed textures always bring their own chain
+        bool gpu_mips = false;
+    };
+
+    struct Stats
+    {
+        uint64_t resident_bytes = 0;
+        uint32_t resident = 0;
+        uint32_t streaming = 0;
+        uint32_t decoding = 0;
+        uint64_t uploaded_bytes = 0;
+        uint32_t evictions = 0;
+        uint32_t reloads = 0;
+    };
+
+    TextureStreamer(SDL_GPUDevice* _device, UploadRing* _uploads, const Settings& _settings);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // same path, same handle
+    TextureHandle Load(const char* path);
+
+    // decodes the file again after it changed on disk, false when nothing loaded it
+    bool Reload(const char* path);
+
+    // what to bind this frame, also marks the texture as used for the LRU
+    SDL_GPUTextureSamplerBinding Binding(TextureHandle handle);
+    bool IsResident(TextureHandle handle) const;
+    bool IsFailed(TextureHandle handle) const;
+
+    // main thread, before the upload ring flushes
+    void Update();
+
+    // after the upload ring flushed, GPU mip generation for gpu_mips
+    void RecordGpuWork(SDL_GPUCommandBuffer* command_buffer);
+
+    const Stats& GetStats() const { return stats; }
+
+private:
+    enum State
+    {
+        STATE_UNLOADED,
+        STATE_DECODING,
+        STATE_STREAMING,            // texture exists, finer levels still uploading
+        STATE_RESIDENT,
+        STATE_FAILED,
+    };
+
+    struct Entry
+    {
+        std::string path;
+        State state = STATE_UNLOADED;
+        SDL_GPUTexture* texture = nullptr;
+        uint32_t levels = 0;
+        uint32_t finest_level = 0;  // finest level uploaded, == levels while nothing is
+        uint64_t bytes = 0;
+        uint64_t last_used = 0;
+        bool gpu_mips = false;      // chain generated on the GPU from level 0
+        bool mips_pending = false;  // gpu_mips: level 0 is up, the chain is not
+        DecodedTexture decoded;     // kept until every level is uploaded
+        uint32_t generation = 0;    // bumped by every reload, older decodes are dropped
+        // the version before a reload, bound until the new one is resident
+        SDL_GPUTexture* previous = nullptr;
+        uint32_t previous_level = 0;
+        uint64_t previous_bytes = 0;
+    };
+
+    void Integrate(DecodedTexture& decoded);
+    void StreamLevels();
+    void Evict();
+    void Release(Entry& entry);
+    void ReleasePrevious(Entry& entry);
+    SDL_GPUSampler* SamplerForLevel(uint32_t level);
+
+    SDL_GPUDevice* device;
+    UploadRing* uploads;
+    Settings settings;
+    TextureDecoder decoder;
+
+    // entries never move, a handle is their slot
+    mem::Pool<Entry> entries{ mem::CATEGORY_TEXTURE };
+    std::unordered_map<std::string, TextureHandle> by_path;
+    std::vector<DecodedTexture> decoded;
+    std::vector<TextureHandle> gpu_mip_queue;
+
+    // trilinear samplers with min_lod at each level, created on first use
+    static const uint32_t kMaxLevels = 16;
+    SDL_GPUSampler* samplers[kMaxLevels] = {};
+    SDL_GPUTexture* fallback = nullptr;
+
+    uint64_t frame = 0;
+    Stats stats;
+};
@@ -0,0 +1,330 @@
+#include "upload_ring.h"
+
+#include <SDL3/SDL.h>
+
+static inline uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// ---------------------------------------------------------------------------
+// SDL backend
+
+SDL_GPUTransferBuffer* SDLUploadBackend::CreateStaging(uint32_t size)
+{
+    SDL_GPUTransferBufferCreateInfo info{};
+    info.usage = SDL_GPU_TRANSFERBUFFERUSAGE_UPLOAD;
+    info.size = size;
+    return SDL_CreateGPUTransferBuffer(device, &info);
+}
+
+void SDLUploadBackend::ReleaseStaging(SDL_GPUTransferBuffer* buffer)
+{
+    SDL_ReleaseGPUTransferBuffer(device, buffer);
+}
+
+uint8_t* SDLUploadBackend::Map(SDL_GPUTransferBuffer* buffer)
+{
+    // never cycle: the ring itself guarantees the regions written are not in use
+    return (uint8_t*)SDL_MapGPUTransferBuffer(device, buffer, false);
+}
+
+void SDLUploadBackend::Unmap(SDL_GPUTransferBuffer* buffer)
+{
+    SDL_UnmapGPUTransferBuffer(device, buffer);
+}
+
+void SDLUploadBackend::BeginCopyPass(SDL_GPUCommandBuffer* command_buffer)
+{
+    copy_pass = SDL_BeginGPUCopyPass(command_buffer);
+}
+
+void SDLUploadBackend::CopyToBuffer(const SDL_GPUTransferBufferLocation& source, const SDL_GPUBufferRegion& destination, bool cycle)
+{
+    SDL_UploadToGPUBuffer(copy_pass, &source, &destination, cycle);
+}
+
+void SDLUploadBackend::CopyToTexture(const SDL_GPUTextureTransferInfo& source, const SDL_GPUTextureRegion& destination, bool cycle)
+{
+    SDL_UploadToGPUTexture(copy_pass, &source, &destination, cycle);
+}
+
+void SDLUploadBackend::EndCopyPass()
+{
+    SDL_EndGPUCopyPass(copy_pass);
+    copy_pass = nullptr;
+}
+
+bool SDLUploadBackend::IsSignaled(SDL_GPUFence* fence)
+{
+    return SDL_QueryGPUFence(device, fence);
+}
+
+void SDLUploadBackend::Wait(SDL_GPUFence* fence)
+{
+    SDL_WaitForGPUFences(device, true, &fence, 1);
+}
+
+void SDLUploadBackend::ReleaseFence(SDL_GPUFence* fence)
+{
+    SDL_ReleaseGPUFence(device, fence);
+}
+
+// ---------------------------------------------------------------------------
+// ring
+
+UploadRing::UploadRing(UploadBackend* _backend, uint32_t _capacity)
+    : backend(_backend)
+{
+    // keep wrap points aligned for any alignment we hand out
+    capacity = (uint32_t)AlignUp(_capacity, 256);
+    ring = backend->CreateStaging(capacity);
+}
+
+UploadRing::~UploadRing()
+{
+    if (mapped)
+        backend->Unmap(ring);
+    for (SDL_GPUTransferBuffer* buffer : overflow_mapped)
+        backend->Unmap(buffer);
+
+    WaitIdle();
+
+    // anything still queued was never submitted
+    for (SDL_GPUTransferBuffer* buffer : overflow)
+        backend->ReleaseStaging(buffer);
+    backend->ReleaseStaging(ring);
+}
+
+void UploadRing::BeginFrame()
+{
+    Retire(false);
+}
+
+bool UploadRing::TryAllocate(uint32_t size, uint32_t alignment, uint64_t& position)
+{
+    uint64_t start = AlignUp(head, alignment);
+
+    // a region never straddles the end of the buffer, skip the remainder and wrap
+    uint64_t offset = start % capacity;
+    if (offset + size > capacity)
+        start += capacity - offset;
+
+    if (start + size - tail > capacity)
+        return false;
+
+    head = start + size;
+    position = start;
+    return true;
+}
+
+UploadRing::Allocation UploadRing::Allocate(uint32_t size, uint32_t alignment)
+{
+    Allocation allocation;
+    if (size == 0)
+        return allocation;
+
+    SDL_assert(alignment && (alignment & (alignment - 1)) == 0 && alignment <= 256);
+
+    // requests that would hog the ring go to a dedicated buffer instead of
+    // stalling on every frame in flight
+    uint64_t position = 0;
+    bool in_ring = size <= capacity / 4;
+    if (in_ring)
+    {
+        while (!TryAllocate(size, alignment, position))
+        {
+            if (frames.empty())
+            {
+                // the current frame alone filled the ring
+                in_ring = false;
+                break;
+            }
+            stats.stalls++;
+            Retire(true);
+        }
+    }
+
+    if (in_ring)
+    {
+        if (!mapped)
+            mapped = backend->Map(ring);
+        if (!mapped)
+            return allocation;
+
+        allocation.buffer = ring;
+        allocation.offset = (uint32_t)(position % capacity);
+        allocation.data = mapped + allocation.offset;
+    }
+    else
+    {
+        SDL_GPUTransferBuffer* buffer = backend->CreateStaging(size);
+        uint8_t* data = buffer ? backend->Map(buffer) : nullptr;
+        if (!data)
+        {
+            SDL_Log("UploadRing: failed to create a %u byte staging buffer", size);
+            if (buffer)
+                backend->ReleaseStaging(buffer);
+            return allocation;
+        }
+        overflow.push_back(buffer);
+        overflow_mapped.push_back(buffer);
+
+        allocation.buffer = buffer;
+        allocation.offset = 0;
+        allocation.data = data;
+        stats.overflow_allocations++;
+        stats.overflow_bytes += size;
+    }
+
+    allocation.size = size;
+    stats.allocations++;
+    stats.bytes += size;
+    return allocation;
+}
+
+void UploadRing::CopyToBuffer(const Allocation& source, SDL_GPUBuffer* destination, uint32_t destination_offset, bool cycle)
+{
+    PendingCopy copy{};
+    copy.source = source.buffer;
+    copy.source_offset = source.offset;
+    copy.size = source.size;
+    copy.buffer = destination;
+    copy.buffer_offset = destination_offset;
+    copy.cycle = cycle;
+    copies.push_back(copy);
+}
+
+void UploadRing::CopyToTexture(const Allocation& source, const SDL_GPUTextureRegion& destination, bool cycle)
+{
+    PendingCopy copy{};
+    copy.source = source.buffer;
+    copy.source_offset = source.offset;
+    copy.size = source.size;
+    copy.region = destination;
+    copy.cycle = cycle;
+    copies.push_back(copy);
+}
+
+bool UploadRing::UploadToBuffer(const void* data, uint32_t size, SDL_GPUBuffer* destination, uint32_t destination_offset, bool cycle)
+{
+    Allocation allocation = Allocate(size, 16);
+    if (!allocation.IsValid())
+        return false;
+    SDL_memcpy(allocation.data, data, size);
+    CopyToBuffer(allocation, destination, destination_offset, cycle);
+    return true;
+}
+
+bool UploadRing::UploadToTexture(const void* data, uint32_t size, const SDL_GPUTextureRegion& destination, bool cycle)
+{
+    Allocation allocation = Allocate(size, 16);
+    if (!allocation.IsValid())
+        return false;
+    SDL_memcpy(allocation.data, data, size);
+    CopyToTexture(allocation, destination, cycle);
+    return true;
+}
+
+void UploadRing::Flush(SDL_GPUCommandBuffer* command_buffer)
+{
+    // copy passes read the staging memory, it has to be unmapped first
+    if (mapped)
+    {
+        backend->Unmap(ring);
+        mapped = nullptr;
+    }
+    for (SDL_GPUTransferBuffer* buffer : overflow_mapped)
+        backend->Unmap(buffer);
+    overflow_mapped.clear();
+
+    if (copies.empty())
+        return;
+
+    backend->BeginCopyPass(command_buffer);
+    for (const PendingCopy& copy : copies)
+    {
+        if (copy.buffer)
+        {
+            SDL_GPUTransferBufferLocation source{};
+            source.transfer_buffer = copy.source;
+            source.offset = copy.source_offset;
+            SDL_GPUBufferRegion destination{};
+            destination.buffer = copy.buffer;
+            destination.offset = copy.buffer_offset;
+            destination.size = copy.size;
+            backend->CopyToBuffer(source, destination, copy.cycle);
+        }
+        else
+        {
+            // tightly packed rows
+            SDL_GPUTextureTransferInfo source{};
+            source.transfer_buffer = copy.source;
+            source.offset = copy.source_offset;
+            backend->CopyToTexture(source, copy.region, copy.cycle);
+        }
+    }
+    backend->EndCopyPass();
+
+    stats.copies += copies.size();
+    stats.copy_passes++;
+    copies.clear();
+}
+
+void UploadRing::EndFrame(SDL_GPUFence* fence)
+{
+    SDL_assert(copies.empty() && "Flush the ring before ending the frame");
+
+    if (!fence)
+    {
+        // nothing can be recycled without a fence, only fine when nothing was used
+        if (head != frame_start || !overflow.empty())
+            SDL_Log("UploadRing: frame ended without a fence, its staging memory is leaked");
+        frame_start = head;
+        return;
+    }
+
+    InFlightFrame frame;
+    frame.fence = fence;
+    frame.end = head;
+    frame.overflow.swap(overflow);
+    frames.push_back(std::move(frame));
+    frame_start = head;
+}
+
+void UploadRing::Retire(bool wait)
+{
+    while (!frames.empty())
+    {
+        InFlightFrame& frame = frames.front();
+        if (!backend->IsSignaled(frame.fence))
+        {
+            if (!wait)
+                break;
+            backend->Wait(frame.fence);
+        }
+
+        tail = frame.end;
+        for (SDL_GPUTransferBuffer* buffer : frame.overflow)
+            backend->ReleaseStaging(buffer);
+        backend->ReleaseFence(frame.fence);
+        frames.pop_front();
+
+        // a blocking retire only needs to free the oldest frame
+        if (wait)
+            break;
+    }
+}
+
+void UploadRing::WaitFrames(size_t max_frames)
+{
+    Retire(false);
+    while (frames.size() > max_frames)
+        Retire(true);
+}
+
+void UploadRing::WaitIdle()
+{
+    while (!frames.empty())
+        Retire(true);
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <deque>
+#include <vector>
+
+// Everything the upload ring needs from the GPU. SDLUploadBackend talks to a
+// real device, tools can plug in a fake to exercise the allocation and fence
+// recycling logic headless.
+class UploadBackend
+{
+public:
+    virtual ~UploadBackend() = default;
+
+    virtual SDL_GPUTransferBuffer* CreateStaging(uint32_t size) = 0;
+    virtual void ReleaseStaging(SDL_GPUTransferBuffer* buffer) = 0;
+    virtual uint8_t* Map(SDL_GPUTransferBuffer* buffer) = 0;
+    virtual void Unmap(SDL_GPUTransferBuffer* buffer) = 0;
+
+    virtual void BeginCopyPass(SDL_GPUCommandBuffer* command_buffer) = 0;
+    virtual void CopyToBuffer(const SDL_GPUTransferBufferLocation& source, const SDL_GPUBufferRegion& destination, bool cycle) = 0;
+    virtual void CopyToTexture(const SDL_GPUTextureTransferInfo& source, const SDL_GPUTextureRegion& destination, bool cycle) = 0;
+    virtual void EndCopyPass() = 0;
+
+    virtual bool IsSignaled(SDL_GPUFence* fence) = 0;
+    virtual void Wait(SDL_GPUFence* fence) = 0;
+    virtual void ReleaseFence(SDL_GPUFence* fence) = 0;
+};
+
+class SDLUploadBackend : public UploadBackend
+{
+    SDL_GPUDevice* device;
+    SDL_GPUCopyPass* copy_pass = nullptr;
+public:
+    explicit SDLUploadBackend(SDL_GPUDevice* _device) : device(_device) {}
+
+    SDL_GPUTransferBuffer* CreateStaging(uint32_t size) override;
+    void ReleaseStaging(SDL_GPUTransferBuffer* buffer) override;
+    uint8_t* Map(SDL_GPUTransferBuffer* buffer) override;
+    void Unmap(SDL_GPUTransferBuffer* buffer) override;
+
+    void BeginCopyPass(SDL_GPUCommandBuffer* command_buffer) override;
+    void CopyToBuffer(const SDL_GPUTransferBufferLocation& source, const SDL_GPUBufferRegion& destination, bool cycle) override;
+    void CopyToTexture(const SDL_GPUTextureTransferInfo& source, const SDL_GPUTextureRegion& destination, bool cycle) override;
+    void EndCopyPass() override;
+
+    bool IsSignaled(SDL_GPUFence* fence) override;
+    void Wait(SDL_GPUFence* fence) override;
+    void ReleaseFence(SDL_GPUFence* fence) override;
+};
+
+// Frame-pipelined staging allocator. One persistent transfer buffer is used as
+// a ring: every frame sub-allocates aligned regions at the head, and the space
+// is recycled once the fence of the submission that consumed it signals. All
+// copies queued in a frame are recorded into a single copy pass by Flush.
+// Requests too large for the ring get a dedicated staging buffer that is
+// released with the frame.
+class UploadRing
+{
+public:
+    struct Allocation
+    {
+        uint8_t* data = nullptr;
+        SDL_GPUTransferBuffer* buffer = nullptr;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+
+        bool IsValid() const { return data != nullptr; }
+    };
+
+    struct Stats
+    {
+        uint64_t bytes = 0;
+        uint64_t allocations = 0;
+        uint64_t copies = 0;
+        uint64_t copy_passes = 0;
+        uint64_t overflow_allocations = 0;
+        uint64_t overflow_bytes = 0;
+        uint64_t stalls = 0;            // allocations that had to wait on a fence
+    };
+
+    UploadRing(UploadBackend* _backend, uint32_t _capacity);
+    ~UploadRing();
+
+    UploadRing(const UploadRing&) = delete;
+    UploadRing& operator=(const UploadRing&) = delete;
+
+    // Recycles the space of every frame whose fence has signaled, never blocks.
+    void BeginFrame();
+
+    // Staging memory the caller fills directly, valid until Flush.
+    Allocation Allocate(uint32_t size, uint32_t alignment = 16);
+    void CopyToBuffer(const Allocation& source, SDL_GPUBuffer* destination, uint32_t destination_offset, bool cycle = false);
+    void CopyToTexture(const Allocation& source, const SDL_GPUTextureRegion& destination, bool cycle = false);
+
+    // Allocate + memcpy + queue the copy.
+    bool UploadToBuffer(const void* data, uint32_t size, SDL_GPUBuffer* destination, uint32_t destination_offset = 0, bool cycle = false);
+    bool UploadToTexture(const void* data, uint32_t size, const SDL_GPUTextureRegion& destination, bool cycle = false);
+
+    bool HasPendingCopies() const { return !copies.empty(); }
+
+    // Records every copy queued since the last flush into one copy pass.
+    void Flush(SDL_GPUCommandBuffer* command_buffer);
+
+    // Fence of the submission containing this frame's copies, the ring takes ownership.
+    void EndFrame(SDL_GPUFence* fence);
+
+    // Recycles like BeginFrame, then blocks until at most max_frames frames are in flight.
+    void WaitFrames(size_t max_frames);
+
+    // Blocks until every in-flight frame has retired.
+    void WaitIdle();
+
+    const Stats& GetStats() const { return stats; }
+    uint32_t Capacity() const { return capacity; }
+    uint64_t BytesInFlight() const { return head - tail; }
+    size_t FramesInFlight() const { return frames.size(); }
+
+private:
+    struct PendingCopy
+    {
+        SDL_GPUTransferBuffer* source;
+        uint32_t source_offset;
+        uint32_t size;
+        SDL_GPUBuffer* buffer;          // null for texture copies
+        uint32_t buffer_offset;
+        SDL_GPUTextureRegion region;
+        bool cycle;
+    };
+
+    struct InFlightFrame
+    {
+        SDL_GPUFence* fence;
+        uint64_t end;                   // ring head when the frame ended
+        std::vector<SDL_GPUTransferBuffer*> overflow;
+    };
+
+    bool TryAllocate(uint32_t size, uint32_t alignment, uint64_t& position);
+    void Retire(bool wait);
+
+    UploadBackend* backend;
+    SDL_GPUTransferBuffer* ring = nullptr;
+    uint8_t* mapped = nullptr;
+    uint32_t capacity;
+
+    // monotonically increasing byte positions, the ring offset is position % capacity
+    uint64_t head = 0;
+    uint64_t tail = 0;
+    uint64_t frame_start = 0;
+
+    std::deque<InFlightFrame> frames;
+    std::vector<PendingCopy> copies;
+    std::vector<SDL_GPUTransferBuffer*> overflow;
+    std::vector<SDL_GPUTransferBuffer*> overflow_mapped;
+    Stats stats;
+};
@@ -0,0 +1,355 @@
+#include "vertex_format.h"
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <cstddef>
+
+namespace vtx
+{
+    const Element* Layout::Find(Attribute attribute) const
+    {
+        for (uint32_t i = 0; i < element_count; i++)
+        {
+            if (elements[i].attribute == attribute)
+                return &elements[i];
+        }
+        return nullptr;
+    }
+
+    Layout MakeLayout(LayoutId id, bool skinned)
+    {
+        Layout layout;
+        layout.id = id;
+        layout.skinned = skinned;
+        auto add = [&layout](Attribute attribute, Encoding encoding, uint32_t offset)
+        {
+            layout.elements[layout.element_count++] = { attribute, encoding, offset };
+            layout.stride = SDL_max(layout.stride, offset + EncodingSize(encoding));
+        };
+
+        if (id == LAYOUT_COMPACT)
+        {
+            add(ATTRIBUTE_POSITION, ENCODING_UNORM16X4, 0);
+            add(ATTRIBUTE_NORMAL, ENCODING_OCT16, 8);
+            add(ATTRIBUTE_TEXCOORD, ENCODING_HALF2, 12);
+            if (skinned)
+            {
+                add(ATTRIBUTE_JOINTS, ENCODING_UINT8X4, 16);
+                add(ATTRIBUTE_WEIGHTS, ENCODING_UNORM8X4, 20);
+            }
+        }
+        else
+        {
+            // Vertex as it is, the skin stream appended
+            add(ATTRIBUTE_POSITION, ENCODING_FLOAT3, offsetof(Vertex, position));
+            add(ATTRIBUTE_NORMAL, ENCODING_FLOAT3, offsetof(Vertex, normal));
+            add(ATTRIBUTE_TEXCOORD, ENCODING_FLOAT2, offsetof(Vertex, tex_coords));
+            if (skinned)
+            {
+                add(ATTRIBUTE_JOINTS, ENCODING_UINT8X4, sizeof(Vertex));
+                add(ATTRIBUTE_WEIGHTS, ENCODING_FLOAT4, sizeof(Vertex) + 4);
+            }
+        }
+        return layout;
+    }
+
+    const char* LayoutName(LayoutId id)
+    {
+        switch (id)
+        {
+        case LAYOUT_FULL: return "full";
+        case LAYOUT_COMPACT: return "compact";
+        default: return "unknown";
+        }
+    }
+
+    uint32_t EncodingSize(Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case ENCODING_FLOAT2: return 8;
+        case ENCODING_FLOAT3: return 12;
+        case ENCODING_FLOAT4: return 16;
+        case ENCODING_UNORM16X4: return 8;
+        case ENCODING_OCT16: return 4;
+        case ENCODING_HALF2: return 4;
+        case ENCODING_UINT8X4: return 4;
+        case ENCODING_UNORM8X4: return 4;
+        }
+        return 0;
+    }
+
+    SDL_GPUVertexElementFormat ElementFormat(Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case ENCODING_FLOAT2: return SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2;
+        case ENCODING_FLOAT3: return SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3;
+        case ENCODING_FLOAT4: return SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4;
+        case ENCODING_UNORM16X4: return SDL_GPU_VERTEXELEMENTFORMAT_USHORT4_NORM;
+        case ENCODING_OCT16: return SDL_GPU_VERTEXELEMENTFORMAT_SHORT2_NORM;
+        case ENCODING_HALF2: return SDL_GPU_VERTEXELEMENTFORMAT_HALF2;
+        case ENCODING_UINT8X4: return SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4;
+        case ENCODING_UNORM8X4: return SDL_GPU_VERTEXELEMENTFORMAT_UBYTE4_NORM;
+        }
+        return SDL_GPU_VERTEXELEMENTFORMAT_INVALID;
+    }
+
+    uint32_t BuildAttributes(const Layout& layout, uint32_t buffer_slot, SDL_GPUVertexAttribute* attributes)
+    {
+        for (uint32_t i = 0; i < layout.element_count; i++)
+        {
+            const Element& element = layout.elements[i];
+            attributes[i].location = (Uint32)element.attribute;
+            attributes[i].buffer_slot = buffer_slot;
+            attributes[i].format = ElementFormat(element.encoding);
+            attributes[i].offset = element.offset;
+        }
+        return layout.element_count;
+    }
+
+    Quantization ComputeQuantization(const Vertex* vertices, size_t count)
+    {
+        Quantization quantization;
+        if (count == 0)
+            return quantization;
+
+        glm::vec3 lo = vertices[0].position, hi = vertices[0].position;
+        for (size_t i = 1; i < count; i++)
+        {
+            lo = glm::min(lo, vertices[i].position);
+            hi = glm::max(hi, vertices[i].position);
+        }
+        quantization.offset = lo;
+        quantization.scale = hi - lo;
+        return quantization;
+    }
+
+    static glm::vec2 OctProject(const glm::vec3& n)
+    {
+        glm::vec3 v = n / (fabsf(n.x) + fabsf(n.y) + fabsf(n.z));
+        if (v.z < 0.0f)
+        {
+            // fold the lower hemisphere over the diagonals
+            glm::vec2 folded((1.0f - fabsf(v.y)) * (v.x >= 0.0f ? 1.0f : -1.0f), (1.0f - fabsf(v.x)) * (v.y >= 0.0f ? 1.0f : -1.0f));
+            return folded;
+        }
+        return glm::vec2(v.x, v.y);
+    }
+
+    void OctEncode(const glm::vec3& n, int16_t out[2])
+    {
+        float length = glm::length(n);
+        if (length <= 0.0f)
+        {
+            out[0] = out[1] = 0;
+            return;
+        }
+
+        // of the four grid points around the projection keep the one decoding closest to n
+        glm::vec3 unit = n / length;
+        glm::vec2 p = OctProject(unit) * 32767.0f;
+        float best = -2.0f;
+        for (int i = 0; i < 4; i++)
+        {
+            int16_t candidate[2] = {
+                (int16_t)SDL_clamp((i & 1) ? ceilf(p.x) : floorf(p.x), -32767.0f, 32767.0f),
+                (int16_t)SDL_clamp((i & 2) ? ceilf(p.y) : floorf(p.y), -32767.0f, 32767.0f),
+            };
+            float similarity = glm::dot(OctDecode(candidate), unit);
+            if (similarity > best)
+            {
+                best = similarity;
+                out[0] = candidate[0];
+                out[1] = candidate[1];
+            }
+        }
+    }
+
+    glm::vec3 OctDecode(const int16_t in[2])
+    {
+        // snorm decode like the vertex fetch does
+        glm::vec3 n(SDL_max(in[0] / 32767.0f, -1.0f), SDL_max(in[1] / 32767.0f, -1.0f), 0.0f);
+        n.z = 1.0f - fabsf(n.x) - fabsf(n.y);
+        float t = SDL_max(-n.z, 0.0f);
+        n.x += n.x >= 0.0f ? -t : t;
+        n.y += n.y >= 0.0f ? -t : t;
+        return glm::normalize(n);
+    }
+
+    uint16_t FloatToHalf(float value)
+    {
+        uint32_t bits;
+        SDL_memcpy(&bits, &value, sizeof(bits));
+        uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+        uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        if (magnitude >= 0x7F800000)
+            return sign | (magnitude > 0x7F800000 ? 0x7E00 : 0x7C00);   // NaN stays NaN
+        if (magnitude >= 0x477FF000)
+            return sign | 0x7C00;                                       // rounds past 65504
+        if (magnitude < 0x38800000)
+        {
+            // subnormal half, steps of 2^-24
+            float f;
+            SDL_memcpy(&f, &magnitude, sizeof(f));
+            return sign | (uint16_t)lrintf(f * 16777216.0f);
+        }
+
+        // rebias the exponent, round the dropped mantissa bits to nearest even
+        uint32_t half = (magnitude - 0x38000000) >> 13;
+        uint32_t rest = magnitude & 0x1FFF;
+        if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+            half++;
+        return sign | (uint16_t)half;
+    }
+
+    float HalfToFloat(uint16_t value)
+    {
+        uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+        uint32_t exponent = (value >> 10) & 0x1F;
+        uint32_t mantissa = value & 0x3FF;
+
+        uint32_t bits;
+        if (exponent == 0)
+        {
+            float f = mantissa / 16777216.0f;
+            return sign ? -f : f;
+        }
+        if (exponent == 31)
+            bits = sign | 0x7F800000 | (mantissa << 13);
+        else
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+        float f;
+        SDL_memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    static void EncodeWeights(const float weights[4], uint8_t out[4])
+    {
+        // round each, then hand the rounding error to the largest so the sum stays exactly 255
+        int sum = 0, largest = 0;
+        for (int k = 0; k < 4; k++)
+        {
+            out[k] = (uint8_t)lrintf(SDL_clamp(weights[k], 0.0f, 1.0f) * 255.0f);
+            sum += out[k];
+            if (weights[k] > weights[largest])
+                largest = k;
+        }
+        out[largest] = (uint8_t)SDL_clamp(out[largest] + 255 - sum, 0, 255);
+    }
+
+    void Encode(const Layout& layout, const Quantization& quantization, const Vertex* vertices, const VertexSkin* skin, size_t count, uint8_t* out)
+    {
+        glm::vec3 inverse_scale;
+        for (int k = 0; k < 3; k++)
+            inverse_scale[k] = quantization.scale[k] > 0.0f ? 1.0f / quantization.scale[k] : 0.0f;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            const Vertex& v = vertices[i];
+            uint8_t* dst = out + i * layout.stride;
+            for (uint32_t e = 0; e < layout.element_count; e++)
+            {
+                const Element& element = layout.elements[e];
+                uint8_t* field = dst + element.offset;
+                switch (element.encoding)
+                {
+                case ENCODING_FLOAT2:
+                    SDL_memcpy(field, &v.tex_coords, 8);
+                    break;
+                case ENCODING_FLOAT3:
+                    SDL_memcpy(field, element.attribute == ATTRIBUTE_POSITION ? &v.position : &v.normal, 12);
+                    break;
+                case ENCODING_FLOAT4:
+                    SDL_memcpy(field, skin[i].weights, 16);
+                    break;
+                case ENCODING_UNORM16X4:
+                {
+                    glm::vec3 t = (v.position - quantization.offset) * inverse_scale;
+                    uint16_t q[4] = { 0, 0, 0, 0xFFFF };
+                    for (int k = 0; k < 3; k++)
+                        q[k] = (uint16_t)lrintf(SDL_clamp(t[k], 0.0f, 1.0f) * 65535.0f);
+                    SDL_memcpy(field, q, sizeof(q));
+                    break;
+                }
+                case ENCODING_OCT16:
+                {
+                    int16_t q[2];
+                    OctEncode(v.normal, q);
+                    SDL_memcpy(field, q, sizeof(q));
+                    break;
+                }
+                case ENCODING_HALF2:
+                {
+                    uint16_t q[2] = { FloatToHalf(v.tex_coords.x), FloatToHalf(v.tex_coords.y) };
+                    SDL_memcpy(field, q, sizeof(q));
+                    break;
+                }
+                case ENCODING_UINT8X4:
+                    SDL_memcpy(field, skin[i].joints, 4);
+                    break;
+                case ENCODING_UNORM8X4:
+                    EncodeWeights(skin[i].weights, field);
+                    break;
+                }
+            }
+        }
+    }
+
+    void Decode(const Layout& layout, const Quantization& quantization, const uint8_t* data, size_t count, Vertex* vertices, VertexSkin* skin)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            Vertex& v = vertices[i];
+            v = Vertex{};
+            const uint8_t* src = data + i * layout.stride;
+            for (uint32_t e = 0; e < layout.element_count; e++)
+            {
+                const Element& element = layout.elements[e];
+                const uint8_t* field = src + element.offset;
+                switch (element.encoding)
+                {
+                case ENCODING_FLOAT2:
+                    SDL_memcpy(&v.tex_coords, field, 8);
+                    break;
+                case ENCODING_FLOAT3:
+                    SDL_memcpy(element.attribute == ATTRIBUTE_POSITION ? &v.position : &v.normal, field, 12);
+                    break;
+                case ENCODING_FLOAT4:
+                    SDL_memcpy(skin[i].weights, field, 16);
+                    break;
+                case ENCODING_UNORM16X4:
+                {
+                    uint16_t q[4];
+                    SDL_memcpy(q, field, sizeof(q));
+                    v.position = quantization.offset + glm::vec3(q[0], q[1], q[2]) / 65535.0f * quantization.scale;
+                    break;
+                }
+                case ENCODING_OCT16:
+                {
+                    int16_t q[2];
+                    SDL_memcpy(q, field, sizeof(q));
+                    v.normal = OctDecode(q);
+                    break;
+                }
+                case ENCODING_HALF2:
+                {
+                    uint16_t q[2];
+                    SDL_memcpy(q, field, sizeof(q));
+                    v.tex_coords = glm::vec2(HalfToFloat(q[0]), HalfToFloat(q[1]));
+                    break;
+                }
+                case ENCODING_UINT8X4:
+                    SDL_memcpy(skin[i].joints, field, 4);
+                    break;
+                case ENCODING_UNORM8X4:
+                    for (int k = 0; k < 4; k++)
+                        skin[i].weights[k] = field[k] / 255.0f;
+                    break;
+                }
+            }
+        }
+    }
+}
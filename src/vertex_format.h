@@ -0,0 +1,93 @@
+#pragma once
+
+#include <SDL3/SDL_gpu.h>
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "mesh.h"
+
+// GPU vertex layouts. The full layout is Vertex as it is, the compact one
+// halves it: positions as 16-bit unorm relative to the mesh bounds, normals
+// octahedral in 2x16-bit snorm, texture coordinates as half floats, and for
+// skinned meshes 8-bit joint indices and 8-bit unorm weights.
+//
+// Attributes always sit at the same shader location, so a vertex shader for a
+// layout only has to declare the inputs it reads. Quantized positions decode
+// as offset + a_position.xyz * scale with the mesh's Quantization, see
+// res/shaders/code/instancedpacked.vert.
+namespace vtx
+{
+    enum Attribute
+    {
+        ATTRIBUTE_POSITION,     // location 0
+        ATTRIBUTE_TEXCOORD,     // location 1
+        ATTRIBUTE_NORMAL,       // location 2
+        ATTRIBUTE_JOINTS,       // location 3
+        ATTRIBUTE_WEIGHTS,      // location 4
+        ATTRIBUTE_COUNT,
+    };
+
+    enum Encoding
+    {
+        ENCODING_FLOAT2,
+        ENCODING_FLOAT3,
+        ENCODING_FLOAT4,
+        ENCODING_UNORM16X4,     // position relative to the bounds, w = 1
+        ENCODING_OCT16,         // unit vector, octahedral snorm16 x2
+        ENCODING_HALF2,
+        ENCODING_UINT8X4,
+        ENCODING_UNORM8X4,      // weights, rounded so they still sum to 1
+    };
+
+    enum LayoutId : uint32_t
+    {
+        LAYOUT_FULL,            // 32 bytes, 52 skinned
+        LAYOUT_COMPACT,         // 16 bytes, 24 skinned
+        LAYOUT_COUNT,
+    };
+
+    struct Element
+    {
+        Attribute attribute;
+        Encoding encoding;
+        uint32_t offset;
+    };
+
+    struct Layout
+    {
+        LayoutId id = LAYOUT_FULL;
+        bool skinned = false;
+        uint32_t stride = 0;
+        uint32_t element_count = 0;
+        Element elements[ATTRIBUTE_COUNT] = {};
+
+        const Element* Find(Attribute attribute) const;
+    };
+
+    // position = offset + unorm * scale, the mesh bounds
+    struct Quantization
+    {
+        glm::vec3 offset = glm::vec3(0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+    };
+
+    Layout MakeLayout(LayoutId id, bool skinned);
+    const char* LayoutName(LayoutId id);
+    uint32_t EncodingSize(Encoding encoding);
+    SDL_GPUVertexElementFormat ElementFormat(Encoding encoding);
+
+    // the SDL attribute list for one interleaved buffer, returns the number written (at most ATTRIBUTE_COUNT)
+    uint32_t BuildAttributes(const Layout& layout, uint32_t buffer_slot, SDL_GPUVertexAttribute* attributes);
+
+    Quantization ComputeQuantization(const Vertex* vertices, size_t count);
+
+    // count vertices into layout.stride * count bytes. skin is read for skinned layouts only
+    void Encode(const Layout& layout, const Quantization& quantization, const Vertex* vertices, const VertexSkin* skin, size_t count, uint8_t* out);
+    // the inverse, for measuring the error. skin is written for skinned layouts only
+    void Decode(const Layout& layout, const Quantization& quantization, const uint8_t* data, size_t count, Vertex* vertices, VertexSkin* skin);
+
+    void OctEncode(const glm::vec3& n, int16_t out[2]);
+    glm::vec3 OctDecode(const int16_t in[2]);
+    uint16_t FloatToHalf(float value);
+    float HalfToFloat(uint16_t value);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Chase-Lev work stealing deque (Le et al., "Correct and Efficient Work-Stealing
+// for Weak Memory Models"). The owning thread pushes and pops at the bottom,
+// any other thread steals from the top. Fixed capacity; Push fails when full.
+template<typename T, uint32_t Capacity>
+class WorkStealingQueue
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+    alignas(64) std::atomic<int64_t> top{ 0 };
+    alignas(64) std::atomic<int64_t> bottom{ 0 };
+    alignas(64) std::atomic<T*> buffer[Capacity];
+public:
+    WorkStealingQueue()
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+            buffer[i].store(nullptr, std::memory_order_relaxed);
+    }
+
+    // owner only
+    bool Push(T* item)
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= (int64_t)Capacity)
+            return false;
+
+        buffer[b & (Capacity - 1)].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // owner only
+    T* Pop()
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b)
+        {
+            // empty
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        T* item = buffer[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b)
+        {
+            // last item, race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // any thread
+    T* Steal()
+    {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+
+        T* item = buffer[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    int64_t Size() const
+    {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+};
@@ -0,0 +1,220 @@
+// alloc_bench: heap traffic of a scene load and of per-frame scratch, with and without arenas.
+//
+// Usage: alloc_bench [--meshes N] [--levels L] [--frames F]
+//
+// Loads a synthetic scene of N meshes L times the way model::LoadModel does
+// (per-mesh working copies, vertex dedup, Mesh packing with a few textures),
+// once on the plain heap and once with a scratch arena for the working copies
+// and an asset arena holding every Mesh of the level, reset in one go when
+// the level unloads. Every operator new in the process is counted, so the
+// numbers include std::string and the optimizer's own temporaries. The frame
+// part allocates a few thousand small scratch arrays per frame, from the heap
+// and from a frame arena reset at the end of every frame.
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "memory.h"
+#include "mesh.h"
+#include "mesh_optimizer.h"
+
+static std::atomic<uint64_t> g_allocations{ 0 };
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    size_t align = (size_t)alignment;
+    if (void* ptr = std::aligned_alloc(align, (size + align - 1) / align * align))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { std::free(ptr); }
+
+struct SourceMesh
+{
+    uint32_t grid;
+    std::string directory;
+};
+
+// unindexed grid soup like an OBJ import, then deduplicated and packed into a Mesh
+static void LoadMesh(const SourceMesh& source, std::pmr::memory_resource* scratch, std::pmr::memory_resource* assets, std::vector<Mesh>& meshes)
+{
+    static const char* kTypes[] = { "texture_diffuse", "texture_specular", "texture_normal" };
+
+    uint32_t grid = source.grid;
+    std::pmr::vector<Vertex> vertices(scratch);
+    std::pmr::vector<uint32_t> indices(scratch);
+    vertices.reserve((size_t)grid * grid * 6);
+    indices.reserve((size_t)grid * grid * 6);
+    for (uint32_t y = 0; y < grid; y++)
+    {
+        for (uint32_t x = 0; x < grid; x++)
+        {
+            const uint32_t corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+            for (const uint32_t* c : corners)
+            {
+                Vertex v{};
+                v.position = glm::vec3((float)(x + c[0]), (float)(y + c[1]), 0.0f);
+                v.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                v.tex_coords = glm::vec2(v.position.x / grid, v.position.y / grid);
+                indices.push_back((uint32_t)vertices.size());
+                vertices.push_back(v);
+            }
+        }
+    }
+    size_t unique = optimizer::DeduplicateVertices(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size());
+    vertices.resize(unique);
+
+    std::pmr::vector<Texture> textures(scratch);
+    for (const char* type : kTypes)
+    {
+        Texture texture{};
+        texture.type = type;
+        texture.path = source.directory + type + ".png";
+        textures.push_back(texture);
+    }
+    meshes.emplace_back(vertices, indices, textures, assets);
+}
+
+struct LoadResult
+{
+    double load_ms = 0.0;
+    double unload_ms = 0.0;
+    uint64_t allocations = 0;
+    size_t vertices = 0;
+};
+
+static LoadResult LoadLevels(const std::vector<SourceMesh>& scene, uint32_t levels, bool arenas)
+{
+    LoadResult result;
+    mem::Arena scratch(1024 * 1024, mem::CATEGORY_IMPORT);
+    mem::Arena assets(16 * 1024 * 1024, mem::CATEGORY_MESH);
+    for (uint32_t level = 0; level < levels; level++)
+    {
+        uint64_t allocations = g_allocations.load();
+        Uint64 start = SDL_GetTicksNS();
+
+        std::vector<Mesh> meshes;
+        meshes.reserve(scene.size());
+        for (const SourceMesh& source : scene)
+        {
+            if (arenas)
+            {
+                scratch.Reset();
+                LoadMesh(source, &scratch, &assets, meshes);
+            }
+            else
+            {
+                LoadMesh(source, mem::HeapResource(mem::CATEGORY_IMPORT), mem::HeapResource(mem::CATEGORY_MESH), meshes);
+            }
+        }
+        Uint64 loaded = SDL_GetTicksNS();
+        result.allocations += g_allocations.load() - allocations;
+        for (const Mesh& mesh : meshes)
+            result.vertices += mesh.Vertices().size();
+
+        // the level goes away: with arenas the mesh destructors free nothing and Reset
+        // keeps the blocks, already faulted in, for the next level
+        meshes = std::vector<Mesh>();
+        assets.Reset();
+        // best of, the first level also pays for faulting the memory in
+        double load_ms = (loaded - start) / 1e6;
+        double unload_ms = (SDL_GetTicksNS() - loaded) / 1e6;
+        result.load_ms = level == 0 ? load_ms : SDL_min(result.load_ms, load_ms);
+        result.unload_ms = level == 0 ? unload_ms : SDL_min(result.unload_ms, unload_ms);
+    }
+    result.allocations /= levels;
+    result.vertices /= levels;
+    return result;
+}
+
+static void FrameScratch(uint32_t frames, bool arena)
+{
+    const uint32_t kArrays = 4096;
+    mem::Arena frame_arena(256 * 1024, mem::CATEGORY_FRAME);
+    std::mt19937 rng(3);
+    uint64_t sink = 0;
+
+    uint64_t allocations = g_allocations.load();
+    uint64_t steady_allocations = 0;
+    Uint64 start = SDL_GetTicksNS();
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        if (frame == 2)
+            steady_allocations = g_allocations.load();
+        for (uint32_t i = 0; i < kArrays; i++)
+        {
+            uint32_t count = 4 + rng() % 60;
+            uint32_t* values = arena ? frame_arena.AllocateArray<uint32_t>(count) : new uint32_t[count];
+            for (uint32_t k = 0; k < count; k++)
+                values[k] = k * i;
+            sink += values[count - 1];
+            if (!arena)
+                delete[] values;
+        }
+        frame_arena.Reset();
+    }
+    double ms = (SDL_GetTicksNS() - start) / 1e6 / frames;
+    uint64_t total = g_allocations.load() - allocations;
+    uint64_t steady = frames > 2 ? g_allocations.load() - steady_allocations : 0;
+    SDL_Log("  %-6s %8.3f ms/frame  %8.1f allocations/frame  %8.1f after warm-up  (%llu)", arena ? "arena" : "heap", ms,
+        (double)total / frames, frames > 2 ? (double)steady / (frames - 2) : 0.0, (unsigned long long)(sink & 1));
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t mesh_count = 20000;
+    uint32_t levels = 5;
+    uint32_t frames = 200;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--meshes") == 0)
+            mesh_count = (uint32_t)SDL_max(SDL_atoi(argv[i + 1]), 1);
+        else if (SDL_strcmp(argv[i], "--levels") == 0)
+            levels = (uint32_t)SDL_max(SDL_atoi(argv[i + 1]), 1);
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = (uint32_t)SDL_max(SDL_atoi(argv[i + 1]), 1);
+    }
+
+    // mostly small props with a few big pieces, paths long enough to defeat the small string buffer
+    std::mt19937 rng(11);
+    std::vector<SourceMesh> scene(mesh_count);
+    for (uint32_t i = 0; i < mesh_count; i++)
+    {
+        scene[i].grid = rng() % 16 == 0 ? 32 + rng() % 32 : 2 + rng() % 8;
+        scene[i].directory = "res/models/props/prop_" + std::to_string(i) + "/";
+    }
+
+    SDL_Log("%u meshes, %u levels", mesh_count, levels);
+    SDL_Log("         load ms  unload ms   allocations   vertices");
+    LoadResult heap = LoadLevels(scene, levels, false);
+    SDL_Log("  heap  %8.2f   %8.2f   %11llu   %8zu", heap.load_ms, heap.unload_ms, (unsigned long long)heap.allocations, heap.vertices);
+    LoadResult arena = LoadLevels(scene, levels, true);
+    SDL_Log("  arena %8.2f   %8.2f   %11llu   %8zu", arena.load_ms, arena.unload_ms, (unsigned long long)arena.allocations, arena.vertices);
+    SDL_Log("  %.1fx fewer allocations, load %.2fx faster", (double)heap.allocations / SDL_max(arena.allocations, 1ull),
+        heap.load_ms / SDL_max(arena.load_ms, 1e-6));
+
+    SDL_Log("per-frame scratch, %u frames", frames);
+    FrameScratch(frames, false);
+    FrameScratch(frames, true);
+
+    mem::LogCategoryStats();
+    return heap.vertices == arena.vertices ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+// anim_bake: offline model -> .skanim baker, the animation clips next to a .skmesh.
+//
+// Usage: anim_bake <model file> <output .skanim> [--force] [--translation-error E]
+//                  [--rotation-error RAD] [--scale-error E] [--chunk-seconds S]
+//
+// Imports the model's clips and stores them compressed (see clip_compression.h).
+// Skips the import when the existing output was baked from the same source
+// contents with the same settings. The error bounds are in units, radians and
+// scale; tools/clip_bench reports what they cost in accuracy and size.
+
+#include <SDL3/SDL.h>
+
+#include "anim_cache.h"
+#include "mesh_cache.h"
+#include "model.h"
+
+int main(int argc, char* argv[])
+{
+    const char* paths[2] = { nullptr, nullptr };
+    int path_count = 0;
+    bool force = false;
+    anim::CompressionSettings settings;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (SDL_strcmp(argv[i], "--translation-error") == 0 && i + 1 < argc)
+            settings.translation_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--rotation-error") == 0 && i + 1 < argc)
+            settings.rotation_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--scale-error") == 0 && i + 1 < argc)
+            settings.scale_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--chunk-seconds") == 0 && i + 1 < argc)
+            settings.chunk_seconds = (float)SDL_atof(argv[++i]);
+        else if (path_count < 2)
+            paths[path_count++] = argv[i];
+    }
+
+    if (path_count != 2)
+    {
+        SDL_Log("usage: anim_bake <model file> <output .skanim> [--force] [--translation-error E] [--rotation-error RAD] "
+            "[--scale-error E] [--chunk-seconds S]");
+        return 1;
+    }
+
+    const char* source = paths[0];
+    const char* output = paths[1];
+
+    uint64_t source_hash = meshcache::HashFile(source);
+    if (source_hash == 0)
+    {
+        SDL_Log("Cannot read %s", source);
+        return 1;
+    }
+    uint64_t settings_hash = animcache::HashSettings(settings);
+
+    if (!force)
+    {
+        animcache::AnimCache existing;
+        if (existing.Open(output) && existing.SourceHash() == source_hash && existing.SettingsHash() == settings_hash)
+        {
+            SDL_Log("%s is up to date", output);
+            return 0;
+        }
+    }
+
+    model::SkinnedModel model;
+    if (!model::LoadSkinnedModel(source, model))
+        return 1;
+
+    std::vector<animcache::BakedClip> clips(model.clips.size());
+    anim::CompressionStats total;
+    for (size_t i = 0; i < model.clips.size(); i++)
+    {
+        anim::CompressionStats stats;
+        clips[i].name = model.clips[i].name;
+        if (!anim::CompressClip(model.clips[i], settings, clips[i].data, &stats))
+            return 1;
+        total.source_keys += stats.source_keys;
+        total.kept_keys += stats.kept_keys;
+        total.range_limited_tracks += stats.range_limited_tracks;
+        total.source_bytes += stats.source_bytes;
+        total.compressed_bytes += stats.compressed_bytes;
+    }
+
+    if (!animcache::Bake(output, clips, source_hash, settings_hash))
+        return 1;
+
+    SDL_Log("baked %s -> %s: %zu clips, %u joints, %u of %u keys kept, %.1f KB -> %.1f KB", source, output, clips.size(),
+        model.skeleton.JointCount(), total.kept_keys, total.source_keys, total.source_bytes / 1024.0, total.compressed_bytes / 1024.0);
+    if (total.range_limited_tracks)
+        SDL_Log("%u tracks cover ranges 16 bits cannot meet the error bounds on", total.range_limited_tracks);
+    return 0;
+}
@@ -0,0 +1,129 @@
+// anim_bench: headless skeletal animation throughput, scalar vs. SIMD paths.
+//
+// Usage: anim_bench [--characters N] [--joints J] [--vertices V] [--frames F]
+//
+// Every character samples two clips through its own cursors, blends them,
+// builds model space matrices and a skinning palette. The skinning pass then
+// deforms V vertices with 4 influences each using character 0's palette.
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "animation.h"
+#include "skeleton.h"
+#include "skinning.h"
+#include "synthetic.h"
+
+struct Character
+{
+    anim::ClipCursor cursor_a, cursor_b;
+    anim::LocalPose pose_a, pose_b, blended;
+    std::vector<glm::mat4> model;
+    std::vector<anim::SkinMatrix> palette;
+};
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t characters = 256, joints = 80, vertices = 200000, frames = 120;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--characters") == 0)
+            characters = ParseCount(argv[i + 1], 1, 1000000);
+        else if (SDL_strcmp(argv[i], "--joints") == 0)
+            joints = ParseCount(argv[i + 1], 1, 256);
+        else if (SDL_strcmp(argv[i], "--vertices") == 0)
+            vertices = ParseCount(argv[i + 1], 1, 100000000);
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[i + 1], 1, 100000);
+    }
+
+    std::mt19937 rng(42);
+    anim::Skeleton skeleton = synthetic::MakeSkeleton(joints, rng);
+    anim::AnimationClip walk = synthetic::MakeClip(joints, 1.0f, 31, rng);
+    anim::AnimationClip run = synthetic::MakeClip(joints, 0.7f, 22, rng);
+
+    std::vector<Character> crowd(characters);
+    for (Character& c : crowd)
+    {
+        c.model.resize(joints);
+        c.palette.resize(joints);
+    }
+
+    for (int simd = 0; simd < 2; simd++)
+    {
+        Uint64 sample_ns = 0, blend_ns = 0, hierarchy_ns = 0;
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            float time = f / 60.0f;
+            for (uint32_t i = 0; i < characters; i++)
+            {
+                Character& c = crowd[i];
+                float offset = i * 0.013f;
+
+                Uint64 t0 = SDL_GetTicksNS();
+                anim::SampleClip(walk, fmodf(time + offset, walk.duration), c.cursor_a, skeleton.bind_pose, c.pose_a);
+                anim::SampleClip(run, fmodf(time + offset, run.duration), c.cursor_b, skeleton.bind_pose, c.pose_b);
+                Uint64 t1 = SDL_GetTicksNS();
+                if (simd)
+                    anim::BlendPoses(c.pose_a, c.pose_b, 0.3f, c.blended);
+                else
+                    anim::BlendPosesScalar(c.pose_a, c.pose_b, 0.3f, c.blended);
+                Uint64 t2 = SDL_GetTicksNS();
+                anim::LocalToModel(skeleton, c.blended, c.model.data());
+                anim::BuildSkinningPalette(skeleton, c.model.data(), c.palette.data());
+                Uint64 t3 = SDL_GetTicksNS();
+
+                sample_ns += t1 - t0;
+                blend_ns += t2 - t1;
+                hierarchy_ns += t3 - t2;
+            }
+        }
+
+        double bones = (double)characters * joints * frames;
+        double total_s = (sample_ns + blend_ns + hierarchy_ns) / 1e9;
+        SDL_Log("pose evaluation (%s blend): %u characters x %u joints x %u frames", simd ? "SIMD" : "scalar", characters, joints, frames);
+        SDL_Log("  sample      %8.2f ms  %8.2f Mbones/s", sample_ns / 1e6, bones / (sample_ns / 1e3));
+        SDL_Log("  blend       %8.2f ms  %8.2f Mbones/s", blend_ns / 1e6, bones / (blend_ns / 1e3));
+        SDL_Log("  hierarchy   %8.2f ms  %8.2f Mbones/s", hierarchy_ns / 1e6, bones / (hierarchy_ns / 1e3));
+        SDL_Log("  total                    %8.2f Mbones/s", bones / total_s / 1e6);
+    }
+
+    std::vector<Vertex> bind;
+    std::vector<VertexSkin> skin;
+    synthetic::MakeSkinnedCloud(vertices, joints, rng, bind, skin);
+
+    std::vector<Vertex> scalar_out(vertices), simd_out(vertices);
+    const anim::SkinMatrix* palette = crowd[0].palette.data();
+    uint32_t passes = SDL_max(frames / 10, 1u);
+
+    Uint64 t0 = SDL_GetTicksNS();
+    for (uint32_t p = 0; p < passes; p++)
+        anim::SkinVerticesScalar(palette, bind.data(), skin.data(), scalar_out.data(), vertices);
+    Uint64 t1 = SDL_GetTicksNS();
+    for (uint32_t p = 0; p < passes; p++)
+        anim::SkinVertices(palette, bind.data(), skin.data(), simd_out.data(), vertices);
+    Uint64 t2 = SDL_GetTicksNS();
+
+    float max_error = 0.0f;
+    for (uint32_t v = 0; v < vertices; v++)
+    {
+        glm::vec3 d = glm::abs(scalar_out[v].position - simd_out[v].position);
+        max_error = SDL_max(max_error, SDL_max(d.x, SDL_max(d.y, d.z)));
+    }
+
+    double skinned = (double)vertices * passes;
+    SDL_Log("skinning: %u vertices x %u passes", vertices, passes);
+    SDL_Log("  scalar      %8.2f ms  %8.2f Mverts/s", (t1 - t0) / 1e6, skinned / ((t1 - t0) / 1e3));
+    SDL_Log("  SIMD        %8.2f ms  %8.2f Mverts/s", (t2 - t1) / 1e6, skinned / ((t2 - t1) / 1e3));
+    SDL_Log("  max |scalar - SIMD| = %g", max_error);
+    return 0;
+}
@@ -0,0 +1,226 @@
+// clip_bench: animation clip compression ratio, accuracy and decompression throughput.
+//
+// Usage: clip_bench [model file] [--clips N] [--joints J] [--seconds S] [--rate HZ]
+//                   [--translation-error E] [--rotation-error RAD] [--scale-error E]
+//                   [--chunk-seconds S] [--vertex-distance D]
+//
+// Compresses the clips of a skinned model, or N synthetic motion capture clips
+// (J joints, S seconds keyed at HZ) without one, with anim::CompressClip.
+// Per clip it reports keys and bytes before and after, and the largest error
+// against the source clip sampled at 120 Hz: in bone space (translation,
+// rotation in degrees, scale) and in world space, where every joint carries
+// virtual vertices D units along its axes through the whole hierarchy.
+//
+// Throughput is animated tracks decoded per second over all clips, for
+// forward playback at 60 Hz and for random seeks, raw SampleClip against
+// SampleCompressedClip. Needs no GPU.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "clip_compression.h"
+#include "model.h"
+#include "skeleton.h"
+#include "synthetic.h"
+
+struct Accuracy
+{
+    float translation = 0.0f;
+    float rotation = 0.0f;      // radians
+    float scale = 0.0f;
+    float world = 0.0f;
+};
+
+static Accuracy Measure(const anim::Skeleton& skeleton, const anim::AnimationClip& clip, const anim::CompressedClip& compressed,
+    float vertex_distance)
+{
+    Accuracy accuracy;
+    uint32_t joints = skeleton.JointCount();
+    anim::ClipCursor cursor;
+    anim::CompressedCursor compressed_cursor;
+    anim::LocalPose a, b;
+    std::vector<glm::mat4> model_a(joints), model_b(joints);
+    const glm::vec4 points[4] = { glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec4(vertex_distance, 0.0f, 0.0f, 1.0f),
+        glm::vec4(0.0f, vertex_distance, 0.0f, 1.0f), glm::vec4(0.0f, 0.0f, vertex_distance, 1.0f) };
+
+    uint32_t samples = (uint32_t)(clip.duration * 120.0f) + 1;
+    for (uint32_t s = 0; s <= samples; s++)
+    {
+        float time = SDL_min(s / 120.0f, clip.duration);
+        anim::SampleClip(clip, time, cursor, skeleton.bind_pose, a);
+        anim::SampleCompressedClip(compressed, time, compressed_cursor, skeleton.bind_pose, b);
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            glm::vec3 dt(a.tx[j] - b.tx[j], a.ty[j] - b.ty[j], a.tz[j] - b.tz[j]);
+            glm::vec3 ds(a.sx[j] - b.sx[j], a.sy[j] - b.sy[j], a.sz[j] - b.sz[j]);
+            // the angle between them, atan2 stays exact for tiny angles where acos does not
+            glm::vec4 qa(a.rx[j], a.ry[j], a.rz[j], a.rw[j]), qb(b.rx[j], b.ry[j], b.rz[j], b.rw[j]);
+            if (glm::dot(qa, qb) < 0.0f)
+                qb = -qb;
+            float angle = 4.0f * atan2f(glm::length(qa - qb), glm::length(qa + qb));
+            accuracy.translation = SDL_max(accuracy.translation, glm::length(dt));
+            accuracy.rotation = SDL_max(accuracy.rotation, angle);
+            accuracy.scale = SDL_max(accuracy.scale, SDL_max(fabsf(ds.x), SDL_max(fabsf(ds.y), fabsf(ds.z))));
+        }
+
+        anim::LocalToModel(skeleton, a, model_a.data());
+        anim::LocalToModel(skeleton, b, model_b.data());
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            for (const glm::vec4& point : points)
+                accuracy.world = SDL_max(accuracy.world, glm::length(glm::vec3(model_a[j] * point - model_b[j] * point)));
+        }
+    }
+    return accuracy;
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* path = nullptr;
+    uint32_t clip_count = 16, joints = 80;
+    float seconds = 10.0f, rate = 60.0f, vertex_distance = 0.1f;
+    anim::CompressionSettings settings;
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] != '-')
+            path = argv[i];
+        else if (i + 1 >= argc)
+            break;
+        else if (SDL_strcmp(argv[i], "--clips") == 0)
+            clip_count = ParseCount(argv[++i], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--joints") == 0)
+            joints = ParseCount(argv[++i], 1, 256);
+        else if (SDL_strcmp(argv[i], "--seconds") == 0)
+            seconds = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--rate") == 0)
+            rate = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--translation-error") == 0)
+            settings.translation_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--rotation-error") == 0)
+            settings.rotation_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--scale-error") == 0)
+            settings.scale_error = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--chunk-seconds") == 0)
+            settings.chunk_seconds = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--vertex-distance") == 0)
+            vertex_distance = (float)SDL_atof(argv[++i]);
+    }
+    seconds = SDL_max(seconds, 0.1f);
+    rate = SDL_max(rate, 1.0f);
+
+    std::mt19937 rng(42);
+    model::SkinnedModel source;
+    if (path)
+    {
+        if (!model::LoadSkinnedModel(path, source) || source.clips.empty())
+        {
+            SDL_Log("%s has no animation clips", path);
+            return 1;
+        }
+    }
+    else
+    {
+        source.skeleton = synthetic::MakeSkeleton(joints, rng);
+        for (uint32_t c = 0; c < clip_count; c++)
+            source.clips.push_back(synthetic::MakeMocapClip(joints, seconds, rate, rng));
+    }
+    const anim::Skeleton& skeleton = source.skeleton;
+
+    std::vector<std::vector<uint8_t>> blobs(source.clips.size());
+    std::vector<anim::CompressedClip> compressed(source.clips.size());
+    anim::CompressionStats total;
+    Accuracy worst;
+    Uint64 compress_ns = 0;
+    SDL_Log("%-20s %8s %8s %8s %9s %9s %6s  %9s %8s %9s %9s", "clip", "keys", "kept", "stored", "raw KB", "packed KB", "ratio",
+        "trans", "rot deg", "scale", "world");
+    for (size_t c = 0; c < source.clips.size(); c++)
+    {
+        const anim::AnimationClip& clip = source.clips[c];
+        anim::CompressionStats stats;
+        Uint64 start = SDL_GetTicksNS();
+        if (!anim::CompressClip(clip, settings, blobs[c], &stats))
+            return 1;
+        compress_ns += SDL_GetTicksNS() - start;
+        compressed[c] = anim::ViewCompressedClip(blobs[c].data(), blobs[c].size());
+        if (!compressed[c].IsValid())
+        {
+            SDL_Log("%s: compressed clip does not validate", clip.name.c_str());
+            return 1;
+        }
+
+        Accuracy accuracy = Measure(skeleton, clip, compressed[c], vertex_distance);
+        SDL_Log("%-20.20s %8u %8u %8u %9.1f %9.1f %5.1fx  %9.2e %8.4f %9.2e %9.2e", clip.name.c_str(), stats.source_keys,
+            stats.kept_keys, stats.stored_keys, stats.source_bytes / 1024.0, stats.compressed_bytes / 1024.0,
+            (double)stats.source_bytes / stats.compressed_bytes, accuracy.translation, accuracy.rotation * 57.29578f,
+            accuracy.scale, accuracy.world);
+
+        total.tracks += stats.tracks;
+        total.constant_tracks += stats.constant_tracks;
+        total.range_limited_tracks += stats.range_limited_tracks;
+        total.source_keys += stats.source_keys;
+        total.kept_keys += stats.kept_keys;
+        total.stored_keys += stats.stored_keys;
+        total.source_bytes += stats.source_bytes;
+        total.compressed_bytes += stats.compressed_bytes;
+        worst.translation = SDL_max(worst.translation, accuracy.translation);
+        worst.rotation = SDL_max(worst.rotation, accuracy.rotation);
+        worst.scale = SDL_max(worst.scale, accuracy.scale);
+        worst.world = SDL_max(worst.world, accuracy.world);
+    }
+
+    SDL_Log("%zu clips, %u joints, %u animated tracks (%u constant, %u limited by 16-bit range), compressed in %.1f ms",
+        source.clips.size(), skeleton.JointCount(), total.tracks, total.constant_tracks, total.range_limited_tracks, compress_ns / 1e6);
+    SDL_Log("keys %u -> %u kept, %u stored with chunk starts; %.1f KB -> %.1f KB (%.1fx)", total.source_keys, total.kept_keys,
+        total.stored_keys, total.source_bytes / 1024.0, total.compressed_bytes / 1024.0, (double)total.source_bytes / total.compressed_bytes);
+    SDL_Log("max error: translation %.2e, rotation %.4f deg, scale %.2e, world %.2e at %.2f units from each joint",
+        worst.translation, worst.rotation * 57.29578f, worst.scale, worst.world, vertex_distance);
+
+    // decompression: every clip played forward, then sampled at random times
+    anim::LocalPose pose;
+    double tracks_sampled = 0.0;
+    Uint64 raw_ns[2] = {}, packed_ns[2] = {};
+    for (size_t c = 0; c < source.clips.size(); c++)
+    {
+        const anim::AnimationClip& clip = source.clips[c];
+        uint32_t frames = (uint32_t)(clip.duration * 60.0f) + 1;
+        std::vector<float> times[2];
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            times[0].push_back(SDL_min(f / 60.0f, clip.duration));
+            times[1].push_back(std::uniform_real_distribution<float>(0.0f, clip.duration)(rng));
+        }
+        tracks_sampled += (double)compressed[c].TrackCount() * frames;
+
+        for (int mode = 0; mode < 2; mode++)
+        {
+            anim::ClipCursor cursor;
+            Uint64 start = SDL_GetTicksNS();
+            for (float time : times[mode])
+                anim::SampleClip(clip, time, cursor, skeleton.bind_pose, pose);
+            Uint64 middle = SDL_GetTicksNS();
+            anim::CompressedCursor compressed_cursor;
+            for (float time : times[mode])
+                anim::SampleCompressedClip(compressed[c], time, compressed_cursor, skeleton.bind_pose, pose);
+            Uint64 end = SDL_GetTicksNS();
+            raw_ns[mode] += middle - start;
+            packed_ns[mode] += end - middle;
+        }
+    }
+    const char* modes[2] = { "playback", "random seek" };
+    for (int mode = 0; mode < 2; mode++)
+    {
+        SDL_Log("%-12s raw %8.2f Mtracks/s   compressed %8.2f Mtracks/s", modes[mode], tracks_sampled / (raw_ns[mode] / 1e3),
+            tracks_sampled / (packed_ns[mode] / 1e3));
+    }
+    return 0;
+}
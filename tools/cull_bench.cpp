@@ -0,0 +1,134 @@
+// cull_bench: BVH build, refit and frustum culling cost on synthetic scenes.
+//
+// Usage: cull_bench [--objects N] [--frames F] [--moving PERCENT]
+//
+// Objects are scattered through a 1000 unit cube, the camera sits in the middle
+// and turns a little every frame. Each frame moves a share of the objects,
+// refits the tree and culls it. The BVH result is checked against a flat
+// SIMD pass over every object and the scalar Frustum::Intersects.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "bvh.h"
+#include "camera.h"
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t objects = 100000, frames = 60, moving = 10;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--objects") == 0)
+            objects = ParseCount(argv[i + 1], 1, 10000000);
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[i + 1], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--moving") == 0)
+            moving = ParseCount(argv[i + 1], 0, 100);
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> size(0.5f, 5.0f);
+    std::uniform_real_distribution<float> step(-1.0f, 1.0f);
+    std::vector<Aabb> bounds(objects);
+    for (Aabb& box : bounds)
+    {
+        glm::vec3 center(position(rng), position(rng), position(rng));
+        glm::vec3 extent(size(rng), size(rng), size(rng));
+        box.min = center - extent;
+        box.max = center + extent;
+    }
+
+    Bvh bvh;
+    Uint64 start = SDL_GetTicksNS();
+    bvh.Build(bounds.data(), objects);
+    double build_ms = (SDL_GetTicksNS() - start) / 1e6;
+
+    BoundsSoA flat;
+    flat.Resize(objects);
+
+    Camera camera;
+    camera.position = glm::vec3(0.0f);
+    camera.near_plane = 0.1f;
+    camera.far_plane = 400.0f;
+
+    std::vector<uint32_t> visible, reference;
+    uint32_t move_count = (uint32_t)((uint64_t)objects * moving / 100);
+    Uint64 update_ns = 0, refit_ns = 0, cull_ns = 0, flat_ns = 0, scalar_ns = 0;
+    uint64_t visible_total = 0;
+    bool ok = true;
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        float angle = frame * 0.05f;
+        camera.target = glm::vec3(SDL_cosf(angle), 0.2f, SDL_sinf(angle));
+        Frustum frustum = Frustum::FromMatrix(camera.ViewProjection());
+
+        // drift a contiguous-by-id share of the objects
+        start = SDL_GetTicksNS();
+        for (uint32_t i = 0; i < move_count; i++)
+        {
+            uint32_t object = (frame * move_count + i) % objects;
+            glm::vec3 offset(step(rng), step(rng), step(rng));
+            bounds[object].min += offset;
+            bounds[object].max += offset;
+            bvh.Update(object, bounds[object]);
+        }
+        update_ns += SDL_GetTicksNS() - start;
+
+        start = SDL_GetTicksNS();
+        bvh.Refit();
+        refit_ns += SDL_GetTicksNS() - start;
+
+        visible.clear();
+        start = SDL_GetTicksNS();
+        bvh.Cull(frustum, visible);
+        cull_ns += SDL_GetTicksNS() - start;
+        visible_total += visible.size();
+
+        // flat pass over the same data in id order, bounds copy not timed
+        for (uint32_t i = 0; i < objects; i++)
+            flat.Set(i, bounds[i]);
+        reference.clear();
+        start = SDL_GetTicksNS();
+        CullBounds(flat, frustum, reference);
+        flat_ns += SDL_GetTicksNS() - start;
+
+        start = SDL_GetTicksNS();
+        uint32_t scalar_visible = 0;
+        for (uint32_t i = 0; i < objects; i++)
+            scalar_visible += frustum.Intersects(bounds[i]);
+        scalar_ns += SDL_GetTicksNS() - start;
+
+        std::sort(visible.begin(), visible.end());
+        if (visible != reference || scalar_visible != reference.size())
+        {
+            SDL_Log("  frame %u: bvh %zu, flat %zu, scalar %u visible", frame, visible.size(), reference.size(), scalar_visible);
+            ok = false;
+        }
+    }
+
+    // quality check: a full rebuild after all the drifting
+    start = SDL_GetTicksNS();
+    bvh.Build(bounds.data(), objects);
+    double rebuild_ms = (SDL_GetTicksNS() - start) / 1e6;
+
+    SDL_Log("%u objects, %u nodes, %u frames, %u%% moving per frame", objects, bvh.NodeCount(), frames, moving);
+    SDL_Log("  build     %8.3f ms (rebuild at the end %.3f ms)", build_ms, rebuild_ms);
+    SDL_Log("  update    %8.3f ms/frame", update_ns / 1e6 / frames);
+    SDL_Log("  refit     %8.3f ms/frame", refit_ns / 1e6 / frames);
+    SDL_Log("  bvh cull  %8.3f ms/frame, %.0f visible (%.1f%%)", cull_ns / 1e6 / frames,
+        (double)visible_total / frames, 100.0 * visible_total / frames / objects);
+    SDL_Log("  flat simd %8.3f ms/frame", flat_ns / 1e6 / frames);
+    SDL_Log("  scalar    %8.3f ms/frame", scalar_ns / 1e6 / frames);
+    SDL_Log("  results match: %s", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
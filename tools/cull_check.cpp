@@ -0,0 +1,227 @@
+// cull_check: GPU culling and LOD selection against the CPU path.
+//
+// Usage: cull_check [--objects N] [--mesh file.skmesh] [--driver vulkan]
+//                   [--max-mismatch FRACTION] [--min-psnr DB]
+//
+// Needs a GPU device but no window, lavapipe works (--driver vulkan, with
+// VK_ICD_FILENAMES pointing at it). Renders the same cube grid of objects
+// twice, culled on the CPU and then in the compute pass, and walks the camera
+// through the same views: outside the grid, inside it, close up and with the
+// far plane cutting through it. After each view both runs read back which
+// objects were drawn and with which LOD. Objects whose bounds touch a plane
+// can land either way through float rounding, so a small fraction of
+// differences is allowed (0.1% of the visible objects by default). The last
+// frames of both runs are also compared, they fail below --min-psnr (40 dB).
+// Without --mesh the objects are a synthetic sphere with a LOD chain, baked
+// with compact vertices to cull_check.skmesh, and the views have to pick
+// coarser LODs somewhere, so LOD selection is compared and not only LOD 0.
+// Exits non-zero if GPU culling is unavailable or a check fails.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "mesh_lod.h"
+#include "renderer.h"
+#include "synthetic.h"
+
+struct View
+{
+    glm::vec3 position;
+    glm::vec3 target;
+    float far_plane;
+    const char* name;
+};
+
+struct ViewResult
+{
+    std::vector<Uint32> visible;
+    std::vector<Uint32> lods;
+};
+
+struct Run
+{
+    std::vector<ViewResult> views;
+    std::vector<Uint8> frame;
+    bool gpu_culling = false;
+};
+
+static glm::mat4 ObjectTransform(Uint32 index, Uint32 side, float spacing)
+{
+    float x = (float)(index % side), y = (float)(index / side % side), z = (float)(index / (side * side));
+    float offset = (side - 1) * spacing * 0.5f;
+    glm::mat4 transform(1.0f);
+    transform[3] = glm::vec4(x * spacing - offset, y * spacing - offset, z * spacing - offset, 1.0f);
+    return transform;
+}
+
+static bool RunViews(Renderer::Settings settings, Uint32 objects, const std::vector<View>& views, Run& run)
+{
+    if (!Renderer::Init(settings))
+        return false;
+    run.gpu_culling = Renderer::IsGpuCulling();
+
+    Uint32 side = (Uint32)std::ceil(std::cbrt((double)objects));
+    const float spacing = 1.5f;
+    for (Uint32 i = 0; i < objects; i++)
+        Renderer::AddObject(i % Renderer::MeshCount(), 0, ObjectTransform(i, side, spacing));
+
+    Camera& camera = Renderer::GetCamera();
+    camera.near_plane = 0.1f;
+    auto Frame = [&]()
+    {
+        Renderer::PreRender();
+        Renderer::Render();
+        Renderer::PostRender();
+    };
+
+    // the pipelines have to be ready, objects are skipped until then
+    Uint32 loading_frames = 0;
+    while (Renderer::IsLoading() && loading_frames < 1000)
+    {
+        Frame();
+        loading_frames++;
+    }
+
+    bool ok = true;
+    for (const View& view : views)
+    {
+        camera.position = view.position;
+        camera.target = view.target;
+        camera.far_plane = view.far_plane;
+        // a few frames per view let the LOD hysteresis settle the same way in both runs
+        for (int i = 0; i < 3; i++)
+            Frame();
+        Renderer::WaitIdle();
+        ViewResult result;
+        ok &= Renderer::ReadbackCulling(result.visible, result.lods);
+        run.views.push_back(result);
+    }
+
+    Uint32 width, height;
+    ok &= Renderer::ReadbackFrame(run.frame, width, height);
+    Renderer::Shutdown();
+    return ok;
+}
+
+static bool Check(bool ok, const char* what)
+{
+    SDL_Log("%-52s %s", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    Uint32 objects = 8000;
+    Renderer::Settings settings;
+    settings.headless = true;
+    settings.width = 640;
+    settings.height = 360;
+    double max_mismatch = 0.001;
+    double min_psnr = 40.0;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--objects") == 0)
+        {
+            // SDL_clamp is a macro, argv is read once. Clamped as a signed value so -5 stays small
+            int count = SDL_atoi(argv[++i]);
+            objects = (Uint32)SDL_clamp(count, 1, 1000000);
+        }
+        else if (SDL_strcmp(argv[i], "--mesh") == 0)
+            settings.mesh_cache_path = argv[++i];
+        else if (SDL_strcmp(argv[i], "--driver") == 0)
+            SDL_SetHint(SDL_HINT_GPU_DRIVER, argv[++i]);
+        else if (SDL_strcmp(argv[i], "--max-mismatch") == 0)
+            max_mismatch = SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--min-psnr") == 0)
+            min_psnr = SDL_atof(argv[++i]);
+    }
+    float extent = std::ceil(std::cbrt((double)objects)) * 1.5f * 0.5f;
+    std::vector<View> views = {
+        { glm::vec3(0.0f, extent * 0.5f, extent * 3.0f), glm::vec3(0.0f), extent * 10.0f, "outside" },
+        { glm::vec3(extent * 2.5f, extent, extent * 2.0f), glm::vec3(0.0f), extent * 10.0f, "outside, diagonal" },
+        { glm::vec3(0.0f), glm::vec3(1.0f, 0.2f, 0.3f), extent * 10.0f, "inside" },
+        { glm::vec3(0.0f, 0.0f, extent + 1.0f), glm::vec3(0.0f, 0.0f, extent - 1.0f), extent * 10.0f, "close up" },
+        { glm::vec3(0.0f, 0.0f, extent * 2.0f), glm::vec3(0.0f), extent * 2.0f, "far plane through the grid" },
+        { glm::vec3(0.0f, extent * 0.5f, extent * 3.0f), glm::vec3(0.0f), extent * 10.0f, "outside again" },
+    };
+
+    // a mesh with LODs, the built-in quad has none
+    bool own_mesh = settings.mesh_cache_path == nullptr;
+    if (own_mesh)
+    {
+        std::vector<Mesh> meshes;
+        meshes.push_back(synthetic::MakeSphere(32, 64, 0.6f));
+        lod::GenerateLods(meshes[0]);
+        settings.mesh_cache_path = "cull_check.skmesh";
+        if (meshes[0].LodCount() < 2 || !meshcache::Bake(settings.mesh_cache_path, meshes, 1, 1, vtx::LAYOUT_COMPACT))
+        {
+            SDL_Log("Failed to bake the test mesh");
+            return 1;
+        }
+    }
+
+    Run cpu, gpu;
+    settings.gpu_culling = false;
+    bool ok = RunViews(settings, objects, views, cpu);
+    settings.gpu_culling = true;
+    ok &= RunViews(settings, objects, views, gpu);
+    if (!ok || !gpu.gpu_culling)
+    {
+        SDL_Log(gpu.gpu_culling ? "Failed to render the views" : "GPU culling is unavailable on this device");
+        return 1;
+    }
+
+    Uint32 total_visible = 0, culled_somewhere = 0, coarser_lods = 0;
+    for (size_t v = 0; v < views.size(); v++)
+    {
+        const ViewResult& a = cpu.views[v];
+        const ViewResult& b = gpu.views[v];
+        // walk both ascending lists: objects only one side drew, then LODs of the shared ones
+        Uint32 only_cpu = 0, only_gpu = 0, lod_differences = 0;
+        size_t i = 0, j = 0;
+        while (i < a.visible.size() || j < b.visible.size())
+        {
+            if (j == b.visible.size() || (i < a.visible.size() && a.visible[i] < b.visible[j]))
+                only_cpu++, i++;
+            else if (i == a.visible.size() || b.visible[j] < a.visible[i])
+                only_gpu++, j++;
+            else
+                lod_differences += a.lods[i++] != b.lods[j++];
+        }
+        total_visible += (Uint32)a.visible.size();
+        for (Uint32 lod : a.lods)
+            coarser_lods += lod > 0;
+        culled_somewhere += a.visible.size() < objects;
+
+        Uint32 lod_histogram[Mesh::kMaxLods] = {};
+        for (Uint32 lod : b.lods)
+            lod_histogram[SDL_min(lod, Mesh::kMaxLods - 1)]++;
+        SDL_Log("%-28s cpu %6zu  gpu %6zu  only cpu %4u  only gpu %4u  lod differences %4u  gpu lods %u/%u/%u/%u",
+            views[v].name, a.visible.size(), b.visible.size(), only_cpu, only_gpu, lod_differences,
+            lod_histogram[0], lod_histogram[1], lod_histogram[2], lod_histogram[3]);
+        double allowed = std::ceil(max_mismatch * SDL_max(a.visible.size(), (size_t)1));
+        ok &= Check(only_cpu + only_gpu <= allowed, "  same objects visible");
+        ok &= Check(lod_differences <= allowed, "  same LODs picked");
+    }
+    ok &= Check(total_visible > 0 && culled_somewhere > 0, "views draw some objects and cull others");
+    if (own_mesh)
+        ok &= Check(coarser_lods > 0, "views pick coarser LODs");
+
+    double error = 0.0;
+    for (size_t i = 0; i < cpu.frame.size(); i++)
+    {
+        if (i % 4 == 3)
+            continue;
+        double diff = (double)cpu.frame[i] - (double)gpu.frame[i];
+        error += diff * diff;
+    }
+    double mse = error / SDL_max((double)cpu.frame.size() / 4 * 3, 1.0);
+    double psnr = mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+    SDL_Log("last frames: PSNR %.2f dB", psnr);
+    ok &= Check(cpu.frame.size() == gpu.frame.size() && psnr >= min_psnr, "frames match");
+
+    return ok ? 0 : 1;
+}
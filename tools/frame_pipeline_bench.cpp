@@ -0,0 +1,216 @@
+// frame_pipeline_bench: frame time and CPU/GPU overlap against the number of frames in flight.
+//
+// Usage: frame_pipeline_bench [--frames N] [--objects N] [--width W] [--height H]
+//                             [--max-in-flight N] [--mesh file.skmesh] [--driver vulkan]
+//                             [--min-psnr DB]
+//
+// Needs a GPU device but no window, lavapipe works (--driver vulkan, with
+// VK_ICD_FILENAMES pointing at it). The scene is render_bench's: a cube grid
+// of objects, a tenth of them moving every frame, the camera orbiting once
+// over the run. Culling is on the CPU so the draw lists are built in parallel
+// segments. The same frames are rendered with 1 up to --max-in-flight (3)
+// frames in flight, back to back without waiting for the GPU in between.
+//
+// Per configuration it reports the frame time (the run's wall time over its
+// frames, GPU included, and percentiles of the intervals between frames), the
+// CPU time per frame without waits, the time spent waiting for a frame slot,
+// how many frames started with an earlier one still on the GPU, and the
+// overlap: the share of the shorter of CPU and GPU time per frame hidden
+// behind the other. SDL_gpu has no timestamp queries, so the GPU time is
+// estimated from the single frame in flight run, where the GPU only runs while
+// the CPU finishes the frame after submitting it or waits.
+//
+// Fails if a frame ever starts with more earlier frames on the GPU than the
+// setting allows, or if the last frames differ from the single frame in flight
+// run, below --min-psnr (40 dB): frames in flight must not share what they draw from.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "renderer.h"
+
+struct Result
+{
+    Uint32 frames_in_flight = 0;
+    double total_ms = 0.0;
+    std::vector<double> ms;         // between the ends of consecutive frames
+    double cpu_ms = 0.0;            // means per frame
+    double record_ms = 0.0;         // PreRender to submission
+    double wait_ms = 0.0;
+    double busy = 0.0;              // frames started with an earlier one on the GPU
+    Uint32 max_busy = 0;
+    double segments = 0.0;
+    std::vector<Uint8> frame;
+};
+
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t index = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[SDL_clamp(index, (size_t)1, sorted.size()) - 1];
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static Uint32 ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (Uint32)SDL_clamp(value, min, max);
+}
+
+static glm::mat4 ObjectTransform(Uint32 index, Uint32 side, float spacing, float lift)
+{
+    float x = (float)(index % side), y = (float)(index / side % side), z = (float)(index / (side * side));
+    float offset = (side - 1) * spacing * 0.5f;
+    glm::mat4 transform(1.0f);
+    transform[3] = glm::vec4(x * spacing - offset, y * spacing - offset + lift, z * spacing - offset, 1.0f);
+    return transform;
+}
+
+static bool Run(Renderer::Settings settings, Uint32 objects, Uint32 frames, Result& result)
+{
+    if (!Renderer::Init(settings))
+        return false;
+    result.frames_in_flight = settings.frames_in_flight;
+
+    Uint32 side = (Uint32)std::ceil(std::cbrt((double)objects));
+    const float spacing = 1.5f;
+    for (Uint32 i = 0; i < objects; i++)
+        Renderer::AddObject(i % Renderer::MeshCount(), 0, ObjectTransform(i, side, spacing, 0.0f));
+
+    float radius = side * spacing * 1.5f + 2.0f;
+    Camera& camera = Renderer::GetCamera();
+    camera.target = glm::vec3(0.0f);
+    camera.near_plane = 0.1f;
+    camera.far_plane = radius * 3.0f;
+    // depends on the frame number alone, every run renders the same frames
+    auto Frame = [&](Uint32 frame)
+    {
+        float angle = 6.2831853f * frame / frames;
+        camera.position = glm::vec3(std::sin(angle) * radius, radius * 0.3f, std::cos(angle) * radius);
+        for (Uint32 i = frame % 10; i < objects; i += 10)
+            Renderer::SetObjectTransform(i, ObjectTransform(i, side, spacing, std::sin(frame * 0.1f + i) * 0.25f));
+        Renderer::PreRender();
+        Renderer::Render();
+        Renderer::PostRender();
+    };
+
+    Uint32 loading_frames = 0;
+    while (Renderer::IsLoading() && loading_frames < 1000)
+    {
+        Frame(0);
+        loading_frames++;
+    }
+    Renderer::WaitIdle();
+
+    Uint64 start = SDL_GetTicksNS();
+    Uint64 last = start;
+    for (Uint32 f = 0; f < frames; f++)
+    {
+        Frame(f);
+        Uint64 now = SDL_GetTicksNS();
+        const Renderer::FrameStats& stats = Renderer::GetFrameStats();
+        double ms = (now - last) / 1e6;
+        result.ms.push_back(ms);
+        result.cpu_ms += ms - stats.wait_ns / 1e6;
+        result.record_ms += stats.cpu_ns / 1e6;
+        result.wait_ms += stats.wait_ns / 1e6;
+        result.busy += stats.frames_busy > 0;
+        result.max_busy = SDL_max(result.max_busy, stats.frames_busy);
+        result.segments += stats.draw_segments;
+        last = now;
+    }
+    // the frames still in flight count towards the run
+    Renderer::WaitIdle();
+    result.total_ms = (SDL_GetTicksNS() - start) / 1e6;
+    result.cpu_ms /= frames;
+    result.record_ms /= frames;
+    result.wait_ms /= frames;
+    result.busy /= frames;
+    result.segments /= frames;
+
+    Uint32 width, height;
+    bool ok = Renderer::ReadbackFrame(result.frame, width, height);
+    Renderer::Shutdown();
+    return ok;
+}
+
+static bool Check(bool ok, const char* what)
+{
+    SDL_Log("%-52s %s", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    Uint32 frames = 300, objects = 16384, max_in_flight = Renderer::kMaxFramesInFlight;
+    Renderer::Settings settings;
+    settings.headless = true;
+    settings.width = 1280;
+    settings.height = 720;
+    double min_psnr = 40.0;
+    for (int i = 1; i + 1 < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[++i], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--objects") == 0)
+            objects = ParseCount(argv[++i], 1, 1000000);
+        else if (SDL_strcmp(argv[i], "--width") == 0)
+            settings.width = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--height") == 0)
+            settings.height = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--max-in-flight") == 0)
+            max_in_flight = ParseCount(argv[++i], 1, (int)Renderer::kMaxFramesInFlight);
+        else if (SDL_strcmp(argv[i], "--mesh") == 0)
+            settings.mesh_cache_path = argv[++i];
+        else if (SDL_strcmp(argv[i], "--driver") == 0)
+            SDL_SetHint(SDL_HINT_GPU_DRIVER, argv[++i]);
+        else if (SDL_strcmp(argv[i], "--min-psnr") == 0)
+            min_psnr = SDL_atof(argv[++i]);
+    }
+
+    std::vector<Result> results(max_in_flight);
+    for (Uint32 n = 0; n < max_in_flight; n++)
+    {
+        settings.frames_in_flight = n + 1;
+        if (!Run(settings, objects, frames, results[n]))
+            return 1;
+    }
+
+    SDL_Log("%u frames at %ux%u, %u objects, culling on the CPU", frames, settings.width, settings.height, objects);
+    // with one frame in flight the GPU works while the CPU waits or finishes the submitted frame
+    const Result& serial = results[0];
+    double gpu_ms = SDL_max(serial.total_ms / frames - serial.record_ms, 0.0);
+    SDL_Log("GPU time per frame, estimated: %.3f ms", gpu_ms);
+    bool ok = true;
+    for (Result& result : results)
+    {
+        std::sort(result.ms.begin(), result.ms.end());
+        double frame_ms = result.total_ms / frames;
+        double shorter = SDL_min(result.cpu_ms, gpu_ms);
+        double overlap = shorter > 0.0 ? SDL_clamp((result.cpu_ms + gpu_ms - frame_ms) / shorter, 0.0, 1.0) : 0.0;
+        SDL_Log("%u in flight: frame %7.3f ms (p50 %7.3f  p90 %7.3f)  %6.1f fps  %.2fx", result.frames_in_flight, frame_ms,
+            Percentile(result.ms, 50.0), Percentile(result.ms, 90.0), 1000.0 / frame_ms, serial.total_ms / result.total_ms);
+        SDL_Log("             cpu %7.3f ms  recording %7.3f ms  waiting %7.3f ms  overlap %5.1f%%  started busy %5.1f%%  segments %.1f",
+            result.cpu_ms, result.record_ms, result.wait_ms, overlap * 100.0, result.busy * 100.0, result.segments);
+        ok &= Check(result.max_busy < result.frames_in_flight, "  never more frames on the GPU than allowed");
+    }
+
+    for (size_t n = 1; n < results.size(); n++)
+    {
+        const Result& result = results[n];
+        double error = 0.0;
+        for (size_t i = 0; i < serial.frame.size() && i < result.frame.size(); i++)
+        {
+            if (i % 4 == 3)
+                continue;
+            double diff = (double)serial.frame[i] - (double)result.frame[i];
+            error += diff * diff;
+        }
+        double mse = error / SDL_max((double)serial.frame.size() / 4 * 3, 1.0);
+        double psnr = mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+        SDL_Log("last frame, %u in flight against 1: PSNR %.2f dB", result.frames_in_flight, psnr);
+        ok &= Check(serial.frame.size() == result.frame.size() && psnr >= min_psnr, "  frames match");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,145 @@
+// import_bench: headless model import benchmark.
+//
+// Usage: import_bench <model file> [--no-optimize] [--runs N]
+//        import_bench --synthetic <grid size> [--runs N]
+//
+// Reports import time, vertex/index counts and ACMR (FIFO, 16 entries) before
+// and after vertex cache optimization. The synthetic mode builds a shuffled
+// grid so the optimizer can be tracked without any asset on disk.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "mesh_optimizer.h"
+#include "model.h"
+
+static void RunSynthetic(int grid, int runs)
+{
+    for (int run = 0; run < runs; run++)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+
+        // unindexed soup, every triangle owns its corners like an OBJ import would
+        for (int y = 0; y < grid; y++)
+        {
+            for (int x = 0; x < grid; x++)
+            {
+                glm::vec3 p[4] = {
+                    glm::vec3((float)x, (float)y, 0.0f), glm::vec3((float)x + 1, (float)y, 0.0f),
+                    glm::vec3((float)x + 1, (float)y + 1, 0.0f), glm::vec3((float)x, (float)y + 1, 0.0f),
+                };
+                const int corners[6] = { 0, 1, 2, 0, 2, 3 };
+                for (int c : corners)
+                {
+                    Vertex v{};
+                    v.position = p[c];
+                    v.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                    v.tex_coords = glm::vec2(p[c].x / grid, p[c].y / grid);
+                    indices.push_back((uint32_t)vertices.size());
+                    vertices.push_back(v);
+                }
+            }
+        }
+
+        Uint64 start = SDL_GetTicksNS();
+        size_t source_vertices = vertices.size();
+        size_t unique = optimizer::DeduplicateVertices(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size());
+        vertices.resize(unique);
+        Uint64 deduped = SDL_GetTicksNS();
+
+        // shuffle triangles so the input has no locality left
+        size_t tri_count = indices.size() / 3;
+        std::vector<uint32_t> order(tri_count);
+        for (size_t i = 0; i < tri_count; i++)
+            order[i] = (uint32_t)i;
+        std::shuffle(order.begin(), order.end(), std::mt19937(1234));
+        std::vector<uint32_t> shuffled(indices.size());
+        for (size_t i = 0; i < tri_count; i++)
+            for (int k = 0; k < 3; k++)
+                shuffled[i * 3 + k] = indices[order[i] * 3 + k];
+        indices.swap(shuffled);
+
+        float before = optimizer::ComputeACMR(indices.data(), indices.size(), vertices.size());
+        Uint64 opt_start = SDL_GetTicksNS();
+        optimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+        unique = optimizer::OptimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size());
+        vertices.resize(unique);
+        Uint64 opt_end = SDL_GetTicksNS();
+        float after = optimizer::ComputeACMR(indices.data(), indices.size(), vertices.size());
+
+        Mesh mesh(std::move(vertices), std::move(indices), {});
+
+        SDL_Log("run %d: grid %dx%d, %zu tris", run, grid, grid, tri_count);
+        SDL_Log("  dedup       %8.2f ms  %zu -> %zu vertices", (deduped - start) / 1e6, source_vertices, unique);
+        SDL_Log("  optimize    %8.2f ms  (%.2f Mtris/s)", (opt_end - opt_start) / 1e6, tri_count / ((opt_end - opt_start) / 1e3));
+        SDL_Log("  indices     %u x %d bit", mesh.IndexCount(), mesh.IndexSize() == SDL_GPU_INDEXELEMENTSIZE_16BIT ? 16 : 32);
+        SDL_Log("  ACMR        %.3f -> %.3f", before, after);
+    }
+}
+
+static void RunModel(const char* path, const model::ImportSettings& settings, int runs)
+{
+    for (int run = 0; run < runs; run++)
+    {
+        model::ImportStats stats{};
+        std::vector<Mesh> meshes = model::LoadModel(path, settings, &stats);
+        if (meshes.empty())
+        {
+            SDL_Log("no meshes imported from %s", path);
+            return;
+        }
+
+        size_t vertex_bytes = 0, index_bytes = 0;
+        for (const Mesh& mesh : meshes)
+        {
+            vertex_bytes += mesh.VertexBytes();
+            index_bytes += mesh.IndexBytes();
+        }
+
+        SDL_Log("run %d: %s", run, path);
+        SDL_Log("  import      %8.2f ms  (parse %.2f ms, process %.2f ms)", stats.parse_ms + stats.process_ms, stats.parse_ms, stats.process_ms);
+        SDL_Log("  meshes      %zu (%zu with 16 bit indices)", stats.meshes, stats.meshes_16bit);
+        SDL_Log("  vertices    %zu -> %zu after dedup", stats.source_vertices, stats.vertices);
+        SDL_Log("  indices     %zu (%zu tris)", stats.indices, stats.indices / 3);
+        SDL_Log("  gpu bytes   %.2f MB vertex, %.2f MB index", vertex_bytes / (1024.0 * 1024.0), index_bytes / (1024.0 * 1024.0));
+        SDL_Log("  ACMR        %.3f -> %.3f", stats.acmr_before, stats.acmr_after);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const char* path = nullptr;
+    int synthetic = 0;
+    int runs = 1;
+    model::ImportSettings settings{};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--no-optimize") == 0)
+            settings.optimize = false;
+        else if (SDL_strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+            runs = SDL_atoi(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc)
+            synthetic = SDL_atoi(argv[++i]);
+        else
+            path = argv[i];
+    }
+
+    if (synthetic > 0)
+    {
+        RunSynthetic(synthetic, runs);
+        return 0;
+    }
+    if (path == nullptr)
+    {
+        SDL_Log("usage: import_bench <model file> [--no-optimize] [--runs N]");
+        SDL_Log("       import_bench --synthetic <grid size> [--runs N]");
+        return 1;
+    }
+
+    RunModel(path, settings, runs);
+    return 0;
+}
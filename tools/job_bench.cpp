@@ -0,0 +1,90 @@
+// job_bench: scaling of the job system from 1 to N threads.
+//
+// Usage: job_bench [--characters N] [--joints J] [--vertices V] [--frames F] [--max-threads T]
+//
+// The workload is a crowd of animators (pose sampling, hierarchy, palette and
+// CPU skinning of V vertices each), the work a skinned renderer would fan out per frame.
+
+#include <SDL3/SDL.h>
+#include <random>
+#include <vector>
+
+#include "animator.h"
+#include "job_system.h"
+#include "synthetic.h"
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t characters = 512, joints = 64, vertices = 4000, frames = 60;
+    uint32_t max_threads = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--characters") == 0)
+            characters = ParseCount(argv[i + 1], 1, 1000000);
+        else if (SDL_strcmp(argv[i], "--joints") == 0)
+            joints = ParseCount(argv[i + 1], 1, 256);
+        else if (SDL_strcmp(argv[i], "--vertices") == 0)
+            vertices = ParseCount(argv[i + 1], 3, 10000000);
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[i + 1], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--max-threads") == 0)
+            max_threads = ParseCount(argv[i + 1], 1, 1024);
+    }
+
+    std::mt19937 rng(7);
+    anim::Skeleton skeleton = synthetic::MakeSkeleton(joints, rng);
+    anim::AnimationClip clip = synthetic::MakeClip(joints, 1.0f, 31, rng);
+
+    std::vector<Vertex> bind;
+    std::vector<VertexSkin> skin;
+    synthetic::MakeSkinnedCloud(vertices, joints, rng, bind, skin);
+    std::vector<uint32_t> indices(bind.size() - bind.size() % 3);
+    for (size_t i = 0; i < indices.size(); i++)
+        indices[i] = (uint32_t)i;
+    Mesh mesh(bind, indices, {});
+    mesh.SetSkin(skin);
+
+    SDL_Log("%u characters, %u joints, %u skinned vertices each, %u frames", characters, joints, vertices, frames);
+    SDL_Log("threads   ms/frame   speedup   efficiency");
+
+    double single_ms = 0.0;
+    for (uint32_t threads = 1; threads <= max_threads; threads++)
+    {
+        JobSystem jobs(threads);
+
+        std::vector<anim::Animator> animators(characters);
+        for (uint32_t i = 0; i < characters; i++)
+        {
+            animators[i].skeleton = &skeleton;
+            animators[i].clip = &clip;
+            animators[i].mesh = &mesh;
+            animators[i].time = i * 0.01f;
+        }
+
+        // warm up so first-touch allocations don't count
+        JobCounter counter;
+        anim::UpdateAnimators(jobs, animators, 0.0f, &counter);
+        jobs.Wait(&counter);
+
+        Uint64 start = SDL_GetTicksNS();
+        for (uint32_t f = 0; f < frames; f++)
+        {
+            anim::UpdateAnimators(jobs, animators, 1.0f / 60.0f, &counter);
+            jobs.Wait(&counter);
+        }
+        double ms = (SDL_GetTicksNS() - start) / 1e6 / frames;
+        if (threads == 1)
+            single_ms = ms;
+
+        double speedup = single_ms / ms;
+        SDL_Log("%7u   %8.3f   %7.2fx   %9.0f%%", threads, ms, speedup, 100.0 * speedup / threads);
+    }
+    return 0;
+}
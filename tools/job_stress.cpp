@@ -0,0 +1,214 @@
+// job_stress: stress checks for the work stealing deque and the job system.
+//
+// Usage: job_stress [--rounds N] [--thieves T]
+//
+// Exits with a non-zero status when an item is lost or taken twice, when a
+// nested parallel sum comes out wrong, or when scheduling more jobs than the
+// queue holds without waiting loses or repeats one.
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "job_system.h"
+#include "work_stealing_queue.h"
+
+struct Item
+{
+    std::atomic<uint32_t> taken{ 0 };
+};
+
+static bool StressDeque(uint32_t items, uint32_t thieves, uint32_t seed)
+{
+    static const uint32_t kCapacity = 256;
+    WorkStealingQueue<Item, kCapacity> queue;
+    std::vector<Item> pool(items);
+    std::atomic<bool> done{ false };
+    std::atomic<uint32_t> consumed{ 0 };
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < thieves; t++)
+    {
+        threads.emplace_back([&]
+        {
+            while (!done.load(std::memory_order_acquire) || queue.Size() > 0)
+            {
+                if (Item* item = queue.Steal())
+                {
+                    item->taken.fetch_add(1, std::memory_order_relaxed);
+                    consumed.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    // the owner mixes pushes with pops so both ends race constantly
+    std::mt19937 rng(seed);
+    uint32_t next = 0;
+    while (next < items)
+    {
+        uint32_t burst = 1 + rng() % 16;
+        for (uint32_t i = 0; i < burst && next < items; i++)
+        {
+            if (queue.Push(&pool[next]))
+                next++;
+        }
+        uint32_t pops = rng() % 12;
+        for (uint32_t i = 0; i < pops; i++)
+        {
+            if (Item* item = queue.Pop())
+            {
+                item->taken.fetch_add(1, std::memory_order_relaxed);
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    while (Item* item = queue.Pop())
+    {
+        item->taken.fetch_add(1, std::memory_order_relaxed);
+        consumed.fetch_add(1, std::memory_order_relaxed);
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread& t : threads)
+        t.join();
+
+    bool ok = consumed.load() == items;
+    for (uint32_t i = 0; i < items; i++)
+    {
+        if (pool[i].taken.load() != 1)
+        {
+            SDL_Log("  item %u taken %u times", i, pool[i].taken.load());
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+struct NestedSum
+{
+    JobSystem* jobs;
+    const uint32_t* values;
+    std::atomic<uint64_t> total{ 0 };
+};
+
+static bool StressJobs(JobSystem& jobs, uint32_t count, uint32_t rounds)
+{
+    std::vector<uint32_t> values(count);
+    uint64_t expected = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        values[i] = i * 2654435761u >> 20;
+        expected += values[i];
+    }
+
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        NestedSum sum;
+        sum.jobs = &jobs;
+        sum.values = values.data();
+
+        // outer chunks schedule and wait on inner jobs from worker threads
+        JobCounter counter;
+        jobs.ParallelFor(count, 4096, [](void* data, uint32_t begin, uint32_t end)
+        {
+            NestedSum* sum = (NestedSum*)data;
+            JobCounter inner;
+            sum->jobs->Schedule([](void* data, uint32_t begin, uint32_t end)
+            {
+                NestedSum* sum = (NestedSum*)data;
+                uint64_t local = 0;
+                for (uint32_t i = begin; i < end; i++)
+                    local += sum->values[i];
+                sum->total.fetch_add(local, std::memory_order_relaxed);
+            }, data, begin, begin + (end - begin) / 2, &inner);
+
+            uint64_t local = 0;
+            for (uint32_t i = begin + (end - begin) / 2; i < end; i++)
+                local += sum->values[i];
+            sum->total.fetch_add(local, std::memory_order_relaxed);
+            sum->jobs->Wait(&inner);
+        }, &sum, &counter);
+        jobs.Wait(&counter);
+
+        if (sum.total.load() != expected)
+        {
+            SDL_Log("  round %u: sum %llu, expected %llu", round, (unsigned long long)sum.total.load(), (unsigned long long)expected);
+            return false;
+        }
+    }
+    return true;
+}
+
+// more single item jobs than one queue holds, scheduled without waiting in between
+static bool StressOverflow(JobSystem& jobs, uint32_t rounds)
+{
+    const uint32_t count = 3 * JobSystem::kQueueCapacity;
+    std::vector<Item> ran(count);
+    for (uint32_t round = 0; round < rounds; round++)
+    {
+        for (Item& item : ran)
+            item.taken.store(0, std::memory_order_relaxed);
+
+        JobCounter counter;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            jobs.Schedule([](void* data, uint32_t begin, uint32_t end)
+            {
+                Item* ran = (Item*)data;
+                for (uint32_t i = begin; i < end; i++)
+                    ran[i].taken.fetch_add(1, std::memory_order_relaxed);
+            }, ran.data(), i, i + 1, &counter);
+        }
+        jobs.Wait(&counter);
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (ran[i].taken.load() != 1)
+            {
+                SDL_Log("  round %u: job %u ran %u times", round, i, ran[i].taken.load());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t rounds = 50;
+    uint32_t thieves = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores() - 1, 2);
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--rounds") == 0)
+            rounds = ParseCount(argv[i + 1], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--thieves") == 0)
+            thieves = ParseCount(argv[i + 1], 1, 256);
+    }
+
+    bool ok = true;
+    for (uint32_t round = 0; round < rounds && ok; round++)
+        ok = StressDeque(100000, thieves, round);
+    SDL_Log("deque: %u rounds, %u thieves: %s", rounds, thieves, ok ? "ok" : "FAILED");
+    if (!ok)
+        return 1;
+
+    for (uint32_t threads = 1; threads <= thieves + 1 && ok; threads++)
+    {
+        JobSystem jobs(threads);
+        ok = StressJobs(jobs, 1 << 20, rounds);
+        SDL_Log("jobs: %u threads, nested parallel sum: %s", threads, ok ? "ok" : "FAILED");
+        ok = ok && StressOverflow(jobs, rounds);
+        SDL_Log("jobs: %u threads, %u jobs without waiting: %s", threads, 3 * JobSystem::kQueueCapacity, ok ? "ok" : "FAILED");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,289 @@
+// lod_bench: LOD chain generation speed and quality, and LOD selection on a crowd.
+//
+// Usage: lod_bench [--lods N] [--ratio R] [--crowd N] [model file ...]
+//
+// Builds the LOD chain of every mesh of each model, or of two synthetic ones
+// when none is given: a UV sphere with a texture seam, and a skinned grid with
+// an open border. Reports triangles and error per LOD and the simplifier's
+// throughput in source triangles per second. On the sphere the real error is
+// measured too (how far LOD triangles sink below the surface), no LOD
+// triangle may straddle the texture seam, and the LODs must come back out of
+// a baked .skmesh unchanged.
+//
+// The crowd part places N instances of the first mesh at random distances in
+// front of a 1080p camera, picks LODs with lod::SelectLod and reports the
+// triangles drawn against LOD 0 everywhere. It then walks one instance back
+// and forth across a switching distance with jitter and counts LOD changes with
+// and without hysteresis. Runs headless, exits non-zero if a check fails.
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bounds.h"
+#include "mesh_cache.h"
+#include "mesh_lod.h"
+#include "model.h"
+#include "synthetic.h"
+
+static const uint32_t kRings = 256, kSegments = 512;
+static const float kRadius = 1.0f;
+
+// a cloth-like sheet weighted to a few joints along x, crowds are mostly skinned
+static Mesh MakeSkinnedGrid(std::mt19937& rng)
+{
+    const uint32_t grid = 200, joints = 8;
+    std::vector<Vertex> vertices;
+    std::vector<VertexSkin> skin;
+    std::vector<uint32_t> indices;
+    std::uniform_real_distribution<float> noise(-0.002f, 0.002f);
+    for (uint32_t y = 0; y <= grid; y++)
+    {
+        for (uint32_t x = 0; x <= grid; x++)
+        {
+            float fx = (float)x / grid, fy = (float)y / grid;
+            Vertex v{};
+            v.position = glm::vec3(fx, 0.1f * sinf(fx * 6.0f) * cosf(fy * 4.0f) + noise(rng), fy);
+            v.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+            v.tex_coords = glm::vec2(fx, fy);
+            vertices.push_back(v);
+
+            // blend between the two nearest joints
+            float joint = fx * (joints - 1);
+            VertexSkin s{};
+            s.joints[0] = (uint8_t)joint;
+            s.joints[1] = (uint8_t)SDL_min((uint32_t)joint + 1, joints - 1);
+            s.weights[1] = joint - floorf(joint);
+            s.weights[0] = 1.0f - s.weights[1];
+            skin.push_back(s);
+        }
+    }
+    for (uint32_t y = 0; y < grid; y++)
+    {
+        for (uint32_t x = 0; x < grid; x++)
+        {
+            uint32_t a = y * (grid + 1) + x, b = a + grid + 1;
+            uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    Mesh mesh(vertices, indices, {});
+    mesh.SetSkin(skin);
+    return mesh;
+}
+
+// deepest point of any LOD triangle below the sphere surface, relative to the extent
+static float SphereError(const Mesh& mesh, const Mesh::MeshLod& lod)
+{
+    float error = 0.0f;
+    for (uint32_t i = 0; i < lod.index_count; i += 3)
+    {
+        glm::vec3 centroid(0.0f);
+        for (int k = 0; k < 3; k++)
+            centroid += mesh.Vertices()[mesh.Index(lod.first_index + i + k)].position / 3.0f;
+        error = SDL_max(error, (kRadius - glm::length(centroid)) / (2.0f * kRadius));
+    }
+    return error;
+}
+
+// faces using both sides of the u = 0 / u = 1 seam wrapped around the sphere
+static uint32_t SeamCrossings(const Mesh& mesh, const Mesh::MeshLod& lod)
+{
+    uint32_t crossings = 0;
+    for (uint32_t i = 0; i < lod.index_count; i += 3)
+    {
+        float lo = 1.0f, hi = 0.0f;
+        for (int k = 0; k < 3; k++)
+        {
+            float u = mesh.Vertices()[mesh.Index(lod.first_index + i + k)].tex_coords.x;
+            lo = SDL_min(lo, u);
+            hi = SDL_max(hi, u);
+        }
+        crossings += hi - lo > 0.5f;
+    }
+    return crossings;
+}
+
+static bool CheckCache(const Mesh& mesh)
+{
+    const char* path = "lod_bench.skmesh";
+    std::vector<Mesh> meshes;
+    meshes.push_back(mesh);
+    if (!meshcache::Bake(path, meshes, 1, 1))
+        return false;
+
+    bool ok = false;
+    {
+        meshcache::MeshCache cache;
+        if (cache.Open(path) && cache.MeshCount() == 1)
+        {
+            meshcache::MeshView view = cache.GetMesh(0);
+            ok = view.lod_count == mesh.LodCount() && view.index_count == mesh.IndexCount();
+            for (uint32_t l = 0; ok && l < view.lod_count; l++)
+            {
+                const Mesh::MeshLod& lod = mesh.Lod(l);
+                ok = view.lods[l].first_index == lod.first_index && view.lods[l].index_count == lod.index_count
+                    && view.lods[l].error == lod.error;
+                for (uint32_t i = 0; ok && i < lod.index_count; i++)
+                {
+                    uint32_t index = view.index_size == SDL_GPU_INDEXELEMENTSIZE_16BIT
+                        ? ((const uint16_t*)view.indices)[lod.first_index + i] : ((const uint32_t*)view.indices)[lod.first_index + i];
+                    ok = index == mesh.Index(lod.first_index + i);
+                }
+            }
+        }
+    }
+    SDL_RemovePath(path);
+    SDL_Log(".skmesh LOD round trip: %s", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool BuildChain(const char* name, std::vector<Mesh>& meshes, const lod::LodSettings& settings, bool sphere)
+{
+    bool ok = true;
+    size_t source_triangles = 0;
+    Uint64 start = SDL_GetTicksNS();
+    for (Mesh& mesh : meshes)
+    {
+        // every LOD simplifies the one before
+        lod::GenerateLods(mesh, settings);
+        for (uint32_t l = 0; l + 1 < mesh.LodCount(); l++)
+            source_triangles += mesh.Lod(l).index_count / 3;
+    }
+    double seconds = (SDL_GetTicksNS() - start) / 1e9;
+
+    SDL_Log("%s: %zu meshes, %.1f ms, %.2f M source triangles/s", name, meshes.size(), seconds * 1e3,
+        source_triangles / SDL_max(seconds, 1e-9) / 1e6);
+    for (size_t m = 0; m < meshes.size() && m < 4; m++)
+    {
+        const Mesh& mesh = meshes[m];
+        for (uint32_t l = 0; l < mesh.LodCount(); l++)
+        {
+            const Mesh::MeshLod& lod = mesh.Lod(l);
+            std::string line = "  mesh " + std::to_string(m) + " lod " + std::to_string(l);
+            if (sphere)
+            {
+                uint32_t crossings = SeamCrossings(mesh, lod);
+                SDL_Log("%s  %8u triangles  %5.1f%%  error %.5f  measured %.5f  seam crossings %u", line.c_str(), lod.index_count / 3,
+                    100.0 * lod.index_count / mesh.IndexCount(), lod.error, SphereError(mesh, lod), crossings);
+                ok &= crossings == 0;
+            }
+            else
+            {
+                SDL_Log("%s  %8u triangles  %5.1f%%  error %.5f", line.c_str(), lod.index_count / 3,
+                    100.0 * lod.index_count / mesh.IndexCount(), lod.error);
+            }
+            ok &= l == 0 || lod.error >= mesh.Lod(l - 1).error;
+        }
+    }
+    if (sphere)
+        ok &= meshes[0].LodCount() >= 3 && CheckCache(meshes[0]);
+    return ok;
+}
+
+static void Crowd(const Mesh& mesh, uint32_t instances)
+{
+    const float fov_y = glm::radians(60.0f), height = 1080.0f, pixel_error = 1.0f, hysteresis = 0.25f;
+    Aabb bounds = ComputeBounds(mesh.Vertices().data(), (uint32_t)mesh.Vertices().size());
+    glm::vec3 size = bounds.max - bounds.min;
+    float extent = SDL_max(SDL_max(size.x, size.y), size.z);
+
+    // a crowd filling the view from 2 to 200 extents away
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<float> distance(2.0f * extent, 200.0f * extent);
+    uint64_t full = 0, drawn = 0;
+    uint32_t per_lod[Mesh::kMaxLods] = {};
+    for (uint32_t i = 0; i < instances; i++)
+    {
+        float projected = lod::ProjectedSize(extent, distance(rng), fov_y, height);
+        uint32_t l = lod::SelectLod(&mesh.Lod(0), mesh.LodCount(), projected, pixel_error, 0, hysteresis);
+        per_lod[l]++;
+        full += mesh.IndexCount() / 3;
+        drawn += mesh.Lod(l).index_count / 3;
+    }
+    std::string split;
+    for (uint32_t l = 0; l < mesh.LodCount(); l++)
+        split += " " + std::to_string(per_lod[l]);
+    SDL_Log("crowd of %u: %llu triangles at LOD 0, %llu with LODs (%.1fx fewer), instances per LOD:%s", instances,
+        (unsigned long long)full, (unsigned long long)drawn, (double)full / SDL_max(drawn, 1ull), split.c_str());
+
+    // hover around the distance where LOD 1 takes over, with a bit of jitter every frame
+    if (mesh.LodCount() < 2)
+        return;
+    float switch_size = pixel_error / mesh.Lod(1).error;
+    float switch_distance = extent / (2.0f * tanf(fov_y * 0.5f) * switch_size) * height;
+    for (float h : { 0.0f, hysteresis })
+    {
+        std::uniform_real_distribution<float> jitter(-0.03f, 0.03f);
+        uint32_t current = 0, changes = 0;
+        for (uint32_t frame = 0; frame < 1000; frame++)
+        {
+            float d = switch_distance * (1.0f + 0.05f * sinf(frame * 0.02f) + jitter(rng));
+            uint32_t l = lod::SelectLod(&mesh.Lod(0), mesh.LodCount(), lod::ProjectedSize(extent, d, fov_y, height), pixel_error, current, h);
+            changes += l != current;
+            current = l;
+        }
+        SDL_Log("hysteresis %.2f: %u LOD changes over 1000 frames near the switch", h, changes);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    lod::LodSettings settings;
+    settings.count = Mesh::kMaxLods;
+    uint32_t crowd = 10000;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        // SDL_clamp is a macro, argv is read once. Counts are clamped as signed values so -1 stays small
+        if (SDL_strcmp(argv[i], "--lods") == 0 && i + 1 < argc)
+        {
+            int lods = SDL_atoi(argv[++i]);
+            settings.count = (uint32_t)SDL_clamp(lods, 1, (int)Mesh::kMaxLods);
+        }
+        else if (SDL_strcmp(argv[i], "--ratio") == 0 && i + 1 < argc)
+        {
+            float ratio = (float)SDL_atof(argv[++i]);
+            settings.ratio = SDL_clamp(ratio, 0.05f, 0.95f);
+        }
+        else if (SDL_strcmp(argv[i], "--crowd") == 0 && i + 1 < argc)
+        {
+            int count = SDL_atoi(argv[++i]);
+            crowd = (uint32_t)SDL_clamp(count, 1, 10000000);
+        }
+        else
+            paths.push_back(argv[i]);
+    }
+
+    bool ok = true;
+    std::vector<Mesh> first;
+    if (paths.empty())
+    {
+        std::mt19937 rng(4);
+        std::vector<Mesh> sphere, grid;
+        sphere.push_back(synthetic::MakeSphere(kRings, kSegments, kRadius));
+        grid.push_back(MakeSkinnedGrid(rng));
+        ok &= BuildChain("uv sphere", sphere, settings, true);
+        ok &= BuildChain("skinned grid", grid, settings, false);
+        first = std::move(sphere);
+    }
+    for (const char* path : paths)
+    {
+        // LODs come from here, not from the import
+        model::ImportSettings import;
+        import.lod_count = 1;
+        model::SkinnedModel loaded;
+        if (!model::LoadSkinnedModel(path, loaded, import))
+            return 1;
+        ok &= BuildChain(path, loaded.meshes, settings, false);
+        if (first.empty() && !loaded.meshes.empty())
+            first = std::move(loaded.meshes);
+    }
+
+    if (!first.empty())
+        Crowd(first[0], crowd);
+    SDL_Log("%s", ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+// mesh_bake: offline model -> .skmesh baker.
+//
+// Usage: mesh_bake <model file> <output .skmesh> [--force] [--no-optimize] [--flip-uvs] [--compact] [--lods N]
+//
+// Skips the import when the existing output was baked from the same source
+// contents with the same import settings and vertex layout. --compact stores
+// vertices in vtx::LAYOUT_COMPACT (16 bytes instead of 32). --lods sets how many
+// levels of detail, LOD 0 included, each mesh gets (1 bakes none).
+
+#include <SDL3/SDL.h>
+
+#include "mesh_cache.h"
+#include "model.h"
+
+int main(int argc, char* argv[])
+{
+    const char* paths[2] = { nullptr, nullptr };
+    int path_count = 0;
+    bool force = false;
+    vtx::LayoutId layout = vtx::LAYOUT_FULL;
+    model::ImportSettings settings{};
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--force") == 0)
+            force = true;
+        else if (SDL_strcmp(argv[i], "--no-optimize") == 0)
+            settings.optimize = false;
+        else if (SDL_strcmp(argv[i], "--flip-uvs") == 0)
+            settings.flip_uvs = true;
+        else if (SDL_strcmp(argv[i], "--compact") == 0)
+            layout = vtx::LAYOUT_COMPACT;
+        else if (SDL_strcmp(argv[i], "--lods") == 0 && i + 1 < argc)
+        {
+            // SDL_clamp is a macro, argv is read once
+            int lods = SDL_atoi(argv[++i]);
+            settings.lod_count = (uint32_t)SDL_clamp(lods, 1, (int)Mesh::kMaxLods);
+        }
+        else if (path_count < 2)
+            paths[path_count++] = argv[i];
+    }
+
+    if (path_count != 2)
+    {
+        SDL_Log("usage: mesh_bake <model file> <output .skmesh> [--force] [--no-optimize] [--flip-uvs] [--compact] [--lods N]");
+        return 1;
+    }
+
+    const char* source = paths[0];
+    const char* output = paths[1];
+
+    uint64_t source_hash = meshcache::HashFile(source);
+    if (source_hash == 0)
+    {
+        SDL_Log("Cannot read %s", source);
+        return 1;
+    }
+    uint64_t settings_hash = meshcache::HashSettings(settings);
+
+    if (!force)
+    {
+        meshcache::MeshCache existing;
+        if (existing.Open(output) && existing.SourceHash() == source_hash && existing.SettingsHash() == settings_hash
+            && existing.VertexLayout() == layout)
+        {
+            SDL_Log("%s is up to date", output);
+            return 0;
+        }
+    }
+
+    model::ImportStats stats{};
+    std::vector<Mesh> meshes = model::LoadModel(source, settings, &stats);
+    if (meshes.empty())
+        return 1;
+
+    if (!meshcache::Bake(output, meshes, source_hash, settings_hash, layout))
+        return 1;
+
+    SDL_Log("baked %s -> %s (%s): %zu meshes, %zu vertices, %zu indices, %zu LODs generated (import %.2f ms, LODs %.2f ms)",
+        source, output, vtx::LayoutName(layout), stats.meshes, stats.vertices, stats.indices, stats.lods,
+        stats.parse_ms + stats.process_ms, stats.lod_ms);
+    return 0;
+}
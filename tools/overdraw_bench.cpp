@@ -0,0 +1,244 @@
+// overdraw_bench: fragments shaded and frame time with and without the depth prepass.
+//
+// Usage: overdraw_bench [--frames N] [--objects N] [--spacing S] [--width W] [--height H]
+//                       [--transparent FRACTION] [--mesh file.skmesh] [--driver vulkan]
+//                       [--gpu-culling] [--min-psnr DB]
+//
+// Needs a GPU device but no window, lavapipe works (--driver vulkan, with
+// VK_ICD_FILENAMES pointing at it). Objects sit in a cube grid S units apart,
+// by default closer than their own size so they hide each other, and the
+// camera looks into the grid from its front corner: many layers per pixel.
+// Every FRACTION-th object (0.1 by default) gets a transparent material.
+//
+// Each configuration renders the scene twice. Once with Renderer::Settings::
+// overdraw_view, where every shaded fragment adds one to the red channel, to
+// count fragments the color passes shade: in total, per pixel covered and the
+// most on one pixel (the count saturates at 255). Then normally for N frames,
+// each waiting for the GPU so the frame time covers the GPU work too, as
+// SDL_gpu has no timestamp queries. The last frames of both configurations
+// must match, they fail below --min-psnr (40 dB): a prepass whose depth does
+// not come out exactly like the shading pass's would drop pixels. A pipeline
+// that fails to build draws nothing, so does a missing SPIR-V module: the
+// bench fails when a configuration shades no fragments, draws nothing or, with
+// the prepass, has no prepass draws.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "renderer.h"
+
+struct Result
+{
+    double fragments = 0.0;
+    Uint32 covered = 0;                 // pixels with at least one fragment
+    Uint32 max_layers = 0;
+    Uint32 saturated = 0;               // pixels whose count hit 255
+    std::vector<double> ms;
+    Renderer::FrameStats stats;
+    std::vector<Uint8> frame;
+    bool prepass = false;
+    std::string graph;
+};
+
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t index = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[SDL_clamp(index, (size_t)1, sorted.size()) - 1];
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static Uint32 ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (Uint32)SDL_clamp(value, min, max);
+}
+
+static glm::mat4 ObjectTransform(Uint32 index, Uint32 side, float spacing)
+{
+    float x = (float)(index % side), y = (float)(index / side % side), z = (float)(index / (side * side));
+    float offset = (side - 1) * spacing * 0.5f;
+    glm::mat4 transform(1.0f);
+    transform[3] = glm::vec4(x * spacing - offset, y * spacing - offset, z * spacing - offset, 1.0f);
+    return transform;
+}
+
+struct Scene
+{
+    Uint32 objects;
+    float spacing;
+    float transparent;
+};
+
+// renders the loading frames, then frames more, waiting for the GPU after each
+static bool RenderScene(Renderer::Settings settings, const Scene& scene, Uint32 frames, Result& result)
+{
+    if (!Renderer::Init(settings))
+        return false;
+    result.prepass = Renderer::IsDepthPrepass();
+
+    Uint32 transparent_material = 0;
+    for (Uint32 m = 0; m < Renderer::MaterialCount(); m++)
+    {
+        if (Renderer::IsTransparent(m))
+            transparent_material = m;
+    }
+    Uint32 every = scene.transparent > 0.0f ? (Uint32)SDL_max(1.0f / scene.transparent, 1.0f) : 0;
+    Uint32 side = (Uint32)std::ceil(std::cbrt((double)scene.objects));
+    for (Uint32 i = 0; i < scene.objects; i++)
+    {
+        Uint32 material = every && i % every == every - 1 ? transparent_material : 0;
+        Renderer::AddObject(i % Renderer::MeshCount(), material, ObjectTransform(i, side, scene.spacing));
+    }
+
+    // from the front corner of the grid, far enough to see all of it
+    float extent = side * scene.spacing * 0.5f;
+    Camera& camera = Renderer::GetCamera();
+    camera.target = glm::vec3(0.0f);
+    camera.position = glm::vec3(extent * 1.2f, extent * 0.9f, extent * 3.0f + 2.0f);
+    camera.near_plane = 0.1f;
+    camera.far_plane = extent * 10.0f + 10.0f;
+
+    auto Frame = [&]()
+    {
+        Renderer::PreRender();
+        Renderer::Render();
+        Renderer::PostRender();
+    };
+    Uint32 loading_frames = 0;
+    while (Renderer::IsLoading() && loading_frames < 1000)
+    {
+        Frame();
+        loading_frames++;
+    }
+    Renderer::WaitIdle();
+
+    for (Uint32 f = 0; f < frames; f++)
+    {
+        Uint64 start = SDL_GetTicksNS();
+        Frame();
+        Renderer::WaitIdle();
+        result.ms.push_back((SDL_GetTicksNS() - start) / 1e6);
+    }
+    result.stats = Renderer::GetFrameStats();
+    result.graph = Renderer::GetFrameGraph().Describe();
+
+    Uint32 width, height;
+    bool ok = Renderer::ReadbackFrame(result.frame, width, height);
+    Renderer::Shutdown();
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    Uint32 frames = 100;
+    Scene scene{ 4096, 0.6f, 0.1f };
+    Renderer::Settings settings;
+    settings.headless = true;
+    settings.width = 1280;
+    settings.height = 720;
+    double min_psnr = 40.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--gpu-culling") == 0)
+            settings.gpu_culling = true;
+        else if (i + 1 >= argc)
+            break;
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[++i], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--objects") == 0)
+            scene.objects = ParseCount(argv[++i], 1, 1000000);
+        else if (SDL_strcmp(argv[i], "--spacing") == 0)
+            scene.spacing = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--transparent") == 0)
+            scene.transparent = (float)SDL_atof(argv[++i]);
+        else if (SDL_strcmp(argv[i], "--width") == 0)
+            settings.width = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--height") == 0)
+            settings.height = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--mesh") == 0)
+            settings.mesh_cache_path = argv[++i];
+        else if (SDL_strcmp(argv[i], "--driver") == 0)
+            SDL_SetHint(SDL_HINT_GPU_DRIVER, argv[++i]);
+        else if (SDL_strcmp(argv[i], "--min-psnr") == 0)
+            min_psnr = SDL_atof(argv[++i]);
+    }
+    scene.spacing = SDL_max(scene.spacing, 0.01f);
+    scene.transparent = SDL_clamp(scene.transparent, 0.0f, 1.0f);
+
+    Result results[2];
+    for (int prepass = 0; prepass < 2; prepass++)
+    {
+        Result& result = results[prepass];
+        settings.depth_prepass = prepass != 0;
+
+        // fragment counts first, one frame is enough for a static view
+        Result counted;
+        settings.overdraw_view = true;
+        if (!RenderScene(settings, scene, 1, counted))
+            return 1;
+        for (size_t i = 0; i < counted.frame.size(); i += 4)
+        {
+            Uint32 layers = counted.frame[i];
+            result.fragments += layers;
+            result.covered += layers > 0;
+            result.max_layers = SDL_max(result.max_layers, layers);
+            result.saturated += layers == 255;
+        }
+
+        settings.overdraw_view = false;
+        if (!RenderScene(settings, scene, frames, result))
+            return 1;
+        if (prepass && !result.prepass)
+        {
+            SDL_Log("The depth prepass is unavailable on this device");
+            return 1;
+        }
+        // two empty frames would match, compare only what was drawn
+        if (result.covered == 0 || result.stats.draws == 0 || (prepass && result.stats.prepass_draws == 0))
+        {
+            SDL_Log("Nothing was drawn %s the prepass, are the shaders in res/shaders/compiled built?", prepass ? "with" : "without");
+            return 1;
+        }
+        if (prepass)
+            SDL_Log("frame graph:\n%s", result.graph.c_str());
+    }
+
+    SDL_Log("%u objects %.2f apart, %.0f%% transparent, %ux%u, culling on the %s, %u frames each",
+        scene.objects, scene.spacing, scene.transparent * 100.0f, settings.width, settings.height,
+        settings.gpu_culling ? "GPU" : "CPU", frames);
+    double pixels = (double)settings.width * settings.height;
+    for (Result& result : results)
+    {
+        std::sort(result.ms.begin(), result.ms.end());
+        double total = 0.0;
+        for (double ms : result.ms)
+            total += ms;
+        SDL_Log("%-12s fragments %10.0f  per covered pixel %5.2f  per pixel %5.2f  max %3u%s", result.prepass ? "prepass" : "no prepass",
+            result.fragments, result.fragments / SDL_max(result.covered, 1u), result.fragments / pixels, result.max_layers,
+            result.saturated ? " (saturated)" : "");
+        SDL_Log("%-12s frame mean %7.3f  p50 %7.3f  p90 %7.3f ms   draws %u  prepass draws %u  triangles %llu", "",
+            total / result.ms.size(), Percentile(result.ms, 50.0), Percentile(result.ms, 90.0), result.stats.draws,
+            result.stats.prepass_draws, (unsigned long long)result.stats.triangles);
+    }
+    const Result& off = results[0];
+    const Result& on = results[1];
+    SDL_Log("the prepass shades %.1f%% of the fragments, frame time p50 %.2fx", 100.0 * on.fragments / SDL_max(off.fragments, 1.0),
+        Percentile(on.ms, 50.0) / Percentile(off.ms, 50.0));
+
+    double error = 0.0;
+    for (size_t i = 0; i < off.frame.size() && i < on.frame.size(); i++)
+    {
+        if (i % 4 == 3)
+            continue;
+        double diff = (double)off.frame[i] - (double)on.frame[i];
+        error += diff * diff;
+    }
+    double mse = error / SDL_max((double)off.frame.size() / 4 * 3, 1.0);
+    double psnr = mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+    bool ok = off.frame.size() == on.frame.size() && psnr >= min_psnr;
+    SDL_Log("frames with and without the prepass: PSNR %.2f dB: %s", psnr, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+// profiler_bench: cost of a profiler zone and a check of the capture path.
+//
+// Usage: profiler_bench [--zones N] [--threads T] [--trace trace.json]
+//
+// Times N empty loop iterations against N iterations that each open and close
+// a zone and reports the difference in ns per zone, single threaded and with
+// T threads recording at once. Then captures a few frames of nested zones and
+// counters from T threads, checks every event arrived and optionally writes
+// them as Chrome trace JSON. Built with SKELETAL_PROFILE=0 the zone loop
+// compiles to nothing and the capture check is skipped.
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "profiler.h"
+
+// keeps the loop alive when the zone compiles away
+static std::atomic<uint32_t> g_sink{ 0 };
+
+static double TimeZones(uint32_t zones, bool with_zone)
+{
+    Uint64 start = SDL_GetTicksNS();
+    uint32_t local = 0;
+    for (uint32_t i = 0; i < zones; i++)
+    {
+        if (with_zone)
+        {
+            PROFILE_ZONE("bench zone");
+            local += i;
+        }
+        else
+        {
+            local += i;
+        }
+        // drain often enough that the ring never drops
+        if ((i & (profiler::kRingCapacity / 2 - 1)) == 0)
+            PROFILE_FRAME();
+    }
+    g_sink.fetch_add(local, std::memory_order_relaxed);
+    return (double)(SDL_GetTicksNS() - start) / zones;
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t zones = 10000000;
+    uint32_t threads = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores(), 2);
+    const char* trace = nullptr;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--zones") == 0)
+            zones = (uint32_t)SDL_max(SDL_atoi(argv[i + 1]), 1);
+        else if (SDL_strcmp(argv[i], "--threads") == 0)
+            threads = (uint32_t)SDL_max(SDL_atoi(argv[i + 1]), 1);
+        else if (SDL_strcmp(argv[i], "--trace") == 0)
+            trace = argv[i + 1];
+    }
+
+    PROFILE_THREAD("main");
+    SDL_Log("SKELETAL_PROFILE=%d", SKELETAL_PROFILE);
+
+    double empty = TimeZones(zones, false);
+    double zoned = TimeZones(zones, true);
+    SDL_Log("1 thread: %.2f ns per zone (loop %.2f ns, with zone %.2f ns)", zoned - empty, empty, zoned);
+
+    // every thread writes its own ring, the cost should not grow with the thread count.
+    // Drained only at the end, so the per-thread count stays under the ring size
+    uint32_t per_thread = SDL_min(zones, profiler::kRingCapacity - 1);
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> total_ns{ 0 };
+    for (uint32_t t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&]
+        {
+            Uint64 start = SDL_GetTicksNS();
+            uint32_t local = 0;
+            for (uint32_t i = 0; i < per_thread; i++)
+            {
+                PROFILE_ZONE("bench zone");
+                local += i;
+            }
+            total_ns.fetch_add(SDL_GetTicksNS() - start);
+            g_sink.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+    PROFILE_FRAME();
+    SDL_Log("%u threads: %.2f ns per zone and iteration", threads, (double)total_ns.load() / ((double)per_thread * threads));
+
+#if SKELETAL_PROFILE
+    // capture: nested zones and a counter per frame from every thread
+    const uint32_t frames = 4, zones_per_frame = 1000;
+    uint64_t dropped = profiler::DroppedEvents();
+    profiler::BeginCapture();
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        workers.clear();
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            workers.emplace_back([t]
+            {
+                std::string name = "bench worker " + std::to_string(t);
+                PROFILE_THREAD(name.c_str());
+                PROFILE_ZONE("outer");
+                for (uint32_t i = 0; i < zones_per_frame; i++)
+                {
+                    PROFILE_ZONE("inner");
+                }
+                PROFILE_COUNTER("bench counter", t);
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        PROFILE_FRAME();
+    }
+    profiler::EndCapture();
+
+    // per thread and frame: inner zones, the outer zone and the counter, plus one frame marker per frame
+    size_t expected = (size_t)frames * threads * (zones_per_frame + 2) + frames;
+    size_t captured = profiler::CapturedEvents();
+    bool ok = captured == expected && profiler::DroppedEvents() == dropped;
+    SDL_Log("capture: %zu events, expected %zu, %llu dropped: %s", captured, expected,
+        (unsigned long long)(profiler::DroppedEvents() - dropped), ok ? "ok" : "FAILED");
+    if (trace && !profiler::WriteChromeTrace(trace))
+        ok = false;
+    return ok ? 0 : 1;
+#else
+    (void)trace;
+    SDL_Log("profiling compiled out, capture check skipped");
+    return 0;
+#endif
+}
@@ -0,0 +1,222 @@
+// reload_check: HotReload's dependency tracking and build scheduling.
+//
+// Usage: reload_check [--threads N]
+//
+// Builds a small shader tree in reload_check.tmp/ with a stand-in compiler (a
+// shell script that sleeps, then copies the source, and fails when the source
+// says "error"), watches it and edits files the way an editor would. Checks
+// that stale outputs compile at startup in parallel and up to date ones do not,
+// that editing an include rebuilds exactly the shaders that include it, that a
+// burst of writes builds once, that an include added by an edit is picked up,
+// that an edit during a build runs it again with the new contents, that a
+// failed build keeps the last good output, and that tracked files come back
+// as changes. Needs no GPU, exits non-zero if a check fails. POSIX only, for
+// the stand-in compiler.
+
+#include <SDL3/SDL.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "hot_reload.h"
+
+static const char* const kRoot = "reload_check.tmp";
+static const float kCompileSeconds = 0.2f;
+
+static bool WriteText(const std::string& path, const std::string& text)
+{
+    return SDL_SaveFile(path.c_str(), text.data(), text.size());
+}
+
+static std::string ReadText(const std::string& path)
+{
+    size_t size;
+    char* data = (char*)SDL_LoadFile(path.c_str(), &size);
+    if (!data)
+        return std::string();
+    std::string text(data, size);
+    SDL_free(data);
+    return text;
+}
+
+static SDL_EnumerationResult SDLCALL RemoveEntry(void*, const char* dirname, const char* fname)
+{
+    std::string path = std::string(dirname) + fname;
+    SDL_PathInfo info;
+    if (SDL_GetPathInfo(path.c_str(), &info) && info.type == SDL_PATHTYPE_DIRECTORY)
+        SDL_EnumerateDirectory(path.c_str(), RemoveEntry, nullptr);
+    SDL_RemovePath(path.c_str());
+    return SDL_ENUM_CONTINUE;
+}
+
+static void RemoveTree(const char* path)
+{
+    SDL_EnumerateDirectory(path, RemoveEntry, nullptr);
+    SDL_RemovePath(path);
+}
+
+// polls like a frame loop until nothing is settling or building, returns the seconds it took
+static float Pump(HotReload& reload, std::vector<HotReload::Change>& changes)
+{
+    Uint64 start = SDL_GetTicksNS();
+    // the first poll may come before the watcher has seen the last write
+    reload.Poll(changes);
+    SDL_Delay(20);
+    for (;;)
+    {
+        reload.Poll(changes);
+        if (reload.IsIdle() || SDL_GetTicksNS() - start > 10 * SDL_NS_PER_SECOND)
+            break;
+        SDL_Delay(5);
+    }
+    return (float)(SDL_GetTicksNS() - start) / SDL_NS_PER_SECOND;
+}
+
+static uint32_t CountChanges(const std::vector<HotReload::Change>& changes, HotReload::Kind kind, const std::string& path)
+{
+    uint32_t count = 0;
+    for (const HotReload::Change& change : changes)
+        count += change.kind == kind && change.path == HotReload::NormalizePath(path);
+    return count;
+}
+
+static bool Check(bool ok, const char* what)
+{
+    SDL_Log("%-52s %s", what, ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    HotReload::Settings settings;
+    settings.build_threads = 4;
+    settings.settle_ms = 50;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            // SDL_clamp is a macro, argv is read once. Clamped as a signed value so -1 stays small
+            int threads = SDL_atoi(argv[++i]);
+            settings.build_threads = (uint32_t)SDL_clamp(threads, 1, 64);
+        }
+    }
+
+    const std::string root = kRoot, code = root + "/code", compiled = root + "/compiled";
+    RemoveTree(kRoot);
+    SDL_CreateDirectory(code.c_str());
+    SDL_CreateDirectory((root + "/textures").c_str());
+
+    settings.shader_compiler = root + "/compile.sh";
+    WriteText(settings.shader_compiler,
+        "#!/bin/sh\n"
+        "sleep " + std::to_string(kCompileSeconds) + "\n"
+        "if grep -q error \"$1\"; then echo \"$1: error: asked to fail\"; exit 1; fi\n"
+        "cat \"$1\" > \"$3\"\n");
+    chmod(settings.shader_compiler.c_str(), 0755);
+
+    const std::string common = code + "/common.glsl", lights = code + "/lights.glsl";
+    const std::string a = code + "/a.vert", b = code + "/b.vert", c = code + "/c.frag", d = code + "/d.frag";
+    const std::string a_out = compiled + "/avert.spv", b_out = compiled + "/bvert.spv";
+    const std::string c_out = compiled + "/cfrag.spv", d_out = compiled + "/dfrag.spv";
+    const std::string texture = root + "/textures/wall.bmp";
+    WriteText(common, "// common\n");
+    WriteText(lights, "// lights\n");
+    WriteText(a, "#include \"common.glsl\"\n// a\n");
+    WriteText(b, "  # include \"common.glsl\"\n// b\n");
+    WriteText(c, "#include \"./common.glsl\"\n// c\n");
+    WriteText(d, "// d\n");
+    WriteText(texture, "v1");
+
+    bool ok = true;
+    std::vector<HotReload::Change> changes;
+    {
+        HotReload reload(settings);
+        reload.Watch(root);
+        uint32_t shaders = reload.AddShaderDirectory(code, compiled);
+        for (const std::string& output : { a_out, b_out, c_out, d_out })
+            reload.Track(output, HotReload::KIND_SHADER);
+        reload.Track(texture, HotReload::KIND_TEXTURE);
+
+        float seconds = Pump(reload, changes);
+        float serial = shaders * kCompileSeconds;
+        SDL_Log("startup: %u shaders in %.2f s, %.2f s one at a time on %u threads", shaders, seconds, serial,
+            settings.build_threads);
+        ok &= Check(shaders == 4 && reload.GetStats().builds == 4 && ReadText(a_out) == ReadText(a),
+            "missing outputs compile at startup");
+        ok &= Check(settings.build_threads == 1 || seconds < serial * 0.75f, "startup builds run in parallel");
+        ok &= Check(CountChanges(changes, HotReload::KIND_SHADER, a_out) == 1 && changes.size() == 4,
+            "each compiled output reported once");
+    }
+
+    HotReload reload(settings);
+    reload.Watch(root);
+    reload.AddShaderDirectory(code, compiled);
+    for (const std::string& output : { a_out, b_out, c_out, d_out })
+        reload.Track(output, HotReload::KIND_SHADER);
+    reload.Track(texture, HotReload::KIND_TEXTURE);
+    ok &= Check(reload.IsIdle() && reload.GetStats().up_to_date == 4, "up to date outputs are not rebuilt");
+
+    // an include edit rebuilds its three readers, not d
+    changes.clear();
+    WriteText(common, "// common v2\n");
+    Pump(reload, changes);
+    ok &= Check(reload.GetStats().builds == 3 && CountChanges(changes, HotReload::KIND_SHADER, d_out) == 0
+        && CountChanges(changes, HotReload::KIND_SHADER, c_out) == 1, "include edit rebuilds only its dependents");
+
+    // an editor saving in several quick writes
+    changes.clear();
+    uint32_t builds = reload.GetStats().builds;
+    for (int i = 0; i < 5; i++)
+    {
+        WriteText(a, "#include \"common.glsl\"\n// a v" + std::to_string(i) + "\n");
+        reload.Poll(changes);
+        SDL_Delay(10);
+    }
+    Pump(reload, changes);
+    ok &= Check(reload.GetStats().builds == builds + 1 && ReadText(a_out) == ReadText(a), "a burst of writes builds once");
+
+    // d starts including lights, whose edits then rebuild it
+    WriteText(d, "#include \"lights.glsl\"\n// d v2\n");
+    Pump(reload, changes);
+    builds = reload.GetStats().builds;
+    changes.clear();
+    WriteText(lights, "// lights v2\n");
+    Pump(reload, changes);
+    ok &= Check(reload.GetStats().builds == builds + 1 && CountChanges(changes, HotReload::KIND_SHADER, d_out) == 1,
+        "include added by an edit is tracked");
+
+    // written again while compiling: the build runs again and ends with the last contents
+    WriteText(c, "#include \"common.glsl\"\n// c v2\n");
+    Uint64 start = SDL_GetTicksNS();
+    while (SDL_GetTicksNS() - start < (settings.settle_ms + 50) * SDL_NS_PER_MS)
+    {
+        reload.Poll(changes);
+        SDL_Delay(5);
+    }
+    WriteText(c, "#include \"common.glsl\"\n// c v3\n");
+    Pump(reload, changes);
+    ok &= Check(ReadText(c_out) == ReadText(c), "edit during a build rebuilds with the new contents");
+
+    // a broken edit keeps the last good output and reports nothing to reload
+    std::string good = ReadText(b_out);
+    uint32_t failures = reload.GetStats().build_failures;
+    changes.clear();
+    WriteText(b, "#include \"common.glsl\"\nerror\n");
+    Pump(reload, changes);
+    ok &= Check(reload.GetStats().build_failures == failures + 1 && ReadText(b_out) == good
+        && CountChanges(changes, HotReload::KIND_SHADER, b_out) == 0, "failed build keeps the last good output");
+    WriteText(b, "#include \"common.glsl\"\n// b v2\n");
+    Pump(reload, changes);
+    ok &= Check(ReadText(b_out) == ReadText(b), "fixed source builds again");
+
+    changes.clear();
+    WriteText(texture, "v2");
+    Pump(reload, changes);
+    ok &= Check(CountChanges(changes, HotReload::KIND_TEXTURE, texture) == 1, "tracked texture edit reported");
+
+    const HotReload::Stats& stats = reload.GetStats();
+    SDL_Log("%u file events, %u builds, %u failed, %u changes reported", stats.file_events, stats.builds, stats.build_failures, stats.changes);
+
+    RemoveTree(kRoot);
+    return ok ? 0 : 1;
+}
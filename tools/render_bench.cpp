@@ -0,0 +1,275 @@
+// render_bench: frame timing of the whole renderer on a scripted scene, headless.
+//
+// Usage: render_bench [--frames N] [--objects N] [--width W] [--height H]
+//                     [--mesh file.skmesh] [--driver vulkan] [--gpu-sync] [--gpu-culling]
+//                     [--golden file.ppm] [--write-golden file.ppm] [--min-psnr DB]
+//                     [--trace trace.json]
+//
+// Needs a GPU device but no window: a software Vulkan driver such as lavapipe
+// works (--driver vulkan, with VK_ICD_FILENAMES pointing at it). Objects sit in
+// a cube grid, the camera orbits it once over the run and a tenth of the
+// objects bob up and down every frame, so culling, sorting, instance uploads
+// and draws all do real work. Frames are only measured once textures and
+// pipelines are done loading.
+//
+// Reports CPU frame time percentiles (PreRender + Render + PostRender, without
+// waiting for a frame in flight to free up) and the average visible objects,
+// draws, instances and triangles. SDL_gpu has no
+// timestamp queries, so with --gpu-sync each frame also waits for the GPU and
+// the time from submit to idle is reported as an upper bound of its GPU time.
+//
+// The last frame can be written as a golden image or compared with one; the
+// comparison fails below --min-psnr (40 dB by default). --trace writes the
+// profiler zones of the measured frames as Chrome trace JSON. --gpu-culling
+// culls and picks LODs in a compute pass and draws with indirect commands;
+// visible objects and instances are then only known to the GPU and read 0.
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+#include "renderer.h"
+
+static double Percentile(const std::vector<double>& sorted, double p)
+{
+    size_t index = (size_t)std::ceil(p / 100.0 * sorted.size());
+    return sorted[SDL_clamp(index, (size_t)1, sorted.size()) - 1];
+}
+
+static void Report(const char* label, std::vector<double> ms)
+{
+    std::sort(ms.begin(), ms.end());
+    double total = 0.0;
+    for (double value : ms)
+        total += value;
+    SDL_Log("%-22s mean %6.3f   p50 %6.3f   p90 %6.3f   p99 %6.3f   max %6.3f ms", label, total / ms.size(),
+        Percentile(ms, 50.0), Percentile(ms, 90.0), Percentile(ms, 99.0), ms.back());
+}
+
+// binary PPM, alpha dropped: viewable anywhere and trivial to diff
+static bool WritePPM(const char* path, const std::vector<Uint8>& rgba, Uint32 width, Uint32 height)
+{
+    std::string header = "P6\n" + std::to_string(width) + " " + std::to_string(height) + "\n255\n";
+    std::vector<Uint8> file(header.begin(), header.end());
+    file.reserve(file.size() + (size_t)width * height * 3);
+    for (size_t i = 0; i < (size_t)width * height; i++)
+        file.insert(file.end(), &rgba[i * 4], &rgba[i * 4] + 3);
+    if (!SDL_SaveFile(path, file.data(), file.size()))
+    {
+        SDL_Log("Failed to write %s: %s", path, SDL_GetError());
+        return false;
+    }
+    return true;
+}
+
+static bool ReadPPM(const char* path, std::vector<Uint8>& rgb, Uint32& width, Uint32& height)
+{
+    size_t size = 0;
+    char* data = (char*)SDL_LoadFile(path, &size);
+    if (!data)
+    {
+        SDL_Log("Failed to read %s: %s", path, SDL_GetError());
+        return false;
+    }
+    int w = 0, h = 0, max = 0, offset = 0;
+    bool ok = SDL_sscanf(data, "P6 %d %d %d%n", &w, &h, &max, &offset) == 3 && w > 0 && h > 0 && max == 255 &&
+              size >= (size_t)offset + 1 + (size_t)w * h * 3;
+    if (ok)
+    {
+        width = (Uint32)w;
+        height = (Uint32)h;
+        rgb.assign(data + offset + 1, data + offset + 1 + (size_t)w * h * 3);
+    }
+    else
+    {
+        SDL_Log("%s is not a binary 8-bit PPM", path);
+    }
+    SDL_free(data);
+    return ok;
+}
+
+static glm::mat4 ObjectTransform(Uint32 index, Uint32 side, float spacing, float lift)
+{
+    float x = (float)(index % side), y = (float)(index / side % side), z = (float)(index / (side * side));
+    float offset = (side - 1) * spacing * 0.5f;
+    glm::mat4 transform(1.0f);
+    transform[3] = glm::vec4(x * spacing - offset, y * spacing - offset + lift, z * spacing - offset, 1.0f);
+    return transform;
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static Uint32 ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (Uint32)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    Uint32 frames = 500, objects = 4096;
+    Renderer::Settings settings;
+    settings.headless = true;
+    settings.width = 1280;
+    settings.height = 720;
+    bool gpu_sync = false;
+    const char* golden = nullptr;
+    const char* write_golden = nullptr;
+    const char* trace = nullptr;
+    double min_psnr = 40.0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--gpu-sync") == 0)
+            gpu_sync = true;
+        else if (SDL_strcmp(argv[i], "--gpu-culling") == 0)
+            settings.gpu_culling = true;
+        else if (i + 1 >= argc)
+            break;
+        else if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[++i], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--objects") == 0)
+            objects = ParseCount(argv[++i], 1, 1000000);
+        else if (SDL_strcmp(argv[i], "--width") == 0)
+            settings.width = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--height") == 0)
+            settings.height = ParseCount(argv[++i], 1, 16384);
+        else if (SDL_strcmp(argv[i], "--mesh") == 0)
+            settings.mesh_cache_path = argv[++i];
+        else if (SDL_strcmp(argv[i], "--driver") == 0)
+            SDL_SetHint(SDL_HINT_GPU_DRIVER, argv[++i]);
+        else if (SDL_strcmp(argv[i], "--golden") == 0)
+            golden = argv[++i];
+        else if (SDL_strcmp(argv[i], "--write-golden") == 0)
+            write_golden = argv[++i];
+        else if (SDL_strcmp(argv[i], "--trace") == 0)
+            trace = argv[++i];
+        else if (SDL_strcmp(argv[i], "--min-psnr") == 0)
+            min_psnr = SDL_atof(argv[++i]);
+    }
+    if (!Renderer::Init(settings))
+        return 1;
+
+    // meshes round robin over a cube grid
+    Uint32 side = (Uint32)std::ceil(std::cbrt((double)objects));
+    const float spacing = 1.5f;
+    for (Uint32 i = 0; i < objects; i++)
+        Renderer::AddObject(i % Renderer::MeshCount(), 0, ObjectTransform(i, side, spacing, 0.0f));
+
+    // the orbit sees the whole grid from outside
+    float radius = side * spacing * 1.5f + 2.0f;
+    Camera& camera = Renderer::GetCamera();
+    camera.target = glm::vec3(0.0f);
+    camera.near_plane = 0.1f;
+    camera.far_plane = radius * 3.0f;
+    auto Script = [&](Uint32 frame)
+    {
+        float angle = 6.2831853f * frame / frames;
+        camera.position = glm::vec3(std::sin(angle) * radius, radius * 0.3f, std::cos(angle) * radius);
+        for (Uint32 i = frame % 10; i < objects; i += 10)
+            Renderer::SetObjectTransform(i, ObjectTransform(i, side, spacing, std::sin(frame * 0.1f + i) * 0.25f));
+    };
+
+    // streaming and background pipeline creation finish before the clock starts
+    Uint32 loading_frames = 0;
+    Uint64 loading_start = SDL_GetTicksNS();
+    while (Renderer::IsLoading() && loading_frames < 1000)
+    {
+        Script(0);
+        Renderer::PreRender();
+        Renderer::Render();
+        Renderer::PostRender();
+        loading_frames++;
+    }
+    Renderer::WaitIdle();
+    SDL_Log("loading: %u frames, %.1f ms%s", loading_frames, (SDL_GetTicksNS() - loading_start) / 1e6,
+        Renderer::IsLoading() ? " (gave up waiting)" : "");
+
+    if (trace)
+        profiler::BeginCapture();
+
+    std::vector<double> cpu_ms, gpu_ms;
+    cpu_ms.reserve(frames);
+    double visible = 0.0, draws = 0.0, instances = 0.0, triangles = 0.0;
+    for (Uint32 frame = 0; frame < frames; frame++)
+    {
+        Uint64 start = SDL_GetTicksNS();
+        Script(frame);
+        Renderer::PreRender();
+        Renderer::Render();
+        Renderer::PostRender();
+        Uint64 submitted = SDL_GetTicksNS();
+        const Renderer::FrameStats& stats = Renderer::GetFrameStats();
+        cpu_ms.push_back((submitted - start - stats.wait_ns) / 1e6);
+        if (gpu_sync)
+        {
+            Renderer::WaitIdle();
+            gpu_ms.push_back((SDL_GetTicksNS() - submitted) / 1e6);
+        }
+
+        visible += stats.visible;
+        draws += stats.draws;
+        instances += stats.instances;
+        triangles += (double)stats.triangles;
+    }
+    Renderer::WaitIdle();
+
+    if (trace)
+    {
+        profiler::EndCapture();
+        if (!SKELETAL_PROFILE)
+            SDL_Log("built with SKELETAL_PROFILE=0, the trace only has thread names");
+        profiler::WriteChromeTrace(trace);
+    }
+
+    SDL_Log("%u frames at %ux%u, %u objects (%u meshes), culling on the %s", frames, settings.width, settings.height, objects,
+        Renderer::MeshCount(), Renderer::IsGpuCulling() ? "GPU" : "CPU");
+    Report("cpu frame", cpu_ms);
+    if (gpu_sync)
+        Report("gpu submit to idle", gpu_ms);
+    SDL_Log("per frame: %.0f visible, %.1f draws, %.0f instances, %.0f triangles", visible / frames, draws / frames,
+        instances / frames, triangles / frames);
+
+    bool ok = true;
+    if (golden || write_golden)
+    {
+        std::vector<Uint8> rgba;
+        Uint32 width, height;
+        ok = Renderer::ReadbackFrame(rgba, width, height);
+        if (ok && write_golden)
+            ok = WritePPM(write_golden, rgba, width, height);
+        if (ok && golden)
+        {
+            std::vector<Uint8> reference;
+            Uint32 ref_width, ref_height;
+            ok = ReadPPM(golden, reference, ref_width, ref_height);
+            if (ok && (ref_width != width || ref_height != height))
+            {
+                SDL_Log("golden image is %ux%u, the frame %ux%u", ref_width, ref_height, width, height);
+                ok = false;
+            }
+            if (ok)
+            {
+                double error = 0.0;
+                int max_diff = 0;
+                for (size_t i = 0; i < (size_t)width * height; i++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        int diff = SDL_abs((int)rgba[i * 4 + c] - (int)reference[i * 3 + c]);
+                        error += (double)diff * diff;
+                        max_diff = SDL_max(max_diff, diff);
+                    }
+                }
+                double mse = error / ((double)width * height * 3);
+                double psnr = mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+                ok = psnr >= min_psnr;
+                SDL_Log("golden %s: PSNR %.2f dB, max channel difference %d: %s", golden, psnr, max_diff, ok ? "ok" : "FAILED");
+            }
+        }
+    }
+
+    Renderer::Shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// shader_check: validation of the SPIR-V reflection and pipeline description hashing.
+//
+// Usage: shader_check [--dir res/shaders/compiled]
+//
+// Reflects every compiled shader the renderer ships and compares stage,
+// resource counts and vertex inputs with what the GLSL in res/shaders/code
+// declares. Shaders that only exist when glslc was available at build time
+// are checked when present. Two hand assembled modules cover what the
+// committed shaders do not use: uniform and storage buffers in both SPIR-V
+// spellings, storage image arrays, builtins and compute local size. Finally
+// checks that every PipelineDesc field feeds its hash and that the cache
+// hands out one pipeline per distinct description. Needs no GPU, exits
+// non-zero on the first mismatch.
+
+#include <SDL3/SDL.h>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "pipeline_cache.h"
+#include "spirv_reflect.h"
+
+struct Expected
+{
+    const char* file;
+    bool optional;                  // built from source only when glslc is around
+    SDL_GPUShaderStage stage;
+    uint32_t samplers;
+    uint32_t storage_buffers;
+    uint32_t uniform_buffers;
+    std::vector<SDL_GPUVertexElementFormat> inputs;     // by location
+};
+
+static bool g_ok = true;
+
+static void Check(bool condition, const char* what, const char* file)
+{
+    if (!condition)
+    {
+        SDL_Log("  %s: %s mismatch", file, what);
+        g_ok = false;
+    }
+}
+
+static void CheckReflection(const spirv::Reflection& r, const Expected& e, const char* name)
+{
+    Check(r.stage == e.stage, "stage", name);
+    Check(r.entry_point == "main", "entry point", name);
+    Check(r.samplers == e.samplers, "sampler count", name);
+    Check(r.storage_buffers == e.storage_buffers, "storage buffer count", name);
+    Check(r.uniform_buffers == e.uniform_buffers, "uniform buffer count", name);
+    Check(r.inputs.size() == e.inputs.size(), "vertex input count", name);
+    for (size_t i = 0; i < r.inputs.size() && i < e.inputs.size(); i++)
+    {
+        Check(r.inputs[i].location == i, "vertex input location", name);
+        Check(r.inputs[i].format == e.inputs[i], "vertex input format", name);
+    }
+    Check(spirv::ValidateLayout(r, name), "descriptor set layout", name);
+}
+
+// ---------------------------------------------------------------------------
+// hand assembled modules
+
+struct Assembler
+{
+    std::vector<uint32_t> words = { 0x07230203, 0x00010000, 0, 64, 0 };
+
+    void Op(uint32_t op, std::initializer_list<uint32_t> operands)
+    {
+        words.push_back((uint32_t)(operands.size() + 1) << 16 | op);
+        words.insert(words.end(), operands);
+    }
+
+    // op, leading operands, a string, trailing operands
+    void OpString(uint32_t op, std::initializer_list<uint32_t> before, const char* text, std::initializer_list<uint32_t> after = {})
+    {
+        size_t length = SDL_strlen(text) + 1;
+        size_t string_words = (length + 3) / 4;
+        words.push_back((uint32_t)(1 + before.size() + string_words + after.size()) << 16 | op);
+        words.insert(words.end(), before);
+        size_t at = words.size();
+        words.resize(at + string_words, 0);
+        SDL_memcpy(words.data() + at, text, length);
+        words.insert(words.end(), after);
+    }
+};
+
+enum { OpName = 5, OpEntryPoint = 15, OpExecutionMode = 16, OpTypeInt = 21, OpTypeFloat = 22, OpTypeVector = 23,
+       OpTypeImage = 25, OpTypeSampledImage = 27, OpTypeArray = 28, OpTypeRuntimeArray = 29, OpTypeStruct = 30,
+       OpTypePointer = 32, OpConstant = 43, OpVariable = 59, OpDecorate = 71, OpMemberDecorate = 72 };
+enum { Block = 2, BufferBlock = 3, BuiltIn = 11, NonWritable = 24, Location = 30, Binding = 33, DescriptorSet = 34 };
+enum { UniformConstant = 0, Input = 1, Uniform = 2, StorageBuffer = 12 };
+
+// compute: readonly SSBO (set 0), old style BufferBlock SSBO and image2D[4] (set 1), UBO (set 2)
+static std::vector<uint32_t> ComputeModule()
+{
+    Assembler a;
+    a.OpString(OpEntryPoint, { 5, 1 }, "main", { 20 });
+    a.Op(OpExecutionMode, { 1, 17, 64, 2, 1 });
+    a.OpString(OpName, { 7 }, "params");
+    a.OpString(OpName, { 11 }, "input_data");
+    a.OpString(OpName, { 14 }, "output_data");
+    a.OpString(OpName, { 21 }, "images");
+    a.Op(OpDecorate, { 5, Block });
+    a.Op(OpDecorate, { 7, DescriptorSet, 2 });
+    a.Op(OpDecorate, { 7, Binding, 0 });
+    a.Op(OpDecorate, { 9, Block });
+    a.Op(OpMemberDecorate, { 9, 0, NonWritable });
+    a.Op(OpDecorate, { 11, DescriptorSet, 0 });
+    a.Op(OpDecorate, { 11, Binding, 0 });
+    a.Op(OpDecorate, { 12, BufferBlock });
+    a.Op(OpDecorate, { 14, DescriptorSet, 1 });
+    a.Op(OpDecorate, { 14, Binding, 0 });
+    a.Op(OpDecorate, { 21, DescriptorSet, 1 });
+    a.Op(OpDecorate, { 21, Binding, 1 });
+    a.Op(OpDecorate, { 20, BuiltIn, 28 });
+    a.Op(OpTypeFloat, { 2, 32 });
+    a.Op(OpTypeInt, { 3, 32, 0 });
+    a.Op(OpTypeVector, { 4, 2, 4 });
+    a.Op(OpTypeStruct, { 5, 4 });
+    a.Op(OpTypePointer, { 6, Uniform, 5 });
+    a.Op(OpVariable, { 6, 7, Uniform });
+    a.Op(OpTypeRuntimeArray, { 8, 4 });
+    a.Op(OpTypeStruct, { 9, 8 });
+    a.Op(OpTypePointer, { 10, StorageBuffer, 9 });
+    a.Op(OpVariable, { 10, 11, StorageBuffer });
+    a.Op(OpTypeStruct, { 12, 8 });
+    a.Op(OpTypePointer, { 13, Uniform, 12 });
+    a.Op(OpVariable, { 13, 14, Uniform });
+    a.Op(OpTypeImage, { 15, 2, 1, 0, 0, 0, 2, 1 });
+    a.Op(OpConstant, { 3, 17, 4 });
+    a.Op(OpTypeArray, { 18, 15, 17 });
+    a.Op(OpTypePointer, { 19, UniformConstant, 18 });
+    a.Op(OpVariable, { 19, 21, UniformConstant });
+    a.Op(OpTypeVector, { 22, 3, 3 });
+    a.Op(OpTypePointer, { 23, Input, 22 });
+    a.Op(OpVariable, { 23, 20, Input });
+    return a.words;
+}
+
+// vertex: vec3 / ivec2 / uvec4 inputs plus gl_VertexIndex, a vertex sampler (set 0) and a UBO (set 1)
+static std::vector<uint32_t> VertexModule()
+{
+    Assembler a;
+    a.OpString(OpEntryPoint, { 0, 1 }, "main", { 10, 11, 12, 13 });
+    a.OpString(OpName, { 10 }, "a_position");
+    a.OpString(OpName, { 11 }, "a_cell");
+    a.OpString(OpName, { 12 }, "a_joints");
+    a.Op(OpDecorate, { 10, Location, 0 });
+    a.Op(OpDecorate, { 11, Location, 1 });
+    a.Op(OpDecorate, { 12, Location, 2 });
+    a.Op(OpDecorate, { 13, BuiltIn, 42 });
+    a.Op(OpDecorate, { 17, DescriptorSet, 0 });
+    a.Op(OpDecorate, { 17, Binding, 0 });
+    a.Op(OpDecorate, { 18, Block });
+    a.Op(OpDecorate, { 20, DescriptorSet, 1 });
+    a.Op(OpDecorate, { 20, Binding, 0 });
+    a.Op(OpTypeFloat, { 2, 32 });
+    a.Op(OpTypeInt, { 3, 32, 1 });
+    a.Op(OpTypeInt, { 4, 32, 0 });
+    a.Op(OpTypeVector, { 5, 2, 3 });
+    a.Op(OpTypeVector, { 6, 3, 2 });
+    a.Op(OpTypeVector, { 7, 4, 4 });
+    a.Op(OpTypePointer, { 21, Input, 5 });
+    a.Op(OpTypePointer, { 22, Input, 6 });
+    a.Op(OpTypePointer, { 23, Input, 7 });
+    a.Op(OpTypePointer, { 24, Input, 3 });
+    a.Op(OpVariable, { 21, 10, Input });
+    a.Op(OpVariable, { 22, 11, Input });
+    a.Op(OpVariable, { 23, 12, Input });
+    a.Op(OpVariable, { 24, 13, Input });
+    a.Op(OpTypeImage, { 14, 2, 1, 0, 0, 0, 1, 0 });
+    a.Op(OpTypeSampledImage, { 15, 14 });
+    a.Op(OpTypePointer, { 16, UniformConstant, 15 });
+    a.Op(OpVariable, { 16, 17, UniformConstant });
+    a.Op(OpTypeStruct, { 18, 2 });
+    a.Op(OpTypePointer, { 19, Uniform, 18 });
+    a.Op(OpVariable, { 19, 20, Uniform });
+    return a.words;
+}
+
+static void CheckAssembled()
+{
+    std::vector<uint32_t> compute = ComputeModule();
+    spirv::Reflection r;
+    Check(spirv::Reflect(compute.data(), compute.size() * 4, r), "parse", "compute module");
+    Check(r.compute, "stage", "compute module");
+    Check(r.threadcount_x == 64 && r.threadcount_y == 2 && r.threadcount_z == 1, "local size", "compute module");
+    Check(r.uniform_buffers == 1, "uniform buffer count", "compute module");
+    Check(r.storage_buffers == 2 && r.readonly_storage_buffers == 1, "storage buffer counts", "compute module");
+    Check(r.storage_textures == 4 && r.readonly_storage_textures == 0, "storage texture counts", "compute module");
+    Check(r.inputs.empty(), "builtin inputs", "compute module");
+    Check(r.resources.size() == 4 && r.resources[0].name == "input_data" && r.resources[3].name == "params", "resource order", "compute module");
+    Check(spirv::ValidateLayout(r, "compute module"), "descriptor set layout", "compute module");
+
+    std::vector<uint32_t> vertex = VertexModule();
+    Check(spirv::Reflect(vertex.data(), vertex.size() * 4, r), "parse", "vertex module");
+    CheckReflection(r, { "vertex module", false, SDL_GPU_SHADERSTAGE_VERTEX, 1, 0, 1,
+        { SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_INT2, SDL_GPU_VERTEXELEMENTFORMAT_UINT4 } }, "vertex module");
+    Check(r.inputs.size() == 3 && r.inputs[1].name == "a_cell", "input names", "vertex module");
+
+    // truncated and foreign data must be rejected, not read past
+    Check(!spirv::Reflect(vertex.data(), 12, r), "short module rejected", "vertex module");
+    vertex[vertex.size() - 4] = 0xFFFF0000 | OpVariable;
+    Check(!spirv::Reflect(vertex.data(), vertex.size() * 4, r), "overlong instruction rejected", "vertex module");
+    const char text[] = "#version 460\nvoid main() {}\n";
+    Check(!spirv::Reflect(text, sizeof(text) - 1, r), "text rejected", "vertex module");
+}
+
+// ---------------------------------------------------------------------------
+// pipeline descriptions
+
+static void CheckHashing()
+{
+    PipelineDesc base;
+    base.vertex_shader = "res/shaders/compiled/texposvert.spv";
+    base.fragment_shader = "res/shaders/compiled/texposfrag.spv";
+    base.color_format = SDL_GPU_TEXTUREFORMAT_B8G8R8A8_UNORM;
+    base.vertex_pitch = 32;
+    base.attribute_offsets[1] = 24;
+
+    PipelineDesc copy = base;
+    Check(copy == base && copy.Hash() == base.Hash(), "equal descriptions", "hash");
+
+    // every field has to reach the hash, or variants would alias each other
+    std::vector<PipelineDesc> variants(15, base);
+    variants[0].vertex_shader = "res/shaders/compiled/shvert.spv";
+    variants[1].fragment_shader = "res/shaders/compiled/shfrag.spv";
+    variants[2].primitive_type = SDL_GPU_PRIMITIVETYPE_LINELIST;
+    variants[3].fill_mode = SDL_GPU_FILLMODE_LINE;
+    variants[4].cull_mode = SDL_GPU_CULLMODE_BACK;
+    variants[5].front_face = SDL_GPU_FRONTFACE_CLOCKWISE;
+    variants[6].color_format = SDL_GPU_TEXTUREFORMAT_R8G8B8A8_UNORM;
+    variants[7].blend = true;
+    variants[8].depth_format = SDL_GPU_TEXTUREFORMAT_D32_FLOAT;
+    variants[9].depth_test = true;
+    variants[10].depth_write = true;
+    variants[11].depth_compare = SDL_GPU_COMPAREOP_GREATER;
+    variants[12].vertex_pitch = 24;
+    variants[13].attribute_offsets[1] = 12;
+    variants[14].attribute_formats[0] = SDL_GPU_VERTEXELEMENTFORMAT_HALF4;
+    for (size_t i = 0; i < variants.size(); i++)
+    {
+        Check(!(variants[i] == base), "field compare", "hash");
+        Check(variants[i].Hash() != base.Hash(), ("field " + std::to_string(i)).c_str(), "hash");
+        for (size_t j = 0; j < i; j++)
+            Check(variants[i].Hash() != variants[j].Hash(), "variant collision", "hash");
+    }
+
+    // no threads and no Get: the cache only deduplicates, nothing touches the device
+    PipelineCache cache(nullptr, 0);
+    PipelineHandle first = cache.Request(base);
+    Check(cache.Request(copy) == first, "dedupe", "cache");
+    for (const PipelineDesc& variant : variants)
+        Check(cache.Request(variant) != first, "distinct variant", "cache");
+    Check(cache.Request(variants[3]) == first + 4, "dedupe variant", "cache");
+    Check(cache.PipelineCount() == variants.size() + 1, "pipeline count", "cache");
+    Check(cache.GetStats().hits == 2, "hit count", "cache");
+}
+
+int main(int argc, char* argv[])
+{
+    std::string dir = "res/shaders/compiled";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--dir") == 0)
+            dir = argv[i + 1];
+    }
+
+    // what res/shaders/code declares for each compiled module
+    const std::vector<Expected> expected = {
+        { "texposvert.spv", false, SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0, { SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2 } },
+        { "texposfrag.spv", false, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, {} },
+        { "shvert.spv", false, SDL_GPU_SHADERSTAGE_VERTEX, 0, 0, 0,
+            { SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT4, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2 } },
+        { "shfrag.spv", false, SDL_GPU_SHADERSTAGE_FRAGMENT, 1, 0, 0, {} },
+        { "instancedvert.spv", true, SDL_GPU_SHADERSTAGE_VERTEX, 0, 1, 2, { SDL_GPU_VERTEXELEMENTFORMAT_FLOAT3, SDL_GPU_VERTEXELEMENTFORMAT_FLOAT2 } },
+    };
+
+    for (const Expected& e : expected)
+    {
+        std::string path = dir + "/" + e.file;
+        size_t size = 0;
+        void* code = SDL_LoadFile(path.c_str(), &size);
+        if (!code)
+        {
+            if (!e.optional)
+            {
+                SDL_Log("  %s: missing", path.c_str());
+                g_ok = false;
+            }
+            else
+            {
+                SDL_Log("%s: not built, skipped", e.file);
+            }
+            continue;
+        }
+
+        spirv::Reflection r;
+        bool parsed = spirv::Reflect(code, size, r);
+        SDL_free(code);
+        Check(parsed, "parse", e.file);
+        if (!parsed)
+            continue;
+        CheckReflection(r, e, e.file);
+        SDL_Log("%s: %s, %u samplers, %u storage buffers, %u uniform buffers, %zu inputs", e.file,
+            r.stage == SDL_GPU_SHADERSTAGE_VERTEX ? "vertex" : "fragment", r.samplers, r.storage_buffers,
+            r.uniform_buffers, r.inputs.size());
+    }
+
+    CheckAssembled();
+    CheckHashing();
+
+    SDL_Log("shader_check: %s", g_ok ? "ok" : "FAILED");
+    return g_ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+// Synthetic content shared by the headless benchmarks.
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "animation.h"
+#include "mesh.h"
+#include "skeleton.h"
+
+namespace synthetic
+{
+    inline anim::Skeleton MakeSkeleton(uint32_t joints, std::mt19937& rng)
+    {
+        anim::Skeleton skeleton;
+        skeleton.bind_pose.Resize(joints);
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            // bushy tree with short chains, close to a humanoid's shape
+            int16_t parent = j == 0 ? anim::kNoParent : (int16_t)(rng() % j);
+            skeleton.parents.push_back(parent);
+            skeleton.names.push_back("joint" + std::to_string(j));
+            skeleton.bind_pose.SetJoint(j, glm::vec3(0.0f, 0.1f, 0.0f), glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec3(1.0f));
+        }
+
+        std::vector<glm::mat4> model(joints);
+        anim::LocalToModel(skeleton, skeleton.bind_pose, model.data());
+        for (uint32_t j = 0; j < joints; j++)
+            skeleton.inverse_bind.push_back(glm::inverse(model[j]));
+        return skeleton;
+    }
+
+    inline anim::AnimationClip MakeClip(uint32_t joints, float duration, uint32_t keys, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        anim::AnimationClip clip;
+        clip.name = "synthetic";
+        clip.duration = duration;
+        clip.joint_count = joints;
+        clip.key_offsets.push_back(0);
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            float ax = dist(rng), ay = dist(rng), az = dist(rng);
+            float len = sqrtf(ax * ax + ay * ay + az * az) + 1e-6f;
+            for (uint32_t type = 0; type < anim::TRACK_COUNT; type++)
+            {
+                for (uint32_t k = 0; type != anim::TRACK_SCALE && k < keys; k++)
+                {
+                    float t = duration * k / (keys - 1);
+                    clip.times.push_back(t);
+                    if (type == anim::TRACK_TRANSLATION)
+                    {
+                        clip.values.push_back(glm::vec4(0.0f, 0.1f + 0.01f * sinf(t * 3.0f), 0.0f, 0.0f));
+                    }
+                    else
+                    {
+                        float angle = 0.5f * sinf(t * 2.0f + j);
+                        float s = sinf(angle * 0.5f) / len;
+                        clip.values.push_back(glm::vec4(ax * s, ay * s, az * s, cosf(angle * 0.5f)));
+                    }
+                }
+                clip.key_offsets.push_back((uint32_t)clip.times.size());
+            }
+        }
+        return clip;
+    }
+
+    // Dense keys at a fixed rate, the way motion capture exports: every joint keys
+    // all three tracks on every frame. Rotations swing smoothly with a little sensor
+    // noise, the root walks forward and bobs, bone lengths and scales never change.
+    inline anim::AnimationClip MakeMocapClip(uint32_t joints, float duration, float rate, std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+        anim::AnimationClip clip;
+        clip.name = "mocap";
+        clip.duration = duration;
+        clip.joint_count = joints;
+        clip.key_offsets.push_back(0);
+        uint32_t keys = (uint32_t)(duration * rate) + 1;
+        for (uint32_t j = 0; j < joints; j++)
+        {
+            float ax = dist(rng), ay = dist(rng), az = dist(rng);
+            float len = sqrtf(ax * ax + ay * ay + az * az) + 1e-6f;
+            float amplitude = 0.2f + 0.4f * (dist(rng) * 0.5f + 0.5f);
+            float frequency = 3.0f + 3.0f * dist(rng), phase = 3.0f * dist(rng);
+            for (uint32_t type = 0; type < anim::TRACK_COUNT; type++)
+            {
+                for (uint32_t k = 0; k < keys; k++)
+                {
+                    float t = k / rate < duration ? k / rate : duration;
+                    clip.times.push_back(t);
+                    if (type == anim::TRACK_TRANSLATION)
+                    {
+                        glm::vec4 offset(0.0f, 0.1f, 0.0f, 0.0f);
+                        if (j == 0)
+                            offset = glm::vec4(0.05f * sinf(t * 7.0f), 1.0f + 0.03f * sinf(t * 14.0f), 1.5f * t, 0.0f);
+                        clip.values.push_back(offset);
+                    }
+                    else if (type == anim::TRACK_ROTATION)
+                    {
+                        float angle = amplitude * sinf(t * frequency + phase) + 0.00005f * dist(rng);
+                        float s = sinf(angle * 0.5f) / len;
+                        clip.values.push_back(glm::vec4(ax * s, ay * s, az * s, cosf(angle * 0.5f)));
+                    }
+                    else
+                    {
+                        clip.values.push_back(glm::vec4(1.0f, 1.0f, 1.0f, 0.0f));
+                    }
+                }
+                clip.key_offsets.push_back((uint32_t)clip.times.size());
+            }
+        }
+        return clip;
+    }
+
+    // bind pose point cloud with 4 random normalized influences per vertex
+    inline void MakeSkinnedCloud(uint32_t vertices, uint32_t joints, std::mt19937& rng, std::vector<Vertex>& bind, std::vector<VertexSkin>& skin)
+    {
+        std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+        bind.resize(vertices);
+        skin.resize(vertices);
+        for (uint32_t v = 0; v < vertices; v++)
+        {
+            bind[v].position = glm::vec3(dist(rng), dist(rng), dist(rng));
+            bind[v].normal = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)));
+            bind[v].tex_coords = glm::vec2(dist(rng), dist(rng));
+            float sum = 0.0f;
+            for (int k = 0; k < 4; k++)
+            {
+                skin[v].joints[k] = (uint8_t)(rng() % joints);
+                skin[v].weights[k] = dist(rng) * 0.5f + 0.5f;
+                sum += skin[v].weights[k];
+            }
+            for (int k = 0; k < 4; k++)
+                skin[v].weights[k] /= sum;
+        }
+    }
+
+    // UV sphere around the origin. The last column repeats the first with u = 1 instead of 0,
+    // a texture seam simplification has to respect
+    inline Mesh MakeSphere(uint32_t rings, uint32_t segments, float radius)
+    {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        for (uint32_t r = 0; r <= rings; r++)
+        {
+            for (uint32_t s = 0; s <= segments; s++)
+            {
+                float theta = 3.14159265f * r / rings, phi = 6.2831853f * (s % segments) / segments;
+                glm::vec3 n(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+                Vertex v{};
+                v.position = n * radius;
+                v.normal = n;
+                v.tex_coords = glm::vec2((float)s / segments, (float)r / rings);
+                vertices.push_back(v);
+            }
+        }
+        for (uint32_t r = 0; r < rings; r++)
+        {
+            for (uint32_t s = 0; s < segments; s++)
+            {
+                uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+                uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+        return Mesh(vertices, indices, {});
+    }
+}
@@ -0,0 +1,107 @@
+// texture_bench: decode + mip chain throughput of the texture streaming path.
+//
+// Usage: texture_bench [--count N] [--max-threads T] [image ...]
+//
+// Decodes the given images (res/textures/container.jpg by default) N times
+// through TextureDecoder with 1, 2, 4, ... and T threads and reports MB/s of RGBA output
+// including the mip chain. Also times the SIMD 2x2 box filter against the
+// scalar one on a synthetic 2048x2048 image and checks they agree.
+
+#include <SDL3/SDL.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mipmap.h"
+#include "texture_streamer.h"
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t count = 64;
+    uint32_t max_threads = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+            count = ParseCount(argv[++i], 1, 100000);
+        else if (SDL_strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc)
+            max_threads = ParseCount(argv[++i], 1, 1024);
+        else
+            paths.push_back(argv[i]);
+    }
+    if (paths.empty())
+        paths.push_back("res/textures/container.jpg");
+
+    // mip filter alone
+    const uint32_t size = 2048;
+    std::vector<uint8_t> image((size_t)size * size * 4);
+    std::mt19937 rng(5);
+    for (uint8_t& byte : image)
+        byte = (uint8_t)rng();
+    std::vector<uint8_t> simd((size_t)size * size), scalar((size_t)size * size);
+    const uint32_t repeats = 20;
+    Uint64 start = SDL_GetTicksNS();
+    for (uint32_t r = 0; r < repeats; r++)
+        mip::Downsample(image.data(), size, size, simd.data());
+    Uint64 simd_ns = SDL_GetTicksNS() - start;
+    start = SDL_GetTicksNS();
+    for (uint32_t r = 0; r < repeats; r++)
+        mip::DownsampleScalar(image.data(), size, size, scalar.data());
+    Uint64 scalar_ns = SDL_GetTicksNS() - start;
+    bool ok = simd == scalar;
+    double source_mb = image.size() * repeats / (1024.0 * 1024.0);
+    SDL_Log("box filter %ux%u: simd %.0f MB/s, scalar %.0f MB/s, match: %s", size, size,
+        source_mb / (simd_ns / 1e9), source_mb / (scalar_ns / 1e9), ok ? "ok" : "FAILED");
+
+    // one decode up front for the sizes
+    uint64_t bytes_per_round = 0;
+    for (const std::string& path : paths)
+    {
+        DecodedTexture texture;
+        TextureDecoder::Decode(path.c_str(), true, texture);
+        if (!texture.ok)
+            return 1;
+        SDL_Log("%s: %ux%u, %u levels, %.2f MB with mips", path.c_str(), texture.width, texture.height,
+            texture.levels, texture.pixels.size() / (1024.0 * 1024.0));
+        bytes_per_round += texture.pixels.size();
+    }
+
+    SDL_Log("%u decodes per run", count * (uint32_t)paths.size());
+    SDL_Log("threads   ms total   MB/s   speedup");
+    // powers of two, then max_threads itself
+    std::vector<uint32_t> sweep;
+    for (uint32_t threads = 1; threads < max_threads; threads *= 2)
+        sweep.push_back(threads);
+    sweep.push_back(max_threads);
+    double baseline = 0.0;
+    for (uint32_t threads : sweep)
+    {
+        TextureDecoder decoder(threads);
+        start = SDL_GetTicksNS();
+        for (uint32_t i = 0; i < count; i++)
+        {
+            for (uint32_t p = 0; p < paths.size(); p++)
+                decoder.Submit(i * (uint32_t)paths.size() + p, paths[p], true);
+        }
+        decoder.WaitIdle();
+        double seconds = (SDL_GetTicksNS() - start) / 1e9;
+
+        std::vector<DecodedTexture> results;
+        decoder.Poll(results);
+        for (const DecodedTexture& texture : results)
+            ok = ok && texture.ok;
+
+        double mb_per_s = bytes_per_round * count / (1024.0 * 1024.0) / seconds;
+        if (threads == 1)
+            baseline = mb_per_s;
+        SDL_Log("%7u   %8.1f   %4.0f   %6.2fx", threads, seconds * 1e3, mb_per_s, mb_per_s / baseline);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,195 @@
+// texture_cook: offline BC1/BC3/BC7 encoder writing .dds files with mips.
+//
+// Usage: texture_cook input output.dds [--format bc1|bc3|bc7] [--srgb] [--threads N]
+//        texture_cook --report [--max-threads T] [image ...]
+//
+// The first form decodes input, builds its mip chain with the same box filter
+// the runtime uses and encodes every level. TextureStreamer loads the result
+// like any other path, uploading the blocks as they are.
+//
+// --report encodes each image (res/textures/container.jpg by default) in all
+// three formats with 1..T threads and prints the level 0 PSNR against the
+// source and the encode throughput in MB/s of RGBA input. Runs headless.
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "block_compress.h"
+#include "dds.h"
+#include "job_system.h"
+#include "texture_streamer.h"
+
+static const char* kFormatNames[] = { "bc1", "bc3", "bc7" };
+
+static bool ParseFormat(const char* name, bc::Format& format)
+{
+    for (uint32_t i = 0; i < SDL_arraysize(kFormatNames); i++)
+    {
+        if (SDL_strcasecmp(name, kFormatNames[i]) == 0)
+        {
+            format = (bc::Format)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// BC1 has no alpha, its PSNR covers RGB only
+static double Psnr(const uint8_t* a, const uint8_t* b, size_t texels, uint32_t channels)
+{
+    double error = 0.0;
+    for (size_t i = 0; i < texels; i++)
+    {
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            double d = (double)a[i * 4 + c] - (double)b[i * 4 + c];
+            error += d * d;
+        }
+    }
+    double mse = error / ((double)texels * channels);
+    return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+static bool Cook(const char* input, const char* output, bc::Format format, bool srgb, uint32_t threads)
+{
+    DecodedTexture source;
+    TextureDecoder::Decode(input, true, source);
+    if (!source.ok)
+        return false;
+
+    dds::Image image;
+    image.format = format;
+    image.srgb = srgb;
+    image.width = source.width;
+    image.height = source.height;
+    image.levels = source.levels;
+    image.level_offsets.resize(image.levels);
+    size_t total = 0;
+    for (uint32_t level = 0; level < image.levels; level++)
+    {
+        image.level_offsets[level] = total;
+        total += dds::LevelBytes(image, level);
+    }
+    image.data.resize(total);
+
+    JobSystem jobs(threads);
+    Uint64 start = SDL_GetTicksNS();
+    for (uint32_t level = 0; level < image.levels; level++)
+    {
+        uint32_t width = SDL_max(source.width >> level, 1u);
+        uint32_t height = SDL_max(source.height >> level, 1u);
+        bc::EncodeImage(format, source.pixels.data() + source.level_offsets[level], width, height,
+            image.data.data() + image.level_offsets[level], &jobs);
+    }
+    Uint64 elapsed = SDL_GetTicksNS() - start;
+
+    if (!dds::Save(output, image))
+        return false;
+    SDL_Log("%s -> %s: %s%s %ux%u, %u levels, %.2f MB -> %.2f MB in %.1f ms (%u threads)", input, output,
+        kFormatNames[format], srgb ? " srgb" : "", image.width, image.height, image.levels,
+        source.pixels.size() / (1024.0 * 1024.0), image.data.size() / (1024.0 * 1024.0), elapsed / 1e6, jobs.ThreadCount());
+    return true;
+}
+
+static bool Report(const std::vector<std::string>& paths, uint32_t max_threads)
+{
+    for (const std::string& path : paths)
+    {
+        DecodedTexture source;
+        TextureDecoder::Decode(path.c_str(), false, source);
+        if (!source.ok)
+            return false;
+
+        size_t texels = (size_t)source.width * source.height;
+        double source_mb = texels * 4 / (1024.0 * 1024.0);
+        SDL_Log("%s: %ux%u", path.c_str(), source.width, source.height);
+        SDL_Log("format   PSNR dB   threads   ms      MB/s   speedup");
+
+        std::vector<uint8_t> decoded(texels * 4);
+        for (uint32_t f = 0; f < SDL_arraysize(kFormatNames); f++)
+        {
+            bc::Format format = (bc::Format)f;
+            std::vector<uint8_t> blocks(bc::ImageBytes(format, source.width, source.height));
+
+            // serial reference, every thread count has to reproduce it byte for byte
+            bc::EncodeImage(format, source.pixels.data(), source.width, source.height, blocks.data());
+            bc::DecodeImage(format, blocks.data(), source.width, source.height, decoded.data());
+            double psnr = Psnr(source.pixels.data(), decoded.data(), texels, format == bc::FORMAT_BC1 ? 3 : 4);
+            std::vector<uint8_t> reference = blocks;
+
+            double baseline = 0.0;
+            for (uint32_t threads = 1; threads <= max_threads; threads *= 2)
+            {
+                JobSystem jobs(threads);
+                Uint64 start = SDL_GetTicksNS();
+                bc::EncodeImage(format, source.pixels.data(), source.width, source.height, blocks.data(), &jobs);
+                double seconds = (SDL_GetTicksNS() - start) / 1e9;
+                if (blocks != reference)
+                {
+                    SDL_Log("%s with %u threads differs from the serial encode", kFormatNames[f], threads);
+                    return false;
+                }
+                if (threads == 1)
+                    baseline = seconds;
+                SDL_Log("%-6s   %7.2f   %7u   %6.1f   %6.1f   %5.2fx", kFormatNames[f], psnr, threads,
+                    seconds * 1e3, source_mb / seconds, baseline / seconds);
+            }
+        }
+    }
+    return true;
+}
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    bool report = false;
+    bool srgb = false;
+    bc::Format format = bc::FORMAT_BC7;
+    uint32_t threads = 0;
+    uint32_t max_threads = (uint32_t)SDL_max(SDL_GetNumLogicalCPUCores(), 1);
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++)
+    {
+        if (SDL_strcmp(argv[i], "--report") == 0)
+            report = true;
+        else if (SDL_strcmp(argv[i], "--srgb") == 0)
+            srgb = true;
+        else if (SDL_strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+        {
+            if (!ParseFormat(argv[++i], format))
+            {
+                SDL_Log("Unknown format %s, expected bc1, bc3 or bc7", argv[i]);
+                return 1;
+            }
+        }
+        else if (SDL_strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = ParseCount(argv[++i], 0, 1024);   // 0 picks the core count
+        else if (SDL_strcmp(argv[i], "--max-threads") == 0 && i + 1 < argc)
+            max_threads = ParseCount(argv[++i], 1, 1024);
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if (report)
+    {
+        if (paths.empty())
+            paths.push_back("res/textures/container.jpg");
+        return Report(paths, max_threads) ? 0 : 1;
+    }
+
+    if (paths.size() != 2)
+    {
+        SDL_Log("Usage: texture_cook input output.dds [--format bc1|bc3|bc7] [--srgb] [--threads N]");
+        SDL_Log("       texture_cook --report [--max-threads T] [image ...]");
+        return 1;
+    }
+    return Cook(paths[0].c_str(), paths[1].c_str(), format, srgb, threads) ? 0 : 1;
+}
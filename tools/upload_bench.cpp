@@ -0,0 +1,251 @@
+// upload_bench: drives UploadRing against a fake GPU backend.
+//
+// Usage: upload_bench [--frames N] [--ring-kb K] [--latency F] [--seed S]
+//
+// The fake GPU executes a submission's copies only once its fence signals,
+// F frames after submission, reading the staging memory at that point. Any
+// region the ring hands out again while still in flight is caught by a
+// checksum mismatch. Exits with a non-zero status on corruption or when
+// staging memory is copied while still mapped.
+
+#include <SDL3/SDL.h>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "hash.h"
+#include "upload_ring.h"
+
+struct FakeStaging
+{
+    std::vector<uint8_t> memory;
+    bool mapped = false;
+};
+
+struct FakeCopy
+{
+    FakeStaging* source;
+    uint32_t offset;
+    uint32_t size;
+    uint64_t checksum;              // of the payload when the copy was recorded
+};
+
+struct FakeFence
+{
+    uint64_t frame;
+    std::vector<FakeCopy> copies;
+    bool signaled = false;
+};
+
+class FakeBackend : public UploadBackend
+{
+public:
+    uint32_t latency = 2;
+    uint64_t frame = 0;
+    uint64_t errors = 0;
+    uint64_t executed_copies = 0;
+    uint64_t staging_buffers = 0;
+    uint64_t live_staging = 0;
+
+    std::vector<FakeCopy> recording;
+    std::deque<FakeFence*> submitted;
+    bool in_copy_pass = false;
+
+    SDL_GPUTransferBuffer* CreateStaging(uint32_t size) override
+    {
+        FakeStaging* staging = new FakeStaging();
+        staging->memory.resize(size);
+        staging_buffers++;
+        live_staging++;
+        return (SDL_GPUTransferBuffer*)staging;
+    }
+
+    void ReleaseStaging(SDL_GPUTransferBuffer* buffer) override
+    {
+        delete (FakeStaging*)buffer;
+        live_staging--;
+    }
+
+    uint8_t* Map(SDL_GPUTransferBuffer* buffer) override
+    {
+        FakeStaging* staging = (FakeStaging*)buffer;
+        staging->mapped = true;
+        return staging->memory.data();
+    }
+
+    void Unmap(SDL_GPUTransferBuffer* buffer) override
+    {
+        ((FakeStaging*)buffer)->mapped = false;
+    }
+
+    void BeginCopyPass(SDL_GPUCommandBuffer*) override { in_copy_pass = true; }
+    void EndCopyPass() override { in_copy_pass = false; }
+
+    void CopyToBuffer(const SDL_GPUTransferBufferLocation& source, const SDL_GPUBufferRegion& destination, bool) override
+    {
+        Record((FakeStaging*)source.transfer_buffer, source.offset, destination.size);
+    }
+
+    void CopyToTexture(const SDL_GPUTextureTransferInfo& source, const SDL_GPUTextureRegion& destination, bool) override
+    {
+        Record((FakeStaging*)source.transfer_buffer, source.offset, destination.w * destination.h * 4);
+    }
+
+    bool IsSignaled(SDL_GPUFence* fence) override
+    {
+        return ((FakeFence*)fence)->signaled;
+    }
+
+    void Wait(SDL_GPUFence* fence) override
+    {
+        while (!((FakeFence*)fence)->signaled)
+            Execute(submitted.front());
+    }
+
+    void ReleaseFence(SDL_GPUFence* fence) override
+    {
+        delete (FakeFence*)fence;
+    }
+
+    SDL_GPUFence* Submit()
+    {
+        FakeFence* fence = new FakeFence();
+        fence->frame = frame;
+        fence->copies.swap(recording);
+        submitted.push_back(fence);
+        return (SDL_GPUFence*)fence;
+    }
+
+    // the GPU catches up to `latency` frames behind the CPU
+    void Tick()
+    {
+        frame++;
+        while (!submitted.empty() && submitted.front()->frame + latency <= frame)
+            Execute(submitted.front());
+    }
+
+private:
+    void Record(FakeStaging* source, uint32_t offset, uint32_t size)
+    {
+        if (!in_copy_pass || source->mapped)
+        {
+            SDL_Log("  copy recorded outside a copy pass or from mapped staging");
+            errors++;
+        }
+        recording.push_back({ source, offset, size, hash::Murmur64(source->memory.data() + offset, size) });
+    }
+
+    void Execute(FakeFence* fence)
+    {
+        for (const FakeCopy& copy : fence->copies)
+        {
+            uint64_t checksum = hash::Murmur64(copy.source->memory.data() + copy.offset, copy.size);
+            if (checksum != copy.checksum)
+            {
+                SDL_Log("  frame %llu: staging [%u, %u) was overwritten while in flight",
+                    (unsigned long long)fence->frame, copy.offset, copy.offset + copy.size);
+                errors++;
+            }
+            executed_copies++;
+        }
+        fence->signaled = true;
+        submitted.pop_front();
+    }
+};
+
+// a count option, clamped while still signed so a negative one cannot wrap around
+static uint32_t ParseCount(const char* text, int min, int max)
+{
+    int value = SDL_atoi(text);
+    return (uint32_t)SDL_clamp(value, min, max);
+}
+
+int main(int argc, char* argv[])
+{
+    uint32_t frames = 20000;
+    uint32_t ring_kb = 4096;
+    uint32_t latency = 2;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (SDL_strcmp(argv[i], "--frames") == 0)
+            frames = ParseCount(argv[i + 1], 1, 10000000);
+        else if (SDL_strcmp(argv[i], "--ring-kb") == 0)
+            ring_kb = ParseCount(argv[i + 1], 1, 1024 * 1024);
+        else if (SDL_strcmp(argv[i], "--latency") == 0)
+            latency = ParseCount(argv[i + 1], 0, 64);
+        else if (SDL_strcmp(argv[i], "--seed") == 0)
+            seed = (uint32_t)SDL_atoi(argv[i + 1]);
+    }
+
+    FakeBackend backend;
+    backend.latency = latency;
+    // fake buffers and textures, copies only care about sizes
+    SDL_GPUBuffer* buffer = (SDL_GPUBuffer*)&backend;
+    SDL_GPUTexture* texture = (SDL_GPUTexture*)&backend;
+
+    std::mt19937 rng(seed);
+    uint64_t peak_in_flight = 0;
+    size_t peak_frames = 0;
+    Uint64 ticks = 0;
+    {
+        UploadRing ring(&backend, ring_kb * 1024);
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            Uint64 start = SDL_GetTicksNS();
+            ring.BeginFrame();
+
+            // mostly small per-object data, a few skinned meshes, rarely a texture
+            uint32_t uploads = 16 + rng() % 64;
+            for (uint32_t i = 0; i < uploads; i++)
+            {
+                uint32_t kind = rng() % 100;
+                uint32_t size = kind < 90 ? 16 + rng() % 1024 : kind < 99 ? 4096 + rng() % 65536 : 0;
+                if (size)
+                {
+                    UploadRing::Allocation allocation = ring.Allocate(size, kind < 90 ? 16 : 256);
+                    SDL_memset(allocation.data, (int)(rng() & 0xFF), size);
+                    SDL_memcpy(allocation.data, &frame, SDL_min(size, (uint32_t)sizeof(frame)));
+                    ring.CopyToBuffer(allocation, buffer, 0);
+                }
+                else
+                {
+                    uint32_t side = 64u << (rng() % 5);
+                    UploadRing::Allocation allocation = ring.Allocate(side * side * 4, 16);
+                    SDL_memset(allocation.data, (int)(rng() & 0xFF), side * side * 4);
+                    SDL_memcpy(allocation.data, &frame, sizeof(frame));
+                    SDL_GPUTextureRegion region{};
+                    region.texture = texture;
+                    region.w = side;
+                    region.h = side;
+                    region.d = 1;
+                    ring.CopyToTexture(allocation, region);
+                }
+            }
+
+            ring.Flush(nullptr);
+
+            peak_in_flight = SDL_max(peak_in_flight, ring.BytesInFlight());
+            ring.EndFrame(backend.Submit());
+            peak_frames = SDL_max(peak_frames, ring.FramesInFlight());
+            ticks += SDL_GetTicksNS() - start;
+
+            backend.Tick();
+        }
+
+        const UploadRing::Stats& stats = ring.GetStats();
+        SDL_Log("frames %u, ring %u KB, gpu latency %u frames", frames, ring.Capacity() / 1024, latency);
+        SDL_Log("  uploads %llu (%.1f MB), %llu copy passes",
+            (unsigned long long)stats.allocations, stats.bytes / (1024.0 * 1024.0), (unsigned long long)stats.copy_passes);
+        SDL_Log("  overflow buffers %llu (%.1f MB), fence stalls %llu",
+            (unsigned long long)stats.overflow_allocations, stats.overflow_bytes / (1024.0 * 1024.0), (unsigned long long)stats.stalls);
+        SDL_Log("  peak in flight %.1f KB over %zu frames", peak_in_flight / 1024.0, peak_frames);
+        SDL_Log("  %.1f ns per upload including payload writes", (double)ticks / (double)SDL_max(stats.allocations, 1ull));
+    }
+
+    // the ring waits for and releases everything on destruction
+    bool ok = backend.errors == 0 && backend.live_staging == 0 && backend.submitted.empty();
+    SDL_Log("  staging buffers created %llu, copies executed %llu: %s",
+        (unsigned long long)backend.staging_buffers, (unsigned long long)backend.executed_copies, ok ? "ok" : "FAILED");
+    return ok ? 0 : 1;
+}
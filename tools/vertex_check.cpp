@@ -0,0 +1,237 @@
+// vertex_check: reconstruction error and size of the compact vertex layout.
+//
+// Usage: vertex_check [model file ...]
+//
+// Encodes every mesh of each model (a synthetic skinned sphere when none is
+// given) in vtx::LAYOUT_COMPACT, decodes it again and reports the largest
+// position error relative to the mesh extent, normal error in degrees,
+// texture coordinate and skin weight error, and the bytes saved against the
+// full layout. Also checks the full layout round-trips exactly, the generated
+// attribute list fits its stride, and a compact .skmesh decodes through
+// MeshCache the same way. Exits non-zero when any error is above what the
+// encodings allow. Runs headless.
+
+#include <SDL3/SDL.h>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "mesh_cache.h"
+#include "model.h"
+#include "synthetic.h"
+#include "vertex_format.h"
+
+struct Errors
+{
+    float position = 0.0f;      // fraction of the largest extent
+    float normal_degrees = 0.0f;
+    float texcoord = 0.0f;      // relative to the coordinate's magnitude, at least 1
+    float weight = 0.0f;
+    uint32_t joint_mismatches = 0;
+};
+
+static void Measure(const Vertex* original, const VertexSkin* skin, const Vertex* decoded, const VertexSkin* decoded_skin,
+    size_t count, const vtx::Quantization& quantization, Errors& errors)
+{
+    float extent = SDL_max(SDL_max(quantization.scale.x, quantization.scale.y), SDL_max(quantization.scale.z, 1e-20f));
+    for (size_t i = 0; i < count; i++)
+    {
+        glm::vec3 d = glm::abs(decoded[i].position - original[i].position);
+        errors.position = SDL_max(errors.position, SDL_max(d.x, SDL_max(d.y, d.z)) / extent);
+
+        if (glm::length(original[i].normal) > 0.0f)
+        {
+            float cosine = glm::dot(glm::normalize(original[i].normal), decoded[i].normal);
+            errors.normal_degrees = SDL_max(errors.normal_degrees, acosf(SDL_clamp(cosine, -1.0f, 1.0f)) * 57.2957795f);
+        }
+
+        for (int k = 0; k < 2; k++)
+        {
+            float magnitude = SDL_max(fabsf(original[i].tex_coords[k]), 1.0f);
+            errors.texcoord = SDL_max(errors.texcoord, fabsf(decoded[i].tex_coords[k] - original[i].tex_coords[k]) / magnitude);
+        }
+
+        if (skin)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                errors.weight = SDL_max(errors.weight, fabsf(decoded_skin[i].weights[k] - skin[i].weights[k]));
+                errors.joint_mismatches += decoded_skin[i].joints[k] != skin[i].joints[k];
+            }
+        }
+    }
+}
+
+static bool CheckAttributes(const vtx::Layout& layout)
+{
+    SDL_GPUVertexAttribute attributes[vtx::ATTRIBUTE_COUNT];
+    uint32_t count = vtx::BuildAttributes(layout, 0, attributes);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t end = attributes[i].offset + vtx::EncodingSize(layout.elements[i].encoding);
+        if (end > layout.stride)
+            return false;
+        for (uint32_t j = 0; j < i; j++)
+        {
+            uint32_t other_end = attributes[j].offset + vtx::EncodingSize(layout.elements[j].encoding);
+            if (attributes[i].location == attributes[j].location || (attributes[i].offset < other_end && attributes[j].offset < end))
+                return false;
+        }
+    }
+    return count == layout.element_count;
+}
+
+// skinned UV sphere placed far from the origin, where 16-bit positions relative to the bounds matter most
+static Mesh MakeSphere(std::mt19937& rng)
+{
+    const uint32_t rings = 64, segments = 128;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (uint32_t r = 0; r <= rings; r++)
+    {
+        for (uint32_t s = 0; s <= segments; s++)
+        {
+            float theta = 3.14159265f * r / rings, phi = 6.2831853f * s / segments;
+            glm::vec3 n(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+            Vertex v{};
+            v.position = glm::vec3(2500.0f, 40.0f, -1200.0f) + n * 3.0f;
+            v.normal = n;
+            v.tex_coords = glm::vec2(4.0f * s / segments, (float)r / rings);
+            vertices.push_back(v);
+        }
+    }
+    for (uint32_t r = 0; r < rings; r++)
+    {
+        for (uint32_t s = 0; s < segments; s++)
+        {
+            uint32_t a = r * (segments + 1) + s, b = a + segments + 1;
+            uint32_t quad[6] = { a, b, a + 1, a + 1, b, b + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    std::vector<Vertex> cloud;
+    std::vector<VertexSkin> skin;
+    synthetic::MakeSkinnedCloud((uint32_t)vertices.size(), 64, rng, cloud, skin);
+    Mesh mesh(vertices, indices, {});
+    mesh.SetSkin(skin);
+    return mesh;
+}
+
+static bool CheckCache(const std::vector<Mesh>& meshes)
+{
+    const char* path = "vertex_check.skmesh";
+    if (!meshcache::Bake(path, meshes, 1, 1, vtx::LAYOUT_COMPACT))
+        return false;
+
+    bool ok = false;
+    {
+        meshcache::MeshCache cache;
+        if (cache.Open(path) && cache.VertexLayout() == vtx::LAYOUT_COMPACT && cache.MeshCount() == meshes.size())
+        {
+            ok = true;
+            vtx::Layout layout = vtx::MakeLayout(vtx::LAYOUT_COMPACT, false);
+            for (uint32_t m = 0; m < cache.MeshCount(); m++)
+            {
+                meshcache::MeshView view = cache.GetMesh(m);
+                std::vector<Vertex> decoded(view.vertex_count);
+                vtx::Decode(layout, view.quantization, view.vertices, view.vertex_count, decoded.data(), nullptr);
+                Errors errors;
+                Measure(meshes[m].Vertices().data(), nullptr, decoded.data(), nullptr, decoded.size(), view.quantization, errors);
+                ok &= errors.position <= 0.5f / 65535.0f * 1.01f && errors.normal_degrees < 0.03f;
+            }
+        }
+    }
+    SDL_RemovePath(path);
+    SDL_Log("compact .skmesh round trip: %s", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+static bool CheckModel(const char* name, const std::vector<Mesh>& meshes)
+{
+    size_t vertices = 0, full_bytes = 0, compact_bytes = 0;
+    Errors errors;
+    bool exact = true;
+    for (const Mesh& mesh : meshes)
+    {
+        const Vertex* source = mesh.Vertices().data();
+        size_t count = mesh.Vertices().size();
+        const VertexSkin* skin = mesh.IsSkinned() ? mesh.Skin().data() : nullptr;
+        vtx::Layout full = vtx::MakeLayout(vtx::LAYOUT_FULL, skin != nullptr);
+        vtx::Layout compact = vtx::MakeLayout(vtx::LAYOUT_COMPACT, skin != nullptr);
+        vtx::Quantization quantization = vtx::ComputeQuantization(source, count);
+
+        std::vector<Vertex> decoded(count);
+        std::vector<VertexSkin> decoded_skin(count);
+
+        std::vector<uint8_t> full_data(count * full.stride);
+        vtx::Encode(full, quantization, source, skin, count, full_data.data());
+        vtx::Decode(full, quantization, full_data.data(), count, decoded.data(), decoded_skin.data());
+        exact &= SDL_memcmp(decoded.data(), source, count * sizeof(Vertex)) == 0;
+
+        std::vector<uint8_t> compact_data(count * compact.stride);
+        vtx::Encode(compact, quantization, source, skin, count, compact_data.data());
+        vtx::Decode(compact, quantization, compact_data.data(), count, decoded.data(), decoded_skin.data());
+        Measure(source, skin, decoded.data(), decoded_skin.data(), count, quantization, errors);
+
+        vertices += count;
+        full_bytes += full_data.size();
+        compact_bytes += compact_data.size();
+    }
+
+    // half the unorm16 step, a degree budget well above the 16-bit octahedral error,
+    // the half float rounding step, and one 8-bit step plus the sum correction
+    bool ok = exact
+        && errors.position <= 0.5f / 65535.0f * 1.01f
+        && errors.normal_degrees < 0.03f
+        && errors.texcoord <= 1.0f / 2048.0f
+        && errors.weight <= 2.0f / 255.0f
+        && errors.joint_mismatches == 0;
+    SDL_Log("%s: %zu meshes, %zu vertices", name, meshes.size(), vertices);
+    SDL_Log("  bytes        %zu full -> %zu compact (%.1f%% saved)", full_bytes, compact_bytes,
+        full_bytes ? 100.0 * (1.0 - (double)compact_bytes / full_bytes) : 0.0);
+    SDL_Log("  position     %.3g of the extent (unorm16 step %.3g)", errors.position, 1.0 / 65535.0);
+    SDL_Log("  normal       %.4f degrees", errors.normal_degrees);
+    SDL_Log("  texcoord     %.3g relative", errors.texcoord);
+    SDL_Log("  weights      %.4f, %u joint mismatches", errors.weight, errors.joint_mismatches);
+    SDL_Log("  full layout  %s", exact ? "exact" : "NOT EXACT");
+    SDL_Log("  %s", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    bool ok = true;
+    for (uint32_t id = 0; id < vtx::LAYOUT_COUNT; id++)
+    {
+        for (int skinned = 0; skinned < 2; skinned++)
+        {
+            vtx::Layout layout = vtx::MakeLayout((vtx::LayoutId)id, skinned != 0);
+            bool fits = CheckAttributes(layout);
+            SDL_Log("%s%s layout: %u bytes, %u attributes, %s", vtx::LayoutName((vtx::LayoutId)id), skinned ? " skinned" : "",
+                layout.stride, layout.element_count, fits ? "ok" : "OVERLAPPING");
+            ok &= fits;
+        }
+    }
+
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            model::SkinnedModel loaded;
+            if (!model::LoadSkinnedModel(argv[i], loaded))
+                return 1;
+            ok &= CheckModel(argv[i], loaded.meshes);
+            ok &= CheckCache(loaded.meshes);
+        }
+    }
+    else
+    {
+        std::mt19937 rng(5);
+        std::vector<Mesh> meshes;
+        meshes.push_back(MakeSphere(rng));
+        ok &= CheckModel("synthetic sphere", meshes);
+        ok &= CheckCache(meshes);
+    }
+    return ok ? 0 : 1;
+}